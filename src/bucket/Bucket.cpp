@@ -8,6 +8,7 @@
 // else.
 #include "util/asio.h"
 #include "bucket/BucketApplicator.h"
+#include "bucket/BucketIndex.h"
 #include "bucket/BucketList.h"
 #include "bucket/BucketManager.h"
 #include "bucket/LedgerCmp.h"
@@ -30,8 +31,15 @@
 #include "util/XDRStream.h"
 #include "util/make_unique.h"
 #include "xdrpp/message.h"
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <condition_variable>
+#include <exception>
+#include <fstream>
 #include <future>
+#include <mutex>
+#include <thread>
 
 namespace stellar
 {
@@ -51,8 +59,9 @@ randomBucketName(std::string const& tmpDir)
     }
 }
 
-Bucket::Bucket(std::string const& filename, Hash const& hash)
-    : mFilename(filename), mHash(hash)
+Bucket::Bucket(std::string const& filename, Hash const& hash,
+               std::shared_ptr<BucketIndex const> index)
+    : mFilename(filename), mHash(hash), mIndex(index)
 {
     assert(filename.empty() || fs::exists(filename));
     if (!filename.empty())
@@ -68,6 +77,7 @@ Bucket::~Bucket()
     {
         CLOG(TRACE, "Bucket") << "Bucket::~Bucket removing file: " << mFilename;
         std::remove(mFilename.c_str());
+        std::remove(BucketIndex::indexFilename(mFilename).c_str());
     }
 }
 
@@ -95,7 +105,8 @@ Bucket::setRetain(bool r)
 
 /**
  * Helper class that reads from the file underlying a bucket, keeping the bucket
- * alive for the duration of its existence.
+ * alive for the duration of its existence. The file is memory-mapped and each
+ * entry decoded straight from the mapping.
  */
 class Bucket::InputIterator
 {
@@ -104,12 +115,16 @@ class Bucket::InputIterator
     // Validity and current-value of the iterator is funneled into a pointer. If
     // non-null, it points to mEntry.
     BucketEntry const* mEntryPtr;
-    XDRInputFileStream mIn;
+    XDRInputMappedStream mIn;
     BucketEntry mEntry;
+    size_t mEntryPos{0};
+    // a page of the bucket's index starting at or before mEntryPos
+    size_t mPage{0};
 
     void
     loadEntry()
     {
+        mEntryPos = mIn.getPos();
         if (mIn.readOne(mEntry))
         {
             mEntryPtr = &mEntry;
@@ -117,6 +132,7 @@ class Bucket::InputIterator
         else
         {
             mEntryPtr = nullptr;
+            mEntryPos = mIn.getPos();
         }
     }
 
@@ -149,6 +165,65 @@ class Bucket::InputIterator
         mIn.close();
     }
 
+    // Offset in the file of the current entry, or of the end of the file once
+    // the iterator is exhausted.
+    size_t
+    getPos() const
+    {
+        return mEntryPos;
+    }
+
+    // Move to the entry at `pos`, an offset previously returned by getPos()
+    // (on an iterator over the same bucket).
+    void
+    seek(size_t pos)
+    {
+        if (!mBucket->mFilename.empty())
+        {
+            mIn.seek(pos);
+            loadEntry();
+            mPage = 0;
+        }
+    }
+
+    // Move forward to the first entry not ordered before `e`, using the
+    // index of the bucket to skip the pages (or the rest of the bucket)
+    // ordered before `e` without decoding them.
+    void
+    advanceTo(BucketEntry const& e)
+    {
+        BucketEntryIdCmp cmp;
+        if (!mEntryPtr || !cmp(*mEntryPtr, e))
+        {
+            return;
+        }
+        auto const& index = mBucket->mIndex;
+        if (index)
+        {
+            if (index->isAfterLastKey(e))
+            {
+                mIn.seek(mIn.size());
+                loadEntry();
+                return;
+            }
+            auto page = index->getPage(e, mPage);
+            if (page != mPage)
+            {
+                auto offset = index->getPageOffsets()[page];
+                if (offset > mEntryPos)
+                {
+                    mIn.seek(offset);
+                    loadEntry();
+                }
+                mPage = page;
+            }
+        }
+        while (mEntryPtr && cmp(*mEntryPtr, e))
+        {
+            ++*this;
+        }
+    }
+
     InputIterator& operator++()
     {
         if (mIn)
@@ -158,6 +233,7 @@ class Bucket::InputIterator
         else
         {
             mEntryPtr = nullptr;
+            mEntryPos = mIn.getPos();
         }
         return *this;
     }
@@ -174,15 +250,37 @@ class Bucket::OutputIterator
     BucketEntryIdCmp mCmp;
     std::unique_ptr<BucketEntry> mBuf;
     std::unique_ptr<SHA256> mHasher;
+    BucketIndex::Builder mIndex;
     size_t mBytesPut{0};
     size_t mObjectsPut{0};
     bool mKeepDeadEntries{true};
 
+    void
+    write(BucketEntry const& e)
+    {
+        mIndex.add(e, mBytesPut);
+        mOut.writeOne(e, mHasher.get(), &mBytesPut);
+        mObjectsPut++;
+    }
+
+    void
+    flush()
+    {
+        if (mBuf)
+        {
+            write(*mBuf);
+            mBuf.reset();
+        }
+    }
+
   public:
-    OutputIterator(std::string const& tmpDir, bool keepDeadEntries)
+    // Outputs that will only be part of a bucket (see mergePartitioned) need
+    // not be `hashed`.
+    OutputIterator(std::string const& tmpDir, bool keepDeadEntries,
+                   bool hashed = true)
         : mFilename(randomBucketName(tmpDir))
         , mBuf(nullptr)
-        , mHasher(SHA256::create())
+        , mHasher(hashed ? SHA256::create() : nullptr)
         , mKeepDeadEntries(keepDeadEntries)
     {
         CLOG(TRACE, "Bucket")
@@ -209,8 +307,7 @@ class Bucket::OutputIterator
             // merely replace (same identity), the buffered entry.
             if (mCmp(*mBuf, e))
             {
-                mOut.writeOne(*mBuf, mHasher.get(), &mBytesPut);
-                mObjectsPut++;
+                write(*mBuf);
             }
         }
         else
@@ -222,16 +319,46 @@ class Bucket::OutputIterator
         *mBuf = e;
     }
 
+    std::string const&
+    getFilename() const
+    {
+        return mFilename;
+    }
+
+    size_t
+    getObjectsPut() const
+    {
+        return mObjectsPut;
+    }
+
+    size_t
+    getBytesPut() const
+    {
+        return mBytesPut;
+    }
+
+    // Index of the entries written so far, with offsets in this output.
+    BucketIndex::Builder&
+    getIndexBuilder()
+    {
+        return mIndex;
+    }
+
+    // Write out the last entry and close the file, leaving it to the caller.
+    void
+    close()
+    {
+        assert(mOut);
+        flush();
+        mOut.close();
+    }
+
     std::shared_ptr<Bucket>
     getBucket(BucketManager& bucketManager)
     {
         assert(mOut);
-        if (mBuf)
-        {
-            mOut.writeOne(*mBuf, mHasher.get(), &mBytesPut);
-            mObjectsPut++;
-            mBuf.reset();
-        }
+        assert(mHasher);
+        flush();
 
         mOut.close();
         if (mObjectsPut == 0 || mBytesPut == 0)
@@ -243,22 +370,44 @@ class Bucket::OutputIterator
             return std::make_shared<Bucket>();
         }
         return bucketManager.adoptFileAsBucket(mFilename, mHasher->finish(),
-                                               mObjectsPut, mBytesPut);
+                                               mObjectsPut, mBytesPut,
+                                               mIndex.finish());
     }
 };
 
 bool
 Bucket::containsBucketIdentity(BucketEntry const& id) const
 {
-    BucketEntryIdCmp cmp;
-    Bucket::InputIterator iter(shared_from_this());
-    while (iter)
+    BucketEntry entry;
+    return getEntry(id.type() == LIVEENTRY ? LedgerEntryKey(id.liveEntry())
+                                           : id.deadEntry(),
+                    entry);
+}
+
+bool
+Bucket::getEntry(LedgerKey const& key, BucketEntry& entry) const
+{
+    size_t offset;
+    if (!mIndex || !mIndex->mayContain(key) ||
+        !mIndex->getPageOffset(key, offset))
     {
-        if (!(cmp(*iter, id) || cmp(id, *iter)))
+        return false;
+    }
+
+    // the entry is in the page starting at `offset`, if anywhere: scan it
+    LedgerEntryIdCmp cmp;
+    XDRInputMappedStream in;
+    in.open(mFilename);
+    in.seek(offset);
+    while (in.readOne(entry))
+    {
+        bool live = entry.type() == LIVEENTRY;
+        if (live ? cmp(entry.liveEntry(), key) : cmp(entry.deadEntry(), key))
         {
-            return true;
+            continue;
         }
-        ++iter;
+        return !(live ? cmp(key, entry.liveEntry())
+                      : cmp(key, entry.deadEntry()));
     }
     return false;
 }
@@ -298,16 +447,19 @@ Bucket::fresh(BucketManager& bucketManager,
               std::vector<LedgerEntry> const& liveEntries,
               std::vector<LedgerKey> const& deadEntries)
 {
-    std::vector<BucketEntry> live, dead, combined;
-    live.reserve(liveEntries.size());
-    dead.reserve(deadEntries.size());
+    // Live entries go first so that, should a key be both live and dead,
+    // the stable sort keeps the dead entry last and the output iterator keeps
+    // that one: the same result as merging a bucket of the live entries with
+    // a newer one of the dead entries, written in a single pass.
+    std::vector<BucketEntry> entries;
+    entries.reserve(liveEntries.size() + deadEntries.size());
 
     for (auto const& e : liveEntries)
     {
         BucketEntry ce;
         ce.type(LIVEENTRY);
         ce.liveEntry() = e;
-        live.push_back(ce);
+        entries.push_back(ce);
     }
 
     for (auto const& e : deadEntries)
@@ -315,27 +467,17 @@ Bucket::fresh(BucketManager& bucketManager,
         BucketEntry ce;
         ce.type(DEADENTRY);
         ce.deadEntry() = e;
-        dead.push_back(ce);
+        entries.push_back(ce);
     }
 
-    std::sort(live.begin(), live.end(), BucketEntryIdCmp());
-
-    std::sort(dead.begin(), dead.end(), BucketEntryIdCmp());
+    std::stable_sort(entries.begin(), entries.end(), BucketEntryIdCmp());
 
-    OutputIterator liveOut(bucketManager.getTmpDir(), true);
-    OutputIterator deadOut(bucketManager.getTmpDir(), true);
-    for (auto const& e : live)
+    OutputIterator out(bucketManager.getTmpDir(), true);
+    for (auto const& e : entries)
     {
-        liveOut.put(e);
+        out.put(e);
     }
-    for (auto const& e : dead)
-    {
-        deadOut.put(e);
-    }
-
-    auto liveBucket = liveOut.getBucket(bucketManager);
-    auto deadBucket = deadOut.getBucket(bucketManager);
-    return Bucket::merge(bucketManager, liveBucket, deadBucket);
+    return out.getBucket(bucketManager);
 }
 
 inline void
@@ -346,10 +488,7 @@ maybe_put(BucketEntryIdCmp const& cmp, Bucket::OutputIterator& out,
     for (auto& si : shadowIterators)
     {
         // Advance the shadowIterator while it's less than the candidate
-        while (si && cmp(*si, *in))
-        {
-            ++si;
-        }
+        si.advanceTo(*in);
         // We have stepped si forward to the point that either si is exhausted,
         // or else *si >= *in; we now check the opposite direction to see if we
         // have equality.
@@ -368,6 +507,61 @@ maybe_put(BucketEntryIdCmp const& cmp, Bucket::OutputIterator& out,
     out.put(*in);
 }
 
+// Merge the entries of `oi` and `ni` ordered before `end` (or all of them, if
+// `end` is null) into `out`.
+static void
+mergeRange(BucketEntryIdCmp const& cmp, Bucket::InputIterator& oi,
+           Bucket::InputIterator& ni,
+           std::vector<Bucket::InputIterator>& shadowIterators,
+           Bucket::OutputIterator& out, BucketEntry const* end)
+{
+    auto inRange = [&cmp, end](Bucket::InputIterator& iter) {
+        return iter && (!end || cmp(*iter, *end));
+    };
+
+    for (;;)
+    {
+        bool haveOld = inRange(oi);
+        bool haveNew = inRange(ni);
+        if (!haveOld && !haveNew)
+        {
+            break;
+        }
+
+        if (!haveNew)
+        {
+            // Out of new entries, take old entries.
+            maybe_put(cmp, out, oi, shadowIterators);
+            ++oi;
+        }
+        else if (!haveOld)
+        {
+            // Out of old entries, take new entries.
+            maybe_put(cmp, out, ni, shadowIterators);
+            ++ni;
+        }
+        else if (cmp(*oi, *ni))
+        {
+            // Next old-entry has smaller key, take it.
+            maybe_put(cmp, out, oi, shadowIterators);
+            ++oi;
+        }
+        else if (cmp(*ni, *oi))
+        {
+            // Next new-entry has smaller key, take it.
+            maybe_put(cmp, out, ni, shadowIterators);
+            ++ni;
+        }
+        else
+        {
+            // Old and new are for the same key, take new.
+            maybe_put(cmp, out, ni, shadowIterators);
+            ++oi;
+            ++ni;
+        }
+    }
+}
+
 std::shared_ptr<Bucket>
 Bucket::merge(BucketManager& bucketManager,
               std::shared_ptr<Bucket> const& oldBucket,
@@ -392,41 +586,349 @@ Bucket::merge(BucketManager& bucketManager,
     Bucket::OutputIterator out(bucketManager.getTmpDir(), keepDeadEntries);
 
     BucketEntryIdCmp cmp;
-    while (oi || ni)
+    mergeRange(cmp, oi, ni, shadowIterators, out, nullptr);
+    return out.getBucket(bucketManager);
+}
+
+static size_t
+bucketFileSize(Bucket const& bucket)
+{
+    if (bucket.getFilename().empty())
     {
-        if (!ni)
+        return 0;
+    }
+    MappedFile file;
+    file.open(bucket.getFilename());
+    return file.size();
+}
+
+std::shared_ptr<Bucket>
+Bucket::merge(Application& app, std::shared_ptr<Bucket> const& oldBucket,
+              std::shared_ptr<Bucket> const& newBucket,
+              std::vector<std::shared_ptr<Bucket>> const& shadows,
+              bool keepDeadEntries)
+{
+    auto& bucketManager = app.getBucketManager();
+    size_t partitionSize = app.getConfig().BUCKET_MERGE_PARTITION_SIZE;
+    if (partitionSize != 0)
+    {
+        size_t bytes = bucketFileSize(*oldBucket) + bucketFileSize(*newBucket);
+        size_t partitions = std::min<size_t>(
+            bytes / partitionSize, std::thread::hardware_concurrency());
+        if (partitions > 1)
         {
-            // Out of new entries, take old entries.
-            maybe_put(cmp, out, oi, shadowIterators);
-            ++oi;
+            return mergePartitioned(app, oldBucket, newBucket, shadows,
+                                    keepDeadEntries, partitions);
         }
-        else if (!oi)
+    }
+    return merge(bucketManager, oldBucket, newBucket, shadows,
+                 keepDeadEntries);
+}
+
+// Offsets of every SAMPLE_INTERVAL-th entry of a bucket (or of the pages of
+// its index, if it has one), starting with the first one; used to find where
+// a key range starts without decoding the whole bucket.
+static size_t const SAMPLE_INTERVAL = 64;
+
+static std::vector<size_t>
+sampleEntryOffsets(Bucket const& bucket)
+{
+    std::vector<size_t> res;
+    if (bucket.getFilename().empty())
+    {
+        return res;
+    }
+    if (bucket.getIndex())
+    {
+        auto const& pages = bucket.getIndex()->getPageOffsets();
+        return std::vector<size_t>(pages.begin(), pages.end());
+    }
+    XDRInputMappedStream in;
+    in.open(bucket.getFilename());
+    for (size_t i = 0; in; ++i)
+    {
+        if (i % SAMPLE_INTERVAL == 0)
         {
-            // Out of old entries, take new entries.
-            maybe_put(cmp, out, ni, shadowIterators);
-            ++ni;
+            res.push_back(in.getPos());
         }
-        else if (cmp(*oi, *ni))
+        if (!in.skipOne())
         {
-            // Next old-entry has smaller key, take it.
-            maybe_put(cmp, out, oi, shadowIterators);
-            ++oi;
+            break;
         }
-        else if (cmp(*ni, *oi))
+    }
+    return res;
+}
+
+// Offset of the first entry of `bucket` not ordered before `key`.
+static size_t
+lowerBoundOffset(std::shared_ptr<Bucket> const& bucket,
+                 std::vector<size_t> const& samples, BucketEntry const& key)
+{
+    BucketEntryIdCmp cmp;
+    Bucket::InputIterator iter(bucket);
+    if (samples.empty())
+    {
+        return iter.getPos();
+    }
+
+    // find the first sample not ordered before `key`; the entry sought is
+    // between the one before it and it.
+    size_t lo = 0, hi = samples.size();
+    while (lo < hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        iter.seek(samples[mid]);
+        if (cmp(*iter, key))
         {
-            // Next new-entry has smaller key, take it.
-            maybe_put(cmp, out, ni, shadowIterators);
-            ++ni;
+            lo = mid + 1;
         }
         else
         {
-            // Old and new are for the same key, take new.
-            maybe_put(cmp, out, ni, shadowIterators);
-            ++oi;
-            ++ni;
+            hi = mid;
         }
     }
-    return out.getBucket(bucketManager);
+    iter.seek(samples[lo == 0 ? 0 : lo - 1]);
+    while (iter && cmp(*iter, key))
+    {
+        ++iter;
+    }
+    return iter.getPos();
+}
+
+namespace
+{
+// Everything the partitions of a merge need, shared by the tasks merging
+// them: a worker may only pick its task up after the merge has completed.
+struct PartitionedMerge
+{
+    std::shared_ptr<Bucket> mOld;
+    std::shared_ptr<Bucket> mNew;
+    std::vector<std::shared_ptr<Bucket>> mShadows;
+    bool mKeepDeadEntries;
+    std::string mTmpDir;
+
+    // Partition i holds the keys from mSplits[i-1] (included) to mSplits[i]
+    // (excluded); the first and last ones are unbounded below and above.
+    std::vector<BucketEntry> mSplits;
+
+    // Offset at which each partition starts in each input, indexed by
+    // partition then by input: old, new, then the shadows.
+    std::vector<std::vector<size_t>> mStarts;
+
+    std::vector<std::unique_ptr<Bucket::OutputIterator>> mOutputs;
+
+    std::atomic<size_t> mNext{0};
+    std::mutex mMutex;
+    std::condition_variable mCond;
+    size_t mDone{0};
+    std::exception_ptr mError;
+
+    size_t
+    size() const
+    {
+        return mSplits.size() + 1;
+    }
+
+    void mergePartition(size_t i);
+    void run();
+};
+
+void
+PartitionedMerge::mergePartition(size_t i)
+{
+    auto const& starts = mStarts[i];
+    Bucket::InputIterator oi(mOld);
+    oi.seek(starts[0]);
+    Bucket::InputIterator ni(mNew);
+    ni.seek(starts[1]);
+    std::vector<Bucket::InputIterator> shadowIterators(mShadows.begin(),
+                                                       mShadows.end());
+    for (size_t j = 0; j < shadowIterators.size(); ++j)
+    {
+        shadowIterators[j].seek(starts[2 + j]);
+    }
+
+    auto out = make_unique<Bucket::OutputIterator>(mTmpDir, mKeepDeadEntries,
+                                                   false);
+    BucketEntryIdCmp cmp;
+    mergeRange(cmp, oi, ni, shadowIterators, *out,
+               i < mSplits.size() ? &mSplits[i] : nullptr);
+    out->close();
+    mOutputs[i] = std::move(out);
+}
+
+void
+PartitionedMerge::run()
+{
+    auto const total = size();
+    for (;;)
+    {
+        size_t i = mNext.fetch_add(1);
+        if (i >= total)
+        {
+            return;
+        }
+        try
+        {
+            mergePartition(i);
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> guard(mMutex);
+            mError = std::current_exception();
+        }
+
+        std::lock_guard<std::mutex> guard(mMutex);
+        if (++mDone == total)
+        {
+            mCond.notify_all();
+        }
+    }
+}
+}
+
+std::shared_ptr<Bucket>
+Bucket::mergePartitioned(Application& app,
+                         std::shared_ptr<Bucket> const& oldBucket,
+                         std::shared_ptr<Bucket> const& newBucket,
+                         std::vector<std::shared_ptr<Bucket>> const& shadows,
+                         bool keepDeadEntries, size_t partitions)
+{
+    assert(oldBucket);
+    assert(newBucket);
+    assert(partitions > 0);
+
+    auto& bucketManager = app.getBucketManager();
+    auto timer = bucketManager.getMergeTimer().TimeScope();
+
+    auto state = std::make_shared<PartitionedMerge>();
+    state->mOld = oldBucket;
+    state->mNew = newBucket;
+    state->mShadows = shadows;
+    state->mKeepDeadEntries = keepDeadEntries;
+    state->mTmpDir = bucketManager.getTmpDir();
+
+    std::vector<std::shared_ptr<Bucket>> inputs{oldBucket, newBucket};
+    inputs.insert(inputs.end(), shadows.begin(), shadows.end());
+    std::vector<std::vector<size_t>> samples;
+    for (auto const& b : inputs)
+    {
+        samples.emplace_back(sampleEntryOffsets(*b));
+    }
+
+    // Split the larger of the two inputs in ranges of about the same size in
+    // bytes, at sampled entries.
+    size_t larger = bucketFileSize(*oldBucket) >= bucketFileSize(*newBucket)
+                        ? 0
+                        : 1;
+    {
+        Bucket::InputIterator iter(inputs[larger]);
+        size_t bytes = bucketFileSize(*inputs[larger]);
+        size_t prev = 0;
+        auto const& offsets = samples[larger];
+        for (size_t p = 1; p < partitions; ++p)
+        {
+            auto target = bytes / partitions * p;
+            auto it = std::lower_bound(offsets.begin(), offsets.end(), target);
+            if (it == offsets.end())
+            {
+                break;
+            }
+            if (*it == prev)
+            {
+                continue;
+            }
+            prev = *it;
+            iter.seek(*it);
+            state->mSplits.emplace_back(*iter);
+        }
+    }
+
+    state->mStarts.resize(state->size());
+    for (size_t i = 0; i < state->size(); ++i)
+    {
+        for (size_t j = 0; j < inputs.size(); ++j)
+        {
+            state->mStarts[i].push_back(
+                i == 0 ? 0 : lowerBoundOffset(inputs[j], samples[j],
+                                              state->mSplits[i - 1]));
+        }
+    }
+    state->mOutputs.resize(state->size());
+
+    app.getMetrics()
+        .NewMeter({"bucket", "merge", "partition"}, "partition")
+        .Mark(state->size());
+    size_t helpers = std::min<size_t>(state->size() - 1,
+                                      std::thread::hardware_concurrency());
+    for (size_t i = 0; i < helpers; ++i)
+    {
+        app.getWorkerIOService().post([state]() { state->run(); });
+    }
+
+    // partitions not picked up by a worker yet are merged here
+    state->run();
+    {
+        std::unique_lock<std::mutex> lock(state->mMutex);
+        state->mCond.wait(lock,
+                          [&state]() { return state->mDone == state->size(); });
+    }
+
+    CLOG(DEBUG, "Bucket") << "Merged curr=" << hexAbbrev(oldBucket->getHash())
+                          << " with snap=" << hexAbbrev(newBucket->getHash())
+                          << " in " << state->size() << " partitions";
+
+    // Concatenate the partial outputs, in key order, into the bucket file.
+    std::string filename = randomBucketName(bucketManager.getTmpDir());
+    auto hasher = SHA256::create();
+    BucketIndex::Builder index;
+    size_t objectsPut = 0;
+    size_t bytesPut = 0;
+    {
+        std::ofstream out;
+        if (!state->mError)
+        {
+            out.open(filename, std::ofstream::binary | std::ofstream::trunc);
+        }
+        for (auto const& part : state->mOutputs)
+        {
+            if (!part)
+            {
+                continue;
+            }
+            if (!state->mError && part->getBytesPut() != 0)
+            {
+                MappedFile in;
+                in.open(part->getFilename());
+                hasher->add(ByteSlice(in.data(), in.size()));
+                out.write(in.data(), in.size());
+                index.append(std::move(part->getIndexBuilder()), bytesPut);
+                objectsPut += part->getObjectsPut();
+                bytesPut += part->getBytesPut();
+            }
+            std::remove(part->getFilename().c_str());
+        }
+        if (state->mError)
+        {
+            std::rethrow_exception(state->mError);
+        }
+        out.close();
+        if (!out)
+        {
+            throw std::runtime_error("failed to write bucket file: " +
+                                     filename);
+        }
+    }
+
+    if (objectsPut == 0)
+    {
+        CLOG(DEBUG, "Bucket") << "Deleting empty bucket file " << filename;
+        std::remove(filename.c_str());
+        return std::make_shared<Bucket>();
+    }
+    return bucketManager.adoptFileAsBucket(filename, hasher->finish(),
+                                           objectsPut, bytesPut,
+                                           index.finish());
 }
 
 static void
@@ -455,59 +957,47 @@ checkDBAgainstBuckets(medida::MetricsRegistry& metrics,
     auto execTimer =
         metrics.NewTimer({"bucket", "checkdb", "execute"}).TimeScope();
 
-    // Step 1: Collect all buckets to merge.
+    // Step 1: Collect all buckets, newest first. Pending merges need not be
+    // resolved: their inputs are still in the list.
     std::vector<std::shared_ptr<Bucket>> buckets;
     for (size_t i = 0; i < BucketList::kNumLevels; ++i)
     {
-        CLOG(INFO, "Bucket") << "CheckDB collecting buckets from level " << i;
         auto& level = bl.getLevel(i);
-        auto& next = level.getNext();
-        if (next.isLive())
-        {
-            CLOG(INFO, "Bucket") << "CheckDB resolving future bucket on level "
-                                 << i;
-            buckets.push_back(next.resolve());
-        }
         buckets.push_back(level.getCurr());
         buckets.push_back(level.getSnap());
     }
 
-    if (buckets.empty())
-    {
-        CLOG(INFO, "Bucket") << "CheckDB found no buckets, returning";
-        return;
-    }
-
-    // Step 2: merge all buckets into a single super-bucket.
-    auto i = buckets.begin();
-    assert(i != buckets.end());
-    std::shared_ptr<Bucket> superBucket = *i;
-    while (++i != buckets.end())
-    {
-        auto mergeTimer =
-            metrics.NewTimer({"bucket", "checkdb", "merge"}).TimeScope();
-        assert(superBucket);
-        assert(*i);
-        superBucket = Bucket::merge(bucketManager, *i, superBucket);
-        assert(superBucket);
-    }
-
     CLOG(INFO, "Bucket") << "CheckDB starting object comparison";
 
-    // Step 3: scan the superbucket, checking each object against the DB and
-    // counting objects along the way.
+    // Step 2: scan the buckets, checking each object not shadowed by a newer
+    // bucket (as found by their indexes, rather than by merging all buckets
+    // together) against the DB and counting objects along the way.
     uint64_t nAccounts = 0, nTrustLines = 0, nOffers = 0, nData = 0;
     {
         auto& meter = metrics.NewMeter({"bucket", "checkdb", "object-compare"},
                                        "comparison");
         auto compareTimer =
             metrics.NewTimer({"bucket", "checkdb", "compare"}).TimeScope();
-        for (Bucket::InputIterator iter(superBucket); iter; ++iter)
+        BucketEntry newer;
+        for (size_t b = 0; b < buckets.size(); ++b)
         {
-            meter.Mark();
-            auto& e = *iter;
-            if (e.type() == LIVEENTRY)
+            for (Bucket::InputIterator iter(buckets[b]); iter; ++iter)
             {
+                auto& e = *iter;
+                if (e.type() != LIVEENTRY)
+                {
+                    continue;
+                }
+                auto key = LedgerEntryKey(e.liveEntry());
+                if (std::any_of(buckets.begin(), buckets.begin() + b,
+                                [&](std::shared_ptr<Bucket> const& n) {
+                                    return n->getEntry(key, newer);
+                                }))
+                {
+                    continue;
+                }
+
+                meter.Mark();
                 switch (e.liveEntry().data.type())
                 {
                 case ACCOUNT:
@@ -537,7 +1027,7 @@ checkDBAgainstBuckets(medida::MetricsRegistry& metrics,
         }
     }
 
-    // Step 4: confirm size of datasets matches size of datasets in DB.
+    // Step 3: confirm size of datasets matches size of datasets in DB.
     soci::session& sess = db.getSession();
     compareSizes("account", AccountFrame::countObjects(sess), nAccounts);
     compareSizes("trustline", TrustFrame::countObjects(sess), nTrustLines);
@@ -27,6 +27,8 @@ namespace stellar
  * merged in sorted order, and all elements are hashed while being added.
  */
 
+class Application;
+class BucketIndex;
 class BucketManager;
 class BucketList;
 class Database;
@@ -37,6 +39,7 @@ class Bucket : public std::enable_shared_from_this<Bucket>,
 
     std::string const mFilename;
     Hash const mHash;
+    std::shared_ptr<BucketIndex const> const mIndex;
     bool mRetain{false};
 
   public:
@@ -52,18 +55,27 @@ class Bucket : public std::enable_shared_from_this<Bucket>,
     // filename is the empty string.
     Bucket();
 
-    // Destroy a bucket, deleting its underlying file if the bucket is not
-    // 'retained'. See `setRetain`.
+    // Destroy a bucket, deleting its underlying file (and that of its index)
+    // if the bucket is not 'retained'. See `setRetain`.
     ~Bucket();
 
-    // Construct a bucket with a given filename and hash. Asserts that the file
-    // exists, but does not check that the hash is the bucket's hash. Caller
-    // needs to ensure that.
-    Bucket(std::string const& filename, Hash const& hash);
+    // Construct a bucket with a given filename, hash and index. Asserts that
+    // the file exists, but does not check that the hash is the bucket's hash,
+    // or the index that of the file. Caller needs to ensure that.
+    Bucket(std::string const& filename, Hash const& hash,
+           std::shared_ptr<BucketIndex const> index = nullptr);
 
     Hash const& getHash() const;
     std::string const& getFilename() const;
 
+    // Index of the bucket file, if it has one: buckets handed out by the
+    // BucketManager do, except the empty bucket.
+    std::shared_ptr<BucketIndex const> const&
+    getIndex() const
+    {
+        return mIndex;
+    }
+
     // Sets or clears the `retain` flag on the bucket. A retained bucket will
     // not be deleted (from the filesystem) when the Bucket object is deleted. A
     // non-retained bucket _will_ delete the underlying file. Buckets should
@@ -76,6 +88,11 @@ class Bucket : public std::enable_shared_from_this<Bucket>,
     // BucketEntry exists in the bucket. For testing.
     bool containsBucketIdentity(BucketEntry const& id) const;
 
+    // Looks `key` up using the index of the bucket: returns true and sets
+    // `entry` to the (live or dead) entry for `key` if there is one. Buckets
+    // without an index hold no entry.
+    bool getEntry(LedgerKey const& key, BucketEntry& entry) const;
+
     // Return the count of live and dead BucketEntries in the bucket. For
     // testing.
     std::pair<size_t, size_t> countLiveAndDeadEntries() const;
@@ -105,6 +122,27 @@ class Bucket : public std::enable_shared_from_this<Bucket>,
           std::vector<std::shared_ptr<Bucket>> const& shadows =
               std::vector<std::shared_ptr<Bucket>>(),
           bool keepDeadEntries = true);
+
+    // Same as above, but inputs larger than Config::BUCKET_MERGE_PARTITION_SIZE
+    // are merged with mergePartitioned, using as many partitions as there are
+    // worker threads.
+    static std::shared_ptr<Bucket>
+    merge(Application& app, std::shared_ptr<Bucket> const& oldBucket,
+          std::shared_ptr<Bucket> const& newBucket,
+          std::vector<std::shared_ptr<Bucket>> const& shadows,
+          bool keepDeadEntries);
+
+    // Merge two buckets like `merge`, but split the key space into (at most)
+    // `partitions` ranges holding about as many bytes of the larger input
+    // each. The ranges are merged concurrently, by the calling thread and by
+    // tasks posted to the worker threads, and their outputs are concatenated
+    // and hashed in key order: the resulting bucket is identical to the one
+    // `merge` produces.
+    static std::shared_ptr<Bucket>
+    mergePartitioned(Application& app, std::shared_ptr<Bucket> const& oldBucket,
+                     std::shared_ptr<Bucket> const& newBucket,
+                     std::vector<std::shared_ptr<Bucket>> const& shadows,
+                     bool keepDeadEntries, size_t partitions);
 };
 
 void checkDBAgainstBuckets(medida::MetricsRegistry& metrics,
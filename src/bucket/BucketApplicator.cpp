@@ -5,15 +5,23 @@
 #include "util/asio.h"
 #include "bucket/BucketApplicator.h"
 #include "bucket/Bucket.h"
+#include "ledger/AccountFrame.h"
+#include "ledger/DataFrame.h"
 #include "ledger/LedgerDelta.h"
+#include "ledger/OfferFrame.h"
+#include "ledger/TrustFrame.h"
 #include "util/Logging.h"
 
 namespace stellar
 {
 
+// entries written per SQL transaction in bulk-load mode
+static size_t const BULK_BATCH_SIZE = 0x2000;
+
 BucketApplicator::BucketApplicator(Database& db,
-                                   std::shared_ptr<const Bucket> bucket)
-    : mDb(db), mBucket(bucket)
+                                   std::shared_ptr<const Bucket> bucket,
+                                   bool bulkLoad)
+    : mDb(db), mBucket(bucket), mBulkLoad(bulkLoad)
 {
     if (!bucket->getFilename().empty())
     {
@@ -29,6 +37,12 @@ BucketApplicator::operator bool() const
 void
 BucketApplicator::advance()
 {
+    if (mBulkLoad)
+    {
+        advanceBulk();
+        return;
+    }
+
     soci::transaction sqlTx(mDb.getSession());
     BucketEntry entry;
     while (mIn && mIn.readOne(entry))
@@ -60,4 +74,73 @@ BucketApplicator::advance()
                              << " entries";
     }
 }
+
+void
+BucketApplicator::advanceBulk()
+{
+    // Entries of a bucket have distinct keys, so each batch can delete every
+    // row it replaces (possibly left by a bucket applied earlier) and then
+    // insert the live entries, one table at a time.
+    size_t const nTypes = DATA + 1;
+    std::vector<std::vector<LedgerKey>> keys(nTypes);
+    std::vector<std::vector<LedgerEntry>> live(nTypes);
+
+    BucketEntry entry;
+    size_t n = 0;
+    while (n < BULK_BATCH_SIZE && mIn && mIn.readOne(entry))
+    {
+        if (entry.type() == LIVEENTRY)
+        {
+            auto type = entry.liveEntry().data.type();
+            keys[type].emplace_back(LedgerEntryKey(entry.liveEntry()));
+            live[type].emplace_back(std::move(entry.liveEntry()));
+        }
+        else
+        {
+            keys[entry.deadEntry().type()].emplace_back(
+                std::move(entry.deadEntry()));
+        }
+        ++n;
+    }
+
+    soci::transaction sqlTx(mDb.getSession());
+    AccountFrame::bulkDelete(mDb, keys[ACCOUNT]);
+    AccountFrame::bulkInsert(mDb, live[ACCOUNT]);
+    TrustFrame::bulkDelete(mDb, keys[TRUSTLINE]);
+    TrustFrame::bulkInsert(mDb, live[TRUSTLINE]);
+    OfferFrame::bulkDelete(mDb, keys[OFFER]);
+    OfferFrame::bulkInsert(mDb, live[OFFER]);
+    DataFrame::bulkDelete(mDb, keys[DATA]);
+    DataFrame::bulkInsert(mDb, live[DATA]);
+    sqlTx.commit();
+
+    auto before = mSize;
+    mSize += n;
+    if (!mIn || (before >> 16) != (mSize >> 16))
+    {
+        CLOG(INFO, "Bucket") << "Bucket-apply: bulk-loaded " << mSize
+                             << " entries";
+    }
+}
+
+void
+BucketApplicator::beginBulkLoad(Database& db)
+{
+    CLOG(INFO, "Bucket") << "Bucket-apply: dropping indexes for bulk load";
+    AccountFrame::dropIndexes(db);
+    OfferFrame::dropIndexes(db);
+    db.getEntryCache().clear();
+    db.getOrderBook().clear();
+}
+
+void
+BucketApplicator::endBulkLoad(Database& db)
+{
+    CLOG(INFO, "Bucket") << "Bucket-apply: rebuilding indexes after bulk load";
+    AccountFrame::createIndexes(db);
+    OfferFrame::createIndexes(db);
+    db.getEntryCache().clear();
+    db.getOrderBook().clear();
+    db.clearPreparedStatementCache();
+}
 }
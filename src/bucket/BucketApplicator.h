@@ -17,17 +17,32 @@ class Database;
 // Class that represents a single apply-bucket-to-database operation in
 // progress. Used during history catchup to split up the task of applying
 // bucket into scheduler-friendly, bite-sized pieces.
+//
+// In bulk-load mode, entries are written in large batches through
+// BulkInserter (multi-row INSERTs, COPY on PostgreSQL) after deleting any row
+// they replace, without going through the entry frames: neither the entry
+// cache nor the order book are kept up to date, so callers must bracket the
+// whole load with beginBulkLoad and endBulkLoad.
 
 class BucketApplicator
 {
     Database& mDb;
     std::shared_ptr<const Bucket> mBucket;
-    XDRInputFileStream mIn;
+    XDRInputMappedStream mIn;
     size_t mSize{0};
+    bool const mBulkLoad;
+
+    void advanceBulk();
 
   public:
-    BucketApplicator(Database& db, std::shared_ptr<const Bucket> bucket);
+    BucketApplicator(Database& db, std::shared_ptr<const Bucket> bucket,
+                     bool bulkLoad = false);
     operator bool() const;
     void advance();
+
+    // Drop the secondary indexes of the ledger tables and forget cached
+    // entries before a bulk load; rebuild them after it.
+    static void beginBulkLoad(Database& db);
+    static void endBulkLoad(Database& db);
 };
 }
@@ -0,0 +1,299 @@
+// Copyright 2017 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "bucket/BucketIndex.h"
+#include "bucket/LedgerCmp.h"
+#include "ledger/EntryFrame.h"
+#include "util/Logging.h"
+#include "util/XDRStream.h"
+#include "xdrpp/marshal.h"
+#include <algorithm>
+#include <cassert>
+#include <cereal/archives/binary.hpp>
+#include <cereal/cereal.hpp>
+#include <cereal/types/vector.hpp>
+#include <fstream>
+
+namespace stellar
+{
+
+size_t const BucketIndex::PAGE_SIZE = 16384;
+size_t const BucketIndex::BLOOM_BITS_PER_KEY = 10;
+size_t const BucketIndex::BLOOM_PROBES = 7;
+
+static uint32_t const INDEX_FILE_VERSION = 2;
+
+static LedgerKey
+bucketEntryKey(BucketEntry const& e)
+{
+    return e.type() == LIVEENTRY ? LedgerEntryKey(e.liveEntry())
+                                 : e.deadEntry();
+}
+
+// whether `key` is ordered before the key of `e`, and conversely
+static bool
+keyBefore(LedgerKey const& key, BucketEntry const& e)
+{
+    LedgerEntryIdCmp cmp;
+    return e.type() == LIVEENTRY ? cmp(key, e.liveEntry())
+                                 : cmp(key, e.deadEntry());
+}
+
+static bool
+entryBefore(BucketEntry const& e, LedgerKey const& key)
+{
+    LedgerEntryIdCmp cmp;
+    return e.type() == LIVEENTRY ? cmp(e.liveEntry(), key)
+                                 : cmp(e.deadEntry(), key);
+}
+
+// splitmix64 finalizer, spreading the bits of the FNV hash
+static uint64_t
+mix(uint64_t h)
+{
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebULL;
+    h ^= h >> 31;
+    return h;
+}
+
+uint64_t
+BucketIndex::hashKey(LedgerKey const& key, std::vector<uint8_t>& buf)
+{
+    // The filter is saved, so the hash must not depend on the process (as
+    // std::hash or shortHash may): FNV-1a over the XDR of the key.
+    auto sz = xdr::xdr_size(key);
+    if (buf.size() < sz)
+    {
+        buf.resize(sz);
+    }
+    xdr::xdr_put p(buf.data(), buf.data() + sz);
+    xdr::xdr_argpack_archive(p, key);
+
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < sz; ++i)
+    {
+        h ^= buf[i];
+        h *= 0x100000001b3ULL;
+    }
+    return mix(h);
+}
+
+// Calls `f` with the bits of a filter of `nBits` bits to set, or check, for
+// a key hashing to `h`, using double hashing.
+template <typename F>
+static bool
+forEachProbe(uint64_t h, size_t nBits, F f)
+{
+    uint64_t h1 = h;
+    uint64_t h2 = mix(h ^ 0x9e3779b97f4a7c15ULL) | 1;
+    for (size_t i = 0; i < BucketIndex::BLOOM_PROBES; ++i)
+    {
+        if (!f((h1 + i * h2) % nBits))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void
+BucketIndex::Builder::add(BucketEntry const& e, size_t offset)
+{
+    auto key = bucketEntryKey(e);
+    mKeyHashes.emplace_back(hashKey(key, mBuf));
+    if (mPageOffsets.empty() || offset >= mPageOffsets.back() + PAGE_SIZE)
+    {
+        mPageKeys.emplace_back(key);
+        mPageOffsets.emplace_back(offset);
+    }
+    mLastKey = std::move(key);
+}
+
+void
+BucketIndex::Builder::append(Builder&& other, size_t offset)
+{
+    mKeyHashes.insert(mKeyHashes.end(), other.mKeyHashes.begin(),
+                      other.mKeyHashes.end());
+    for (size_t i = 0; i < other.mPageKeys.size(); ++i)
+    {
+        mPageKeys.emplace_back(std::move(other.mPageKeys[i]));
+        mPageOffsets.emplace_back(other.mPageOffsets[i] + offset);
+    }
+    if (!other.mKeyHashes.empty())
+    {
+        mLastKey = std::move(other.mLastKey);
+    }
+    other = Builder();
+}
+
+std::shared_ptr<BucketIndex const>
+BucketIndex::Builder::finish()
+{
+    size_t nBits = std::max<size_t>(mKeyHashes.size() * BLOOM_BITS_PER_KEY, 1);
+    std::vector<uint64_t> bloom((nBits + 63) / 64, 0);
+    nBits = bloom.size() * 64;
+    for (auto h : mKeyHashes)
+    {
+        forEachProbe(h, nBits, [&bloom](uint64_t bit) {
+            bloom[bit / 64] |= 1ULL << (bit % 64);
+            return true;
+        });
+    }
+    mKeyHashes.clear();
+    return std::make_shared<BucketIndex>(std::move(bloom), std::move(mPageKeys),
+                                         std::move(mPageOffsets), mLastKey);
+}
+
+BucketIndex::BucketIndex(std::vector<uint64_t>&& bloom,
+                         std::vector<LedgerKey>&& keys,
+                         std::vector<uint64_t>&& offsets,
+                         LedgerKey const& lastKey)
+    : mBloom(std::move(bloom))
+    , mPageKeys(std::move(keys))
+    , mPageOffsets(std::move(offsets))
+    , mLastKey(lastKey)
+{
+    assert(!mBloom.empty());
+    assert(mPageKeys.size() == mPageOffsets.size());
+}
+
+std::shared_ptr<BucketIndex const>
+BucketIndex::build(std::string const& bucketFilename)
+{
+    CLOG(DEBUG, "Bucket") << "Building index of " << bucketFilename;
+    Builder builder;
+    XDRInputMappedStream in;
+    in.open(bucketFilename);
+    BucketEntry e;
+    for (size_t pos = in.getPos(); in.readOne(e); pos = in.getPos())
+    {
+        builder.add(e, pos);
+    }
+    return builder.finish();
+}
+
+std::string
+BucketIndex::indexFilename(std::string const& bucketFilename)
+{
+    return bucketFilename + ".index";
+}
+
+void
+BucketIndex::save(std::string const& filename) const
+{
+    std::vector<std::vector<uint8_t>> keys;
+    keys.reserve(mPageKeys.size() + 1);
+    for (auto const& k : mPageKeys)
+    {
+        auto opaque = xdr::xdr_to_opaque(k);
+        keys.emplace_back(opaque.begin(), opaque.end());
+    }
+    auto lastKey = xdr::xdr_to_opaque(mLastKey);
+    keys.emplace_back(lastKey.begin(), lastKey.end());
+
+    std::ofstream out(filename, std::ofstream::binary | std::ofstream::trunc);
+    {
+        cereal::BinaryOutputArchive ar(out);
+        ar(INDEX_FILE_VERSION, mBloom, mPageOffsets, keys);
+    }
+    out.close();
+    if (!out)
+    {
+        throw std::runtime_error("failed to write bucket index: " + filename);
+    }
+}
+
+std::shared_ptr<BucketIndex const>
+BucketIndex::load(std::string const& filename)
+{
+    std::ifstream in(filename, std::ifstream::binary);
+    if (!in)
+    {
+        return nullptr;
+    }
+    try
+    {
+        uint32_t version;
+        std::vector<uint64_t> bloom;
+        std::vector<uint64_t> offsets;
+        std::vector<std::vector<uint8_t>> keys;
+        {
+            cereal::BinaryInputArchive ar(in);
+            ar(version, bloom, offsets, keys);
+        }
+        // the keys of the pages are followed by the last key
+        if (version != INDEX_FILE_VERSION || bloom.empty() ||
+            keys.size() != offsets.size() + 1)
+        {
+            CLOG(WARNING, "Bucket") << "Ignoring bucket index " << filename
+                                    << " of unexpected format";
+            return nullptr;
+        }
+
+        std::vector<LedgerKey> pageKeys(offsets.size());
+        for (size_t i = 0; i < pageKeys.size(); ++i)
+        {
+            xdr::xdr_from_opaque(keys[i], pageKeys[i]);
+        }
+        LedgerKey lastKey;
+        xdr::xdr_from_opaque(keys.back(), lastKey);
+        return std::make_shared<BucketIndex>(std::move(bloom),
+                                             std::move(pageKeys),
+                                             std::move(offsets), lastKey);
+    }
+    catch (std::exception& e)
+    {
+        CLOG(WARNING, "Bucket") << "Ignoring unreadable bucket index "
+                                << filename << ": " << e.what();
+        return nullptr;
+    }
+}
+
+bool
+BucketIndex::mayContain(LedgerKey const& key) const
+{
+    std::vector<uint8_t> buf;
+    auto const& bloom = mBloom;
+    return forEachProbe(hashKey(key, buf), bloom.size() * 64,
+                        [&bloom](uint64_t bit) {
+                            return (bloom[bit / 64] >> (bit % 64)) & 1;
+                        });
+}
+
+bool
+BucketIndex::getPageOffset(LedgerKey const& key, size_t& offset) const
+{
+    LedgerEntryIdCmp cmp;
+    // first page starting after `key`
+    auto it = std::upper_bound(mPageKeys.begin(), mPageKeys.end(), key, cmp);
+    if (it == mPageKeys.begin())
+    {
+        return false;
+    }
+    offset = mPageOffsets[std::distance(mPageKeys.begin(), it) - 1];
+    return true;
+}
+
+size_t
+BucketIndex::getPage(BucketEntry const& e, size_t from) const
+{
+    if (from + 1 >= mPageKeys.size() || entryBefore(e, mPageKeys[from + 1]))
+    {
+        return from;
+    }
+    // first page starting after `e`
+    auto it = std::upper_bound(mPageKeys.begin() + from + 2, mPageKeys.end(),
+                               e, entryBefore);
+    return std::distance(mPageKeys.begin(), it) - 1;
+}
+
+bool
+BucketIndex::isAfterLastKey(BucketEntry const& e) const
+{
+    return keyBefore(mLastKey, e);
+}
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+// Copyright 2017 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "overlay/StellarXDR.h"
+#include "util/NonCopyable.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace stellar
+{
+
+/**
+ * BucketIndex answers "where, if anywhere, is the entry for key K" for the
+ * file of a bucket without reading through it. It holds:
+ *
+ *   - a bloom filter over the LedgerKeys of the bucket, which rules out most
+ *     keys that are not in it;
+ *   - a sparse index of the file: the key and offset of the first entry of
+ *     each page of about PAGE_SIZE bytes. Entries being sorted, the entry for
+ *     a key can only be in the last page starting at or before it;
+ *   - the key of the last entry, so that together with the key of the first
+ *     page, the key range of the bucket is known.
+ *
+ * An index is built while the bucket file is written (see Builder) or by
+ * scanning an existing file, and saved next to the bucket file (see
+ * indexFilename) so it does not need to be rebuilt on restart. Like buckets,
+ * indexes are immutable once built and can be shared between threads.
+ */
+class BucketIndex : public NonMovableOrCopyable
+{
+  public:
+    // bytes of bucket file per entry of the sparse index
+    static size_t const PAGE_SIZE;
+    // bits of bloom filter per key, and probes per lookup: about 1% of keys
+    // not in the bucket get past the filter
+    static size_t const BLOOM_BITS_PER_KEY;
+    static size_t const BLOOM_PROBES;
+
+    class Builder
+    {
+        std::vector<uint64_t> mKeyHashes;
+        std::vector<LedgerKey> mPageKeys;
+        std::vector<uint64_t> mPageOffsets;
+        LedgerKey mLastKey;
+        std::vector<uint8_t> mBuf;
+
+      public:
+        // Adds `e`, written at `offset` in the bucket file. Entries must be
+        // added in file order.
+        void add(BucketEntry const& e, size_t offset);
+
+        // Adds the entries added to `other`, which were written to a file
+        // appended to this one at `offset`.
+        void append(Builder&& other, size_t offset);
+
+        std::shared_ptr<BucketIndex const> finish();
+    };
+
+    // Builds the index of an existing bucket file.
+    static std::shared_ptr<BucketIndex const>
+    build(std::string const& bucketFilename);
+
+    // Loads the index saved at `filename`, or returns nullptr if there is none
+    // or it can't be read.
+    static std::shared_ptr<BucketIndex const>
+    load(std::string const& filename);
+
+    // Where the index of the bucket file `bucketFilename` is saved.
+    static std::string indexFilename(std::string const& bucketFilename);
+
+    void save(std::string const& filename) const;
+
+    // False if `key` is certainly not in the bucket.
+    bool mayContain(LedgerKey const& key) const;
+
+    // Offset in the bucket file of the page that holds the entry for `key`,
+    // if it is in the bucket at all; false if `key` is before the first entry.
+    bool getPageOffset(LedgerKey const& key, size_t& offset) const;
+
+    // Last page starting at or before the key of `e`, or `from` if it is not
+    // after page `from`. Cheap when `e` is in page `from`, which makes it
+    // suitable to follow an iteration through the file.
+    size_t getPage(BucketEntry const& e, size_t from) const;
+
+    // True if every entry of the bucket is ordered before `e`.
+    bool isAfterLastKey(BucketEntry const& e) const;
+
+    size_t
+    getPageCount() const
+    {
+        return mPageOffsets.size();
+    }
+
+    // Offsets in the bucket file of the pages, in file order.
+    std::vector<uint64_t> const&
+    getPageOffsets() const
+    {
+        return mPageOffsets;
+    }
+
+    BucketIndex(std::vector<uint64_t>&& bloom, std::vector<LedgerKey>&& keys,
+                std::vector<uint64_t>&& offsets, LedgerKey const& lastKey);
+
+  private:
+    std::vector<uint64_t> mBloom;
+    std::vector<LedgerKey> mPageKeys;
+    std::vector<uint64_t> mPageOffsets;
+    LedgerKey mLastKey;
+
+    static uint64_t hashKey(LedgerKey const& key, std::vector<uint8_t>& buf);
+};
+}
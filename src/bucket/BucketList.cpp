@@ -182,6 +182,20 @@ BucketList::getHash() const
     return hsh->finish();
 }
 
+bool
+BucketList::getEntry(LedgerKey const& key, BucketEntry& entry) const
+{
+    for (auto const& lev : mLevels)
+    {
+        if (lev.getCurr()->getEntry(key, entry) ||
+            lev.getSnap()->getEntry(key, entry))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
 bool
 BucketList::levelShouldSpill(uint32_t ledger, size_t level)
 {
@@ -205,8 +219,17 @@ void
 BucketList::addBatch(Application& app, uint32_t currLedger,
                      std::vector<LedgerEntry> const& liveEntries,
                      std::vector<LedgerKey> const& deadEntries)
+{
+    addBatch(app, currLedger,
+             Bucket::fresh(app.getBucketManager(), liveEntries, deadEntries));
+}
+
+void
+BucketList::addBatch(Application& app, uint32_t currLedger,
+                     std::shared_ptr<Bucket> fresh)
 {
     assert(currLedger > 0);
+    assert(fresh);
 
     std::vector<std::shared_ptr<Bucket>> shadows;
     for (auto& level : mLevels)
@@ -291,9 +314,7 @@ BucketList::addBatch(Application& app, uint32_t currLedger,
     }
 
     assert(shadows.size() == 0);
-    mLevels[0].prepare(app, currLedger, Bucket::fresh(app.getBucketManager(),
-                                                      liveEntries, deadEntries),
-                       shadows);
+    mLevels[0].prepare(app, currLedger, fresh, shadows);
     mLevels[0].commit();
 }
 
@@ -294,6 +294,11 @@ class BucketList
     // of the concatenation of the hashes of the `curr` and `snap` buckets.
     Hash getHash() const;
 
+    // Looks `key` up in the buckets of the list, newest first, using their
+    // indexes: returns true and sets `entry` to the most recent (live or dead)
+    // entry for `key` if there is one.
+    bool getEntry(LedgerKey const& key, BucketEntry& entry) const;
+
     // Restart any merges that might be running on background worker threads,
     // merging buckets between levels. This needs to be called after forcing a
     // BucketList to adopt a new state, either at application restart or when
@@ -308,5 +313,9 @@ class BucketList
     void addBatch(Application& app, uint32_t currLedger,
                   std::vector<LedgerEntry> const& liveEntries,
                   std::vector<LedgerKey> const& deadEntries);
+
+    // Same, with the entries already made into a bucket by Bucket::fresh.
+    void addBatch(Application& app, uint32_t currLedger,
+                  std::shared_ptr<Bucket> fresh);
 };
 }
@@ -15,6 +15,7 @@ namespace stellar
 {
 
 class Application;
+class BucketIndex;
 class BucketList;
 struct LedgerHeader;
 struct HistoryArchiveState;
@@ -64,12 +65,16 @@ class BucketManager : NonMovableOrCopyable
     // otherwise move `filename` to the bucket directory, stored under `hash`,
     // and return a new bucket pointing to that.
     //
+    // The index of the new bucket, if `index` is not given, is built by
+    // reading `filename`; it is saved next to the bucket in any case.
+    //
     // This method is mostly-threadsafe -- assuming you don't destruct the
     // BucketManager mid-call -- and is intended to be called from both main and
     // worker threads. Very carefully.
     virtual std::shared_ptr<Bucket>
     adoptFileAsBucket(std::string const& filename, uint256 const& hash,
-                      size_t nObjects = 0, size_t nBytes = 0) = 0;
+                      size_t nObjects = 0, size_t nBytes = 0,
+                      std::shared_ptr<BucketIndex const> index = nullptr) = 0;
 
     // Return a bucket by hash if we have it, else return nullptr.
     virtual std::shared_ptr<Bucket> getBucketByHash(uint256 const& hash) = 0;
@@ -85,6 +90,19 @@ class BucketManager : NonMovableOrCopyable
                           std::vector<LedgerEntry> const& liveEntries,
                           std::vector<LedgerKey> const& deadEntries) = 0;
 
+    // Same as addBatch, in two steps so that the caller can get on with other
+    // work while the bucket of the new entries is sorted, written and hashed
+    // on a worker thread: prepareBatch starts that, and addPreparedBatch adds
+    // the result to the bucket list, waiting for it (or doing it on the
+    // calling thread, if no worker got to it yet) as needed. At most one batch
+    // is prepared at a time: prepareBatch drops any batch not added yet. The
+    // entries are taken by value, so that the vectors built for the batch are
+    // moved to the worker rather than copied.
+    virtual void prepareBatch(Application& app, uint32_t currLedger,
+                              std::vector<LedgerEntry> liveEntries,
+                              std::vector<LedgerKey> deadEntries) = 0;
+    virtual void addPreparedBatch(Application& app, uint32_t currLedger) = 0;
+
     // Update the given LedgerHeader's bucketListHash to reflect the current
     // state of the bucket list.
     virtual void snapshotLedger(LedgerHeader& currentHeader) = 0;
@@ -3,6 +3,8 @@
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
 #include "bucket/BucketManagerImpl.h"
+#include "bucket/Bucket.h"
+#include "bucket/BucketIndex.h"
 #include "bucket/BucketList.h"
 #include "crypto/Hex.h"
 #include "history/HistoryManager.h"
@@ -14,7 +16,9 @@
 #include "util/TmpDir.h"
 #include "util/make_unique.h"
 #include "util/types.h"
+#include <atomic>
 #include <fstream>
+#include <future>
 #include <map>
 #include <set>
 
@@ -61,6 +65,7 @@ BucketManagerImpl::BucketManagerImpl(Application& app)
     , mBucketByteInsert(
           app.getMetrics().NewMeter({"bucket", "byte", "insert"}, "byte"))
     , mBucketAddBatch(app.getMetrics().NewTimer({"bucket", "batch", "add"}))
+    , mBucketBatchWait(app.getMetrics().NewTimer({"bucket", "batch", "wait"}))
     , mBucketSnapMerge(app.getMetrics().NewTimer({"bucket", "snap", "merge"}))
     , mSharedBucketsSize(
           app.getMetrics().NewCounter({"bucket", "memory", "shared"}))
@@ -147,12 +152,29 @@ BucketManagerImpl::getMergeTimer()
 std::shared_ptr<Bucket>
 BucketManagerImpl::adoptFileAsBucket(std::string const& filename,
                                      uint256 const& hash, size_t nObjects,
-                                     size_t nBytes)
+                                     size_t nBytes,
+                                     std::shared_ptr<BucketIndex const> index)
 {
+    // a file adopted without an index is scanned before taking the lock, so
+    // that other bucket lookups don't wait for it
+    if (!index)
+    {
+        index = BucketIndex::build(filename);
+    }
+
     std::lock_guard<std::recursive_mutex> lock(mBucketMutex);
     // Check to see if we have an existing bucket (either in-memory or on-disk)
-    std::shared_ptr<Bucket> b = getBucketByHash(hash);
-    if (b)
+    auto i = mSharedBuckets.find(hash);
+    if (i != mSharedBuckets.end())
+    {
+        CLOG(DEBUG, "Bucket") << "Deleting bucket file " << filename
+                              << " that is redundant with existing bucket";
+        std::remove(filename.c_str());
+        return i->second;
+    }
+
+    std::string canonicalName = bucketFilename(hash);
+    if (fs::exists(canonicalName))
     {
         CLOG(DEBUG, "Bucket") << "Deleting bucket file " << filename
                               << " that is redundant with existing bucket";
@@ -162,7 +184,6 @@ BucketManagerImpl::adoptFileAsBucket(std::string const& filename,
     {
         mBucketObjectInsert.Mark(nObjects);
         mBucketByteInsert.Mark(nBytes);
-        std::string canonicalName = bucketFilename(hash);
         CLOG(DEBUG, "Bucket") << "Adopting bucket file " << filename << " as "
                               << canonicalName;
         if (rename(filename.c_str(), canonicalName.c_str()) != 0)
@@ -171,45 +192,69 @@ BucketManagerImpl::adoptFileAsBucket(std::string const& filename,
             err += strerror(errno);
             throw std::runtime_error(err);
         }
-
-        b = std::make_shared<Bucket>(canonicalName, hash);
-        {
-            mSharedBuckets.insert(std::make_pair(hash, b));
-            mSharedBucketsSize.set_count(mSharedBuckets.size());
-        }
     }
-    assert(b);
+    // same contents either way, so the same index
+    index->save(BucketIndex::indexFilename(canonicalName));
+
+    auto b = std::make_shared<Bucket>(canonicalName, hash, index);
+    mSharedBuckets.insert(std::make_pair(hash, b));
+    mSharedBucketsSize.set_count(mSharedBuckets.size());
     return b;
 }
 
 std::shared_ptr<Bucket>
 BucketManagerImpl::getBucketByHash(uint256 const& hash)
 {
-    std::lock_guard<std::recursive_mutex> lock(mBucketMutex);
     if (isZero(hash))
     {
         return std::make_shared<Bucket>();
     }
+    std::string canonicalName = bucketFilename(hash);
+    {
+        std::lock_guard<std::recursive_mutex> lock(mBucketMutex);
+        auto i = mSharedBuckets.find(hash);
+        if (i != mSharedBuckets.end())
+        {
+            CLOG(TRACE, "Bucket") << "BucketManager::getBucketByHash("
+                                  << binToHex(hash) << ") found bucket "
+                                  << i->second->getFilename();
+            return i->second;
+        }
+        if (!fs::exists(canonicalName))
+        {
+            return std::shared_ptr<Bucket>();
+        }
+    }
+
+    // Bucket files are immutable and only deleted once forgotten, so the
+    // index can be loaded, or built by scanning the file, without holding
+    // the lock.
+    CLOG(TRACE, "Bucket") << "BucketManager::getBucketByHash("
+                          << binToHex(hash)
+                          << ") found no bucket, making new one";
+    auto indexName = BucketIndex::indexFilename(canonicalName);
+    auto index = BucketIndex::load(indexName);
+    bool built = !index;
+    if (built)
+    {
+        index = BucketIndex::build(canonicalName);
+    }
+
+    std::lock_guard<std::recursive_mutex> lock(mBucketMutex);
+    // another thread may have made the bucket in the meantime
     auto i = mSharedBuckets.find(hash);
     if (i != mSharedBuckets.end())
     {
-        CLOG(TRACE, "Bucket") << "BucketManager::getBucketByHash("
-                              << binToHex(hash) << ") found bucket "
-                              << i->second->getFilename();
         return i->second;
     }
-    std::string canonicalName = bucketFilename(hash);
-    if (fs::exists(canonicalName))
+    if (built)
     {
-        CLOG(TRACE, "Bucket") << "BucketManager::getBucketByHash("
-                              << binToHex(hash)
-                              << ") found no bucket, making new one";
-        auto p = std::make_shared<Bucket>(canonicalName, hash);
-        mSharedBuckets.insert(std::make_pair(hash, p));
-        mSharedBucketsSize.set_count(mSharedBuckets.size());
-        return p;
+        index->save(indexName);
     }
-    return std::shared_ptr<Bucket>();
+    auto p = std::make_shared<Bucket>(canonicalName, hash, index);
+    mSharedBuckets.insert(std::make_pair(hash, p));
+    mSharedBucketsSize.set_count(mSharedBuckets.size());
+    return p;
 }
 
 void
@@ -285,6 +330,66 @@ BucketManagerImpl::addBatch(Application& app, uint32_t currLedger,
     mBucketList.addBatch(app, currLedger, liveEntries, deadEntries);
 }
 
+// Bucket::fresh for a batch, run by whichever of a worker thread or
+// addPreparedBatch gets to it first.
+struct BucketManagerImpl::PreparedBatch
+{
+    uint32_t mLedger;
+    std::atomic<bool> mStarted{false};
+    std::packaged_task<std::shared_ptr<Bucket>()> mTask;
+    std::future<std::shared_ptr<Bucket>> mBucket;
+
+    void
+    run()
+    {
+        if (!mStarted.exchange(true))
+        {
+            mTask();
+        }
+    }
+};
+
+void
+BucketManagerImpl::prepareBatch(Application& app, uint32_t currLedger,
+                                std::vector<LedgerEntry> liveEntries,
+                                std::vector<LedgerKey> deadEntries)
+{
+    // a batch prepared by a ledger close that failed half-way is dropped
+    auto live =
+        std::make_shared<std::vector<LedgerEntry>>(std::move(liveEntries));
+    auto dead =
+        std::make_shared<std::vector<LedgerKey>>(std::move(deadEntries));
+    auto batch = std::make_shared<PreparedBatch>();
+    batch->mLedger = currLedger;
+    batch->mTask = std::packaged_task<std::shared_ptr<Bucket>()>(
+        [&app, live, dead]() {
+            return Bucket::fresh(app.getBucketManager(), *live, *dead);
+        });
+    batch->mBucket = batch->mTask.get_future();
+
+    mPreparedBatch = batch;
+    app.getWorkerIOService().post([batch]() { batch->run(); });
+}
+
+void
+BucketManagerImpl::addPreparedBatch(Application& app, uint32_t currLedger)
+{
+    assert(mPreparedBatch);
+    assert(mPreparedBatch->mLedger == currLedger);
+
+    auto timer = mBucketAddBatch.TimeScope();
+    auto batch = std::move(mPreparedBatch);
+
+    std::shared_ptr<Bucket> fresh;
+    {
+        auto waitTimer = mBucketBatchWait.TimeScope();
+        batch->run();
+        // rethrows whatever Bucket::fresh threw
+        fresh = batch->mBucket.get();
+    }
+    mBucketList.addBatch(app, currLedger, fresh);
+}
+
 // updates the given LedgerHeader to reflect the current state of the bucket
 // list
 void
@@ -356,6 +461,15 @@ BucketManagerImpl::assumeState(HistoryArchiveState const& has)
 void
 BucketManagerImpl::shutdown()
 {
+    // a batch prepared but never added only needs to be finished, so that no
+    // worker is left writing into the bucket directory
+    if (mPreparedBatch)
+    {
+        mPreparedBatch->run();
+        mPreparedBatch->mBucket.wait();
+        mPreparedBatch.reset();
+    }
+
     // forgetUnreferencedBuckets does what we want - it retains needed buckets
     forgetUnreferencedBuckets();
 }
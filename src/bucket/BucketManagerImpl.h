@@ -42,9 +42,14 @@ class BucketManagerImpl : public BucketManager
     medida::Meter& mBucketObjectInsert;
     medida::Meter& mBucketByteInsert;
     medida::Timer& mBucketAddBatch;
+    medida::Timer& mBucketBatchWait;
     medida::Timer& mBucketSnapMerge;
     medida::Counter& mSharedBucketsSize;
 
+    // bucket of the batch passed to prepareBatch, until addPreparedBatch
+    struct PreparedBatch;
+    std::shared_ptr<PreparedBatch> mPreparedBatch;
+
   protected:
     void calculateSkipValues(LedgerHeader& currentHeader);
     std::string bucketFilename(std::string const& bucketHexHash);
@@ -57,16 +62,20 @@ class BucketManagerImpl : public BucketManager
     std::string const& getBucketDir() override;
     BucketList& getBucketList() override;
     medida::Timer& getMergeTimer() override;
-    std::shared_ptr<Bucket> adoptFileAsBucket(std::string const& filename,
-                                              uint256 const& hash,
-                                              size_t nObjects,
-                                              size_t nBytes) override;
+    std::shared_ptr<Bucket>
+    adoptFileAsBucket(std::string const& filename, uint256 const& hash,
+                      size_t nObjects, size_t nBytes,
+                      std::shared_ptr<BucketIndex const> index) override;
     std::shared_ptr<Bucket> getBucketByHash(uint256 const& hash) override;
 
     void forgetUnreferencedBuckets() override;
     void addBatch(Application& app, uint32_t currLedger,
                   std::vector<LedgerEntry> const& liveEntries,
                   std::vector<LedgerKey> const& deadEntries) override;
+    void prepareBatch(Application& app, uint32_t currLedger,
+                      std::vector<LedgerEntry> liveEntries,
+                      std::vector<LedgerKey> deadEntries) override;
+    void addPreparedBatch(Application& app, uint32_t currLedger) override;
     void snapshotLedger(LedgerHeader& currentHeader) override;
 
     std::vector<std::string>
@@ -8,6 +8,8 @@
 #include "util/asio.h"
 
 #include "bucket/Bucket.h"
+#include "bucket/BucketApplicator.h"
+#include "bucket/BucketIndex.h"
 #include "bucket/BucketList.h"
 #include "bucket/BucketManager.h"
 #include "bucket/BucketManagerImpl.h"
@@ -15,8 +17,13 @@
 #include "crypto/Hex.h"
 #include "database/Database.h"
 #include "herder/LedgerCloseData.h"
+#include "ledger/AccountFrame.h"
+#include "ledger/DataFrame.h"
+#include "ledger/EntryFrame.h"
 #include "ledger/LedgerManager.h"
 #include "ledger/LedgerTestUtils.h"
+#include "ledger/OfferFrame.h"
+#include "ledger/TrustFrame.h"
 #include "lib/catch.hpp"
 #include "main/Application.h"
 #include "medida/meter.h"
@@ -27,10 +34,17 @@
 #include "util/Logging.h"
 #include "util/Timer.h"
 #include "util/TmpDir.h"
+#include "util/XDRStream.h"
 #include "util/types.h"
 #include "xdrpp/autocheck.h"
 #include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <functional>
 #include <future>
+#include <iterator>
+#include <map>
+#include <thread>
 
 using namespace stellar;
 
@@ -222,6 +236,44 @@ TEST_CASE("bucket list", "[bucket]")
     }
 }
 
+TEST_CASE("prepared batches", "[bucket]")
+{
+    VirtualClock clock;
+    Config const& cfg = getTestConfig();
+    Application::pointer app = Application::create(clock, cfg);
+    auto& bm = app->getBucketManager();
+
+    // the bucket manager's list gets prepared batches, `bl` the same batches
+    // added directly
+    BucketList bl;
+    autocheck::generator<std::vector<LedgerKey>> deadGen;
+    for (uint32_t i = 1; i < 70; ++i)
+    {
+        auto live = LedgerTestUtils::generateValidLedgerEntries(8);
+        auto dead = deadGen(5);
+        bm.prepareBatch(*app, i, live, dead);
+        if (i % 2 == 0)
+        {
+            // lets workers get to the batch first
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        bl.addBatch(*app, i, live, dead);
+        bm.addPreparedBatch(*app, i);
+        REQUIRE(bm.getBucketList().getHash() == bl.getHash());
+    }
+
+    SECTION("a batch never added is dropped")
+    {
+        bm.prepareBatch(*app, 70, LedgerTestUtils::generateValidLedgerEntries(8),
+                        {});
+        auto live = LedgerTestUtils::generateValidLedgerEntries(8);
+        bm.prepareBatch(*app, 70, live, {});
+        bl.addBatch(*app, 70, live, {});
+        bm.addPreparedBatch(*app, 70);
+        REQUIRE(bm.getBucketList().getHash() == bl.getHash());
+    }
+}
+
 TEST_CASE("bucket list shadowing", "[bucket]")
 {
     VirtualClock clock;
@@ -432,6 +484,141 @@ TEST_CASE("file-backed buckets", "[bucket][bucketbench]")
     CLOG(DEBUG, "Bucket") << "Spill file size: " << fileSize(b1->getFilename());
 }
 
+// Write `n` entries, cycling through `entries`, to `filename`.
+static void
+writeBucketEntries(std::string const& filename,
+                   std::vector<BucketEntry> const& entries, size_t n)
+{
+    XDROutputFileStream out;
+    out.open(filename);
+    for (size_t i = 0; i < n; ++i)
+    {
+        out.writeOne(entries[i % entries.size()]);
+    }
+    out.close();
+}
+
+template <typename Stream>
+static std::vector<BucketEntry>
+readBucketEntries(std::string const& filename, size_t max)
+{
+    std::vector<BucketEntry> res;
+    Stream in;
+    in.open(filename);
+    BucketEntry e;
+    while (res.size() < max && in && in.readOne(e))
+    {
+        res.push_back(e);
+    }
+    return res;
+}
+
+template <typename Stream>
+static size_t
+countBucketEntries(std::string const& filename)
+{
+    size_t n = 0;
+    Stream in;
+    in.open(filename);
+    BucketEntry e;
+    while (in && in.readOne(e))
+    {
+        ++n;
+    }
+    return n;
+}
+
+static std::vector<BucketEntry>
+generateBucketEntries(size_t n)
+{
+    autocheck::generator<LedgerKey> deadGen;
+    std::vector<BucketEntry> entries(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (i % 10 == 0)
+        {
+            entries[i].type(DEADENTRY);
+            entries[i].deadEntry() = deadGen(3);
+        }
+        else
+        {
+            entries[i].type(LIVEENTRY);
+            entries[i].liveEntry() = LedgerTestUtils::generateValidLedgerEntry(3);
+        }
+    }
+    return entries;
+}
+
+TEST_CASE("mapped and buffered bucket readers agree", "[bucket]")
+{
+    TmpDirManager tdm("bucket-readers");
+    auto dir = tdm.tmpDir("readers");
+    auto filename = dir.getName() + "/entries.xdr";
+
+    auto entries = generateBucketEntries(1000);
+    writeBucketEntries(filename, entries, entries.size());
+
+    using xdr::operator==;
+    auto buffered = readBucketEntries<XDRInputFileStream>(filename, SIZE_MAX);
+    auto mapped = readBucketEntries<XDRInputMappedStream>(filename, SIZE_MAX);
+    REQUIRE(buffered == entries);
+    REQUIRE(mapped == entries);
+
+    SECTION("truncated file")
+    {
+        std::string truncated;
+        {
+            std::ifstream in(filename, std::ifstream::binary);
+            truncated.assign(std::istreambuf_iterator<char>(in),
+                             std::istreambuf_iterator<char>());
+        }
+        truncated.resize(truncated.size() - 3);
+        auto truncatedName = dir.getName() + "/truncated.xdr";
+        {
+            std::ofstream out(truncatedName, std::ofstream::binary);
+            out.write(truncated.data(), truncated.size());
+        }
+        REQUIRE_THROWS_AS(
+            readBucketEntries<XDRInputMappedStream>(truncatedName, SIZE_MAX),
+            xdr::xdr_runtime_error);
+    }
+}
+
+TEST_CASE("bucket reader throughput", "[bucketbench][hide]")
+{
+    TmpDirManager tdm("bucket-readers");
+    auto dir = tdm.tmpDir("throughput");
+    auto filename = dir.getName() + "/entries.xdr";
+
+    // a few GB of entries, from a smaller pool repeated over and over
+    size_t const nEntries = 20000000;
+    writeBucketEntries(filename, generateBucketEntries(10000), nEntries);
+    size_t bytes;
+    {
+        std::ifstream in(filename, std::ifstream::binary | std::ifstream::ate);
+        bytes = static_cast<size_t>(in.tellg());
+    }
+    CLOG(INFO, "Bucket") << "Reading " << nEntries << " entries, " << bytes
+                         << " bytes";
+
+    auto measure = [&](std::string const& name,
+                       std::function<size_t()> readAll) {
+        auto start = std::chrono::steady_clock::now();
+        REQUIRE(readAll() == nEntries);
+        auto secs = std::chrono::duration<double>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+        CLOG(INFO, "Bucket") << name << ": " << secs << "s, "
+                             << (bytes / secs / (1024 * 1024)) << " MB/s";
+    };
+    measure("ifstream", [&]() {
+        return countBucketEntries<XDRInputFileStream>(filename);
+    });
+    measure("mmap", [&]() {
+        return countBucketEntries<XDRInputMappedStream>(filename);
+    });
+}
+
 TEST_CASE("merging bucket entries", "[bucket]")
 {
     VirtualClock clock;
@@ -574,6 +761,390 @@ clearFutures(Application::pointer app, BucketList& bl)
     }
 }
 
+TEST_CASE("partitioned merge matches single-threaded merge", "[bucket]")
+{
+    VirtualClock clock;
+    Config const& cfg = getTestConfig();
+    Application::pointer app = Application::create(clock, cfg);
+    auto& bm = app->getBucketManager();
+
+    auto oldLive = LedgerTestUtils::generateValidLedgerEntries(2000);
+    auto newLive = LedgerTestUtils::generateValidLedgerEntries(500);
+    std::vector<LedgerKey> newDead;
+    std::vector<LedgerEntry> shadowLive;
+    for (size_t i = 0; i < oldLive.size(); ++i)
+    {
+        // every 3rd old entry is deleted, every 5th is shadowed and every 7th
+        // is updated.
+        if (i % 3 == 0)
+        {
+            newDead.push_back(LedgerEntryKey(oldLive[i]));
+        }
+        else if (i % 7 == 0)
+        {
+            newLive.push_back(oldLive[i]);
+            newLive.back().lastModifiedLedgerSeq++;
+        }
+        if (i % 5 == 0)
+        {
+            shadowLive.push_back(oldLive[i]);
+        }
+    }
+
+    auto oldBucket = Bucket::fresh(bm, oldLive, {});
+    auto newBucket = Bucket::fresh(bm, newLive, newDead);
+    std::vector<std::shared_ptr<Bucket>> shadows{
+        Bucket::fresh(bm, shadowLive, {}), std::make_shared<Bucket>()};
+
+    for (bool keepDeadEntries : {true, false})
+    {
+        auto expected =
+            Bucket::merge(bm, oldBucket, newBucket, shadows, keepDeadEntries);
+        for (size_t partitions : {1, 2, 3, 8, 10000})
+        {
+            auto merged = Bucket::mergePartitioned(*app, oldBucket, newBucket,
+                                                   shadows, keepDeadEntries,
+                                                   partitions);
+            REQUIRE(merged->getHash() == expected->getHash());
+        }
+    }
+
+    SECTION("empty inputs")
+    {
+        auto empty = std::make_shared<Bucket>();
+        REQUIRE(Bucket::mergePartitioned(*app, oldBucket, empty, shadows, true,
+                                         4)
+                    ->getHash() ==
+                Bucket::merge(bm, oldBucket, empty, shadows, true)->getHash());
+        REQUIRE(Bucket::mergePartitioned(*app, empty, newBucket, {}, true, 4)
+                    ->getHash() ==
+                Bucket::merge(bm, empty, newBucket, {}, true)->getHash());
+        REQUIRE(isZero(
+            Bucket::mergePartitioned(*app, empty, empty, {}, true, 4)
+                ->getHash()));
+    }
+}
+
+// A bucket of the file of `bucket`, without its index.
+static std::shared_ptr<Bucket>
+withoutIndex(std::shared_ptr<Bucket> const& bucket)
+{
+    auto res =
+        std::make_shared<Bucket>(bucket->getFilename(), bucket->getHash());
+    res->setRetain(true);
+    return res;
+}
+
+static std::vector<LedgerEntry>
+generateAccountLedgerEntries(size_t n)
+{
+    std::vector<LedgerEntry> res(n);
+    auto accounts = LedgerTestUtils::generateValidAccountEntries(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        res[i].data.type(ACCOUNT);
+        res[i].data.account() = accounts[i];
+    }
+    return res;
+}
+
+static std::vector<LedgerEntry>
+generateOfferLedgerEntries(size_t n)
+{
+    std::vector<LedgerEntry> res(n);
+    auto offers = LedgerTestUtils::generateValidOfferEntries(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        res[i].data.type(OFFER);
+        res[i].data.offer() = offers[i];
+    }
+    return res;
+}
+
+TEST_CASE("shadows skipped by index match entry-by-entry shadowing",
+          "[bucket]")
+{
+    VirtualClock clock;
+    Config const& cfg = getTestConfig();
+    Application::pointer app = Application::create(clock, cfg);
+    auto& bm = app->getBucketManager();
+
+    auto oldLive = LedgerTestUtils::generateValidLedgerEntries(5000);
+    auto newLive = LedgerTestUtils::generateValidLedgerEntries(500);
+    std::vector<LedgerKey> newDead;
+    // a large shadow mostly of offers, shadowing every 5th old entry, and a
+    // small one of unrelated entries
+    auto shadowLive = generateOfferLedgerEntries(5000);
+    for (size_t i = 0; i < oldLive.size(); ++i)
+    {
+        if (i % 3 == 0)
+        {
+            newDead.push_back(LedgerEntryKey(oldLive[i]));
+        }
+        if (i % 5 == 0)
+        {
+            shadowLive.push_back(oldLive[i]);
+        }
+    }
+
+    auto oldBucket = Bucket::fresh(bm, oldLive, {});
+    auto newBucket = Bucket::fresh(bm, newLive, newDead);
+    std::vector<std::shared_ptr<Bucket>> shadows{
+        Bucket::fresh(bm, shadowLive, {}),
+        Bucket::fresh(bm, LedgerTestUtils::generateValidLedgerEntries(100), {}),
+        std::make_shared<Bucket>()};
+    std::vector<std::shared_ptr<Bucket>> unindexed;
+    for (auto const& s : shadows)
+    {
+        unindexed.push_back(s->getFilename().empty() ? s : withoutIndex(s));
+    }
+
+    for (bool keepDeadEntries : {true, false})
+    {
+        auto expected = Bucket::merge(bm, oldBucket, newBucket, unindexed,
+                                      keepDeadEntries);
+        auto merged =
+            Bucket::merge(bm, oldBucket, newBucket, shadows, keepDeadEntries);
+        REQUIRE(merged->getHash() == expected->getHash());
+        REQUIRE(Bucket::mergePartitioned(*app, oldBucket, newBucket, shadows,
+                                         keepDeadEntries, 3)
+                    ->getHash() == expected->getHash());
+
+        BucketEntry shadowed;
+        shadowed.type(LIVEENTRY);
+        shadowed.liveEntry() = oldLive[5];
+        REQUIRE(!merged->containsBucketIdentity(shadowed));
+    }
+}
+
+TEST_CASE("merge with shadows throughput", "[bucketbench][hide]")
+{
+    VirtualClock clock;
+    Config const& cfg = getTestConfig();
+    Application::pointer app = Application::create(clock, cfg);
+    auto& bm = app->getBucketManager();
+
+    auto measure = [&](std::string const& name,
+                       std::shared_ptr<Bucket> const& oldBucket,
+                       std::shared_ptr<Bucket> const& newBucket,
+                       std::vector<std::shared_ptr<Bucket>> const& shadows) {
+        std::vector<std::shared_ptr<Bucket>> unindexed;
+        for (auto const& s : shadows)
+        {
+            unindexed.push_back(withoutIndex(s));
+        }
+        for (bool indexed : {false, true})
+        {
+            auto start = std::chrono::steady_clock::now();
+            auto merged = Bucket::merge(bm, oldBucket, newBucket,
+                                        indexed ? shadows : unindexed);
+            auto secs = std::chrono::duration<double>(
+                            std::chrono::steady_clock::now() - start)
+                            .count();
+            CLOG(INFO, "Bucket") << name << (indexed ? ", skipping" : "")
+                                 << ": " << secs << "s, "
+                                 << countEntries(merged) << " entries";
+        }
+    };
+
+    CLOG(DEBUG, "Bucket") << "Generating buckets";
+    auto oldLive = generateOfferLedgerEntries(200000);
+    auto newLive = generateOfferLedgerEntries(50000);
+    auto oldBucket = Bucket::fresh(bm, oldLive, {});
+    auto newBucket = Bucket::fresh(bm, newLive, {});
+
+    // as in the bucket list: shadows shrinking by level, each updating some
+    // of the entries of the merged buckets
+    {
+        std::vector<std::shared_ptr<Bucket>> shadows;
+        for (size_t n = 25000; n >= 100; n /= 4)
+        {
+            auto live = LedgerTestUtils::generateValidLedgerEntries(n / 2);
+            for (size_t i = 0; i < n / 2; ++i)
+            {
+                live.push_back(oldLive[(i * 7919 + n) % oldLive.size()]);
+            }
+            shadows.push_back(Bucket::fresh(bm, live, {}));
+        }
+        measure("shadows shrinking by level", oldBucket, newBucket, shadows);
+    }
+
+    // large shadows barely overlapping the merged buckets: accounts, ordered
+    // before the offers of the merged buckets, but for a few offers
+    {
+        std::vector<std::shared_ptr<Bucket>> shadows;
+        for (size_t i = 0; i < 3; ++i)
+        {
+            auto live = generateAccountLedgerEntries(200000);
+            live.insert(live.end(), oldLive.begin() + i * 100,
+                        oldLive.begin() + (i + 1) * 100);
+            shadows.push_back(Bucket::fresh(bm, live, {}));
+        }
+        measure("large shadows of other entries", oldBucket, newBucket,
+                shadows);
+    }
+}
+
+// Checks every entry of `bucket` can be looked up, and that none of `absent`
+// can.
+static void
+checkBucketLookups(std::shared_ptr<Bucket> const& bucket,
+                   std::vector<LedgerKey> const& absent)
+{
+    using xdr::operator==;
+    BucketEntry found;
+    size_t n = 0;
+    XDRInputFileStream in;
+    in.open(bucket->getFilename());
+    BucketEntry e;
+    while (in && in.readOne(e))
+    {
+        auto key = e.type() == LIVEENTRY ? LedgerEntryKey(e.liveEntry())
+                                         : e.deadEntry();
+        REQUIRE(bucket->getEntry(key, found));
+        REQUIRE(found == e);
+        REQUIRE(bucket->containsBucketIdentity(e));
+        ++n;
+    }
+    REQUIRE(n == countEntries(bucket));
+    for (auto const& key : absent)
+    {
+        REQUIRE(!bucket->getEntry(key, found));
+    }
+}
+
+TEST_CASE("bucket index point lookups", "[bucket][bucketindex]")
+{
+    VirtualClock clock;
+    Config const& cfg = getTestConfig();
+    Application::pointer app = Application::create(clock, cfg);
+    auto& bm = app->getBucketManager();
+
+    // enough entries for the index to have many pages
+    auto live = LedgerTestUtils::generateValidLedgerEntries(5000);
+    std::vector<LedgerKey> dead;
+    std::vector<LedgerKey> absent;
+    for (size_t i = 0; i < live.size(); ++i)
+    {
+        if (i % 10 == 0)
+        {
+            dead.push_back(LedgerEntryKey(live[i]));
+        }
+        else if (i % 10 == 1)
+        {
+            absent.push_back(LedgerEntryKey(live[i]));
+        }
+    }
+    std::vector<LedgerEntry> present;
+    for (size_t i = 0; i < live.size(); ++i)
+    {
+        if (i % 10 > 1)
+        {
+            present.push_back(live[i]);
+        }
+    }
+
+    auto bucket = Bucket::fresh(bm, present, dead);
+    REQUIRE(bucket->getIndex());
+    REQUIRE(bucket->getIndex()->getPageCount() > 1);
+    checkBucketLookups(bucket, absent);
+
+    BucketEntry found;
+    REQUIRE(!std::make_shared<Bucket>()->getEntry(absent[0], found));
+
+    SECTION("index is saved next to the bucket")
+    {
+        auto indexName = BucketIndex::indexFilename(bucket->getFilename());
+        REQUIRE(fs::exists(indexName));
+        auto index = BucketIndex::load(indexName);
+        REQUIRE(index);
+        REQUIRE(index->getPageCount() == bucket->getIndex()->getPageCount());
+
+        auto reloaded = std::make_shared<Bucket>(bucket->getFilename(),
+                                                 bucket->getHash(), index);
+        reloaded->setRetain(true);
+        checkBucketLookups(reloaded, absent);
+    }
+
+    SECTION("missing or unreadable index is rebuilt")
+    {
+        auto indexName = BucketIndex::indexFilename(bucket->getFilename());
+        std::remove(indexName.c_str());
+        REQUIRE(!BucketIndex::load(indexName));
+        {
+            std::ofstream out(indexName);
+            out << "garbage";
+        }
+        REQUIRE(!BucketIndex::load(indexName));
+
+        auto index = BucketIndex::build(bucket->getFilename());
+        REQUIRE(index->getPageCount() == bucket->getIndex()->getPageCount());
+        auto rebuilt = std::make_shared<Bucket>(bucket->getFilename(),
+                                                bucket->getHash(), index);
+        rebuilt->setRetain(true);
+        checkBucketLookups(rebuilt, absent);
+    }
+
+    SECTION("partitioned merge output")
+    {
+        auto newLive = LedgerTestUtils::generateValidLedgerEntries(1000);
+        auto merged = Bucket::mergePartitioned(
+            *app, bucket, Bucket::fresh(bm, newLive, {}), {}, true, 4);
+        checkBucketLookups(merged, absent);
+    }
+}
+
+TEST_CASE("bucket list point lookups", "[bucket][bucketindex]")
+{
+    VirtualClock clock;
+    Config const& cfg = getTestConfig();
+    Application::pointer app = Application::create(clock, cfg);
+
+    BucketList bl;
+    // latest state of every key added, null for deleted ones
+    std::map<LedgerKey, std::shared_ptr<LedgerEntry>> state;
+    std::vector<LedgerEntry> previous;
+    for (uint32_t i = 1; i < 130; ++i)
+    {
+        app->getClock().crank(false);
+        auto live = LedgerTestUtils::generateValidLedgerEntries(8);
+        std::vector<LedgerKey> dead;
+        // update one entry of the previous batch and delete another
+        if (previous.size() > 1)
+        {
+            live.push_back(previous[0]);
+            live.back().lastModifiedLedgerSeq = i;
+            dead.push_back(LedgerEntryKey(previous[1]));
+        }
+        for (auto const& e : live)
+        {
+            state[LedgerEntryKey(e)] = std::make_shared<LedgerEntry>(e);
+        }
+        for (auto const& k : dead)
+        {
+            state[k] = nullptr;
+        }
+        bl.addBatch(*app, i, live, dead);
+        previous = live;
+    }
+
+    using xdr::operator==;
+    BucketEntry found;
+    for (auto const& kv : state)
+    {
+        REQUIRE(bl.getEntry(kv.first, found));
+        if (kv.second)
+        {
+            REQUIRE(found.type() == LIVEENTRY);
+            REQUIRE(found.liveEntry() == *kv.second);
+        }
+        else
+        {
+            REQUIRE(found.type() == DEADENTRY);
+        }
+    }
+}
+
 TEST_CASE("bucketmanager ownership", "[bucket]")
 {
     VirtualClock clock;
@@ -915,7 +1486,98 @@ TEST_CASE("bucket apply", "[bucket]")
     REQUIRE(count == 1);
 }
 
+// Applies the same buckets to one database entry by entry and to another
+// through the bulk loader, and checks that both end up with the same entries.
+static void
+checkBulkLoadMatchesApply(Config::TestDbMode mode)
+{
+    VirtualClock clock;
+    Application::pointer app =
+        Application::create(clock, getTestConfig(0, mode));
+    Application::pointer bulkApp =
+        Application::create(clock, getTestConfig(1, mode));
+    app->start();
+    bulkApp->start();
+
+    auto oldLive = LedgerTestUtils::generateValidLedgerEntries(1000);
+    auto newLive = LedgerTestUtils::generateValidLedgerEntries(200);
+    std::vector<LedgerKey> newDead;
+    std::vector<LedgerEntry> expectedLive = newLive;
+    std::vector<LedgerKey> expectedDead;
+    for (size_t i = 0; i < oldLive.size(); ++i)
+    {
+        auto const& e = oldLive[i];
+        if (i % 3 == 0)
+        {
+            newLive.push_back(e);
+            newLive.back().lastModifiedLedgerSeq++;
+            expectedLive.push_back(newLive.back());
+        }
+        else if (i % 5 == 0)
+        {
+            newDead.push_back(LedgerEntryKey(e));
+            expectedDead.push_back(LedgerEntryKey(e));
+        }
+        else
+        {
+            expectedLive.push_back(e);
+        }
+    }
+
+    auto& bm = app->getBucketManager();
+    std::vector<std::shared_ptr<Bucket>> buckets{
+        Bucket::fresh(bm, oldLive, {}), Bucket::fresh(bm, newLive, newDead)};
+
+    auto& db = app->getDatabase();
+    auto& bulkDb = bulkApp->getDatabase();
+    BucketApplicator::beginBulkLoad(bulkDb);
+    for (auto const& b : buckets)
+    {
+        b->apply(db);
+        BucketApplicator applicator(bulkDb, b, true);
+        while (applicator)
+        {
+            applicator.advance();
+        }
+    }
+    BucketApplicator::endBulkLoad(bulkDb);
+
+    for (auto d : {&db, &bulkDb})
+    {
+        for (auto const& e : expectedLive)
+        {
+            REQUIRE(EntryFrame::exists(*d, LedgerEntryKey(e)));
+            REQUIRE(EntryFrame::checkAgainstDatabase(e, *d).empty());
+        }
+        for (auto const& k : expectedDead)
+        {
+            REQUIRE(!EntryFrame::exists(*d, k));
+        }
+    }
+    REQUIRE(AccountFrame::countObjects(db.getSession()) ==
+            AccountFrame::countObjects(bulkDb.getSession()));
+    REQUIRE(TrustFrame::countObjects(db.getSession()) ==
+            TrustFrame::countObjects(bulkDb.getSession()));
+    REQUIRE(OfferFrame::countObjects(db.getSession()) ==
+            OfferFrame::countObjects(bulkDb.getSession()));
+    REQUIRE(DataFrame::countObjects(db.getSession()) ==
+            DataFrame::countObjects(bulkDb.getSession()));
+}
+
+TEST_CASE("bucket bulk load", "[bucket]")
+{
+    checkBulkLoadMatchesApply(Config::TESTDB_IN_MEMORY_SQLITE);
+}
+
 #ifdef USE_POSTGRES
+TEST_CASE("bucket bulk load with COPY", "[bucket]")
+{
+    if (!force_sqlite)
+    {
+        checkBulkLoadMatchesApply(Config::TESTDB_POSTGRESQL);
+    }
+}
+
 TEST_CASE("bucket apply bench", "[bucketbench][hide]")
 {
     VirtualClock clock;
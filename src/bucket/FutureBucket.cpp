@@ -280,16 +280,15 @@ FutureBucket::startMerge(Application& app)
                           << hexAbbrev(curr->getHash())
                           << " with snap=" << hexAbbrev(snap->getHash());
 
-    BucketManager& bm = app.getBucketManager();
-
     using task_t = std::packaged_task<std::shared_ptr<Bucket>()>;
     std::shared_ptr<task_t> task =
-        std::make_shared<task_t>([curr, snap, &bm, shadows, keepDeadEntries]() {
+        std::make_shared<task_t>([curr, snap, &app, shadows, keepDeadEntries]() {
             CLOG(TRACE, "Bucket")
                 << "Worker merging curr=" << hexAbbrev(curr->getHash())
                 << " with snap=" << hexAbbrev(snap->getHash());
 
-            auto res = Bucket::merge(bm, curr, snap, shadows, keepDeadEntries);
+            auto res =
+                Bucket::merge(app, curr, snap, shadows, keepDeadEntries);
 
             CLOG(TRACE, "Bucket")
                 << "Worker finished merging curr=" << hexAbbrev(curr->getHash())
@@ -9,6 +9,7 @@
 #include "bucket/BucketManager.h"
 #include "crypto/Hex.h"
 #include "history/HistoryArchive.h"
+#include "history/HistoryManager.h"
 #include "historywork/Progress.h"
 #include "ledger/LedgerManager.h"
 #include "main/Application.h"
@@ -30,6 +31,7 @@ ApplyBucketsWork::ApplyBucketsWork(
     , mApplyState(applyState)
     , mFirstVerified(firstVerified)
     , mApplying(false)
+    , mBulkLoad(false)
     , mLevel(BucketList::kNumLevels - 1)
     , mBucketApplyStart(app.getMetrics().NewMeter(
           {"history", "bucket-apply", "start"}, "event"))
@@ -54,6 +56,25 @@ ApplyBucketsWork::ApplyBucketsWork(
 
 ApplyBucketsWork::~ApplyBucketsWork()
 {
+    if (mBulkLoad)
+    {
+        try
+        {
+            endBulkLoad();
+        }
+        catch (std::exception& e)
+        {
+            CLOG(ERROR, "History")
+                << "ApplyBuckets : failed to rebuild indexes: " << e.what();
+        }
+    }
+}
+
+void
+ApplyBucketsWork::endBulkLoad()
+{
+    mBulkLoad = false;
+    BucketApplicator::endBulkLoad(mApp.getDatabase());
 }
 
 BucketList&
@@ -106,13 +127,22 @@ ApplyBucketsWork::onReset()
 void
 ApplyBucketsWork::onStart()
 {
+    if (!mBulkLoad && !mApplying && mLevel == BucketList::kNumLevels - 1 &&
+        mApp.getLedgerManager().getLastClosedLedgerNum() <=
+            HistoryManager::GENESIS_LEDGER_SEQ)
+    {
+        BucketApplicator::beginBulkLoad(mApp.getDatabase());
+        mBulkLoad = true;
+    }
+
     auto& level = getBucketLevel(mLevel);
     HistoryStateBucket& i = mApplyState.currentBuckets.at(mLevel);
     if (mApplying || i.snap != binToHex(level.getSnap()->getHash()))
     {
         mSnapBucket = getBucket(i.snap);
         mSnapApplicator =
-            make_unique<BucketApplicator>(mApp.getDatabase(), mSnapBucket);
+            make_unique<BucketApplicator>(mApp.getDatabase(), mSnapBucket,
+                                          mBulkLoad);
         CLOG(DEBUG, "History") << "ApplyBuckets : starting level[" << mLevel
                                << "].snap = " << i.snap;
         mApplying = true;
@@ -122,7 +152,8 @@ ApplyBucketsWork::onStart()
     {
         mCurrBucket = getBucket(i.curr);
         mCurrApplicator =
-            make_unique<BucketApplicator>(mApp.getDatabase(), mCurrBucket);
+            make_unique<BucketApplicator>(mApp.getDatabase(), mCurrBucket,
+                                          mBulkLoad);
         CLOG(DEBUG, "History") << "ApplyBuckets : starting level[" << mLevel
                                << "].curr = " << i.curr;
         mApplying = true;
@@ -182,6 +213,11 @@ ApplyBucketsWork::onSuccess()
         return WORK_PENDING;
     }
 
+    if (mBulkLoad)
+    {
+        endBulkLoad();
+    }
+
     CLOG(DEBUG, "History") << "ApplyBuckets : done, restarting merges";
     getBucketList().restartMerges(mApp, mFirstVerified.header.ledgerSeq);
     return WORK_SUCCESS;
@@ -198,6 +234,10 @@ void
 ApplyBucketsWork::onFailureRaise()
 {
     mBucketApplyFailure.Mark();
+    if (mBulkLoad)
+    {
+        endBulkLoad();
+    }
     Work::onFailureRaise();
 }
 }
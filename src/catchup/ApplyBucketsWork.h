@@ -28,6 +28,9 @@ class ApplyBucketsWork : public Work
     LedgerHeaderHistoryEntry const& mFirstVerified;
 
     bool mApplying;
+    // whether buckets are bulk-loaded into a database that held nothing but
+    // the genesis ledger; see BucketApplicator.
+    bool mBulkLoad;
     size_t mLevel;
     std::shared_ptr<Bucket> mSnapBucket;
     std::shared_ptr<Bucket> mCurrBucket;
@@ -41,6 +44,7 @@ class ApplyBucketsWork : public Work
     std::shared_ptr<Bucket> getBucket(std::string const& bucketHash);
     BucketLevel& getBucketLevel(size_t level);
     BucketList& getBucketList();
+    void endBulkLoad();
 
   public:
     ApplyBucketsWork(Application& app, WorkParent& parent,
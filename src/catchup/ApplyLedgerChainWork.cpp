@@ -82,11 +82,11 @@ ApplyLedgerChainWork::openCurrentInputFiles()
     FileTransferInfo hi(mDownloadDir, HISTORY_FILE_TYPE_LEDGER, mCurrSeq);
     FileTransferInfo ti(mDownloadDir, HISTORY_FILE_TYPE_TRANSACTIONS, mCurrSeq);
     CLOG(DEBUG, "History") << "Replaying ledger headers from "
-                           << hi.localPath_nogz();
+                           << hi.localPath_gz();
     CLOG(DEBUG, "History") << "Replaying transactions from "
-                           << ti.localPath_nogz();
-    mHdrIn.open(hi.localPath_nogz());
-    mTxIn.open(ti.localPath_nogz());
+                           << ti.localPath_gz();
+    mHdrIn.open(hi.localPath_gz());
+    mTxIn.open(ti.localPath_gz());
     mTxHistoryEntry = TransactionHistoryEntry();
 }
 
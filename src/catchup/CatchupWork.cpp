@@ -4,8 +4,8 @@
 
 #include "catchup/CatchupWork.h"
 #include "catchup/ApplyBucketsWork.h"
-#include "catchup/ApplyLedgerChainWork.h"
 #include "catchup/CatchupConfiguration.h"
+#include "catchup/DownloadApplyTransactionsWork.h"
 #include "catchup/DownloadBucketsWork.h"
 #include "catchup/VerifyLedgerChainWork.h"
 #include "history/FileTransferInfo.h"
@@ -46,10 +46,6 @@ CatchupWork::getStatus() const
         {
             return mApplyTransactionsWork->getStatus();
         }
-        else if (mDownloadTransactionsWork)
-        {
-            return mDownloadTransactionsWork->getStatus();
-        }
         else if (mApplyBucketsWork)
         {
             return mApplyBucketsWork->getStatus();
@@ -110,7 +106,6 @@ CatchupWork::onReset()
     mGetBucketsHistoryArchiveStateWork.reset();
     mDownloadBucketsWork.reset();
     mApplyBucketsWork.reset();
-    mDownloadTransactionsWork.reset();
     mApplyTransactionsWork.reset();
 
     uint64_t sleepSeconds =
@@ -156,7 +151,7 @@ CatchupWork::downloadLedgers(CheckpointRange const& range)
         << "Catchup downloading ledger chain for checkpointRange ["
         << range.first() << ".." << range.last() << "]";
     mDownloadLedgersWork = addWork<BatchDownloadWork>(
-        range, HISTORY_FILE_TYPE_LEDGER, *mDownloadDir);
+        range, HISTORY_FILE_TYPE_LEDGER, *mDownloadDir, false);
 
     return true;
 }
@@ -239,24 +234,6 @@ CatchupWork::applyBuckets()
     return true;
 }
 
-bool
-CatchupWork::downloadTransactions(CheckpointRange const& range)
-{
-    if (mDownloadTransactionsWork)
-    {
-        assert(mDownloadTransactionsWork->getState() == WORK_SUCCESS);
-        return false;
-    }
-
-    CLOG(INFO, "History") << "Catchup downloading transactions for range ["
-                          << range.first() << ".." << range.last() << "]";
-
-    mDownloadTransactionsWork = addWork<BatchDownloadWork>(
-        range, HISTORY_FILE_TYPE_TRANSACTIONS, *mDownloadDir);
-
-    return true;
-}
-
 bool
 CatchupWork::applyTransactions(LedgerRange const& range)
 {
@@ -266,11 +243,12 @@ CatchupWork::applyTransactions(LedgerRange const& range)
         return false;
     }
 
-    CLOG(INFO, "History") << "Catchup applying transactions for range ["
+    CLOG(INFO, "History") << "Catchup downloading and applying transactions "
+                             "for range ["
                           << range.first() << ".." << range.last() << "]";
 
-    mApplyTransactionsWork =
-        addWork<ApplyLedgerChainWork>(*mDownloadDir, range, mLastApplied);
+    mApplyTransactionsWork = addWork<DownloadApplyTransactionsWork>(
+        *mDownloadDir, range, mLastApplied);
 
     return true;
 }
@@ -344,11 +322,6 @@ CatchupWork::onSuccess()
                               << checkpointRange.first() << " not needed";
     }
 
-    if (downloadTransactions(checkpointRange))
-    {
-        return WORK_PENDING;
-    }
-
     if (applyTransactions(ledgerRange))
     {
         return WORK_PENDING;
@@ -50,7 +50,9 @@ using CatchupRange = std::pair<LedgerRange, bool>;
 //
 // Then, depending on configuration, it can download, verify and apply buckets
 // (as in MINIMAL and RECENT catchups), and then download and apply
-// transactions (as in COMPLETE and RECENT catchups).
+// transactions (as in COMPLETE and RECENT catchups). Transactions are
+// downloaded, verified and applied as a pipeline, a few checkpoints ahead of
+// the one being applied (see DownloadApplyTransactionsWork).
 //
 // After that, catchup is done and node can replay buffered ledgers and take
 // part in consensus protocol.
@@ -117,7 +119,6 @@ class CatchupWork : public BucketDownloadWork
     std::shared_ptr<Work> mGetBucketsHistoryArchiveStateWork;
     std::shared_ptr<Work> mDownloadBucketsWork;
     std::shared_ptr<Work> mApplyBucketsWork;
-    std::shared_ptr<Work> mDownloadTransactionsWork;
     std::shared_ptr<Work> mApplyTransactionsWork;
     LedgerHeaderHistoryEntry mFirstVerified;
     LedgerHeaderHistoryEntry mLastVerified;
@@ -132,7 +133,6 @@ class CatchupWork : public BucketDownloadWork
     bool downloadBucketsHistoryArchiveState(uint32_t atCheckpoint);
     bool downloadBuckets();
     bool applyBuckets();
-    bool downloadTransactions(CheckpointRange const& range);
     bool applyTransactions(LedgerRange const& range);
 };
 }
@@ -0,0 +1,416 @@
+// Copyright 2017 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "catchup/DownloadApplyTransactionsWork.h"
+#include "catchup/ApplyLedgerChainWork.h"
+#include "catchup/CatchupManager.h"
+#include "crypto/Hex.h"
+#include "herder/TxSetFrame.h"
+#include "history/FileTransferInfo.h"
+#include "history/HistoryManager.h"
+#include "historywork/GetAndUnzipRemoteFileWork.h"
+#include "historywork/Progress.h"
+#include "ledger/LedgerManager.h"
+#include "lib/util/format.h"
+#include "main/Application.h"
+#include "util/Fs.h"
+#include "util/Logging.h"
+#include "util/XDRStream.h"
+#include "util/make_unique.h"
+#include <medida/counter.h>
+#include <medida/meter.h>
+#include <medida/metrics_registry.h>
+#include <medida/timer.h>
+
+#include <fstream>
+
+namespace stellar
+{
+
+static size_t
+fileSize(std::string const& filename)
+{
+    std::ifstream in(filename, std::ifstream::binary | std::ifstream::ate);
+    return in ? static_cast<size_t>(in.tellg()) : 0;
+}
+
+DownloadApplyTransactionsWork::DownloadApplyTransactionsWork(
+    Application& app, WorkParent& parent, TmpDir const& downloadDir,
+    LedgerRange range, LedgerHeaderHistoryEntry& lastApplied)
+    : Work(app, parent, "download-apply-transactions")
+    , mDownloadDir(downloadDir)
+    , mRange(range)
+    , mCheckpoints(range, app.getHistoryManager())
+    , mLastApplied(lastApplied)
+    , mNextDownload(mCheckpoints.first())
+    , mNextApply(mCheckpoints.first())
+    , mDownloadCached(app.getMetrics().NewMeter(
+          {"history", "download-transactions", "cached"}, "event"))
+    , mDownloadStart(app.getMetrics().NewMeter(
+          {"history", "download-transactions", "start"}, "event"))
+    , mDownloadSuccess(app.getMetrics().NewMeter(
+          {"history", "download-transactions", "success"}, "event"))
+    , mDownloadFailure(app.getMetrics().NewMeter(
+          {"history", "download-transactions", "failure"}, "event"))
+    , mVerifyTime(app.getMetrics().NewTimer(
+          {"history", "verify-transactions", "checkpoint"}))
+    , mVerifyFailure(app.getMetrics().NewMeter(
+          {"history", "verify-transactions", "failure"}, "event"))
+    , mApplyCheckpoint(app.getMetrics().NewTimer(
+          {"history", "apply-transactions", "checkpoint"}))
+    , mApplyStall(app.getMetrics().NewMeter(
+          {"history", "apply-transactions", "stall"}, "event"))
+    , mLookaheadDownloading(app.getMetrics().NewCounter(
+          {"history", "catchup-lookahead", "downloading"}))
+    , mLookaheadReady(
+          app.getMetrics().NewCounter({"history", "catchup-lookahead", "ready"}))
+    , mLookaheadBytes(
+          app.getMetrics().NewCounter({"history", "catchup-lookahead", "bytes"}))
+{
+}
+
+DownloadApplyTransactionsWork::~DownloadApplyTransactionsWork()
+{
+    mLookaheadDownloading.set_count(0);
+    mLookaheadReady.set_count(0);
+    mLookaheadBytes.set_count(0);
+}
+
+std::string
+DownloadApplyTransactionsWork::getStatus() const
+{
+    if (mState == WORK_PENDING && mNextApply <= mCheckpoints.last())
+    {
+        auto task = fmt::format(
+            "applying transactions ({:d} checkpoints ready, {:d} downloading)",
+            mReady.size(), mDownloading.size());
+        return fmtProgress(mApp, task, mCheckpoints.first(),
+                           mCheckpoints.last(), mNextApply);
+    }
+    return Work::getStatus();
+}
+
+LedgerRange
+DownloadApplyTransactionsWork::checkpointLedgers(uint32_t checkpoint) const
+{
+    auto freq = mCheckpoints.frequency();
+    auto first = checkpoint >= freq ? checkpoint - freq + 1 : 1;
+    return LedgerRange{std::max(first, mRange.first()),
+                       std::min(checkpoint, mRange.last())};
+}
+
+void
+DownloadApplyTransactionsWork::onReset()
+{
+    clearChildren();
+    mDownloading.clear();
+    mReady.clear();
+    mReadyBytes = 0;
+    mApplyWork.reset();
+    mApplyTime.reset();
+    mApplyStalled = false;
+    mVerifyFailed = false;
+
+    // checkpoints applied before a retry need neither downloading nor
+    // applying again
+    mNextDownload = mNextApply;
+
+    CLOG(INFO, "History") << "Downloading and applying transactions for "
+                          << "checkpoints [" << mNextApply << ".."
+                          << mCheckpoints.last() << "], up to "
+                          << mApp.getConfig().CATCHUP_LOOKAHEAD_CHECKPOINTS
+                          << " ahead";
+    pump();
+}
+
+void
+DownloadApplyTransactionsWork::startDownload(uint32_t checkpoint)
+{
+    FileTransferInfo ft(mDownloadDir, HISTORY_FILE_TYPE_TRANSACTIONS,
+                        checkpoint);
+    if (fs::exists(ft.localPath_gz()))
+    {
+        CLOG(DEBUG, "History") << "already have transactions for checkpoint "
+                               << checkpoint;
+        mDownloadCached.Mark();
+        downloaded(checkpoint);
+        return;
+    }
+
+    CLOG(DEBUG, "History") << "Downloading transactions for checkpoint "
+                           << checkpoint;
+    auto getAndUnzip = addWork<GetAndUnzipRemoteFileWork>(ft, false);
+    assert(mDownloading.find(getAndUnzip->getUniqueName()) ==
+           mDownloading.end());
+    mDownloading.insert(
+        std::make_pair(getAndUnzip->getUniqueName(), checkpoint));
+    mDownloadStart.Mark();
+}
+
+bool
+DownloadApplyTransactionsWork::downloaded(uint32_t checkpoint)
+{
+    if (!verifyCheckpoint(checkpoint))
+    {
+        mVerifyFailure.Mark();
+        // so that the retry fetches it again, maybe from another archive
+        FileTransferInfo ft(mDownloadDir, HISTORY_FILE_TYPE_TRANSACTIONS,
+                            checkpoint);
+        std::remove(ft.localPath_gz().c_str());
+        mVerifyFailed = true;
+        scheduleFailure();
+        return false;
+    }
+
+    FileTransferInfo ft(mDownloadDir, HISTORY_FILE_TYPE_TRANSACTIONS,
+                        checkpoint);
+    auto size = fileSize(ft.localPath_gz());
+    mReady.insert(std::make_pair(checkpoint, size));
+    mReadyBytes += size;
+    return true;
+}
+
+bool
+DownloadApplyTransactionsWork::verifyCheckpoint(uint32_t checkpoint)
+{
+    auto timer = mVerifyTime.TimeScope();
+
+    FileTransferInfo hi(mDownloadDir, HISTORY_FILE_TYPE_LEDGER, checkpoint);
+    FileTransferInfo ti(mDownloadDir, HISTORY_FILE_TYPE_TRANSACTIONS,
+                        checkpoint);
+
+    try
+    {
+        std::map<uint32_t, Hash> txSetHashes;
+        XDRInputFileStream hdrIn;
+        hdrIn.open(hi.localPath_gz());
+        LedgerHeaderHistoryEntry header;
+        while (hdrIn && hdrIn.readOne(header))
+        {
+            txSetHashes[header.header.ledgerSeq] =
+                header.header.scpValue.txSetHash;
+        }
+
+        XDRInputFileStream txIn;
+        txIn.open(ti.localPath_gz());
+        TransactionHistoryEntry entry;
+        while (txIn && txIn.readOne(entry))
+        {
+            auto expected = txSetHashes.find(entry.ledgerSeq);
+            if (expected == txSetHashes.end())
+            {
+                CLOG(ERROR, "History") << "Transaction set for ledger "
+                                       << entry.ledgerSeq << " in "
+                                       << ti.localPath_gz()
+                                       << " has no ledger header";
+                return false;
+            }
+            TxSetFrame txSet(mApp.getNetworkID(), entry.txSet);
+            if (txSet.getContentsHash() != expected->second)
+            {
+                CLOG(ERROR, "History")
+                    << "Transaction set for ledger " << entry.ledgerSeq
+                    << " in " << ti.localPath_gz() << " hashes to "
+                    << hexAbbrev(txSet.getContentsHash()) << ", expected "
+                    << hexAbbrev(expected->second);
+                return false;
+            }
+        }
+    }
+    catch (std::runtime_error& e)
+    {
+        CLOG(ERROR, "History") << "Failed reading transactions of checkpoint "
+                               << checkpoint << ": " << e.what();
+        return false;
+    }
+    return true;
+}
+
+void
+DownloadApplyTransactionsWork::startApply()
+{
+    auto range = checkpointLedgers(mNextApply);
+    CLOG(DEBUG, "History") << "Applying transactions for checkpoint "
+                           << mNextApply << ", ledgers [" << range.first()
+                           << ".." << range.last() << "]";
+    mApplyTime = make_unique<medida::TimerContext>(mApplyCheckpoint);
+    mApplyWork =
+        addWork<ApplyLedgerChainWork>(mDownloadDir, range, mLastApplied);
+}
+
+void
+DownloadApplyTransactionsWork::applied()
+{
+    if (mApplyTime)
+    {
+        mApplyTime->Stop();
+        mApplyTime.reset();
+    }
+    mApplyWork.reset();
+
+    auto ready = mReady.find(mNextApply);
+    assert(ready != mReady.end());
+    mReadyBytes -= ready->second;
+    mReady.erase(ready);
+
+    FileTransferInfo hi(mDownloadDir, HISTORY_FILE_TYPE_LEDGER, mNextApply);
+    FileTransferInfo ti(mDownloadDir, HISTORY_FILE_TYPE_TRANSACTIONS,
+                        mNextApply);
+    std::remove(hi.localPath_gz().c_str());
+    std::remove(ti.localPath_gz().c_str());
+
+    mNextApply += mCheckpoints.frequency();
+}
+
+void
+DownloadApplyTransactionsWork::pump()
+{
+    auto const& cfg = mApp.getConfig();
+    auto freq = mCheckpoints.frequency();
+    auto lcl = mApp.getLedgerManager().getLastClosedLedgerNum();
+
+    bool progress = true;
+    while (progress)
+    {
+        progress = false;
+
+        // apply: checkpoints strictly in order, skipping the one LCL may
+        // already be at the end of
+        while (!mApplyWork && mNextApply <= mCheckpoints.last() &&
+               mReady.find(mNextApply) != mReady.end())
+        {
+            progress = true;
+            mApplyStalled = false;
+            if (checkpointLedgers(mNextApply).last() <= lcl)
+            {
+                CLOG(DEBUG, "History") << "Checkpoint " << mNextApply
+                                       << " is already applied";
+                applied();
+            }
+            else
+            {
+                startApply();
+            }
+        }
+
+        // download: within the lookahead window and, except for the
+        // checkpoint the apply stage needs next, under the disk budget
+        while (mNextDownload <= mCheckpoints.last() &&
+               (mNextDownload - mNextApply) / freq <
+                   cfg.CATCHUP_LOOKAHEAD_CHECKPOINTS &&
+               (mNextDownload == mNextApply ||
+                cfg.CATCHUP_LOOKAHEAD_MAX_BYTES == 0 ||
+                mReadyBytes < cfg.CATCHUP_LOOKAHEAD_MAX_BYTES))
+        {
+            progress = true;
+            auto checkpoint = mNextDownload;
+            mNextDownload += freq;
+            startDownload(checkpoint);
+            if (mVerifyFailed)
+            {
+                return;
+            }
+        }
+    }
+
+    if (!mApplyWork && mNextApply <= mCheckpoints.last() && !mApplyStalled)
+    {
+        CLOG(DEBUG, "History") << "Apply waiting for transactions of "
+                               << "checkpoint " << mNextApply;
+        mApplyStall.Mark();
+        mApplyStalled = true;
+    }
+
+    mLookaheadDownloading.set_count(mDownloading.size());
+    mLookaheadReady.set_count(mReady.size());
+    mLookaheadBytes.set_count(mReadyBytes);
+}
+
+void
+DownloadApplyTransactionsWork::notify(std::string const& child)
+{
+    auto i = mChildren.find(child);
+    if (i == mChildren.end())
+    {
+        CLOG(WARNING, "Work")
+            << "DownloadApplyTransactionsWork notified by unknown child "
+            << child;
+        return;
+    }
+
+    bool isDownload = mDownloading.find(child) != mDownloading.end();
+    switch (i->second->getState())
+    {
+    case Work::WORK_SUCCESS:
+        if (isDownload)
+        {
+            mDownloadSuccess.Mark();
+        }
+        break;
+    case Work::WORK_FAILURE_RETRY:
+    case Work::WORK_FAILURE_FATAL:
+    case Work::WORK_FAILURE_RAISE:
+        if (isDownload)
+        {
+            mDownloadFailure.Mark();
+        }
+        break;
+    default:
+        break;
+    }
+
+    std::vector<std::string> done;
+    for (auto const& c : mChildren)
+    {
+        if (c.second->getState() == WORK_SUCCESS)
+        {
+            done.push_back(c.first);
+        }
+    }
+    for (auto const& d : done)
+    {
+        mChildren.erase(d);
+        if (mApplyWork && mApplyWork->getUniqueName() == d)
+        {
+            applied();
+            continue;
+        }
+
+        auto j = mDownloading.find(d);
+        assert(j != mDownloading.end());
+        auto checkpoint = j->second;
+        mDownloading.erase(j);
+        CLOG(DEBUG, "History") << "Finished download of transactions for "
+                               << "checkpoint " << checkpoint;
+        if (!downloaded(checkpoint))
+        {
+            return;
+        }
+    }
+
+    pump();
+    if (mVerifyFailed)
+    {
+        return;
+    }
+    mApp.getCatchupManager().logAndUpdateCatchupStatus(true);
+    advance();
+}
+
+Work::State
+DownloadApplyTransactionsWork::onSuccess()
+{
+    if (mNextApply <= mCheckpoints.last())
+    {
+        // all children done, but checkpoints are left: start the next ones
+        pump();
+        return WORK_PENDING;
+    }
+
+    CLOG(INFO, "History") << "Transactions for checkpoints ["
+                          << mCheckpoints.first() << ".."
+                          << mCheckpoints.last() << "] applied";
+    return WORK_SUCCESS;
+}
+}
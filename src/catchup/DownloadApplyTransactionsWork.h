@@ -0,0 +1,98 @@
+// Copyright 2017 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#pragma once
+
+#include "ledger/CheckpointRange.h"
+#include "ledger/LedgerRange.h"
+#include "work/Work.h"
+#include "xdr/Stellar-ledger.h"
+
+#include <map>
+
+namespace medida
+{
+class Counter;
+class Meter;
+class Timer;
+class TimerContext;
+}
+
+namespace stellar
+{
+
+class TmpDir;
+
+/**
+ * Downloads, verifies and applies the transaction files of a range of
+ * checkpoints as a pipeline: while checkpoint N is applied, the files of the
+ * following checkpoints are downloaded and checked, so that the network, the
+ * CPU and the database are kept busy at the same time.
+ *
+ * Downloads run ahead of the applied checkpoint by at most
+ * CATCHUP_LOOKAHEAD_CHECKPOINTS checkpoints, and stop early while the
+ * downloaded files waiting to be applied take more than
+ * CATCHUP_LOOKAHEAD_MAX_BYTES. A downloaded file is verified by checking that
+ * each of its transaction sets hashes to the value in the (already verified)
+ * ledger header it belongs to; a file that doesn't is deleted and the work
+ * retried. Checkpoints are applied in order, one ApplyLedgerChainWork each,
+ * and their ledger and transaction files are deleted once applied.
+ *
+ * Ledger header files for the whole range must already be in downloadDir.
+ */
+class DownloadApplyTransactionsWork : public Work
+{
+    TmpDir const& mDownloadDir;
+    LedgerRange mRange;
+    CheckpointRange mCheckpoints;
+    LedgerHeaderHistoryEntry& mLastApplied;
+
+    // next checkpoint to download, and next one to apply
+    uint32_t mNextDownload;
+    uint32_t mNextApply;
+
+    // download children by name, and verified checkpoints waiting to be
+    // applied along with the size of their transaction file
+    std::map<std::string, uint32_t> mDownloading;
+    std::map<uint32_t, size_t> mReady;
+    size_t mReadyBytes{0};
+
+    std::shared_ptr<Work> mApplyWork;
+    std::unique_ptr<medida::TimerContext> mApplyTime;
+    bool mApplyStalled{false};
+
+    // set when a downloaded file fails verification, until the retry
+    bool mVerifyFailed{false};
+
+    medida::Meter& mDownloadCached;
+    medida::Meter& mDownloadStart;
+    medida::Meter& mDownloadSuccess;
+    medida::Meter& mDownloadFailure;
+    medida::Timer& mVerifyTime;
+    medida::Meter& mVerifyFailure;
+    medida::Timer& mApplyCheckpoint;
+    medida::Meter& mApplyStall;
+    medida::Counter& mLookaheadDownloading;
+    medida::Counter& mLookaheadReady;
+    medida::Counter& mLookaheadBytes;
+
+    LedgerRange checkpointLedgers(uint32_t checkpoint) const;
+    void startDownload(uint32_t checkpoint);
+    bool downloaded(uint32_t checkpoint);
+    bool verifyCheckpoint(uint32_t checkpoint);
+    void startApply();
+    void applied();
+    void pump();
+
+  public:
+    DownloadApplyTransactionsWork(Application& app, WorkParent& parent,
+                                  TmpDir const& downloadDir, LedgerRange range,
+                                  LedgerHeaderHistoryEntry& lastApplied);
+    ~DownloadApplyTransactionsWork();
+    std::string getStatus() const override;
+    void onReset() override;
+    Work::State onSuccess() override;
+    void notify(std::string const& child) override;
+};
+}
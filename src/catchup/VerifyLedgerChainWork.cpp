@@ -115,13 +115,13 @@ VerifyLedgerChainWork::verifyHistoryOfSingleCheckpoint()
 {
     FileTransferInfo ft(mDownloadDir, HISTORY_FILE_TYPE_LEDGER, mCurrSeq);
     XDRInputFileStream hdrIn;
-    hdrIn.open(ft.localPath_nogz());
+    hdrIn.open(ft.localPath_gz());
 
     LedgerHeaderHistoryEntry prev = mLastVerified;
     LedgerHeaderHistoryEntry curr;
 
     CLOG(DEBUG, "History") << "Verifying ledger headers from "
-                           << ft.localPath_nogz() << " starting from ledger "
+                           << ft.localPath_gz() << " starting from ledger "
                            << LedgerManager::ledgerAbbrev(prev);
 
     while (hdrIn && hdrIn.readOne(curr))
@@ -214,7 +214,24 @@ VerifyLedgerChainWork::onSuccess()
     }
 
     // This is in onSuccess rather than onRun, so we can force a FAILURE_RAISE.
-    switch (verifyHistoryOfSingleCheckpoint())
+    HistoryManager::VerifyHashStatus status;
+    try
+    {
+        status = verifyHistoryOfSingleCheckpoint();
+    }
+    catch (std::runtime_error& e)
+    {
+        // files are read compressed, so a corrupt download shows up here;
+        // remove it so that catchup fetches it again when it retries
+        FileTransferInfo ft(mDownloadDir, HISTORY_FILE_TYPE_LEDGER, mCurrSeq);
+        CLOG(ERROR, "History") << "Failed reading " << ft.localPath_gz()
+                               << ": " << e.what();
+        std::remove(ft.localPath_gz().c_str());
+        mVerifyLedgerChainFailure.Mark();
+        return WORK_FAILURE_RAISE;
+    }
+
+    switch (status)
     {
     case HistoryManager::VERIFY_HASH_OK:
         if (mCurrSeq == mRange.last())
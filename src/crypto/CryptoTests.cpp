@@ -8,6 +8,7 @@
 #include "crypto/SHA.h"
 #include "crypto/SecretKey.h"
 #include "crypto/StrKey.h"
+#include "crypto/VerifySigCache.h"
 #include "lib/catch.hpp"
 #include "test/test.h"
 #include "util/Logging.h"
@@ -153,6 +154,71 @@ TEST_CASE("sign tests", "[crypto]")
     CHECK(!PubKeyUtils::verifySig(pk, sig, msg));
 }
 
+TEST_CASE("verify signature cache", "[crypto]")
+{
+    VerifySigCache cache(1000);
+    // 1000 / 16 shards rounds up to 64 slots per shard
+    REQUIRE(cache.getCapacity() == 64 * VerifySigCache::SHARDS);
+
+    std::vector<Hash> keys;
+    for (int i = 0; i < 500; ++i)
+    {
+        keys.push_back(sha256(std::to_string(i)));
+        cache.put(keys.back(), i % 2 == 0);
+    }
+
+    size_t found = 0;
+    for (size_t i = 0; i < keys.size(); ++i)
+    {
+        bool valid;
+        if (cache.get(keys[i], valid))
+        {
+            REQUIRE(valid == (i % 2 == 0));
+            ++found;
+        }
+    }
+    // windows may overflow before the cache is full, but not by much
+    REQUIRE(found > keys.size() * 9 / 10);
+
+    uint64_t hits = 0, misses = 0;
+    for (auto const& c : cache.flushCounts())
+    {
+        hits += c.mHits;
+        misses += c.mMisses;
+    }
+    REQUIRE(hits == found);
+    REQUIRE(misses == keys.size() - found);
+    for (auto const& c : cache.flushCounts())
+    {
+        REQUIRE(c.mHits == 0);
+        REQUIRE(c.mMisses == 0);
+    }
+
+    SECTION("entries are overwritten")
+    {
+        cache.put(keys[0], false);
+        bool valid = true;
+        REQUIRE(cache.get(keys[0], valid));
+        REQUIRE(!valid);
+    }
+    SECTION("clear")
+    {
+        cache.clear();
+        bool valid;
+        REQUIRE(!cache.get(keys[0], valid));
+    }
+    SECTION("resize")
+    {
+        cache.resize(1000);
+        bool valid;
+        REQUIRE(cache.get(keys[0], valid));
+        cache.resize(10);
+        REQUIRE(cache.getCapacity() ==
+                VerifySigCache::WAYS * VerifySigCache::SHARDS);
+        REQUIRE(!cache.get(keys[0], valid));
+    }
+}
+
 struct SignVerifyTestcase
 {
     SecretKey key;
@@ -7,13 +7,12 @@
 #include "crypto/KeyUtils.h"
 #include "crypto/SHA.h"
 #include "crypto/StrKey.h"
+#include "crypto/VerifySigCache.h"
 #include "main/Config.h"
 #include "transactions/SignatureUtils.h"
 #include "util/HashOfHash.h"
-#include "util/lrucache.hpp"
 #include "util/make_unique.h"
 #include <memory>
-#include <mutex>
 #include <sodium.h>
 #include <type_traits>
 
@@ -27,24 +26,7 @@ namespace stellar
 // makes all signature-verification in the program faster and
 // has no effect on correctness.
 
-static std::mutex gVerifySigCacheMutex;
-static cache::lru_cache<Hash, bool> gVerifySigCache(0xffff);
-static std::unique_ptr<SHA256> gHasher = SHA256::create();
-static uint64_t gVerifyCacheHit = 0;
-static uint64_t gVerifyCacheMiss = 0;
-
-static Hash
-verifySigCacheKey(PublicKey const& key, Signature const& signature,
-                  ByteSlice const& bin)
-{
-    assert(key.type() == PUBLIC_KEY_TYPE_ED25519);
-
-    gHasher->reset();
-    gHasher->add(key.ed25519());
-    gHasher->add(signature);
-    gHasher->add(bin);
-    return gHasher->finish();
-}
+static VerifySigCache gVerifySigCache(0xffff);
 
 SecretKey::SecretKey() : mKeyType(PUBLIC_KEY_TYPE_ED25519)
 {
@@ -198,18 +180,38 @@ SecretKey::fromStrKeySeed(std::string const& strKeySeed)
 void
 PubKeyUtils::clearVerifySigCache()
 {
-    std::lock_guard<std::mutex> guard(gVerifySigCacheMutex);
     gVerifySigCache.clear();
 }
 
+void
+PubKeyUtils::resizeVerifySigCache(size_t capacity)
+{
+    gVerifySigCache.resize(capacity);
+}
+
 void
 PubKeyUtils::flushVerifySigCacheCounts(uint64_t& hits, uint64_t& misses)
 {
-    std::lock_guard<std::mutex> guard(gVerifySigCacheMutex);
-    hits = gVerifyCacheHit;
-    misses = gVerifyCacheMiss;
-    gVerifyCacheHit = 0;
-    gVerifyCacheMiss = 0;
+    hits = 0;
+    misses = 0;
+    for (auto const& c : gVerifySigCache.flushCounts())
+    {
+        hits += c.mHits;
+        misses += c.mMisses;
+    }
+}
+
+void
+PubKeyUtils::flushVerifySigCacheCounts(std::vector<uint64_t>& hits,
+                                       std::vector<uint64_t>& misses)
+{
+    hits.clear();
+    misses.clear();
+    for (auto const& c : gVerifySigCache.flushCounts())
+    {
+        hits.push_back(c.mHits);
+        misses.push_back(c.mMisses);
+    }
 }
 
 std::string
@@ -289,22 +291,16 @@ PubKeyUtils::verifySig(PublicKey const& key, Signature const& signature,
         return false;
     }
 
-    auto cacheKey = verifySigCacheKey(key, signature, bin);
+    auto cacheKey = VerifySigCache::makeKey(key, signature, bin);
 
+    bool ok;
+    if (gVerifySigCache.get(cacheKey, ok))
     {
-        std::lock_guard<std::mutex> guard(gVerifySigCacheMutex);
-        if (gVerifySigCache.exists(cacheKey))
-        {
-            ++gVerifyCacheHit;
-            return gVerifySigCache.get(cacheKey);
-        }
+        return ok;
     }
 
-    ++gVerifyCacheMiss;
-    bool ok =
-        (crypto_sign_verify_detached(signature.data(), bin.data(), bin.size(),
-                                     key.ed25519().data()) == 0);
-    std::lock_guard<std::mutex> guard(gVerifySigCacheMutex);
+    ok = (crypto_sign_verify_detached(signature.data(), bin.data(), bin.size(),
+                                      key.ed25519().data()) == 0);
     gVerifySigCache.put(cacheKey, ok);
     return ok;
 }
@@ -10,6 +10,7 @@
 #include <array>
 #include <functional>
 #include <ostream>
+#include <vector>
 
 namespace stellar
 {
@@ -102,7 +103,12 @@ bool verifySig(PublicKey const& key, Signature const& signature,
                ByteSlice const& bin);
 
 void clearVerifySigCache();
+// Change the number of results the cache can hold; a no-op if unchanged.
+void resizeVerifySigCache(size_t capacity);
+// Return and reset the hit/miss counts, summed or per cache shard.
 void flushVerifySigCacheCounts(uint64_t& hits, uint64_t& misses);
+void flushVerifySigCacheCounts(std::vector<uint64_t>& hits,
+                               std::vector<uint64_t>& misses);
 
 PublicKey random();
 }
@@ -0,0 +1,172 @@
+// Copyright 2017 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "crypto/VerifySigCache.h"
+
+#include <cassert>
+#include <cstring>
+#include <sodium.h>
+#include <stdexcept>
+
+namespace stellar
+{
+
+size_t const VerifySigCache::SHARDS;
+size_t const VerifySigCache::WAYS;
+
+VerifySigCache::VerifySigCache(size_t capacity)
+{
+    resize(capacity);
+}
+
+Hash
+VerifySigCache::makeKey(PublicKey const& key, Signature const& signature,
+                        ByteSlice const& bin)
+{
+    assert(key.type() == PUBLIC_KEY_TYPE_ED25519);
+
+    // hashed in place rather than through SHA256::create(), which allocates
+    crypto_hash_sha256_state state;
+    crypto_hash_sha256_init(&state);
+    crypto_hash_sha256_update(&state, key.ed25519().data(),
+                              key.ed25519().size());
+    crypto_hash_sha256_update(&state, signature.data(), signature.size());
+    crypto_hash_sha256_update(&state, bin.data(), bin.size());
+
+    Hash out;
+    if (crypto_hash_sha256_final(&state, out.data()) != 0)
+    {
+        throw std::runtime_error("error from crypto_hash_sha256_final");
+    }
+    return out;
+}
+
+size_t
+VerifySigCache::slotsPerShard(size_t capacity)
+{
+    size_t wanted = (capacity + SHARDS - 1) / SHARDS;
+    size_t slots = WAYS;
+    while (slots < wanted)
+    {
+        slots <<= 1;
+    }
+    return slots;
+}
+
+VerifySigCache::Shard&
+VerifySigCache::shardFor(Hash const& key, size_t& home)
+{
+    // keys are SHA-256 outputs, so any of their bytes will do: the last one
+    // picks the shard and the first eight the home slot inside it.
+    uint64_t h;
+    std::memcpy(&h, key.data(), sizeof(h));
+    home = static_cast<size_t>(h);
+    return mShards[key[key.size() - 1] % SHARDS];
+}
+
+bool
+VerifySigCache::get(Hash const& key, bool& valid)
+{
+    size_t home;
+    auto& shard = shardFor(key, home);
+    std::lock_guard<std::mutex> guard(shard.mMutex);
+    for (size_t i = 0; i < WAYS; ++i)
+    {
+        auto const& slot = shard.mSlots[(home + i) & shard.mMask];
+        if (slot.mState == SLOT_EMPTY)
+        {
+            // slots are never emptied one at a time, so the key can't be
+            // further along
+            break;
+        }
+        if (slot.mKey == key)
+        {
+            valid = (slot.mState == SLOT_VALID);
+            ++shard.mCounts.mHits;
+            return true;
+        }
+    }
+    ++shard.mCounts.mMisses;
+    return false;
+}
+
+void
+VerifySigCache::put(Hash const& key, bool valid)
+{
+    size_t home;
+    auto& shard = shardFor(key, home);
+    std::lock_guard<std::mutex> guard(shard.mMutex);
+
+    Slot* target = nullptr;
+    for (size_t i = 0; i < WAYS; ++i)
+    {
+        auto& slot = shard.mSlots[(home + i) & shard.mMask];
+        if (slot.mState == SLOT_EMPTY || slot.mKey == key)
+        {
+            target = &slot;
+            break;
+        }
+    }
+    if (!target)
+    {
+        target = &shard.mSlots[(home + shard.mNextVictim) & shard.mMask];
+        shard.mNextVictim = (shard.mNextVictim + 1) % WAYS;
+    }
+    target->mKey = key;
+    target->mState = valid ? SLOT_VALID : SLOT_INVALID;
+}
+
+void
+VerifySigCache::clear()
+{
+    for (auto& shard : mShards)
+    {
+        std::lock_guard<std::mutex> guard(shard.mMutex);
+        for (auto& slot : shard.mSlots)
+        {
+            slot.mState = SLOT_EMPTY;
+        }
+    }
+}
+
+void
+VerifySigCache::resize(size_t capacity)
+{
+    size_t slots = slotsPerShard(capacity);
+    for (auto& shard : mShards)
+    {
+        std::lock_guard<std::mutex> guard(shard.mMutex);
+        if (shard.mSlots.size() == slots)
+        {
+            continue;
+        }
+        shard.mSlots.assign(slots, Slot{Hash{}, SLOT_EMPTY});
+        shard.mSlots.shrink_to_fit();
+        shard.mMask = slots - 1;
+        shard.mNextVictim = 0;
+    }
+}
+
+size_t
+VerifySigCache::getCapacity() const
+{
+    // every shard has the same size
+    std::lock_guard<std::mutex> guard(mShards[0].mMutex);
+    return mShards[0].mSlots.size() * SHARDS;
+}
+
+std::array<VerifySigCache::Counts, VerifySigCache::SHARDS>
+VerifySigCache::flushCounts()
+{
+    std::array<Counts, SHARDS> res;
+    for (size_t i = 0; i < SHARDS; ++i)
+    {
+        auto& shard = mShards[i];
+        std::lock_guard<std::mutex> guard(shard.mMutex);
+        res[i] = shard.mCounts;
+        shard.mCounts = Counts{0, 0};
+    }
+    return res;
+}
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+// Copyright 2017 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "crypto/ByteSlice.h"
+#include "util/NonCopyable.h"
+#include "xdr/Stellar-types.h"
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace stellar
+{
+
+/**
+ * Concurrent cache of ed25519 signature-verification results, keyed by the
+ * SHA-256 of (public key, signature, message).
+ *
+ * The cache is split into SHARDS independently locked shards. Each shard is
+ * a fixed-size, open-addressed table: a key may only live in the WAYS slots
+ * following its home slot, and when they are all taken one of them is
+ * overwritten. Slots are allocated up front, so neither lookups nor inserts
+ * allocate; memory is only (re)allocated by resize().
+ *
+ * Hits and misses are counted per shard and collected with flushCounts().
+ */
+class VerifySigCache : NonMovableOrCopyable
+{
+  public:
+    static size_t const SHARDS = 16;
+    static size_t const WAYS = 8;
+
+    struct Counts
+    {
+        uint64_t mHits;
+        uint64_t mMisses;
+    };
+
+    // Room for at least `capacity` results, rounded up so every shard holds
+    // a power of two slots.
+    explicit VerifySigCache(size_t capacity);
+
+    static Hash makeKey(PublicKey const& key, Signature const& signature,
+                        ByteSlice const& bin);
+
+    // Return true and set `valid` if `key` is cached. Records a hit or miss.
+    bool get(Hash const& key, bool& valid);
+    void put(Hash const& key, bool valid);
+
+    void clear();
+
+    // Change the capacity, dropping every cached result if it differs from
+    // the current one.
+    void resize(size_t capacity);
+    size_t getCapacity() const;
+
+    // Return the counts of each shard since the last call, and reset them.
+    std::array<Counts, SHARDS> flushCounts();
+
+  private:
+    enum SlotState : uint8_t
+    {
+        SLOT_EMPTY,
+        SLOT_INVALID,
+        SLOT_VALID
+    };
+
+    struct Slot
+    {
+        Hash mKey;
+        SlotState mState;
+    };
+
+    struct Shard
+    {
+        mutable std::mutex mMutex;
+        std::vector<Slot> mSlots;
+        size_t mMask{0};
+        // rotates over the ways when a full window needs a victim
+        size_t mNextVictim{0};
+        Counts mCounts{0, 0};
+    };
+
+    std::array<Shard, SHARDS> mShards;
+
+    static size_t slotsPerShard(size_t capacity);
+    Shard& shardFor(Hash const& key, size_t& home);
+};
+}
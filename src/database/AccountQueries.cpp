@@ -10,11 +10,23 @@
 namespace stellar
 {
 
+static char const* SUM_OF_BALANCES_QUERY = "SELECT SUM(balance) FROM accounts;";
+
+static char const* NUMBER_OF_SUBENTRIES_QUERY = R"(
+        SELECT numsubentries,
+              (SELECT COUNT(*) FROM trustlines WHERE accountid = :id)
+            + (SELECT COUNT(*) FROM offers WHERE sellerid = :id)
+            + (SELECT COUNT(*) FROM accountdata WHERE accountid = :id)
+            + (SELECT COUNT(*) FROM signers WHERE accountid = :id)
+        FROM accounts
+        WHERE accountid = :id
+    )";
+
 int64_t
 sumOfBalances(Database& db)
 {
     int64_t sum = 0;
-    auto prep = db.getPreparedStatement("SELECT SUM(balance) FROM accounts;");
+    auto prep = db.getPreparedStatement(SUM_OF_BALANCES_QUERY);
 
     auto& st = prep.statement();
     st.exchange(soci::into(sum));
@@ -30,17 +42,7 @@ numberOfSubentries(AccountID const& accountID, Database& db)
     auto result = NumberOfSubentries{};
     auto actIDStrKey = KeyUtils::toStrKey(accountID);
 
-    auto query = std::string{R"(
-        SELECT numsubentries,
-              (SELECT COUNT(*) FROM trustlines WHERE accountid = :id)
-            + (SELECT COUNT(*) FROM offers WHERE sellerid = :id)
-            + (SELECT COUNT(*) FROM accountdata WHERE accountid = :id)
-            + (SELECT COUNT(*) FROM signers WHERE accountid = :id)
-        FROM accounts
-        WHERE accountid = :id
-    )"};
-
-    auto prep = db.getPreparedStatement(query);
+    auto prep = db.getPreparedStatement(NUMBER_OF_SUBENTRIES_QUERY);
     auto& st = prep.statement();
     st.exchange(soci::use(actIDStrKey, "id"));
     st.exchange(soci::into(result.inAccountsTable));
@@ -50,4 +52,24 @@ numberOfSubentries(AccountID const& accountID, Database& db)
 
     return result;
 }
+
+int64_t
+sumOfBalances(soci::session& sess)
+{
+    int64_t sum = 0;
+    sess << SUM_OF_BALANCES_QUERY, soci::into(sum);
+    return sum;
+}
+
+NumberOfSubentries
+numberOfSubentries(AccountID const& accountID, soci::session& sess)
+{
+    auto result = NumberOfSubentries{};
+    auto actIDStrKey = KeyUtils::toStrKey(accountID);
+
+    sess << NUMBER_OF_SUBENTRIES_QUERY, soci::use(actIDStrKey, "id"),
+        soci::into(result.inAccountsTable), soci::into(result.calculated);
+
+    return result;
+}
 }
@@ -8,6 +8,11 @@
 
 #include <cstdint>
 
+namespace soci
+{
+class session;
+}
+
 namespace stellar
 {
 
@@ -22,4 +27,11 @@ struct NumberOfSubentries
 int64_t sumOfBalances(Database& db);
 
 NumberOfSubentries numberOfSubentries(AccountID const& accountID, Database& db);
+
+// Same as the above, through `sess` rather than the main connection, such as
+// from a worker thread with a session of Database::getPool.
+int64_t sumOfBalances(soci::session& sess);
+
+NumberOfSubentries numberOfSubentries(AccountID const& accountID,
+                                      soci::session& sess);
 }
@@ -0,0 +1,341 @@
+// Copyright 2017 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "database/BulkInserter.h"
+#include "database/Database.h"
+#include "util/Logging.h"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+#ifdef USE_POSTGRES
+#include "soci-postgresql.h"
+#include <libpq-fe.h>
+#endif
+
+namespace stellar
+{
+
+// SQLite limits a statement to 999 parameters
+static size_t const MAX_STATEMENT_PARAMETERS = 900;
+
+// amount of COPY data buffered before being sent to the server
+static size_t const COPY_BUFFER_SIZE = 1024 * 1024;
+
+#ifdef USE_POSTGRES
+static PGconn*
+getConnection(Database& db)
+{
+    auto backend = dynamic_cast<soci::postgresql_session_backend*>(
+        db.getSession().get_backend());
+    if (!backend)
+    {
+        throw std::runtime_error("not a PostgreSQL session");
+    }
+    return backend->conn_;
+}
+#endif
+
+static std::string
+joinColumns(std::vector<std::string> const& columns)
+{
+    std::string res;
+    for (auto const& c : columns)
+    {
+        if (!res.empty())
+        {
+            res += ",";
+        }
+        res += c;
+    }
+    return res;
+}
+
+BulkInserter::BulkInserter(Database& db, std::string const& table,
+                           std::vector<std::string> const& columns)
+    : mDb(db)
+    , mTable(table)
+    , mColumns(columns)
+    , mRowsPerStatement(
+          std::max<size_t>(1, MAX_STATEMENT_PARAMETERS / columns.size()))
+#ifdef USE_POSTGRES
+    , mCopy(!db.isSqlite())
+#else
+    , mCopy(false)
+#endif
+{
+    assert(!mColumns.empty());
+}
+
+BulkInserter::~BulkInserter()
+{
+#ifdef USE_POSTGRES
+    if (mCopying)
+    {
+        // leave the connection usable; the transaction itself is aborted
+        auto conn = getConnection(mDb);
+        PQputCopyEnd(conn, "bulk insert abandoned");
+        while (auto res = PQgetResult(conn))
+        {
+            PQclear(res);
+        }
+    }
+#endif
+}
+
+void
+BulkInserter::add(std::string const& value)
+{
+    addValue(&value);
+}
+
+void
+BulkInserter::addNull()
+{
+    addValue(nullptr);
+}
+
+void
+BulkInserter::addValue(std::string const* value)
+{
+    if (mCopy)
+    {
+        if (mColumn != 0)
+        {
+            mCopyBuffer += '\t';
+        }
+        if (!value)
+        {
+            mCopyBuffer += "\\N";
+        }
+        else
+        {
+            // text format: backslash escapes the delimiters
+            for (char c : *value)
+            {
+                switch (c)
+                {
+                case '\\':
+                    mCopyBuffer += "\\\\";
+                    break;
+                case '\t':
+                    mCopyBuffer += "\\t";
+                    break;
+                case '\n':
+                    mCopyBuffer += "\\n";
+                    break;
+                case '\r':
+                    mCopyBuffer += "\\r";
+                    break;
+                default:
+                    mCopyBuffer += c;
+                }
+            }
+        }
+    }
+    else
+    {
+        mValues.emplace_back(value ? *value : std::string());
+        mIndicators.push_back(value ? soci::i_ok : soci::i_null);
+    }
+
+    if (++mColumn < mColumns.size())
+    {
+        return;
+    }
+
+    // row complete
+    mColumn = 0;
+    ++mPendingRows;
+    if (mCopy)
+    {
+        mCopyBuffer += '\n';
+        if (mCopyBuffer.size() >= COPY_BUFFER_SIZE)
+        {
+            sendCopyData();
+        }
+    }
+    else if (mPendingRows == mRowsPerStatement)
+    {
+        insertRows();
+    }
+}
+
+void
+BulkInserter::insertRows()
+{
+    if (mPendingRows == 0)
+    {
+        return;
+    }
+
+    std::string sql =
+        "INSERT INTO " + mTable + " (" + joinColumns(mColumns) + ") VALUES ";
+    size_t n = 0;
+    for (size_t row = 0; row < mPendingRows; ++row)
+    {
+        sql += (row == 0) ? "(" : ",(";
+        for (size_t col = 0; col < mColumns.size(); ++col)
+        {
+            sql += (col == 0) ? ":v" : ",:v";
+            sql += std::to_string(n++);
+        }
+        sql += ")";
+    }
+
+    auto prep = mDb.getPreparedStatement(sql);
+    auto& st = prep.statement();
+    for (size_t i = 0; i < n; ++i)
+    {
+        st.exchange(soci::use(mValues[i], mIndicators[i]));
+    }
+    st.define_and_bind();
+    {
+        auto timer = mDb.getInsertTimer(mTable);
+        st.execute(true);
+    }
+    if (st.get_affected_rows() != static_cast<long long>(mPendingRows))
+    {
+        throw std::runtime_error("Could not insert data in SQL");
+    }
+
+    mRowsInserted += mPendingRows;
+    mPendingRows = 0;
+    mValues.clear();
+    mIndicators.clear();
+}
+
+void
+BulkInserter::sendCopyData()
+{
+#ifdef USE_POSTGRES
+    auto conn = getConnection(mDb);
+    auto timer = mDb.getInsertTimer(mTable);
+    if (!mCopying)
+    {
+        std::string sql =
+            "COPY " + mTable + " (" + joinColumns(mColumns) + ") FROM STDIN";
+        auto res = PQexec(conn, sql.c_str());
+        bool ok = PQresultStatus(res) == PGRES_COPY_IN;
+        PQclear(res);
+        if (!ok)
+        {
+            throw std::runtime_error("could not start COPY into " + mTable +
+                                     ": " + PQerrorMessage(conn));
+        }
+        mCopying = true;
+    }
+    if (!mCopyBuffer.empty() &&
+        PQputCopyData(conn, mCopyBuffer.data(),
+                      static_cast<int>(mCopyBuffer.size())) != 1)
+    {
+        throw std::runtime_error("could not send COPY data into " + mTable +
+                                 ": " + PQerrorMessage(conn));
+    }
+    mCopyBuffer.clear();
+#else
+    assert(false);
+#endif
+}
+
+void
+BulkInserter::endCopy()
+{
+#ifdef USE_POSTGRES
+    if (mPendingRows == 0 && !mCopying)
+    {
+        return;
+    }
+    sendCopyData();
+
+    auto conn = getConnection(mDb);
+    auto timer = mDb.getInsertTimer(mTable);
+    mCopying = false;
+    if (PQputCopyEnd(conn, nullptr) != 1)
+    {
+        throw std::runtime_error("could not end COPY into " + mTable + ": " +
+                                 PQerrorMessage(conn));
+    }
+    std::string error;
+    while (auto res = PQgetResult(conn))
+    {
+        if (PQresultStatus(res) != PGRES_COMMAND_OK)
+        {
+            error = PQresultErrorMessage(res);
+        }
+        PQclear(res);
+    }
+    if (!error.empty())
+    {
+        throw std::runtime_error("COPY into " + mTable + " failed: " + error);
+    }
+
+    mRowsInserted += mPendingRows;
+    mPendingRows = 0;
+#else
+    assert(false);
+#endif
+}
+
+void
+BulkInserter::flush()
+{
+    if (mColumn != 0)
+    {
+        throw std::logic_error("incomplete row for " + mTable);
+    }
+    if (mCopy)
+    {
+        endCopy();
+    }
+    else
+    {
+        insertRows();
+    }
+}
+
+void
+bulkDelete(Database& db, std::string const& table, std::string const& column,
+           std::vector<std::string> const& keys)
+{
+    forEachKeyChunk(keys, [&](std::vector<std::string>& chunk,
+                              std::string const& placeholders) {
+        std::string sql = "DELETE FROM " + table + " WHERE " + column +
+                          " IN (" + placeholders + ")";
+
+        auto prep = db.getPreparedStatement(sql);
+        auto& st = prep.statement();
+        for (auto& k : chunk)
+        {
+            st.exchange(soci::use(k));
+        }
+        st.define_and_bind();
+        auto timer = db.getDeleteTimer(table);
+        st.execute(true);
+    });
+}
+
+void
+forEachKeyChunk(std::vector<std::string> const& keys,
+                std::function<void(std::vector<std::string>& chunk,
+                                   std::string const& placeholders)> const& f)
+{
+    for (size_t begin = 0; begin < keys.size();
+         begin += MAX_STATEMENT_PARAMETERS)
+    {
+        size_t end = std::min(begin + MAX_STATEMENT_PARAMETERS, keys.size());
+        std::vector<std::string> chunk(keys.begin() + begin,
+                                       keys.begin() + end);
+
+        std::string placeholders;
+        for (size_t i = 0; i < chunk.size(); ++i)
+        {
+            placeholders += (i == 0) ? ":v" : ",:v";
+            placeholders += std::to_string(i);
+        }
+        f(chunk, placeholders);
+    }
+}
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+// Copyright 2017 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/NonCopyable.h"
+#include "util/SociNoWarnings.h"
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace stellar
+{
+
+class Database;
+
+/**
+ * Writes many rows to one table with as few round trips as possible: rows
+ * are streamed through COPY ... FROM STDIN on PostgreSQL, and grouped into
+ * multi-row INSERT statements elsewhere.
+ *
+ * Values are given in text form, one column after the other, and a row is
+ * complete once every column got a value. Nothing is guaranteed to reach the
+ * database before flush() returns; on PostgreSQL no other statement may be
+ * run on the session between the first add() and flush().
+ */
+class BulkInserter : NonMovableOrCopyable
+{
+    Database& mDb;
+    std::string const mTable;
+    std::vector<std::string> const mColumns;
+    size_t const mRowsPerStatement;
+
+    // column of the current row the next value goes to, and rows complete
+    // but not written yet
+    size_t mColumn{0};
+    size_t mPendingRows{0};
+
+    // values of the rows not written yet, for INSERT statements
+    std::vector<std::string> mValues;
+    std::vector<soci::indicator> mIndicators;
+
+    bool mCopy;
+    bool mCopying{false};
+    std::string mCopyBuffer;
+
+    size_t mRowsInserted{0};
+
+    void addValue(std::string const* value);
+    void insertRows();
+    void sendCopyData();
+    void endCopy();
+
+  public:
+    BulkInserter(Database& db, std::string const& table,
+                 std::vector<std::string> const& columns);
+    ~BulkInserter();
+
+    void add(std::string const& value);
+    void addNull();
+
+    // Write every row added so far.
+    void flush();
+
+    size_t
+    getRowsInserted() const
+    {
+        return mRowsInserted;
+    }
+};
+
+// Delete the rows of `table` whose `column` holds one of `keys`, a few hundred
+// keys per statement.
+void bulkDelete(Database& db, std::string const& table,
+                std::string const& column, std::vector<std::string> const& keys);
+
+// Call `f` with `keys` a few hundred at a time, along with the placeholders
+// (":v0,:v1,...") to bind them to, in order, in an IN (...) list.
+void forEachKeyChunk(
+    std::vector<std::string> const& keys,
+    std::function<void(std::vector<std::string>& chunk,
+                       std::string const& placeholders)> const& f);
+}
@@ -81,7 +81,9 @@ Database::Database(Application& app)
           app.getMetrics().NewMeter({"database", "query", "exec"}, "query"))
     , mStatementsSize(
           app.getMetrics().NewCounter({"database", "memory", "statements"}))
-    , mEntryCache(4096)
+    , mEntryCache(app.getMetrics(), app.getConfig().ENTRY_CACHE_SIZE,
+                  app.getConfig().ENTRY_CACHE_SHARDS)
+    , mOrderBook(*this, app.getMetrics(), app.getConfig().IN_MEMORY_ORDER_BOOK)
     , mExcludedQueryTime(0)
     , mExcludedTotalTime(0)
     , mLastIdleQueryTime(0)
@@ -341,12 +343,18 @@ Database::getPool()
     return *mPool;
 }
 
-cache::lru_cache<std::string, std::shared_ptr<LedgerEntry const>>&
+Database::EntryCache&
 Database::getEntryCache()
 {
     return mEntryCache;
 }
 
+OrderBook&
+Database::getOrderBook()
+{
+    return mOrderBook;
+}
+
 class SQLLogContext : NonCopyable
 {
     std::string mName;
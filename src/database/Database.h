@@ -4,12 +4,13 @@
 // under the Apache License, Version 2.0. See the COPYING file at the root
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
+#include "ledger/LedgerEntryCache.h"
+#include "ledger/OrderBook.h"
 #include "medida/timer_context.h"
 #include "overlay/StellarXDR.h"
 #include "util/NonCopyable.h"
 #include "util/SociNoWarnings.h"
 #include "util/Timer.h"
-#include "util/lrucache.hpp"
 #include <set>
 #include <string>
 
@@ -92,8 +93,8 @@ class Database : NonMovableOrCopyable
     std::map<std::string, std::shared_ptr<soci::statement>> mStatements;
     medida::Counter& mStatementsSize;
 
-    cache::lru_cache<std::string, std::shared_ptr<LedgerEntry const>>
-        mEntryCache;
+    LedgerEntryCache mEntryCache;
+    OrderBook mOrderBook;
 
     // Helpers for maintaining the total query time and calculating
     // idle percentage.
@@ -192,9 +193,13 @@ class Database : NonMovableOrCopyable
     // Access the LedgerEntry cache. Note: clients are responsible for
     // invalidating entries in this cache as they perform statements
     // against the database. It's kept here only for ease of access.
-    typedef cache::lru_cache<std::string, std::shared_ptr<LedgerEntry const>>
-        EntryCache;
+    typedef LedgerEntryCache EntryCache;
     EntryCache& getEntryCache();
+
+    // Access the in-memory index of the offers table. Like the entry cache,
+    // it is kept in sync by the ledger entry frames as they write to the
+    // database.
+    OrderBook& getOrderBook();
 };
 
 class DBTimeExcluder : NonCopyable
@@ -0,0 +1,48 @@
+// Copyright 2017 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "database/DatabaseUtils.h"
+#include "database/Database.h"
+
+#include <algorithm>
+
+namespace stellar
+{
+
+size_t
+deleteOldestLedgers(Database& db, std::string const& table,
+                    std::string const& ledgerSeqColumn, uint32_t ledgerSeq,
+                    uint32_t count)
+{
+    if (count == 0)
+    {
+        return 0;
+    }
+
+    auto& sess = db.getSession();
+    int64_t curMin;
+    soci::indicator gotMin;
+    {
+        auto timer = db.getSelectTimer(table);
+        sess << "SELECT MIN(" << ledgerSeqColumn << ") FROM " << table,
+            soci::into(curMin, gotMin);
+    }
+    if (gotMin != soci::i_ok || curMin > ledgerSeq)
+    {
+        return 0;
+    }
+
+    // the range is bounded by ledgers rather than by rows so that every
+    // table is trimmed to the same point, whatever its number of rows per
+    // ledger
+    int64_t last = std::min<int64_t>(curMin + count - 1, ledgerSeq);
+    soci::statement st = (sess.prepare << "DELETE FROM " << table << " WHERE "
+                                       << ledgerSeqColumn << " <= " << last);
+    {
+        auto timer = db.getDeleteTimer(table);
+        st.execute(true);
+    }
+    return static_cast<size_t>(st.get_affected_rows());
+}
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+// Copyright 2017 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace stellar
+{
+
+class Database;
+
+// Delete the rows of `table` belonging to at most `count` ledgers, from the
+// oldest ledger it holds up to `ledgerSeq` included, `ledgerSeqColumn` being
+// the column holding the ledger of a row. Returns the number of rows deleted.
+size_t deleteOldestLedgers(Database& db, std::string const& table,
+                           std::string const& ledgerSeqColumn,
+                           uint32_t ledgerSeq, uint32_t count);
+}
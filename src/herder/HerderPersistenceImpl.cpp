@@ -5,6 +5,7 @@
 #include "herder/HerderPersistenceImpl.h"
 #include "crypto/Hex.h"
 #include "database/Database.h"
+#include "database/DatabaseUtils.h"
 #include "herder/Herder.h"
 #include "main/Application.h"
 #include "scp/Slot.h"
@@ -265,12 +266,13 @@ HerderPersistence::dropAll(Database& db)
                        ")";
 }
 
-void
-HerderPersistence::deleteOldEntries(Database& db, uint32_t ledgerSeq)
+size_t
+HerderPersistence::deleteOldEntries(Database& db, uint32_t ledgerSeq,
+                                    uint32_t count)
 {
-    db.getSession() << "DELETE FROM scphistory WHERE ledgerseq <= "
-                    << ledgerSeq;
-    db.getSession() << "DELETE FROM scpquorums WHERE lastledgerseq <= "
-                    << ledgerSeq;
+    return deleteOldestLedgers(db, "scphistory", "ledgerseq", ledgerSeq,
+                               count) +
+           deleteOldestLedgers(db, "scpquorums", "lastledgerseq", ledgerSeq,
+                               count);
 }
 }
@@ -3,14 +3,17 @@
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
 #include "herder/HerderImpl.h"
+#include "herder/TransactionQueue.h"
 #include "main/Application.h"
 #include "main/Config.h"
+#include "main/Maintainer.h"
 #include "scp/SCP.h"
 #include "simulation/Simulation.h"
 #include "test/TestAccount.h"
 #include "test/test.h"
 
 #include "crypto/SHA.h"
+#include "crypto/SecretKey.h"
 #include "database/Database.h"
 #include "ledger/LedgerHeaderFrame.h"
 #include "ledger/LedgerManager.h"
@@ -19,9 +22,19 @@
 #include "overlay/OverlayManager.h"
 #include "simulation/Simulation.h"
 #include "test/TxTests.h"
+#include "transactions/BatchSignatureVerifier.h"
+#include "util/Logging.h"
+#include "util/Math.h"
 
 #include "xdrpp/marshal.h"
 
+#include "medida/counter.h"
+#include "medida/metrics_registry.h"
+
+#include <algorithm>
+#include <chrono>
+#include <unordered_map>
+
 using namespace stellar;
 using namespace stellar::txtest;
 
@@ -137,6 +150,39 @@ TEST_CASE("standalone", "[herder]")
                 REQUIRE(!lh);
             }
         }
+
+        SECTION("Queue processing in batches")
+        {
+            while (app->getLedgerManager().getLastClosedLedgerNum() <
+                   (app->getHistoryManager().getCheckpointFrequency() + 5))
+            {
+                app->getClock().crank(true);
+            }
+
+            auto& db = app->getDatabase();
+            auto& sess = db.getSession();
+            auto& lag =
+                app->getMetrics().NewCounter({"maintenance", "trim", "lag"});
+
+            app->getCommandHandler().manualCmd("setcursor?id=A1&cursor=4");
+            // ledgers 1 and 2
+            app->getCommandHandler().manualCmd(
+                "maintenance?queue=true&count=2");
+            REQUIRE(!LedgerHeaderFrame::loadBySequence(2, db, sess));
+            REQUIRE(!!LedgerHeaderFrame::loadBySequence(3, db, sess));
+            REQUIRE(lag.count() == 2);
+
+            // ledgers 3 and 4, leaving 5 as the cursor requires
+            app->getCommandHandler().manualCmd(
+                "maintenance?queue=true&count=2");
+            REQUIRE(!LedgerHeaderFrame::loadBySequence(4, db, sess));
+            REQUIRE(!!LedgerHeaderFrame::loadBySequence(5, db, sess));
+            REQUIRE(lag.count() == 0);
+
+            REQUIRE(app->getMaintainer().isEnabled());
+            app->getCommandHandler().manualCmd("maintenance?automatic=false");
+            REQUIRE(!app->getMaintainer().isEnabled());
+        }
     }
 }
 
@@ -232,6 +278,30 @@ TEST_CASE("txset", "[herder]")
             REQUIRE(txSet->checkValid(*app));
         }
     }
+    SECTION("signatures pre-verified")
+    {
+        txSet->sortForHash();
+
+        uint64_t hits = 0, misses = 0;
+        PubKeyUtils::clearVerifySigCache();
+        PubKeyUtils::flushVerifySigCacheCounts(hits, misses);
+
+        BatchSignatureVerifier verifier(*app);
+        verifier.add(txSet->mTransactions);
+        REQUIRE(verifier.size() == txSet->mTransactions.size());
+        verifier.verify();
+        REQUIRE(verifier.size() == 0);
+
+        PubKeyUtils::flushVerifySigCacheCounts(hits, misses);
+        REQUIRE(hits == 0);
+        REQUIRE(misses == txSet->mTransactions.size());
+
+        // validation only finds signatures that were already verified
+        REQUIRE(txSet->checkValid(*app));
+        PubKeyUtils::flushVerifySigCacheCounts(hits, misses);
+        REQUIRE(misses == 0);
+        REQUIRE(hits >= txSet->mTransactions.size());
+    }
     SECTION("invalid tx")
     {
         SECTION("no user")
@@ -412,6 +482,226 @@ TEST_CASE("surge", "[herder]")
     }
 }
 
+static TransactionFramePtr
+makeQueuedTx(Hash const& networkID, PublicKey const& source,
+             SequenceNumber seq, uint32_t fee)
+{
+    // never applied nor checked, so neither signatures nor a valid operation
+    // are needed
+    TransactionEnvelope e;
+    e.tx.sourceAccount = source;
+    e.tx.seqNum = seq;
+    e.tx.fee = fee;
+    e.tx.operations.resize(1);
+    return TransactionFrame::makeTransactionFromWire(networkID, e);
+}
+
+TEST_CASE("transaction queue", "[herder]")
+{
+    Hash networkID = sha256("transaction queue");
+    auto a = getAccount("a").getPublicKey();
+    auto b = getAccount("b").getPublicKey();
+    auto c = getAccount("c").getPublicKey();
+
+    TransactionQueue queue;
+    auto add = [&](PublicKey const& source, SequenceNumber seq, uint32_t fee) {
+        auto tx = makeQueuedTx(networkID, source, seq, fee);
+        queue.add(tx, fee / 100.0);
+        return tx;
+    };
+    auto priorityOrder = [&]() {
+        std::vector<TransactionFramePtr> res;
+        queue.visitByPriority([&](std::vector<TransactionFramePtr> const& txs) {
+            res.insert(res.end(), txs.begin(), txs.end());
+            return true;
+        });
+        return res;
+    };
+
+    auto a2 = add(a, 2, 100);
+    auto a1 = add(a, 1, 300);
+    auto b1 = add(b, 1, 200);
+    auto b2 = add(b, 2, 200);
+
+    SECTION("lookups")
+    {
+        REQUIRE(queue.size() == 4);
+        REQUIRE(queue.contains(a1->getFullHash()));
+        REQUIRE(!queue.contains(
+            makeQueuedTx(networkID, c, 1, 100)->getFullHash()));
+        REQUIRE(queue.getMaxSeq(a) == 2);
+        REQUIRE(queue.getTotalFees(a) == 400);
+        REQUIRE(queue.getMaxSeq(c) == 0);
+        REQUIRE(queue.getTotalFees(c) == 0);
+    }
+
+    SECTION("priority follows the lowest fee of each account")
+    {
+        REQUIRE(priorityOrder() ==
+                std::vector<TransactionFramePtr>({b1, b2, a1, a2}));
+
+        queue.remove({a2});
+        REQUIRE(queue.getMaxSeq(a) == 1);
+        REQUIRE(queue.getTotalFees(a) == 300);
+        REQUIRE(priorityOrder() ==
+                std::vector<TransactionFramePtr>({a1, b1, b2}));
+
+        auto b3 = add(b, 3, 100);
+        REQUIRE(priorityOrder() ==
+                std::vector<TransactionFramePtr>({a1, b1, b2, b3}));
+    }
+
+    SECTION("transactions age out")
+    {
+        queue.shift();
+        auto c1 = add(c, 1, 100);
+        REQUIRE(queue.countOfAge(0) == 1);
+        REQUIRE(queue.countOfAge(1) == 4);
+
+        for (size_t i = 2; i < TransactionQueue::MAX_AGE; i++)
+        {
+            queue.shift();
+        }
+        REQUIRE(queue.size() == 5);
+        REQUIRE(queue.countOfAge(TransactionQueue::MAX_AGE - 1) == 4);
+
+        queue.shift();
+        REQUIRE(queue.size() == 1);
+        REQUIRE(queue.contains(c1->getFullHash()));
+        REQUIRE(queue.getMaxSeq(a) == 0);
+        REQUIRE(priorityOrder() == std::vector<TransactionFramePtr>({c1}));
+
+        queue.remove({c1});
+        REQUIRE(queue.countOfAge(TransactionQueue::MAX_AGE - 1) == 0);
+        queue.shift();
+        REQUIRE(queue.size() == 0);
+    }
+
+    SECTION("a transaction received again ages from its new generation")
+    {
+        queue.remove({a1});
+        queue.shift();
+        queue.add(a1, 3.0);
+        REQUIRE(queue.countOfAge(0) == 1);
+        REQUIRE(queue.countOfAge(1) == 3);
+
+        for (size_t i = 2; i < TransactionQueue::MAX_AGE; i++)
+        {
+            queue.shift();
+        }
+        queue.shift();
+        REQUIRE(queue.size() == 1);
+        REQUIRE(queue.contains(a1->getFullHash()));
+        REQUIRE(queue.countOfAge(TransactionQueue::MAX_AGE - 1) == 1);
+
+        queue.shift();
+        REQUIRE(queue.size() == 0);
+    }
+}
+
+// Queues `txPerAccount` payments with random fees from each of `nbAccounts`
+// accounts, more than fit in a ledger, triggers the next ledger and checks
+// that the transactions applied are the ones surge pricing would keep out of
+// everything pending.
+static void
+checkTriggeredSetMatchesSurgePricing(size_t nbAccounts, size_t txPerAccount,
+                                     size_t maxTxSetSize)
+{
+    Config cfg(getTestConfig());
+    cfg.DESIRED_MAX_TX_PER_LEDGER = static_cast<uint32_t>(maxTxSetSize);
+    VirtualClock clock;
+    Application::pointer app = Application::create(clock, cfg);
+    app->start();
+
+    auto& lm = app->getLedgerManager();
+    lm.getCurrentLedgerHeader().maxTxSetSize = cfg.DESIRED_MAX_TX_PER_LEDGER;
+
+    auto root = TestAccount::createRoot(*app);
+    std::vector<TestAccount> accounts;
+    std::vector<Operation> creates;
+    for (size_t i = 0; i < nbAccounts; i++)
+    {
+        accounts.emplace_back(
+            *app, getAccount(("load-" + std::to_string(i)).c_str()));
+        creates.emplace_back(
+            createAccount(accounts.back().getPublicKey(), 1000000000));
+        if (creates.size() == 100 || i + 1 == nbAccounts)
+        {
+            applyTx(root.tx(creates), *app);
+            creates.clear();
+        }
+    }
+
+    std::vector<TransactionFramePtr> txs;
+    txs.reserve(nbAccounts * txPerAccount);
+    auto start = std::chrono::steady_clock::now();
+    for (size_t n = 0; n < txPerAccount; n++)
+    {
+        for (auto& account : accounts)
+        {
+            auto tx = account.tx({payment(root, 1)});
+            tx->getEnvelope().tx.fee =
+                lm.getTxFee() * rand_uniform<uint32_t>(1, 10);
+            tx->getEnvelope().signatures.clear();
+            tx->clearCached();
+            tx->addSignature(account.getSecretKey());
+            REQUIRE(app->getHerder().recvTransaction(tx) ==
+                    Herder::TX_STATUS_PENDING);
+            txs.emplace_back(tx);
+        }
+    }
+    auto received = std::chrono::steady_clock::now();
+
+    auto lcl = lm.getLastClosedLedgerNum();
+    app->getHerder().triggerNextLedger(lcl + 1);
+    auto triggered = std::chrono::steady_clock::now();
+    while (lm.getLastClosedLedgerNum() == lcl)
+    {
+        clock.crank(true);
+    }
+
+    LOG(INFO) << "transaction queue: received " << txs.size() << " txs in "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(
+                     received - start)
+                     .count()
+              << "ms, triggered the next ledger in "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(
+                     triggered - received)
+                     .count()
+              << "ms";
+
+    // same transactions as surge pricing over everything
+    TxSetFrame all(lm.getLastClosedLedgerHeader().hash);
+    all.mTransactions = txs;
+    all.surgePricingFilter(lm);
+    REQUIRE(all.size() == maxTxSetSize);
+    std::unordered_map<AccountID, SequenceNumber> expectedSeq;
+    for (auto const& tx : all.mTransactions)
+    {
+        auto& seq = expectedSeq[tx->getSourceID()];
+        seq = std::max(seq, tx->getSeqNum());
+    }
+    for (auto& account : accounts)
+    {
+        auto it = expectedSeq.find(account.getPublicKey());
+        auto expected = it == expectedSeq.end()
+                            ? account.getLastSequenceNumber() -
+                                  static_cast<SequenceNumber>(txPerAccount)
+                            : it->second;
+        REQUIRE(account.loadSequenceNumber() == expected);
+    }
+}
+
+TEST_CASE("transaction queue selection", "[herder]")
+{
+    checkTriggeredSetMatchesSurgePricing(30, 3, 40);
+}
+
+TEST_CASE("transaction queue load", "[herder][hide]")
+{
+    checkTriggeredSetMatchesSurgePricing(10000, 10, 5000);
+}
+
 TEST_CASE("SCP Driver", "[herder]")
 {
     Config cfg(getTestConfig());
@@ -0,0 +1,220 @@
+// Copyright 2017 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "herder/TransactionQueue.h"
+#include "xdrpp/marshal.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace stellar
+{
+
+using xdr::operator<;
+using xdr::operator==;
+
+size_t const TransactionQueue::MAX_AGE;
+
+bool
+TransactionQueue::PriorityOrder::operator()(PriorityKey const& a,
+                                            PriorityKey const& b) const
+{
+    // same order as TxSetFrame::surgePricingFilter
+    if (a.mFeeRatio != b.mFeeRatio)
+    {
+        return a.mFeeRatio > b.mFeeRatio;
+    }
+    return a.mAccount < b.mAccount;
+}
+
+TransactionQueue::TransactionQueue()
+    : mAges(MAX_AGE), mAgeCounts(MAX_AGE, 0)
+{
+}
+
+bool
+TransactionQueue::contains(Hash const& fullHash) const
+{
+    return mByHash.find(fullHash) != mByHash.end();
+}
+
+SequenceNumber
+TransactionQueue::getMaxSeq(AccountID const& account) const
+{
+    auto it = mAccounts.find(account);
+    if (it == mAccounts.end())
+    {
+        return 0;
+    }
+    return it->second.mEntries.back().mTx->getSeqNum();
+}
+
+int64_t
+TransactionQueue::getTotalFees(AccountID const& account) const
+{
+    auto it = mAccounts.find(account);
+    return it == mAccounts.end() ? 0 : it->second.mTotalFees;
+}
+
+void
+TransactionQueue::add(TransactionFramePtr tx, double feeRatio)
+{
+    auto const& account = tx->getSourceID();
+    auto const& h = tx->getFullHash();
+    assert(!contains(h));
+
+    auto& txs = mAccounts[account];
+    if (!txs.mEntries.empty())
+    {
+        mByPriority.erase(PriorityKey{txs.mMinFeeRatio, account});
+        txs.mMinFeeRatio = std::min(txs.mMinFeeRatio, feeRatio);
+    }
+    else
+    {
+        txs.mMinFeeRatio = feeRatio;
+    }
+    mByPriority.insert(PriorityKey{txs.mMinFeeRatio, account});
+
+    // transactions normally arrive in sequence order, so this is an append
+    auto pos = std::upper_bound(txs.mEntries.begin(), txs.mEntries.end(),
+                                tx->getSeqNum(),
+                                [](SequenceNumber seq, Entry const& e) {
+                                    return seq < e.mTx->getSeqNum();
+                                });
+    txs.mEntries.insert(pos, Entry{tx, feeRatio, mGeneration});
+    txs.mTotalFees += tx->getFee();
+
+    mByHash.emplace(h, account);
+    mAges.front().emplace_back(h);
+    mAgeCounts.front()++;
+}
+
+void
+TransactionQueue::removeEntry(AccountID const& account, Hash const& fullHash)
+{
+    auto accIt = mAccounts.find(account);
+    assert(accIt != mAccounts.end());
+    auto& txs = accIt->second;
+
+    auto it = std::find_if(
+        txs.mEntries.begin(), txs.mEntries.end(),
+        [&](Entry const& e) { return e.mTx->getFullHash() == fullHash; });
+    assert(it != txs.mEntries.end());
+
+    auto age = static_cast<size_t>(mGeneration - it->mGeneration);
+    if (age < mAgeCounts.size())
+    {
+        mAgeCounts[age]--;
+    }
+    txs.mTotalFees -= it->mTx->getFee();
+    txs.mEntries.erase(it);
+    mByHash.erase(fullHash);
+
+    mByPriority.erase(PriorityKey{txs.mMinFeeRatio, account});
+    if (txs.mEntries.empty())
+    {
+        mAccounts.erase(accIt);
+        return;
+    }
+    txs.mMinFeeRatio = txs.mEntries.front().mFeeRatio;
+    for (auto const& e : txs.mEntries)
+    {
+        txs.mMinFeeRatio = std::min(txs.mMinFeeRatio, e.mFeeRatio);
+    }
+    mByPriority.insert(PriorityKey{txs.mMinFeeRatio, account});
+}
+
+void
+TransactionQueue::remove(std::vector<TransactionFramePtr> const& txs)
+{
+    for (auto const& tx : txs)
+    {
+        auto it = mByHash.find(tx->getFullHash());
+        if (it != mByHash.end())
+        {
+            // copied: removeEntry erases `it`
+            auto account = it->second;
+            removeEntry(account, tx->getFullHash());
+        }
+    }
+}
+
+void
+TransactionQueue::shift()
+{
+    auto oldest = std::move(mAges.back());
+    // generation the oldest transactions were received at
+    auto oldestGeneration = mGeneration + 1 - MAX_AGE;
+    mAges.pop_back();
+    mAgeCounts.pop_back();
+    mAges.emplace_front();
+    mAgeCounts.emplace_front(0);
+    // from here on, removeEntry sees the oldest entries as MAX_AGE old and
+    // leaves mAgeCounts alone
+    mGeneration++;
+
+    for (auto const& h : oldest)
+    {
+        auto it = mByHash.find(h);
+        if (it == mByHash.end())
+        {
+            continue;
+        }
+        // the transaction may have been removed and received again since,
+        // in which case it is younger and listed in a later generation
+        auto account = it->second;
+        auto const& entries = mAccounts.find(account)->second.mEntries;
+        auto e = std::find_if(
+            entries.begin(), entries.end(),
+            [&](Entry const& x) { return x.mTx->getFullHash() == h; });
+        assert(e != entries.end());
+        if (e->mGeneration == oldestGeneration)
+        {
+            removeEntry(account, h);
+        }
+    }
+}
+
+size_t
+TransactionQueue::countOfAge(size_t age) const
+{
+    return age < mAgeCounts.size() ? mAgeCounts[age] : 0;
+}
+
+void
+TransactionQueue::visitByPriority(
+    std::function<bool(std::vector<TransactionFramePtr> const&)> const& f)
+    const
+{
+    std::vector<TransactionFramePtr> chain;
+    for (auto const& key : mByPriority)
+    {
+        auto const& txs = mAccounts.find(key.mAccount)->second;
+        chain.clear();
+        for (auto const& e : txs.mEntries)
+        {
+            chain.emplace_back(e.mTx);
+        }
+        if (!f(chain))
+        {
+            return;
+        }
+    }
+}
+
+std::vector<TransactionFramePtr>
+TransactionQueue::getTransactions() const
+{
+    std::vector<TransactionFramePtr> res;
+    res.reserve(size());
+    for (auto const& a : mAccounts)
+    {
+        for (auto const& e : a.second.mEntries)
+        {
+            res.emplace_back(e.mTx);
+        }
+    }
+    return res;
+}
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+// Copyright 2017 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "transactions/TransactionFrame.h"
+#include "util/HashOfHash.h"
+
+#include <deque>
+#include <functional>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+namespace stellar
+{
+
+/**
+ * Transactions received by the herder and not applied yet, indexed:
+ * - by full hash, for duplicate checks;
+ * - by source account, as chains ordered by sequence number along with their
+ *   total fees, for admission checks;
+ * - by the lowest fee ratio of each account's chain, so the transactions to
+ *   nominate when more are pending than fit in a ledger can be taken in
+ *   surge pricing order without sorting everything.
+ *
+ * Every transaction also has an age: the number of ledgers closed since it
+ * was received. Transactions are dropped once they reach MAX_AGE.
+ */
+class TransactionQueue
+{
+  public:
+    static size_t const MAX_AGE = 4;
+
+    TransactionQueue();
+
+    bool contains(Hash const& fullHash) const;
+
+    // highest sequence number, and sum of the fees, of the transactions
+    // pending for `account` (0 if there are none)
+    SequenceNumber getMaxSeq(AccountID const& account) const;
+    int64_t getTotalFees(AccountID const& account) const;
+
+    // Adds `tx`, which must not be in the queue, with age 0. `feeRatio` is
+    // TransactionFrame::getFeeRatio of `tx`.
+    void add(TransactionFramePtr tx, double feeRatio);
+
+    // Removes the transactions of `txs` that are in the queue.
+    void remove(std::vector<TransactionFramePtr> const& txs);
+
+    // Ages every transaction by one ledger, dropping those reaching MAX_AGE.
+    void shift();
+
+    size_t
+    size() const
+    {
+        return mByHash.size();
+    }
+
+    // number of transactions of the given age
+    size_t countOfAge(size_t age) const;
+
+    // Calls `f` with the transactions of each account, in sequence order,
+    // going through accounts by decreasing lowest fee ratio (then by account
+    // ID), until `f` returns false. The queue must not be modified from `f`.
+    void visitByPriority(
+        std::function<bool(std::vector<TransactionFramePtr> const&)> const& f)
+        const;
+
+    // every transaction of the queue, in no particular order
+    std::vector<TransactionFramePtr> getTransactions() const;
+
+  private:
+    struct Entry
+    {
+        TransactionFramePtr mTx;
+        double mFeeRatio;
+        uint64_t mGeneration;
+    };
+
+    struct AccountTxs
+    {
+        // ordered by sequence number
+        std::vector<Entry> mEntries;
+        int64_t mTotalFees{0};
+        double mMinFeeRatio{0};
+    };
+
+    struct PriorityKey
+    {
+        double mFeeRatio;
+        AccountID mAccount;
+    };
+    struct PriorityOrder
+    {
+        bool operator()(PriorityKey const& a, PriorityKey const& b) const;
+    };
+
+    std::unordered_map<AccountID, AccountTxs> mAccounts;
+    std::unordered_map<Hash, AccountID> mByHash;
+    std::set<PriorityKey, PriorityOrder> mByPriority;
+
+    // mGeneration counts the calls to shift(); mAges[i] lists the hashes of
+    // the transactions received at generation mGeneration - i (some of which
+    // may be gone already, or received again later) and mAgeCounts[i] how
+    // many of them are still there from that generation
+    uint64_t mGeneration{0};
+    std::deque<std::vector<Hash>> mAges;
+    std::deque<size_t> mAgeCounts;
+
+    void removeEntry(AccountID const& account, Hash const& fullHash);
+};
+}
@@ -9,9 +9,12 @@
 #include "database/Database.h"
 #include "main/Application.h"
 #include "main/Config.h"
+#include "transactions/BatchSignatureVerifier.h"
 #include "util/Logging.h"
 #include "xdrpp/marshal.h"
 #include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
 
 #include "xdrpp/printer.h"
 
@@ -135,8 +138,8 @@ TxSetFrame::sortForApply()
 
 struct SurgeSorter
 {
-    map<AccountID, double>& mAccountFeeMap;
-    SurgeSorter(map<AccountID, double>& afm) : mAccountFeeMap(afm)
+    unordered_map<AccountID, double>& mAccountFeeMap;
+    SurgeSorter(unordered_map<AccountID, double>& afm) : mAccountFeeMap(afm)
     {
     }
 
@@ -163,7 +166,7 @@ TxSetFrame::surgePricingFilter(LedgerManager const& lm)
                                 << mTransactions.size();
 
         // determine the fee ratio for each account
-        map<AccountID, double> accountFeeMap;
+        unordered_map<AccountID, double> accountFeeMap;
         for (auto& tx : mTransactions)
         {
             double r = tx->getFeeRatio(lm);
@@ -179,10 +182,16 @@ TxSetFrame::surgePricingFilter(LedgerManager const& lm)
         std::vector<TransactionFramePtr> tempList = mTransactions;
         std::sort(tempList.begin(), tempList.end(), SurgeSorter(accountFeeMap));
 
-        for (auto iter = tempList.begin() + max; iter != tempList.end(); iter++)
-        {
-            removeTx(*iter);
-        }
+        // removed in one pass, keeping the order of the others
+        unordered_set<TransactionFramePtr> removed(tempList.begin() + max,
+                                                   tempList.end());
+        mTransactions.erase(
+            remove_if(mTransactions.begin(), mTransactions.end(),
+                      [&](TransactionFramePtr const& tx) {
+                          return removed.find(tx) != removed.end();
+                      }),
+            mTransactions.end());
+        mHashIsValid = false;
     }
 }
 
@@ -196,6 +205,8 @@ TxSetFrame::trimInvalid(Application& app,
 
     sortForHash();
 
+    BatchSignatureVerifier::preVerify(app, mTransactions);
+
     map<AccountID, vector<TransactionFramePtr>> accountTxMap;
 
     for (auto tx : mTransactions)
@@ -289,6 +300,8 @@ TxSetFrame::checkValid(Application& app) const
         lastHash = tx->getFullHash();
     }
 
+    BatchSignatureVerifier::preVerify(app, mTransactions);
+
     for (auto& item : accountTxMap)
     {
         // order by sequence number
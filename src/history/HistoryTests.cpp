@@ -9,6 +9,7 @@
 #include "catchup/CatchupWork.h"
 #include "catchup/CatchupWorkTests.h"
 #include "crypto/Hex.h"
+#include "crypto/SHA.h"
 #include "herder/LedgerCloseData.h"
 #include "history/HistoryArchive.h"
 #include "history/HistoryManager.h"
@@ -32,11 +33,13 @@
 #include "util/NonCopyable.h"
 #include "util/Timer.h"
 #include "util/TmpDir.h"
+#include "util/XDRStream.h"
 #include "work/WorkManager.h"
 #include "work/WorkParent.h"
 
 #include <cstdio>
 #include <fstream>
+#include <limits>
 #include <lib/util/format.h>
 #include <medida/counter.h>
 #include <medida/metrics_registry.h>
@@ -396,6 +399,60 @@ TEST_CASE_METHOD(HistoryTests, "HistoryManager::compress", "[history]")
     REQUIRE(!fs::exists(compressed));
 }
 
+TEST_CASE_METHOD(HistoryTests, "XDRInputFileStream reads compressed files",
+                 "[history]")
+{
+    HistoryManager& hm = app.getHistoryManager();
+    std::string fname = hm.localFilename("headers.xdr");
+    std::vector<LedgerHeaderHistoryEntry> written(100);
+    {
+        XDROutputFileStream out;
+        out.open(fname);
+        for (size_t i = 0; i < written.size(); ++i)
+        {
+            written[i].header.ledgerSeq = static_cast<uint32_t>(i + 1);
+            written[i].hash = sha256(std::to_string(i));
+            out.writeOne(written[i]);
+        }
+    }
+    gzipFile(fname, fname + ".gz");
+
+    XDRInputFileStream in;
+    in.open(fname + ".gz");
+    LedgerHeaderHistoryEntry entry;
+    size_t n = 0;
+    while (in && in.readOne(entry))
+    {
+        REQUIRE(n < written.size());
+        REQUIRE(entry.header.ledgerSeq == written[n].header.ledgerSeq);
+        REQUIRE(entry.hash == written[n].hash);
+        ++n;
+    }
+    REQUIRE(n == written.size());
+
+    SECTION("truncated file")
+    {
+        in.close();
+        std::ifstream src(fname + ".gz",
+                          std::ifstream::binary | std::ifstream::ate);
+        std::vector<char> bytes(static_cast<size_t>(src.tellg()) / 2);
+        src.seekg(0);
+        src.read(bytes.data(), bytes.size());
+        {
+            std::ofstream out(fname + ".gz",
+                              std::ofstream::binary | std::ofstream::trunc);
+            out.write(bytes.data(), bytes.size());
+        }
+        in.open(fname + ".gz");
+        auto readAll = [&]() {
+            while (in && in.readOne(entry))
+            {
+            }
+        };
+        REQUIRE_THROWS_AS(readAll(), std::runtime_error);
+    }
+}
+
 TEST_CASE_METHOD(HistoryTests, "HistoryArchiveState::get_put", "[history]")
 {
     HistoryArchiveState has;
@@ -953,6 +1010,42 @@ TEST_CASE_METHOD(HistoryTests, "Full history catchup",
     }
 }
 
+TEST_CASE_METHOD(HistoryTests, "Catchup with a small lookahead window",
+                 "[history][historycatchup]")
+{
+    generateAndPublishInitialHistory(3);
+
+    uint32_t initLedger = app.getLedgerManager().getLastClosedLedgerNum();
+    auto count = std::numeric_limits<uint32_t>::max();
+
+    // a single checkpoint ahead, and a byte budget small enough that every
+    // download but the one apply is waiting for is held back
+    std::vector<std::pair<uint32_t, size_t>> windows = {{1, 0}, {4, 1}};
+    for (auto const& window : windows)
+    {
+        mCfgs.emplace_back(getTestConfig(static_cast<int>(mCfgs.size()) + 1));
+        mCfgs.back().CATCHUP_COMPLETE = true;
+        mCfgs.back().CATCHUP_LOOKAHEAD_CHECKPOINTS = window.first;
+        mCfgs.back().CATCHUP_LOOKAHEAD_MAX_BYTES = window.second;
+        auto app2 = Application::create(
+            clock, mConfigurator->configure(mCfgs.back(), false));
+        app2->start();
+
+        CHECK(catchupApplication(initLedger, count, false, app2));
+
+        auto& verified = app2->getMetrics().NewTimer(
+            {"history", "verify-transactions", "checkpoint"});
+        auto& verifyFailures = app2->getMetrics().NewMeter(
+            {"history", "verify-transactions", "failure"}, "event");
+        auto& applied = app2->getMetrics().NewTimer(
+            {"history", "apply-transactions", "checkpoint"});
+        CHECK(verified.count() > 0);
+        CHECK(verifyFailures.count() == 0);
+        CHECK(applied.count() > 0);
+        CHECK(applied.count() <= verified.count());
+    }
+}
+
 TEST_CASE_METHOD(HistoryTests, "History publish queueing",
                  "[history][historydelay][historycatchup]")
 {
@@ -1234,7 +1327,7 @@ TEST_CASE("persist publish queue", "[history]")
 
         // Trim history after publishing.
         ExternalQueue ps(*app0);
-        ps.process();
+        ps.deleteOldEntries(std::numeric_limits<uint32_t>::max());
     }
 
     cfg.MAX_CONCURRENT_SUBPROCESSES = 32;
@@ -1253,7 +1346,7 @@ TEST_CASE("persist publish queue", "[history]")
 
             // Trim history after publishing whenever possible.
             ExternalQueue ps(*app1);
-            ps.process();
+            ps.deleteOldEntries(std::numeric_limits<uint32_t>::max());
         }
         // We should have either an empty publish queue or a
         // ledger sometime after the 5th checkpoint
@@ -18,13 +18,14 @@ namespace stellar
 BatchDownloadWork::BatchDownloadWork(Application& app, WorkParent& parent,
                                      CheckpointRange range,
                                      std::string const& type,
-                                     TmpDir const& downloadDir)
+                                     TmpDir const& downloadDir, bool unzip)
     : Work(app, parent, fmt::format("batch-download-{:s}-{:08x}-{:08x}", type,
                                     range.first(), range.last()))
     , mRange(range)
     , mNext(mRange.first())
     , mFileType(type)
     , mDownloadDir(downloadDir)
+    , mUnzip(unzip)
     , mDownloadCached(app.getMetrics().NewMeter(
           {"history", "download-" + type, "cached"}, "event"))
     , mDownloadStart(app.getMetrics().NewMeter(
@@ -56,7 +57,7 @@ BatchDownloadWork::addNextDownloadWorker()
     }
 
     FileTransferInfo ft(mDownloadDir, mFileType, mNext);
-    if (fs::exists(ft.localPath_nogz()))
+    if (fs::exists(mUnzip ? ft.localPath_nogz() : ft.localPath_gz()))
     {
         CLOG(DEBUG, "History") << "already have " << mFileType
                                << " for checkpoint " << mNext;
@@ -66,7 +67,7 @@ BatchDownloadWork::addNextDownloadWorker()
     {
         CLOG(DEBUG, "History") << "Downloading and unzipping " << mFileType
                                << " for checkpoint " << mNext;
-        auto getAndUnzip = addWork<GetAndUnzipRemoteFileWork>(ft);
+        auto getAndUnzip = addWork<GetAndUnzipRemoteFileWork>(ft, mUnzip);
         assert(mRunning.find(getAndUnzip->getUniqueName()) == mRunning.end());
         mRunning.insert(std::make_pair(getAndUnzip->getUniqueName(), mNext));
         mDownloadStart.Mark();
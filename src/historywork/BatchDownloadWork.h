@@ -33,6 +33,7 @@ class BatchDownloadWork : public Work
     uint32_t mNext;
     std::string mFileType;
     TmpDir const& mDownloadDir;
+    bool mUnzip;
 
     medida::Meter& mDownloadCached;
     medida::Meter& mDownloadStart;
@@ -42,9 +43,11 @@ class BatchDownloadWork : public Work
     void addNextDownloadWorker();
 
   public:
+    // With unzip unset files are left compressed, see
+    // GetAndUnzipRemoteFileWork.
     BatchDownloadWork(Application& app, WorkParent& parent,
                       CheckpointRange range, std::string const& type,
-                      TmpDir const& downloadDir);
+                      TmpDir const& downloadDir, bool unzip = true);
     std::string getStatus() const override;
     void onReset() override;
     void notify(std::string const& child) override;
@@ -12,12 +12,13 @@ namespace stellar
 {
 
 GetAndUnzipRemoteFileWork::GetAndUnzipRemoteFileWork(
-    Application& app, WorkParent& parent, FileTransferInfo ft,
+    Application& app, WorkParent& parent, FileTransferInfo ft, bool unzip,
     std::shared_ptr<HistoryArchive const> archive, size_t maxRetries)
     : Work(app, parent,
            std::string("get-and-unzip-remote-file ") + ft.remoteName(),
            maxRetries)
     , mFt(std::move(ft))
+    , mUnzip(unzip)
     , mArchive(archive)
 {
 }
@@ -104,6 +105,11 @@ GetAndUnzipRemoteFileWork::onSuccess()
         return WORK_FAILURE_RETRY;
     }
 
+    if (!mUnzip)
+    {
+        return WORK_SUCCESS;
+    }
+
     CLOG(DEBUG, "History") << "Downloading and unzipping " << mFt.remoteName()
                            << ": unzipping";
     mGunzipFileWork =
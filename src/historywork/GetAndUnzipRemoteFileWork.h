@@ -19,14 +19,19 @@ class GetAndUnzipRemoteFileWork : public Work
     std::shared_ptr<Work> mGunzipFileWork;
 
     FileTransferInfo mFt;
+    bool mUnzip;
     std::shared_ptr<HistoryArchive const> mArchive;
 
   public:
     // Passing `nullptr` for the archive argument will cause the work to
     // select a new readable history archive at random each time it runs /
     // retries.
+    //
+    // With unzip unset the file is left compressed at ft.localPath_gz(), for
+    // readers that decompress as they go (see XDRInputFileStream).
     GetAndUnzipRemoteFileWork(
         Application& app, WorkParent& parent, FileTransferInfo ft,
+        bool unzip = true,
         std::shared_ptr<HistoryArchive const> archive = nullptr,
         size_t maxRetries = Work::RETRY_A_LOT);
     std::string getStatus() const override;
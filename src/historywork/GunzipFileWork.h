@@ -4,21 +4,24 @@
 
 #pragma once
 
-#include "historywork/RunCommandWork.h"
+#include "work/Work.h"
 
 namespace stellar
 {
 
-class GunzipFileWork : public RunCommandWork
+// Decompresses <file>.gz to <file> on a worker thread, removing the .gz
+// unless keepExisting is set.
+class GunzipFileWork : public Work
 {
     std::string mFilenameGz;
     bool mKeepExisting;
-    void getCommand(std::string& cmdLine, std::string& outFile) override;
 
   public:
     GunzipFileWork(Application& app, WorkParent& parent,
                    std::string const& filenameGz, bool keepExisting = false,
                    size_t maxRetries = Work::RETRY_NEVER);
     void onReset() override;
+    void onStart() override;
+    void onRun() override;
 };
 }
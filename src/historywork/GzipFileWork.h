@@ -4,20 +4,23 @@
 
 #pragma once
 
-#include "historywork/RunCommandWork.h"
+#include "work/Work.h"
 
 namespace stellar
 {
 
-class GzipFileWork : public RunCommandWork
+// Compresses a file to <file>.gz on a worker thread, removing the original
+// unless keepExisting is set.
+class GzipFileWork : public Work
 {
     std::string mFilenameNoGz;
     bool mKeepExisting;
-    void getCommand(std::string& cmdLine, std::string& outFile) override;
 
   public:
     GzipFileWork(Application& app, WorkParent& parent,
                  std::string const& filenameNoGz, bool keepExisting = false);
     void onReset() override;
+    void onStart() override;
+    void onRun() override;
 };
 }
@@ -3,17 +3,17 @@
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
 #include "historywork/VerifyBucketWork.h"
+#include "bucket/BucketIndex.h"
 #include "bucket/BucketManager.h"
 #include "crypto/Hex.h"
 #include "crypto/SHA.h"
 #include "main/Application.h"
 #include "util/Fs.h"
 #include "util/Logging.h"
+#include "util/MappedFile.h"
 #include <medida/meter.h>
 #include <medida/metrics_registry.h>
 
-#include <fstream>
-
 namespace stellar
 {
 
@@ -41,24 +41,42 @@ VerifyBucketWork::onStart()
     uint256 hash = mHash;
     Application& app = this->mApp;
     auto handler = callComplete();
-    app.getWorkerIOService().post([&app, filename, handler, hash]() {
+    std::weak_ptr<VerifyBucketWork> weak(
+        std::static_pointer_cast<VerifyBucketWork>(shared_from_this()));
+    app.getWorkerIOService().post([&app, filename, handler, hash, weak]() {
         auto hasher = SHA256::create();
         asio::error_code ec;
-        char buf[4096];
+        std::shared_ptr<BucketIndex const> index;
         {
-            // ensure that the stream gets its own scope to avoid race with
+            // ensure that the mapping gets its own scope to avoid race with
             // main thread
-            std::ifstream in(filename, std::ifstream::binary);
-            while (in)
+            MappedFile in;
+            try
+            {
+                in.open(filename);
+                hasher->add(ByteSlice(in.data(), in.size()));
+            }
+            catch (std::runtime_error const&)
             {
-                in.read(buf, sizeof(buf));
-                hasher->add(ByteSlice(buf, in.gcount()));
+                // reported below as a hash mismatch
             }
             uint256 vHash = hasher->finish();
             if (vHash == hash)
             {
                 CLOG(DEBUG, "History") << "Verified hash (" << hexAbbrev(hash)
                                        << ") for " << filename;
+                // indexed here rather than when the bucket is adopted, on
+                // the main thread
+                try
+                {
+                    index = BucketIndex::build(filename);
+                }
+                catch (std::runtime_error const& e)
+                {
+                    CLOG(WARNING, "History") << "FAILED indexing " << filename
+                                             << ": " << e.what();
+                    ec = std::make_error_code(std::errc::io_error);
+                }
             }
             else
             {
@@ -70,7 +88,14 @@ VerifyBucketWork::onStart()
                 ec = std::make_error_code(std::errc::io_error);
             }
         }
-        app.getClock().getIOService().post([ec, handler]() { handler(ec); });
+        app.getClock().getIOService().post([ec, handler, weak, index]() {
+            auto self = weak.lock();
+            if (self)
+            {
+                self->mIndex = index;
+            }
+            handler(ec);
+        });
     });
 }
 
@@ -83,7 +108,8 @@ VerifyBucketWork::onRun()
 Work::State
 VerifyBucketWork::onSuccess()
 {
-    auto b = mApp.getBucketManager().adoptFileAsBucket(mBucketFile, mHash);
+    auto b = mApp.getBucketManager().adoptFileAsBucket(mBucketFile, mHash, 0,
+                                                       0, mIndex);
     mBuckets[binToHex(mHash)] = b;
     mVerifyBucketSuccess.Mark();
     return WORK_SUCCESS;
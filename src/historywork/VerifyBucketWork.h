@@ -16,12 +16,15 @@ namespace stellar
 {
 
 class Bucket;
+class BucketIndex;
 
 class VerifyBucketWork : public Work
 {
     std::map<std::string, std::shared_ptr<Bucket>>& mBuckets;
     std::string mBucketFile;
     uint256 mHash;
+    // built on the worker thread along with checking the hash
+    std::shared_ptr<BucketIndex const> mIndex;
 
     medida::Meter& mVerifyBucketSuccess;
     medida::Meter& mVerifyBucketFailure;
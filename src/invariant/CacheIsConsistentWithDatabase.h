@@ -14,6 +14,9 @@ class Application;
 class Database;
 class LedgerDelta;
 
+// Always checked on ledger close, even when invariants are checked
+// asynchronously: the entry cache belongs to the main thread, and the next
+// ledger changes it.
 class CacheIsConsistentWithDatabase : public Invariant
 {
   public:
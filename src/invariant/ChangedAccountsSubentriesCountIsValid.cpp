@@ -116,9 +116,33 @@ std::string
 ChangedAccountsSubentriesCountIsValid::checkOnLedgerClose(
     LedgerDelta const& delta)
 {
-    for (auto const& account : getAddedOrUpdatedAccounts(delta))
+    return check(getAddedOrUpdatedAccounts(delta), getDeletedAccounts(delta),
+                 [this](AccountID const& account) {
+                     return numberOfSubentries(account, mDb);
+                 });
+}
+
+CommittedLedgerCheck
+ChangedAccountsSubentriesCountIsValid::prepareCheckOnLedgerCommit(
+    LedgerDelta const& delta)
+{
+    auto changed = getAddedOrUpdatedAccounts(delta);
+    auto deleted = getDeletedAccounts(delta);
+    return [changed, deleted](soci::session& sess) {
+        return check(changed, deleted, [&sess](AccountID const& account) {
+            return numberOfSubentries(account, sess);
+        });
+    };
+}
+
+std::string
+ChangedAccountsSubentriesCountIsValid::check(
+    std::set<AccountID> const& changed, std::set<AccountID> const& deleted,
+    std::function<NumberOfSubentries(AccountID const&)> const& count)
+{
+    for (auto const& account : changed)
     {
-        auto subentries = numberOfSubentries(account, mDb);
+        auto subentries = count(account);
         if (subentries.inAccountsTable != subentries.calculated)
         {
             return fmt::format("account {} subentries count mismatch: "
@@ -129,9 +153,9 @@ ChangedAccountsSubentriesCountIsValid::checkOnLedgerClose(
         }
     }
 
-    for (auto const& account : getDeletedAccounts(delta))
+    for (auto const& account : deleted)
     {
-        auto subentries = numberOfSubentries(account, mDb);
+        auto subentries = count(account);
         if (subentries.inAccountsTable != subentries.calculated ||
             subentries.inAccountsTable != 0)
         {
@@ -4,8 +4,10 @@
 // under the Apache License, Version 2.0. See the COPYING file at the root
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
+#include "database/AccountQueries.h"
 #include "invariant/Invariant.h"
 #include <memory>
+#include <set>
 
 namespace stellar
 {
@@ -24,7 +26,15 @@ class ChangedAccountsSubentriesCountIsValid : public Invariant
 
     virtual std::string checkOnLedgerClose(LedgerDelta const& delta) override;
 
+    virtual CommittedLedgerCheck
+    prepareCheckOnLedgerCommit(LedgerDelta const& delta) override;
+
   private:
     Database& mDb;
+
+    static std::string
+    check(std::set<AccountID> const& changed,
+          std::set<AccountID> const& deleted,
+          std::function<NumberOfSubentries(AccountID const&)> const& count);
 };
 }
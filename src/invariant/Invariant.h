@@ -4,13 +4,24 @@
 // under the Apache License, Version 2.0. See the COPYING file at the root
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
+#include <functional>
 #include <string>
 
+namespace soci
+{
+class session;
+}
+
 namespace stellar
 {
 
 class LedgerDelta;
 
+// A check of the changes of a ledger, run once the ledger is committed,
+// reading the state of the ledger through a session of its own. Returns what
+// Invariant::checkOnLedgerClose would.
+typedef std::function<std::string(soci::session& sess)> CommittedLedgerCheck;
+
 // NOTE: The checkOn* functions should have a default implementation so that
 //       more can be added in the future without requiring changes to all
 //       derived classes.
@@ -28,5 +39,25 @@ class Invariant
     {
         return std::string{};
     }
+
+    // When invariants are checked asynchronously, called on ledger close
+    // instead of checkOnLedgerClose to take what is needed from `delta` for
+    // a check run later on a worker thread. The checks prepared by an
+    // invariant run one at a time, in ledger order, but the checks of a
+    // ledger are skipped when they fall behind, so they can't count on seeing
+    // every ledger. Invariants that can only be checked on ledger close
+    // return nullptr.
+    virtual CommittedLedgerCheck
+    prepareCheckOnLedgerCommit(LedgerDelta const& delta)
+    {
+        return nullptr;
+    }
+
+    // Asks invariants that only check what changed on ledger close to check
+    // everything on the next one.
+    virtual void
+    requestFullCheck()
+    {
+    }
 };
 }
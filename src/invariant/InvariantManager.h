@@ -20,6 +20,11 @@ class LedgerDelta;
  * When the appropriate event, such as a ledger close, triggers the
  * InvariantManager it will check each of the enabled invariants and
  * throw InvariantDoesNotHold if any are violated.
+ *
+ * With ASYNC_INVARIANT_CHECKS, invariants that allow it are instead checked
+ * on a worker thread once the ledger is committed, against a snapshot of the
+ * database as of that ledger, while the next ledger closes. A violation is
+ * then thrown by reportFailedChecks, at the start of the next ledger close.
  */
 class InvariantManager
 {
@@ -33,6 +38,21 @@ class InvariantManager
     virtual void checkOnLedgerClose(TxSetFramePtr const& txSet,
                                     LedgerDelta const& delta) = 0;
 
+    // Starts the checks prepared by the last checkOnLedgerClose, once its
+    // ledger is committed.
+    virtual void checkOnLedgerCommit() = 0;
+
+    // Throws InvariantDoesNotHold if a check started by checkOnLedgerCommit
+    // failed.
+    virtual void reportFailedChecks() = 0;
+
+    // Waits for the checks started by checkOnLedgerCommit, then reports
+    // their failures.
+    virtual void waitForChecks() = 0;
+
+    // See Invariant::requestFullCheck.
+    virtual void requestFullChecks() = 0;
+
     virtual void registerInvariant(std::shared_ptr<Invariant> invariant) = 0;
     virtual void enableInvariant(std::string const& name) = 0;
 
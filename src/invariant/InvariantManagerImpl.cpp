@@ -7,11 +7,21 @@
 #include "invariant/ChangedAccountsSubentriesCountIsValid.h"
 #include "invariant/InvariantDoesNotHold.h"
 #include "invariant/TotalCoinsEqualsBalancesPlusFeePool.h"
+#include "database/Database.h"
 #include "ledger/LedgerDelta.h"
 #include "lib/util/format.h"
+#include "main/Application.h"
+#include "main/Config.h"
+#include "medida/counter.h"
+#include "medida/meter.h"
+#include "medida/metrics_registry.h"
+#include "medida/timer.h"
 #include "util/Logging.h"
 #include "xdrpp/printer.h"
+#include <condition_variable>
+#include <deque>
 #include <memory>
+#include <mutex>
 #include <numeric>
 
 namespace stellar
@@ -20,33 +30,291 @@ namespace stellar
 std::unique_ptr<InvariantManager>
 InvariantManager::create(Application& app)
 {
-    return make_unique<InvariantManagerImpl>();
+    return make_unique<InvariantManagerImpl>(app);
 }
 
-InvariantManagerImpl::InvariantManagerImpl()
+// The checks prepared on the close of a ledger, and the session they read
+// the ledger through once it is committed.
+struct InvariantManagerImpl::CommittedLedger
+{
+    struct Check
+    {
+        std::shared_ptr<Invariant> mInvariant;
+        CommittedLedgerCheck mCheck;
+    };
+
+    uint32_t mLedgerSeq;
+    TxSetFramePtr mTxSet;
+    std::vector<Check> mChecks;
+
+    // read-only transaction on a session leased from the pool, started
+    // right after the ledger was committed; rolled back when done
+    soci::connection_pool* mPool{nullptr};
+    std::size_t mPoolPos{0};
+    std::unique_ptr<soci::transaction> mTransaction;
+
+    ~CommittedLedger()
+    {
+        release();
+    }
+
+    soci::session&
+    session()
+    {
+        return mPool->at(mPoolPos);
+    }
+
+    void
+    release()
+    {
+        mTransaction.reset();
+        if (mPool)
+        {
+            mPool->give_back(mPoolPos);
+            mPool = nullptr;
+        }
+    }
+};
+
+struct InvariantManagerImpl::AsyncChecks
+{
+    std::mutex mMutex;
+    std::condition_variable mDone;
+    // committed ledgers to check, in order
+    std::deque<std::shared_ptr<CommittedLedger>> mQueue;
+    bool mRunning{false};
+
+    // first check that failed; no other check is run after it
+    std::shared_ptr<CommittedLedger> mFailedLedger;
+    std::string mFailedInvariant;
+    std::string mFailure;
+};
+
+static void
+throwInvariantDoesNotHold(std::string const& name, uint32_t ledgerSeq,
+                          std::string const& result,
+                          TxSetFramePtr const& txSet)
+{
+    auto transactions = TransactionSet{};
+    txSet->toXDR(transactions);
+    auto message =
+        fmt::format(R"(invariant "{}" does not hold on ledger {}: {}{}{})",
+                    name, ledgerSeq, result, "\n",
+                    xdr::xdr_to_string(transactions));
+    CLOG(FATAL, "Invariant") << message;
+    throw InvariantDoesNotHold{message};
+}
+
+size_t const InvariantManagerImpl::MAX_PENDING_LEDGERS = 2;
+
+InvariantManagerImpl::InvariantManagerImpl(Application& app)
+    : mApp(app)
+    , mAsync(app.getConfig().ASYNC_INVARIANT_CHECKS &&
+             app.getDatabase().canUsePool())
+    , mAsyncChecks(std::make_shared<AsyncChecks>())
+    , mAsyncCheckTime(
+          app.getMetrics().NewTimer({"ledger", "invariant", "async-check"}))
+    , mAsyncCheckPending(
+          app.getMetrics().NewCounter({"ledger", "invariant", "async-pending"}))
+    , mAsyncCheckSkip(app.getMetrics().NewMeter(
+          {"ledger", "invariant", "async-skip"}, "ledger"))
 {
 }
 
+InvariantManagerImpl::~InvariantManagerImpl()
+{
+    waitForRunningChecks();
+    std::lock_guard<std::mutex> lock(mAsyncChecks->mMutex);
+    auto const& failed = mAsyncChecks->mFailedLedger;
+    if (failed)
+    {
+        CLOG(FATAL, "Invariant")
+            << "invariant \"" << mAsyncChecks->mFailedInvariant
+            << "\" does not hold on ledger " << failed->mLedgerSeq << ": "
+            << mAsyncChecks->mFailure;
+    }
+}
+
 void
 InvariantManagerImpl::checkOnLedgerClose(TxSetFramePtr const& txSet,
                                          LedgerDelta const& delta)
 {
+    // checks prepared by a ledger close that failed half-way are dropped
+    mPrepared.reset();
+    auto prepared = std::make_shared<CommittedLedger>();
+    prepared->mLedgerSeq = delta.getHeader().ledgerSeq;
+    prepared->mTxSet = txSet;
+
     for (auto invariant : mEnabled)
     {
+        if (mAsync)
+        {
+            auto check = invariant->prepareCheckOnLedgerCommit(delta);
+            if (check)
+            {
+                prepared->mChecks.emplace_back(
+                    CommittedLedger::Check{invariant, check});
+                continue;
+            }
+        }
+
         auto result = invariant->checkOnLedgerClose(delta);
-        if (result.empty())
+        if (!result.empty())
         {
-            continue;
+            throwInvariantDoesNotHold(invariant->getName(),
+                                      delta.getHeader().ledgerSeq, result,
+                                      txSet);
         }
+    }
+
+    if (!prepared->mChecks.empty())
+    {
+        mPrepared = prepared;
+    }
+}
+
+void
+InvariantManagerImpl::checkOnLedgerCommit()
+{
+    if (!mPrepared)
+    {
+        return;
+    }
+    auto ledger = std::move(mPrepared);
 
-        auto transactions = TransactionSet{};
-        txSet->toXDR(transactions);
-        auto message =
-            fmt::format(R"(invariant "{}" does not hold on ledger {}: {}{}{})",
-                        invariant->getName(), delta.getHeader().ledgerSeq,
-                        result, "\n", xdr::xdr_to_string(transactions));
-        CLOG(FATAL, "Invariant") << message;
-        throw InvariantDoesNotHold{message};
+    // Ledger close must not wait for the checks: when they fall behind, or
+    // the pool has no session to spare, this ledger goes unchecked and the
+    // checks of the next one notice the gap.
+    auto& db = mApp.getDatabase();
+    auto& pool = db.getPool();
+    size_t pos;
+    if (static_cast<size_t>(mAsyncCheckPending.count()) >=
+            MAX_PENDING_LEDGERS ||
+        !pool.try_lease(pos, 0))
+    {
+        CLOG(DEBUG, "Invariant") << "Skipping checks of ledger "
+                                 << ledger->mLedgerSeq;
+        mAsyncCheckSkip.Mark();
+        return;
+    }
+    ledger->mPool = &pool;
+    ledger->mPoolPos = pos;
+
+    // The snapshot read by the checks is taken now, by the first read of the
+    // transaction, before the next ledger gets to change anything.
+    auto& sess = ledger->session();
+    ledger->mTransaction = make_unique<soci::transaction>(sess);
+    if (!db.isSqlite())
+    {
+        sess << "SET TRANSACTION READ ONLY";
+    }
+    int n;
+    sess << "SELECT COUNT(*) FROM storestate", soci::into(n);
+
+    mAsyncCheckPending.inc();
+    bool start;
+    {
+        std::lock_guard<std::mutex> lock(mAsyncChecks->mMutex);
+        mAsyncChecks->mQueue.emplace_back(std::move(ledger));
+        start = !mAsyncChecks->mRunning;
+        mAsyncChecks->mRunning = true;
+    }
+    if (start)
+    {
+        auto checks = mAsyncChecks;
+        auto& time = mAsyncCheckTime;
+        auto& pending = mAsyncCheckPending;
+        mApp.getWorkerIOService().post(
+            [checks, &time, &pending]() { runChecks(checks, time, pending); });
+    }
+}
+
+void
+InvariantManagerImpl::runChecks(std::shared_ptr<AsyncChecks> checks,
+                                medida::Timer& time, medida::Counter& pending)
+{
+    for (;;)
+    {
+        std::shared_ptr<CommittedLedger> ledger;
+        {
+            std::lock_guard<std::mutex> lock(checks->mMutex);
+            if (checks->mQueue.empty())
+            {
+                checks->mRunning = false;
+                checks->mDone.notify_all();
+                return;
+            }
+            ledger = checks->mQueue.front();
+            checks->mQueue.pop_front();
+            if (checks->mFailedLedger)
+            {
+                ledger.reset();
+            }
+        }
+
+        if (ledger)
+        {
+            auto timer = time.TimeScope();
+            for (auto const& c : ledger->mChecks)
+            {
+                std::string result;
+                try
+                {
+                    result = c.mCheck(ledger->session());
+                }
+                catch (std::exception& e)
+                {
+                    result = std::string{"check failed: "} + e.what();
+                }
+                if (!result.empty())
+                {
+                    std::lock_guard<std::mutex> lock(checks->mMutex);
+                    checks->mFailedLedger = ledger;
+                    checks->mFailedInvariant = c.mInvariant->getName();
+                    checks->mFailure = result;
+                    break;
+                }
+            }
+            ledger->release();
+        }
+        pending.dec();
+    }
+}
+
+void
+InvariantManagerImpl::reportFailedChecks()
+{
+    std::lock_guard<std::mutex> lock(mAsyncChecks->mMutex);
+    auto const& failed = mAsyncChecks->mFailedLedger;
+    if (failed)
+    {
+        throwInvariantDoesNotHold(mAsyncChecks->mFailedInvariant,
+                                  failed->mLedgerSeq, mAsyncChecks->mFailure,
+                                  failed->mTxSet);
+    }
+}
+
+void
+InvariantManagerImpl::waitForChecks()
+{
+    waitForRunningChecks();
+    reportFailedChecks();
+}
+
+void
+InvariantManagerImpl::waitForRunningChecks()
+{
+    std::unique_lock<std::mutex> lock(mAsyncChecks->mMutex);
+    auto checks = mAsyncChecks;
+    checks->mDone.wait(lock, [checks]() { return !checks->mRunning; });
+}
+
+void
+InvariantManagerImpl::requestFullChecks()
+{
+    for (auto invariant : mEnabled)
+    {
+        invariant->requestFullCheck();
     }
 }
 
@@ -4,25 +4,64 @@
 // under the Apache License, Version 2.0. See the COPYING file at the root
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
+#include "invariant/Invariant.h"
 #include "invariant/InvariantManager.h"
 #include "util/make_unique.h"
 #include <map>
 #include <vector>
 
+namespace medida
+{
+class Counter;
+class Meter;
+class Timer;
+}
+
 namespace stellar
 {
 
 class InvariantManagerImpl : public InvariantManager
 {
+    Application& mApp;
     std::map<std::string, std::shared_ptr<Invariant>> mInvariants;
     std::vector<std::shared_ptr<Invariant>> mEnabled;
+    bool const mAsync;
+
+    struct CommittedLedger;
+    struct AsyncChecks;
+
+    // checks prepared by the last checkOnLedgerClose
+    std::shared_ptr<CommittedLedger> mPrepared;
+    // shared with the worker thread running the checks
+    std::shared_ptr<AsyncChecks> mAsyncChecks;
+
+    medida::Timer& mAsyncCheckTime;
+    medida::Counter& mAsyncCheckPending;
+    medida::Meter& mAsyncCheckSkip;
+
+    // committed ledgers waiting to be checked past which the checks of the
+    // next ones are skipped rather than holding on to more sessions of the
+    // pool
+    static size_t const MAX_PENDING_LEDGERS;
+
+    static void runChecks(std::shared_ptr<AsyncChecks> checks,
+                          medida::Timer& time, medida::Counter& pending);
+    void waitForRunningChecks();
 
   public:
-    InvariantManagerImpl();
+    explicit InvariantManagerImpl(Application& app);
+    // waits for the pending checks and logs the first one that failed
+    ~InvariantManagerImpl();
 
     virtual void checkOnLedgerClose(TxSetFramePtr const& txSet,
                                     LedgerDelta const& delta) override;
 
+    virtual void checkOnLedgerCommit() override;
+    virtual void reportFailedChecks() override;
+    virtual void waitForChecks() override;
+
+    virtual void requestFullChecks() override;
+
     virtual void
     registerInvariant(std::shared_ptr<Invariant> invariant) override;
     virtual void enableInvariant(std::string const& name) override;
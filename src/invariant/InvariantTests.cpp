@@ -5,13 +5,22 @@
 #include "util/asio.h"
 
 #include "crypto/Hex.h"
+#include "database/Database.h"
 #include "herder/TxSetFrame.h"
 #include "invariant/Invariant.h"
 #include "invariant/InvariantDoesNotHold.h"
 #include "invariant/InvariantManager.h"
+#include "invariant/TotalCoinsEqualsBalancesPlusFeePool.h"
+#include "ledger/AccountFrame.h"
 #include "ledger/LedgerDelta.h"
+#include "ledger/LedgerManager.h"
 #include "lib/catch.hpp"
+#include "lib/util/format.h"
 #include "main/Application.h"
+#include "medida/meter.h"
+#include "medida/metrics_registry.h"
+#include "test/TestAccount.h"
+#include "test/TxTests.h"
 #include "test/test.h"
 #include "util/Timer.h"
 
@@ -42,6 +51,47 @@ class TestInvariant : public Invariant
   private:
     bool mShouldFail;
 };
+
+class CommittedTestInvariant : public Invariant
+{
+  public:
+    CommittedTestInvariant(bool shouldFail) : mShouldFail(shouldFail)
+    {
+    }
+
+    virtual std::string
+    getName() const override
+    {
+        return "CommittedTestInvariant";
+    }
+
+    virtual std::string
+    checkOnLedgerClose(LedgerDelta const& delta) override
+    {
+        return "checked on ledger close";
+    }
+
+    virtual CommittedLedgerCheck
+    prepareCheckOnLedgerCommit(LedgerDelta const& delta) override
+    {
+        int ledgerSeq = delta.getHeader().ledgerSeq;
+        bool shouldFail = mShouldFail;
+        return [ledgerSeq, shouldFail](soci::session& sess) -> std::string {
+            int lastSeq;
+            sess << "SELECT MAX(ledgerseq) FROM ledgerheaders",
+                soci::into(lastSeq);
+            if (lastSeq != ledgerSeq)
+            {
+                return fmt::format("checked ledger {} as of ledger {}",
+                                   ledgerSeq, lastSeq);
+            }
+            return shouldFail ? "fail" : "";
+        };
+    }
+
+  private:
+    bool mShouldFail;
+};
 }
 
 using namespace InvariantTests;
@@ -122,3 +172,161 @@ TEST_CASE("onLedgerClose fail/succeed", "[invariant]")
             app->getInvariantManager().checkOnLedgerClose(tsfp, ld));
     }
 }
+
+TEST_CASE("total coins checked incrementally", "[invariant]")
+{
+    VirtualClock clock;
+    Config cfg = getTestConfig();
+    Application::pointer app = Application::create(clock, cfg);
+    app->start();
+
+    auto& db = app->getDatabase();
+    auto rootID = txtest::getRoot(app->getNetworkID()).getPublicKey();
+    LedgerHeader lh = app->getLedgerManager().getCurrentLedgerHeader();
+    lh.ledgerVersion = Config::CURRENT_LEDGER_PROTOCOL_VERSION;
+
+    // burns `amount` of the root account in the next ledger, recording the
+    // previous state of the account in the delta if `record`
+    auto closeBurning = [&](TotalCoinsEqualsBalancesPlusFeePool& invariant,
+                            int64_t amount, bool record) {
+        LedgerDelta delta(lh, db);
+        auto root = record ? AccountFrame::loadAccount(delta, rootID, db)
+                           : AccountFrame::loadAccount(rootID, db);
+        REQUIRE(root->addBalance(-amount));
+        root->storeChange(delta, db);
+        delta.getHeader().totalCoins -= amount;
+        auto result = invariant.checkOnLedgerClose(delta);
+        delta.commit();
+        lh.ledgerSeq++;
+        return result;
+    };
+
+    TotalCoinsEqualsBalancesPlusFeePool invariant(db, 0);
+    REQUIRE(closeBurning(invariant, 10, true).empty());
+    REQUIRE(invariant.getFullCheckCount() == 1);
+
+    SECTION("changes followed without summing balances")
+    {
+        for (int i = 0; i < 5; ++i)
+        {
+            REQUIRE(closeBurning(invariant, 10, true).empty());
+        }
+        REQUIRE(invariant.getFullCheckCount() == 1);
+    }
+
+    SECTION("balances summed when previous state is not recorded")
+    {
+        REQUIRE(closeBurning(invariant, 10, false).empty());
+        REQUIRE(invariant.getFullCheckCount() == 2);
+        REQUIRE(closeBurning(invariant, 10, true).empty());
+        REQUIRE(invariant.getFullCheckCount() == 2);
+    }
+
+    SECTION("balances summed when ledgers are skipped")
+    {
+        lh.ledgerSeq++;
+        REQUIRE(closeBurning(invariant, 10, true).empty());
+        REQUIRE(invariant.getFullCheckCount() == 2);
+    }
+
+    SECTION("balances summed on request")
+    {
+        invariant.requestFullCheck();
+        REQUIRE(closeBurning(invariant, 10, true).empty());
+        REQUIRE(invariant.getFullCheckCount() == 2);
+    }
+
+    SECTION("balances summed periodically")
+    {
+        TotalCoinsEqualsBalancesPlusFeePool periodic(db, 2);
+        for (int i = 0; i < 7; ++i)
+        {
+            REQUIRE(closeBurning(periodic, 10, true).empty());
+        }
+        REQUIRE(periodic.getFullCheckCount() == 3);
+    }
+
+    SECTION("changes made outside of ledger closes are found")
+    {
+        {
+            LedgerDelta delta(lh, db);
+            auto root = AccountFrame::loadAccount(rootID, db);
+            REQUIRE(root->addBalance(5));
+            root->storeChange(delta, db);
+        }
+        REQUIRE(!closeBurning(invariant, 10, true).empty());
+        REQUIRE(invariant.getFullCheckCount() == 2);
+    }
+}
+
+TEST_CASE("invariants checked after commit", "[invariant]")
+{
+    VirtualClock clock;
+    Config cfg = getTestConfig(0, Config::TESTDB_ON_DISK_SQLITE);
+    cfg.ASYNC_INVARIANT_CHECKS = true;
+
+    SECTION("succeed")
+    {
+        Application::pointer app = Application::create(clock, cfg);
+        app->getInvariantManager().registerInvariant<CommittedTestInvariant>(
+            false);
+        app->getInvariantManager().enableInvariant("CommittedTestInvariant");
+        app->start();
+
+        auto root = txtest::TestAccount::createRoot(*app);
+        auto a = root.create("a", 1000000000);
+        for (int i = 0; i < 5; ++i)
+        {
+            auto ledgerSeq = app->getLedgerManager().getLedgerNum();
+            REQUIRE_NOTHROW(txtest::closeLedgerOn(
+                *app, ledgerSeq, 1, 1, 2017,
+                {root.tx({txtest::payment(a, 1)})}));
+        }
+        REQUIRE_NOTHROW(app->getInvariantManager().waitForChecks());
+    }
+
+    SECTION("fail on next ledger close")
+    {
+        Application::pointer app = Application::create(clock, cfg);
+        app->getInvariantManager().registerInvariant<CommittedTestInvariant>(
+            true);
+        app->getInvariantManager().enableInvariant("CommittedTestInvariant");
+        app->start();
+
+        auto ledgerSeq = app->getLedgerManager().getLedgerNum();
+        REQUIRE_NOTHROW(txtest::closeLedgerOn(*app, ledgerSeq, 1, 1, 2017));
+        REQUIRE_THROWS_AS(app->getInvariantManager().waitForChecks(),
+                          InvariantDoesNotHold);
+        REQUIRE_THROWS_AS(
+            txtest::closeLedgerOn(*app, ledgerSeq + 1, 1, 1, 2017),
+            InvariantDoesNotHold);
+    }
+
+    SECTION("skipped when no session is free")
+    {
+        Application::pointer app = Application::create(clock, cfg);
+        app->getInvariantManager().registerInvariant<CommittedTestInvariant>(
+            true);
+        app->getInvariantManager().enableInvariant("CommittedTestInvariant");
+        app->start();
+
+        auto& skips = app->getMetrics().NewMeter(
+            {"ledger", "invariant", "async-skip"}, "ledger");
+        auto& pool = app->getDatabase().getPool();
+        std::vector<size_t> leased;
+        size_t pos;
+        while (pool.try_lease(pos, 0))
+        {
+            leased.push_back(pos);
+        }
+
+        auto ledgerSeq = app->getLedgerManager().getLedgerNum();
+        REQUIRE_NOTHROW(txtest::closeLedgerOn(*app, ledgerSeq, 1, 1, 2017));
+        REQUIRE(skips.count() == 1);
+        for (auto p : leased)
+        {
+            pool.give_back(p);
+        }
+        REQUIRE_NOTHROW(app->getInvariantManager().waitForChecks());
+    }
+}
@@ -8,6 +8,8 @@
 #include "ledger/LedgerDelta.h"
 #include "lib/util/format.h"
 #include "main/Application.h"
+#include "main/Config.h"
+#include "util/Logging.h"
 
 namespace stellar
 {
@@ -17,12 +19,12 @@ TotalCoinsEqualsBalancesPlusFeePool::registerInvariant(Application& app)
 {
     return app.getInvariantManager()
         .registerInvariant<TotalCoinsEqualsBalancesPlusFeePool>(
-            app.getDatabase());
+            app.getDatabase(), app.getConfig().INVARIANT_FULL_CHECK_PERIOD);
 }
 
 TotalCoinsEqualsBalancesPlusFeePool::TotalCoinsEqualsBalancesPlusFeePool(
-    Database& db)
-    : mDb{db}
+    Database& db, uint32_t fullCheckPeriod)
+    : mDb{db}, mFullCheckPeriod{fullCheckPeriod}
 {
 }
 
@@ -36,23 +38,111 @@ std::string
 TotalCoinsEqualsBalancesPlusFeePool::checkOnLedgerClose(
     LedgerDelta const& delta)
 {
-    auto& lh = delta.getHeader();
+    int64_t change;
+    bool changeKnown = getBalancesChange(delta, change);
+    return check(delta.getHeader(), changeKnown, change,
+                 [this]() { return sumOfBalances(mDb); });
+}
+
+CommittedLedgerCheck
+TotalCoinsEqualsBalancesPlusFeePool::prepareCheckOnLedgerCommit(
+    LedgerDelta const& delta)
+{
+    int64_t change;
+    bool changeKnown = getBalancesChange(delta, change);
+    auto lh = delta.getHeader();
+    return [this, lh, changeKnown, change](soci::session& sess) {
+        return check(lh, changeKnown, change,
+                     [&sess]() { return sumOfBalances(sess); });
+    };
+}
+
+std::string
+TotalCoinsEqualsBalancesPlusFeePool::check(
+    LedgerHeader const& lh, bool changeKnown, int64_t change,
+    std::function<int64_t()> const& sumBalances)
+{
     if (lh.ledgerVersion < 7) // due to bugs in previous versions
     {
+        mLastLedgerSeq = 0;
         return {};
     }
 
+    bool full = mLastLedgerSeq == 0 || lh.ledgerSeq != mLastLedgerSeq + 1 ||
+                mFullCheckRequested ||
+                (mFullCheckPeriod != 0 &&
+                 mLedgersSinceFullCheck >= mFullCheckPeriod) ||
+                !changeKnown;
+
     auto ledgerTotalCoins = lh.totalCoins;
     auto feePool = lh.feePool;
-    auto databaseTotalCoins = sumOfBalances(mDb);
+    if (!full)
+    {
+        mTotalBalances += change;
+        mLedgersSinceFullCheck++;
+        if (ledgerTotalCoins != mTotalBalances + feePool)
+        {
+            // balances may have been changed outside of ledger closes
+            CLOG(DEBUG, "Invariant")
+                << "Running total of balances does not match on ledger "
+                << lh.ledgerSeq << ", summing all balances";
+            full = true;
+        }
+    }
+    if (full)
+    {
+        mTotalBalances = sumBalances();
+        mLedgersSinceFullCheck = 0;
+        mFullCheckRequested = false;
+        mFullCheckCount++;
+    }
 
-    if (ledgerTotalCoins != databaseTotalCoins + feePool)
+    if (ledgerTotalCoins != mTotalBalances + feePool)
     {
+        mLastLedgerSeq = 0;
         return fmt::format(
             "lh.totalCoins = {}, sum(balance) = {}, lh.feePool = {}",
-            ledgerTotalCoins, databaseTotalCoins, feePool);
+            ledgerTotalCoins, mTotalBalances, feePool);
     }
 
+    mLastLedgerSeq = lh.ledgerSeq;
     return {};
 }
+
+void
+TotalCoinsEqualsBalancesPlusFeePool::requestFullCheck()
+{
+    mFullCheckRequested = true;
+}
+
+bool
+TotalCoinsEqualsBalancesPlusFeePool::getBalancesChange(
+    LedgerDelta const& delta, int64_t& change)
+{
+    bool known = true;
+    change = 0;
+    delta.forEachChange([&](LedgerEntryChangeType type, LedgerKey const& key,
+                            LedgerEntry const* previous,
+                            LedgerEntry const* current) {
+        if (key.type() != ACCOUNT)
+        {
+            return;
+        }
+        if (current)
+        {
+            change += current->data.account().balance;
+        }
+        if (type != LEDGER_ENTRY_CREATED)
+        {
+            if (!previous)
+            {
+                known = false;
+                return;
+            }
+            change -= previous->data.account().balance;
+        }
+    });
+    return known;
+}
+
 }
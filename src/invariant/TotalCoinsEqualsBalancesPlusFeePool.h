@@ -5,6 +5,8 @@
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
 #include "invariant/Invariant.h"
+#include "overlay/StellarXDR.h"
+#include <atomic>
 #include <memory>
 
 namespace stellar
@@ -14,18 +16,59 @@ class Application;
 class Database;
 class LedgerDelta;
 
+// Rather than summing the balances of all accounts on every ledger close,
+// keeps a running total updated with the balances changed by each ledger
+// (see LedgerDelta::forEachChange). The sum over all accounts is still
+// computed every `fullCheckPeriod` ledgers, when the running total may have
+// missed changes (first check, ledgers skipped, previous balances not
+// recorded in the delta), on request, and to confirm any mismatch before it
+// is reported.
+//
+// When invariants are checked asynchronously, every check of the invariant
+// runs on a worker thread, one at a time, so only mFullCheckRequested is
+// shared with the main thread.
 class TotalCoinsEqualsBalancesPlusFeePool : public Invariant
 {
   public:
     static std::shared_ptr<Invariant> registerInvariant(Application& app);
 
-    explicit TotalCoinsEqualsBalancesPlusFeePool(Database& db);
+    TotalCoinsEqualsBalancesPlusFeePool(Database& db, uint32_t fullCheckPeriod);
 
     virtual std::string getName() const override;
 
     virtual std::string checkOnLedgerClose(LedgerDelta const& delta) override;
 
+    virtual CommittedLedgerCheck
+    prepareCheckOnLedgerCommit(LedgerDelta const& delta) override;
+
+    virtual void requestFullCheck() override;
+
+    // for testing
+    uint64_t
+    getFullCheckCount() const
+    {
+        return mFullCheckCount;
+    }
+
   private:
     Database& mDb;
+    uint32_t const mFullCheckPeriod;
+
+    // sum of the balances of all accounts as of ledger mLastLedgerSeq, if
+    // it is not 0
+    int64_t mTotalBalances{0};
+    uint32_t mLastLedgerSeq{0};
+    uint32_t mLedgersSinceFullCheck{0};
+    std::atomic<bool> mFullCheckRequested{false};
+    std::atomic<uint64_t> mFullCheckCount{0};
+
+    // Change of the sum of balances made by `delta`, or false if it can't be
+    // known from it.
+    static bool getBalancesChange(LedgerDelta const& delta, int64_t& change);
+
+    // Checks `lh` against the running total of balances, updated with
+    // `change` if `changeKnown`, or with `sumBalances` if it must be summed.
+    std::string check(LedgerHeader const& lh, bool changeKnown, int64_t change,
+                      std::function<int64_t()> const& sumBalances);
 };
 }
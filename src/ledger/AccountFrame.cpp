@@ -8,7 +8,9 @@
 #include "crypto/KeyUtils.h"
 #include "crypto/SecretKey.h"
 #include "crypto/SignerKey.h"
+#include "database/BulkInserter.h"
 #include "database/Database.h"
+#include "ledger/EntryPrefetch.h"
 #include "ledger/LedgerManager.h"
 #include "lib/util/format.h"
 #include "util/basen.h"
@@ -228,33 +230,58 @@ AccountFrame::loadAccount(LedgerDelta& delta, AccountID const& accountID,
     return a;
 }
 
+static char const* accountColumnSelector =
+    "SELECT accountid, balance, seqnum, numsubentries, inflationdest, "
+    "homedomain, thresholds, flags, lastmodified FROM accounts";
+
+// sets the fields of `account` stored as text
+static void
+decodeAccountColumns(AccountEntry& account, std::string const& inflationDest,
+                     soci::indicator inflationDestInd,
+                     std::string const& homeDomain,
+                     std::string const& thresholds)
+{
+    account.homeDomain = homeDomain;
+
+    bn::decode_b64(thresholds.begin(), thresholds.end(),
+                   account.thresholds.begin());
+
+    if (inflationDestInd == soci::i_ok)
+    {
+        account.inflationDest.activate() =
+            KeyUtils::fromStrKey<PublicKey>(inflationDest);
+    }
+    else
+    {
+        account.inflationDest.reset();
+    }
+}
+
 AccountFrame::pointer
 AccountFrame::loadAccount(AccountID const& accountID, Database& db)
 {
     LedgerKey key;
     key.type(ACCOUNT);
     key.account().accountID = accountID;
-    if (cachedEntryExists(key, db))
+    std::shared_ptr<LedgerEntry const> cached;
+    if (getCachedEntry(key, cached, db))
     {
-        auto p = getCachedEntry(key, db);
-        return p ? std::make_shared<AccountFrame>(*p) : nullptr;
+        return cached ? std::make_shared<AccountFrame>(*cached) : nullptr;
     }
 
     std::string actIDStrKey = KeyUtils::toStrKey(accountID);
 
-    std::string publicKey, inflationDest, creditAuthKey;
+    std::string rowIDStrKey, inflationDest;
     std::string homeDomain, thresholds;
     soci::indicator inflationDestInd;
 
     AccountFrame::pointer res = make_shared<AccountFrame>(accountID);
     AccountEntry& account = res->getAccount();
 
-    auto prep =
-        db.getPreparedStatement("SELECT balance, seqnum, numsubentries, "
-                                "inflationdest, homedomain, thresholds, "
-                                "flags, lastmodified "
-                                "FROM accounts WHERE accountid=:v1");
+    auto prep = db.getPreparedStatement(std::string(accountColumnSelector) +
+                                        " WHERE accountid=:v1");
     auto& st = prep.statement();
+    st.exchange(into(rowIDStrKey));
     st.exchange(into(account.balance));
     st.exchange(into(account.seqNum));
     st.exchange(into(account.numSubEntries));
@@ -276,16 +303,8 @@ AccountFrame::loadAccount(AccountID const& accountID, Database& db)
         return nullptr;
     }
 
-    account.homeDomain = homeDomain;
-
-    bn::decode_b64(thresholds.begin(), thresholds.end(),
-                   res->mAccountEntry.thresholds.begin());
-
-    if (inflationDestInd == soci::i_ok)
-    {
-        account.inflationDest.activate() =
-            KeyUtils::fromStrKey<PublicKey>(inflationDest);
-    }
+    decodeAccountColumns(account, inflationDest, inflationDestInd, homeDomain,
+                         thresholds);
 
     account.signers.clear();
 
@@ -304,6 +323,138 @@ AccountFrame::loadAccount(AccountID const& accountID, Database& db)
     return res;
 }
 
+void
+AccountFrame::prefetch(std::vector<AccountID> const& accountIDs, Database& db,
+                       PrefetchCounts& counts)
+{
+    std::vector<std::string> toLoad;
+    for (auto const& id : accountIDs)
+    {
+        LedgerKey key;
+        key.type(ACCOUNT);
+        key.account().accountID = id;
+        if (cachedEntryExists(key, db))
+        {
+            counts.mCached++;
+        }
+        else
+        {
+            toLoad.emplace_back(KeyUtils::toStrKey(id));
+        }
+    }
+
+    std::map<std::string, AccountFrame::pointer> loaded;
+    forEachKeyChunk(toLoad, [&](std::vector<std::string>& chunk,
+                                std::string const& placeholders) {
+        std::string actIDStrKey, inflationDest;
+        std::string homeDomain, thresholds;
+        soci::indicator inflationDestInd;
+        LedgerEntry le;
+        le.data.type(ACCOUNT);
+        AccountEntry& account = le.data.account();
+
+        auto prep = db.getPreparedStatement(
+            std::string(accountColumnSelector) + " WHERE accountid IN (" +
+            placeholders + ")");
+        auto& st = prep.statement();
+        st.exchange(into(actIDStrKey));
+        st.exchange(into(account.balance));
+        st.exchange(into(account.seqNum));
+        st.exchange(into(account.numSubEntries));
+        st.exchange(into(inflationDest, inflationDestInd));
+        st.exchange(into(homeDomain));
+        st.exchange(into(thresholds));
+        st.exchange(into(account.flags));
+        st.exchange(into(le.lastModifiedLedgerSeq));
+        for (auto& k : chunk)
+        {
+            st.exchange(use(k));
+        }
+        st.define_and_bind();
+        {
+            auto timer = db.getSelectTimer("account");
+            st.execute(true);
+        }
+        counts.mQueries++;
+
+        while (st.got_data())
+        {
+            account.accountID = KeyUtils::fromStrKey<PublicKey>(actIDStrKey);
+            decodeAccountColumns(account, inflationDest, inflationDestInd,
+                                 homeDomain, thresholds);
+            loaded[actIDStrKey] = make_shared<AccountFrame>(le);
+            st.fetch();
+        }
+    });
+
+    std::vector<std::string> withSigners;
+    for (auto const& a : loaded)
+    {
+        if (a.second->mAccountEntry.numSubEntries != 0)
+        {
+            withSigners.emplace_back(a.first);
+        }
+    }
+    forEachKeyChunk(withSigners, [&](std::vector<std::string>& chunk,
+                                     std::string const& placeholders) {
+        std::string actIDStrKey, pubKey;
+        Signer signer;
+
+        auto prep = db.getPreparedStatement(
+            "SELECT accountid, publickey, weight FROM signers WHERE "
+            "accountid IN (" +
+            placeholders + ")");
+        auto& st = prep.statement();
+        st.exchange(into(actIDStrKey));
+        st.exchange(into(pubKey));
+        st.exchange(into(signer.weight));
+        for (auto& k : chunk)
+        {
+            st.exchange(use(k));
+        }
+        st.define_and_bind();
+        {
+            auto timer = db.getSelectTimer("signer");
+            st.execute(true);
+        }
+        counts.mQueries++;
+
+        while (st.got_data())
+        {
+            signer.key = KeyUtils::fromStrKey<SignerKey>(pubKey);
+            loaded[actIDStrKey]->mAccountEntry.signers.push_back(signer);
+            st.fetch();
+        }
+    });
+
+    for (auto const& id : toLoad)
+    {
+        auto it = loaded.find(id);
+        if (it == loaded.end())
+        {
+            LedgerKey key;
+            key.type(ACCOUNT);
+            key.account().accountID = KeyUtils::fromStrKey<PublicKey>(id);
+            putCachedEntry(key, nullptr, db);
+            continue;
+        }
+
+        auto& res = it->second;
+        auto& signers = res->mAccountEntry.signers;
+        std::sort(signers.begin(), signers.end(), &AccountFrame::signerCompare);
+        res->normalize();
+        res->mUpdateSigners = false;
+        assert(res->isValid());
+        res->mKeyCalculated = false;
+        res->putCachedEntry(db);
+    }
+
+    counts.mLoaded += toLoad.size();
+    // loadAccount makes a query on accounts, and one on signers if the
+    // account has subentries
+    counts.mReplacedQueries += toLoad.size() + withSigners.size();
+}
+
 std::vector<Signer>
 AccountFrame::loadSigners(Database& db, std::string const& actIDStrKey)
 {
@@ -337,7 +488,8 @@ AccountFrame::loadSigners(Database& db, std::string const& actIDStrKey)
 bool
 AccountFrame::exists(Database& db, LedgerKey const& key)
 {
-    if (cachedEntryExists(key, db) && getCachedEntry(key, db) != nullptr)
+    std::shared_ptr<LedgerEntry const> cached;
+    if (getCachedEntry(key, cached, db) && cached)
     {
         return true;
     }
@@ -707,4 +859,81 @@ AccountFrame::dropAll(Database& db)
     db.getSession() << kSQLCreateStatement3;
     db.getSession() << kSQLCreateStatement4;
 }
+
+void
+AccountFrame::bulkDelete(Database& db, std::vector<LedgerKey> const& keys)
+{
+    std::vector<std::string> ids;
+    ids.reserve(keys.size());
+    for (auto const& k : keys)
+    {
+        ids.emplace_back(KeyUtils::toStrKey(k.account().accountID));
+    }
+    stellar::bulkDelete(db, "accounts", "accountid", ids);
+    stellar::bulkDelete(db, "signers", "accountid", ids);
+}
+
+void
+AccountFrame::bulkInsert(Database& db, std::vector<LedgerEntry> const& entries)
+{
+    {
+        BulkInserter accounts(db, "accounts",
+                              {"accountid", "balance", "seqnum",
+                               "numsubentries", "inflationdest", "homedomain",
+                               "thresholds", "flags", "lastmodified"});
+        for (auto const& e : entries)
+        {
+            auto const& a = e.data.account();
+            accounts.add(KeyUtils::toStrKey(a.accountID));
+            accounts.add(std::to_string(a.balance));
+            accounts.add(std::to_string(a.seqNum));
+            accounts.add(std::to_string(a.numSubEntries));
+            if (a.inflationDest)
+            {
+                accounts.add(KeyUtils::toStrKey(*a.inflationDest));
+            }
+            else
+            {
+                accounts.addNull();
+            }
+            accounts.add(std::string(a.homeDomain));
+            accounts.add(bn::encode_b64(a.thresholds));
+            accounts.add(std::to_string(a.flags));
+            accounts.add(std::to_string(e.lastModifiedLedgerSeq));
+        }
+        accounts.flush();
+    }
+
+    BulkInserter signers(db, "signers", {"accountid", "publickey", "weight"});
+    for (auto const& e : entries)
+    {
+        auto const& a = e.data.account();
+        if (a.signers.empty())
+        {
+            continue;
+        }
+        auto id = KeyUtils::toStrKey(a.accountID);
+        for (auto const& s : a.signers)
+        {
+            signers.add(id);
+            signers.add(KeyUtils::toStrKey(s.key));
+            signers.add(std::to_string(s.weight));
+        }
+    }
+    signers.flush();
+}
+
+void
+AccountFrame::dropIndexes(Database& db)
+{
+    db.getSession() << "DROP INDEX IF EXISTS signersaccount;";
+    db.getSession() << "DROP INDEX IF EXISTS accountbalances;";
+}
+
+void
+AccountFrame::createIndexes(Database& db)
+{
+    db.getSession() << kSQLCreateStatement3;
+    db.getSession() << kSQLCreateStatement4;
+}
 }
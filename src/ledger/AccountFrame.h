@@ -21,6 +21,7 @@ class prepare_temp_type;
 namespace stellar
 {
 class LedgerManager;
+struct PrefetchCounts;
 
 class AccountFrame : public EntryFrame
 {
@@ -128,6 +129,12 @@ class AccountFrame : public EntryFrame
     static AccountFrame::pointer loadAccount(AccountID const& accountID,
                                              Database& db);
 
+    // Loads the accounts of `accountIDs` (without repeats) that are not
+    // cached yet into the entry cache, a few hundred per query on accounts
+    // and on signers.
+    static void prefetch(std::vector<AccountID> const& accountIDs,
+                         Database& db, PrefetchCounts& counts);
+
     // compare signers, ignores weight
     static bool signerCompare(Signer const& s1, Signer const& s2);
 
@@ -150,6 +157,15 @@ class AccountFrame : public EntryFrame
 
     static void dropAll(Database& db);
 
+    // Bulk loading (see BucketApplicator): delete the rows of `keys` and
+    // insert `entries`, bypassing the entry cache and LedgerDelta.
+    static void bulkDelete(Database& db, std::vector<LedgerKey> const& keys);
+    static void bulkInsert(Database& db,
+                           std::vector<LedgerEntry> const& entries);
+    // Secondary indexes, dropped while bulk loading and rebuilt after.
+    static void dropIndexes(Database& db);
+    static void createIndexes(Database& db);
+
   private:
     static const char* kSQLCreateStatement1;
     static const char* kSQLCreateStatement2;
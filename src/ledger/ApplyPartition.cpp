@@ -0,0 +1,153 @@
+// Copyright 2017 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "ledger/ApplyPartition.h"
+#include "util/types.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+namespace stellar
+{
+
+static void
+addIssuer(Asset const& asset, std::vector<AccountID>& accounts)
+{
+    if (asset.type() != ASSET_TYPE_NATIVE)
+    {
+        accounts.emplace_back(getIssuer(asset));
+    }
+}
+
+bool
+ApplyPartition::getFootprint(TransactionFrame const& tx,
+                             std::vector<AccountID>& accounts)
+{
+    auto const& envelope = tx.getEnvelope();
+    accounts.emplace_back(envelope.tx.sourceAccount);
+    for (auto const& op : envelope.tx.operations)
+    {
+        if (op.sourceAccount)
+        {
+            accounts.emplace_back(*op.sourceAccount);
+        }
+
+        auto const& body = op.body;
+        switch (body.type())
+        {
+        case CREATE_ACCOUNT:
+            accounts.emplace_back(body.createAccountOp().destination);
+            break;
+        case PAYMENT:
+            accounts.emplace_back(body.paymentOp().destination);
+            addIssuer(body.paymentOp().asset, accounts);
+            break;
+        case SET_OPTIONS:
+            if (body.setOptionsOp().inflationDest)
+            {
+                accounts.emplace_back(*body.setOptionsOp().inflationDest);
+            }
+            break;
+        case CHANGE_TRUST:
+            addIssuer(body.changeTrustOp().line, accounts);
+            break;
+        case ALLOW_TRUST:
+            accounts.emplace_back(body.allowTrustOp().trustor);
+            break;
+        case ACCOUNT_MERGE:
+            accounts.emplace_back(body.destination());
+            break;
+        case MANAGE_DATA:
+            break;
+        default:
+            // crosses offers of unknown accounts, or touches every account
+            return false;
+        }
+    }
+    return true;
+}
+
+ApplyPartition::ApplyPartition(std::vector<TransactionFramePtr> const& txs)
+{
+    size_t begin = 0;
+    std::vector<AccountID> accounts;
+    for (size_t i = 0; i < txs.size(); ++i)
+    {
+        accounts.clear();
+        if (!getFootprint(*txs[i], accounts))
+        {
+            addStage(txs, begin, i);
+            mStages.emplace_back(Stage{Cluster{i}});
+            mClusterCount++;
+            mLargestCluster = std::max<size_t>(mLargestCluster, 1);
+            mBarrierCount++;
+            begin = i + 1;
+        }
+    }
+    addStage(txs, begin, txs.size());
+}
+
+void
+ApplyPartition::addStage(std::vector<TransactionFramePtr> const& txs,
+                         size_t begin, size_t end)
+{
+    if (begin == end)
+    {
+        return;
+    }
+
+    // union-find over the transactions of the stage, joined by account
+    std::vector<size_t> parent(end - begin);
+    for (size_t i = 0; i < parent.size(); ++i)
+    {
+        parent[i] = i;
+    }
+    auto find = [&parent](size_t i) {
+        while (parent[i] != i)
+        {
+            parent[i] = parent[parent[i]];
+            i = parent[i];
+        }
+        return i;
+    };
+
+    std::unordered_map<AccountID, size_t> owner;
+    std::vector<AccountID> accounts;
+    for (size_t i = begin; i < end; ++i)
+    {
+        accounts.clear();
+        getFootprint(*txs[i], accounts);
+        for (auto const& a : accounts)
+        {
+            auto res = owner.emplace(a, i - begin);
+            if (!res.second)
+            {
+                auto x = find(i - begin);
+                auto y = find(res.first->second);
+                // the smallest position stays the root
+                parent[std::max(x, y)] = std::min(x, y);
+            }
+        }
+    }
+
+    Stage stage;
+    std::unordered_map<size_t, size_t> clusterOfRoot;
+    for (size_t i = begin; i < end; ++i)
+    {
+        auto res = clusterOfRoot.emplace(find(i - begin), stage.size());
+        if (res.second)
+        {
+            stage.emplace_back();
+        }
+        stage[res.first->second].emplace_back(i);
+    }
+
+    for (auto const& c : stage)
+    {
+        mLargestCluster = std::max(mLargestCluster, c.size());
+    }
+    mClusterCount += stage.size();
+    mStages.emplace_back(std::move(stage));
+}
+}
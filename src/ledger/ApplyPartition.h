@@ -0,0 +1,80 @@
+#pragma once
+
+// Copyright 2017 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "transactions/TransactionFrame.h"
+
+#include <vector>
+
+namespace stellar
+{
+
+/**
+ * Splits transactions, in apply order, into clusters that can be applied
+ * independently of each other, based on the accounts each transaction may
+ * touch as the source, destination or trustor of an operation, or as the
+ * issuer of an asset it uses (standing for the trust lines of that asset).
+ *
+ * Transactions that may touch entries which can't be known before applying
+ * them (crossing offers, inflation) are barriers: they are put in a stage
+ * of their own, and clusters never span stages. Within a stage, the
+ * transactions of two clusters have no account in common, so applying the
+ * clusters in any order, or concurrently, gives the same results as applying
+ * every transaction in the original order.
+ *
+ * Everything is ordered deterministically: stages by position, clusters of
+ * a stage by their first transaction, transactions of a cluster by their
+ * position.
+ */
+class ApplyPartition
+{
+  public:
+    // positions in the transactions given to the constructor
+    typedef std::vector<size_t> Cluster;
+    typedef std::vector<Cluster> Stage;
+
+    explicit ApplyPartition(std::vector<TransactionFramePtr> const& txs);
+
+    std::vector<Stage> const&
+    getStages() const
+    {
+        return mStages;
+    }
+
+    size_t
+    getClusterCount() const
+    {
+        return mClusterCount;
+    }
+
+    // number of transactions of the largest cluster
+    size_t
+    getLargestCluster() const
+    {
+        return mLargestCluster;
+    }
+
+    // number of barrier transactions
+    size_t
+    getBarrierCount() const
+    {
+        return mBarrierCount;
+    }
+
+    // Accounts `tx` may touch (with repeats), or false if it may touch
+    // entries that can't be known before it is applied.
+    static bool getFootprint(TransactionFrame const& tx,
+                             std::vector<AccountID>& accounts);
+
+  private:
+    std::vector<Stage> mStages;
+    size_t mClusterCount{0};
+    size_t mLargestCluster{0};
+    size_t mBarrierCount{0};
+
+    void addStage(std::vector<TransactionFramePtr> const& txs, size_t begin,
+                  size_t end);
+};
+}
@@ -0,0 +1,137 @@
+// Copyright 2017 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "crypto/Hex.h"
+#include "database/Database.h"
+#include "ledger/ApplyPartition.h"
+#include "ledger/LedgerManager.h"
+#include "lib/catch.hpp"
+#include "main/Application.h"
+#include "main/Config.h"
+#include "test/TestAccount.h"
+#include "test/TxTests.h"
+#include "test/test.h"
+#include "util/Timer.h"
+
+using namespace stellar;
+using namespace stellar::txtest;
+
+namespace
+{
+// a mix of transactions: independent payments, payments chaining accounts
+// together, a credit payment, an offer and a failing payment
+std::vector<TransactionFramePtr>
+makeMixedTxs(TestAccount& issuer, std::vector<TestAccount>& accounts)
+{
+    auto& a = accounts[0];
+    auto& b = accounts[1];
+    auto& c = accounts[2];
+    auto& d = accounts[3];
+    auto& e = accounts[4];
+    auto& f = accounts[5];
+    auto usd = makeAsset(issuer, "USD");
+    DataValue value;
+    value.resize(4);
+
+    return {a.tx({payment(b, 100)}),
+            c.tx({payment(d, 200)}),
+            b.tx({payment(e, 300)}),
+            d.tx({manageOffer(0, makeNativeAsset(), usd, Price{1, 1}, 10)}),
+            e.tx({payment(f, 400)}),
+            a.tx({manageData("data", &value)}),
+            issuer.tx({payment(c, usd, 50)}),
+            f.tx({payment(a, 1000000000000)})};
+}
+}
+
+TEST_CASE("apply partition", "[ledger][applypartition]")
+{
+    Config cfg(getTestConfig());
+    VirtualClock clock;
+    Application::pointer app = Application::create(clock, cfg);
+    app->start();
+
+    auto root = TestAccount::createRoot(*app);
+    auto issuer = root.create("issuer", 1000000000);
+    std::vector<TestAccount> accounts;
+    for (auto name : {"a", "b", "c", "d", "e", "f"})
+    {
+        accounts.emplace_back(root.create(name, 1000000000));
+    }
+    auto txs = makeMixedTxs(issuer, accounts);
+
+    ApplyPartition partition(txs);
+    using Stage = ApplyPartition::Stage;
+    REQUIRE(partition.getStages() ==
+            std::vector<Stage>({Stage{{0, 2}, {1}},
+                                Stage{{3}},
+                                Stage{{4, 5, 7}, {6}}}));
+    REQUIRE(partition.getClusterCount() == 5);
+    REQUIRE(partition.getLargestCluster() == 3);
+    REQUIRE(partition.getBarrierCount() == 1);
+
+    SECTION("asset issuers link their trust lines")
+    {
+        auto usd = makeAsset(issuer, "USD");
+        std::vector<TransactionFramePtr> credit{
+            accounts[0].tx({payment(accounts[1], usd, 1)}),
+            accounts[2].tx({payment(accounts[3], usd, 1)})};
+        ApplyPartition p(credit);
+        REQUIRE(p.getStages() == std::vector<Stage>({Stage{{0, 1}}}));
+    }
+
+    SECTION("no transactions")
+    {
+        ApplyPartition p({});
+        REQUIRE(p.getStages().empty());
+        REQUIRE(p.getClusterCount() == 0);
+    }
+}
+
+TEST_CASE("clustered apply matches serial apply", "[ledger][applypartition]")
+{
+    auto run = [](bool clustered) {
+        Config cfg(getTestConfig());
+        cfg.CLUSTERED_TX_APPLY = clustered;
+        VirtualClock clock;
+        Application::pointer app = Application::create(clock, cfg);
+        app->start();
+
+        auto root = TestAccount::createRoot(*app);
+        auto issuer = root.create("issuer", 1000000000);
+        std::vector<TestAccount> accounts;
+        for (auto name : {"a", "b", "c", "d", "e", "f"})
+        {
+            accounts.emplace_back(root.create(name, 1000000000));
+        }
+        auto usd = makeAsset(issuer, "USD");
+        accounts[2].changeTrust(usd, 1000);
+
+        auto ledgerSeq = app->getLedgerManager().getLedgerNum();
+        closeLedgerOn(*app, ledgerSeq, 1, 1, 2017,
+                      makeMixedTxs(issuer, accounts));
+
+        // the header covers the results and the bucket list, the meta is
+        // only in the database
+        std::vector<std::string> res{
+            binToHex(app->getLedgerManager().getLastClosedLedgerHeader().hash)};
+        std::string meta;
+        int seq = static_cast<int>(ledgerSeq);
+        auto& sess = app->getDatabase().getSession();
+        soci::statement st =
+            (sess.prepare << "SELECT txmeta FROM txhistory WHERE ledgerseq = "
+                             ":seq ORDER BY txindex",
+             soci::into(meta), soci::use(seq));
+        st.execute();
+        while (st.fetch())
+        {
+            res.emplace_back(meta);
+        }
+        return res;
+    };
+
+    auto serial = run(false);
+    REQUIRE(serial.size() == 9);
+    REQUIRE(run(true) == serial);
+}
@@ -7,6 +7,7 @@
 #include "crypto/KeyUtils.h"
 #include "crypto/SHA.h"
 #include "crypto/SecretKey.h"
+#include "database/BulkInserter.h"
 #include "database/Database.h"
 #include "transactions/ManageDataOpFrame.h"
 #include "util/basen.h"
@@ -287,4 +288,38 @@ DataFrame::dropAll(Database& db)
     db.getSession() << "DROP TABLE IF EXISTS accountdata;";
     db.getSession() << kSQLCreateStatement1;
 }
+
+void
+DataFrame::bulkDelete(Database& db, std::vector<LedgerKey> const& keys)
+{
+    for (auto const& k : keys)
+    {
+        std::string actIDStrKey = KeyUtils::toStrKey(k.data().accountID);
+        std::string dataName = k.data().dataName;
+        auto prep = db.getPreparedStatement(
+            "DELETE FROM accountdata WHERE accountid=:id AND dataname=:s");
+        auto& st = prep.statement();
+        st.exchange(use(actIDStrKey));
+        st.exchange(use(dataName));
+        st.define_and_bind();
+        auto timer = db.getDeleteTimer("data");
+        st.execute(true);
+    }
+}
+
+void
+DataFrame::bulkInsert(Database& db, std::vector<LedgerEntry> const& entries)
+{
+    BulkInserter data(db, "accountdata",
+                      {"accountid", "dataname", "datavalue", "lastmodified"});
+    for (auto const& e : entries)
+    {
+        auto const& d = e.data.data();
+        data.add(KeyUtils::toStrKey(d.accountID));
+        data.add(std::string(d.dataName));
+        data.add(bn::encode_b64(d.dataValue));
+        data.add(std::to_string(e.lastModifiedLedgerSeq));
+    }
+    data.flush();
+}
 }
@@ -82,6 +82,12 @@ class DataFrame : public EntryFrame
 
     static void dropAll(Database& db);
 
+    // Bulk loading (see BucketApplicator): delete the rows of `keys` and
+    // insert `entries`, bypassing the entry cache and LedgerDelta.
+    static void bulkDelete(Database& db, std::vector<LedgerKey> const& keys);
+    static void bulkInsert(Database& db,
+                           std::vector<LedgerEntry> const& entries);
+
   private:
     static const char* kSQLCreateStatement1;
 };
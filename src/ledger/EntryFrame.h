@@ -45,8 +45,11 @@ class EntryFrame : public NonMovableOrCopyable
     // Static helpers for working with the DB LedgerEntry cache.
     static void flushCachedEntry(LedgerKey const& key, Database& db);
     static bool cachedEntryExists(LedgerKey const& key, Database& db);
-    static std::shared_ptr<LedgerEntry const>
-    getCachedEntry(LedgerKey const& key, Database& db);
+    // Return true and set `p` if `key` is cached; `p` may be set to nullptr
+    // if the entry is cached as missing from the database.
+    static bool getCachedEntry(LedgerKey const& key,
+                               std::shared_ptr<LedgerEntry const>& p,
+                               Database& db);
     static void putCachedEntry(LedgerKey const& key,
                                std::shared_ptr<LedgerEntry const> p,
                                Database& db);
@@ -0,0 +1,161 @@
+// Copyright 2017 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "ledger/EntryPrefetch.h"
+#include "database/Database.h"
+#include "ledger/AccountFrame.h"
+#include "ledger/TrustFrame.h"
+#include "util/types.h"
+
+#include <set>
+
+namespace stellar
+{
+using xdr::operator==;
+
+static void
+addAccount(AccountID const& accountID, std::vector<LedgerKey>& keys)
+{
+    keys.emplace_back(ACCOUNT);
+    keys.back().account().accountID = accountID;
+}
+
+// the trust line of `accountID` for `asset` and its issuer, if any
+static void
+addTrustLine(AccountID const& accountID, Asset const& asset,
+             std::vector<LedgerKey>& keys)
+{
+    if (asset.type() == ASSET_TYPE_NATIVE)
+    {
+        return;
+    }
+    auto issuer = getIssuer(asset);
+    addAccount(issuer, keys);
+    if (!(accountID == issuer))
+    {
+        keys.emplace_back(TRUSTLINE);
+        keys.back().trustLine().accountID = accountID;
+        keys.back().trustLine().asset = asset;
+    }
+}
+
+void
+EntryPrefetch::getKeys(TransactionFrame const& tx,
+                       std::vector<LedgerKey>& keys)
+{
+    auto const& envelope = tx.getEnvelope();
+    addAccount(envelope.tx.sourceAccount, keys);
+    for (auto const& op : envelope.tx.operations)
+    {
+        auto const& source =
+            op.sourceAccount ? *op.sourceAccount : envelope.tx.sourceAccount;
+        addAccount(source, keys);
+
+        auto const& body = op.body;
+        switch (body.type())
+        {
+        case CREATE_ACCOUNT:
+            addAccount(body.createAccountOp().destination, keys);
+            break;
+        case PAYMENT:
+        {
+            auto const& payment = body.paymentOp();
+            addAccount(payment.destination, keys);
+            addTrustLine(source, payment.asset, keys);
+            addTrustLine(payment.destination, payment.asset, keys);
+            break;
+        }
+        case PATH_PAYMENT:
+        {
+            auto const& payment = body.pathPaymentOp();
+            addAccount(payment.destination, keys);
+            addTrustLine(source, payment.sendAsset, keys);
+            addTrustLine(payment.destination, payment.destAsset, keys);
+            break;
+        }
+        case MANAGE_OFFER:
+            addTrustLine(source, body.manageOfferOp().selling, keys);
+            addTrustLine(source, body.manageOfferOp().buying, keys);
+            break;
+        case CREATE_PASSIVE_OFFER:
+            addTrustLine(source, body.createPassiveOfferOp().selling, keys);
+            addTrustLine(source, body.createPassiveOfferOp().buying, keys);
+            break;
+        case SET_OPTIONS:
+            if (body.setOptionsOp().inflationDest)
+            {
+                addAccount(*body.setOptionsOp().inflationDest, keys);
+            }
+            break;
+        case CHANGE_TRUST:
+            addTrustLine(source, body.changeTrustOp().line, keys);
+            break;
+        case ALLOW_TRUST:
+        {
+            auto const& allowTrust = body.allowTrustOp();
+            addAccount(allowTrust.trustor, keys);
+            Asset asset;
+            asset.type(allowTrust.asset.type());
+            if (asset.type() == ASSET_TYPE_CREDIT_ALPHANUM4)
+            {
+                asset.alphaNum4().assetCode = allowTrust.asset.assetCode4();
+                asset.alphaNum4().issuer = source;
+            }
+            else if (asset.type() == ASSET_TYPE_CREDIT_ALPHANUM12)
+            {
+                asset.alphaNum12().assetCode = allowTrust.asset.assetCode12();
+                asset.alphaNum12().issuer = source;
+            }
+            addTrustLine(allowTrust.trustor, asset, keys);
+            break;
+        }
+        case ACCOUNT_MERGE:
+            addAccount(body.destination(), keys);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+PrefetchCounts
+EntryPrefetch::prefetch(std::vector<TransactionFramePtr> const& txs,
+                        Database& db)
+{
+    auto limit = db.getEntryCache().getCapacity() / 2;
+    std::vector<LedgerKey> keys;
+    std::set<LedgerKey, LedgerEntryIdCmp> seen;
+    std::vector<AccountID> accounts;
+    std::vector<LedgerKey> trustLines;
+    for (auto const& tx : txs)
+    {
+        keys.clear();
+        getKeys(*tx, keys);
+        if (seen.size() + keys.size() > limit)
+        {
+            break;
+        }
+        for (auto& k : keys)
+        {
+            if (!seen.insert(k).second)
+            {
+                continue;
+            }
+            if (k.type() == ACCOUNT)
+            {
+                accounts.emplace_back(k.account().accountID);
+            }
+            else
+            {
+                trustLines.emplace_back(std::move(k));
+            }
+        }
+    }
+
+    PrefetchCounts counts;
+    AccountFrame::prefetch(accounts, db, counts);
+    TrustFrame::prefetch(trustLines, db, counts);
+    return counts;
+}
+}
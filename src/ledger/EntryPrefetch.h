@@ -0,0 +1,52 @@
+#pragma once
+
+// Copyright 2017 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "transactions/TransactionFrame.h"
+
+#include <vector>
+
+namespace stellar
+{
+
+class Database;
+
+struct PrefetchCounts
+{
+    // keys already in the entry cache
+    size_t mCached{0};
+    // keys loaded into the entry cache, including those of missing entries
+    size_t mLoaded{0};
+    // bulk queries made to load them
+    size_t mQueries{0};
+    // queries loading them one at a time would have made
+    size_t mReplacedQueries{0};
+};
+
+/**
+ * Loads into the entry cache, before a set of transactions is applied, the
+ * accounts and trust lines their operations name: source accounts,
+ * destinations, trustors, asset issuers, and the trust lines of the assets
+ * each account sends, receives, trusts or offers. Applying the transactions
+ * then finds them in the cache, rather than making one or two queries for
+ * each.
+ *
+ * Entries only known once operations are applied (owners of crossed offers,
+ * inflation winners) are not prefetched. Neither is more than half of what
+ * the entry cache holds, so that prefetched entries are not evicted before
+ * they are used.
+ */
+class EntryPrefetch
+{
+  public:
+    // Keys of the accounts and trust lines the operations of `tx` name, with
+    // repeats.
+    static void getKeys(TransactionFrame const& tx,
+                        std::vector<LedgerKey>& keys);
+
+    static PrefetchCounts prefetch(std::vector<TransactionFramePtr> const& txs,
+                                   Database& db);
+};
+}
@@ -0,0 +1,117 @@
+// Copyright 2017 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "crypto/KeyUtils.h"
+#include "database/Database.h"
+#include "ledger/AccountFrame.h"
+#include "ledger/EntryPrefetch.h"
+#include "ledger/TrustFrame.h"
+#include "lib/catch.hpp"
+#include "main/Application.h"
+#include "test/TestAccount.h"
+#include "test/TxTests.h"
+#include "test/test.h"
+#include "util/Timer.h"
+#include <algorithm>
+
+using namespace stellar;
+using namespace stellar::txtest;
+using xdr::operator==;
+
+TEST_CASE("entry prefetch", "[ledger][prefetch]")
+{
+    Config cfg(getTestConfig());
+    VirtualClock clock;
+    Application::pointer app = Application::create(clock, cfg);
+    app->start();
+    auto& db = app->getDatabase();
+
+    auto root = TestAccount::createRoot(*app);
+    auto issuer = root.create("issuer", 1000000000);
+    auto a = root.create("a", 1000000000);
+    auto b = root.create("b", 1000000000);
+    auto usd = makeAsset(issuer, "USD");
+    a.changeTrust(usd, 1000);
+    b.changeTrust(usd, 1000);
+    issuer.pay(a, usd, 100);
+    Signer signer(KeyUtils::convertKey<SignerKey>(b.getPublicKey()), 1);
+    a.setOptions(nullptr, nullptr, nullptr, nullptr, &signer, nullptr);
+    auto missing = getAccount("missing");
+
+    std::vector<TransactionFramePtr> txs{
+        a.tx({payment(b, usd, 10)}),
+        b.tx({payment(missing.getPublicKey(), 100)}),
+        issuer.tx({payment(a, usd, 10)})};
+
+    SECTION("keys")
+    {
+        std::vector<LedgerKey> keys;
+        EntryPrefetch::getKeys(*txs[0], keys);
+        auto count = [&keys](LedgerKey const& k) {
+            return std::count_if(
+                keys.begin(), keys.end(),
+                [&k](LedgerKey const& other) { return other == k; });
+        };
+
+        LedgerKey aKey(ACCOUNT), issuerKey(ACCOUNT), bLine(TRUSTLINE);
+        aKey.account().accountID = a.getPublicKey();
+        issuerKey.account().accountID = issuer.getPublicKey();
+        bLine.trustLine().accountID = b.getPublicKey();
+        bLine.trustLine().asset = usd;
+        REQUIRE(count(aKey) >= 1);
+        REQUIRE(count(issuerKey) >= 1);
+        REQUIRE(count(bLine) == 1);
+
+        // issuers have no trust line of their own assets
+        keys.clear();
+        EntryPrefetch::getKeys(*txs[2], keys);
+        for (auto const& k : keys)
+        {
+            if (k.type() == TRUSTLINE)
+            {
+                REQUIRE(k.trustLine().accountID == a.getPublicKey());
+            }
+        }
+    }
+
+    SECTION("loads entries into the cache")
+    {
+        db.getEntryCache().clear();
+        auto counts = EntryPrefetch::prefetch(txs, db);
+        // issuer, a, b, missing, and the trust lines of a and b
+        REQUIRE(counts.mCached == 0);
+        REQUIRE(counts.mLoaded == 6);
+        // accounts, signers of a and b, trust lines
+        REQUIRE(counts.mQueries == 3);
+        REQUIRE(counts.mReplacedQueries == 8);
+
+        auto accountA = AccountFrame::loadAccount(a.getPublicKey(), db);
+        auto lineB = TrustFrame::loadTrustLine(b.getPublicKey(), usd, db);
+        REQUIRE(accountA->getAccount().signers.size() == 1);
+        REQUIRE(!AccountFrame::loadAccount(missing.getPublicKey(), db));
+
+        // the same as loaded one at a time
+        db.getEntryCache().clear();
+        REQUIRE(AccountFrame::loadAccount(a.getPublicKey(), db)->mEntry ==
+                accountA->mEntry);
+        REQUIRE(TrustFrame::loadTrustLine(b.getPublicKey(), usd, db)->mEntry ==
+                lineB->mEntry);
+
+        // entries still cached are not loaded again
+        counts = EntryPrefetch::prefetch(txs, db);
+        REQUIRE(counts.mLoaded == 4);
+        REQUIRE(counts.mCached == 2);
+    }
+
+    SECTION("transactions apply the same with entries prefetched")
+    {
+        db.getEntryCache().clear();
+        EntryPrefetch::prefetch(txs, db);
+        auto ledgerSeq = app->getLedgerManager().getLedgerNum();
+        closeLedgerOn(*app, ledgerSeq, 1, 1, 2017, txs);
+        REQUIRE(b.loadTrustLine(usd).balance == 10);
+        REQUIRE(a.loadTrustLine(usd).balance == 100);
+        REQUIRE(!AccountFrame::loadAccount(missing.getPublicKey(), db));
+    }
+}
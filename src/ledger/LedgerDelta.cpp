@@ -3,33 +3,254 @@
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
 #include "ledger/LedgerDelta.h"
+#include "database/Database.h"
+#include "ledger/LedgerEntryCache.h"
 #include "main/Application.h"
 #include "main/Config.h"
 #include "medida/meter.h"
 #include "medida/metrics_registry.h"
+#include "util/make_unique.h"
 #include "xdr/Stellar-ledger.h"
 #include "xdrpp/printer.h"
+#include <algorithm>
+#include <cassert>
+#include <limits>
 
 namespace stellar
 {
 using xdr::operator==;
 
+/*
+ * The entries changed in a ledger are kept in a single table, owned by the
+ * top level delta: a record per entry, appended to a vector as the entry is
+ * first seen and found through an open-addressed index hashed on the bytes
+ * of its key (see LedgerEntryCacheKey). A record has the latest value of the
+ * entry and its state in the top level delta.
+ *
+ * A nested delta doesn't copy anything: it changes the records in place, and
+ * appends an undo record for each entry it touches, with the state of the
+ * entry in that delta and, once it changes it, the value the entry had
+ * before. The undo records of the deltas nested in each other follow each
+ * other, so rolling back a delta replays its own undo records backwards,
+ * and committing it folds their states into the outer delta; both cost as
+ * much as the entries the delta touched.
+ */
+
+namespace
+{
+enum EntryState : uint8_t
+{
+    ENTRY_NONE,
+    ENTRY_NEW,
+    ENTRY_MOD,
+    ENTRY_DELETED
+};
+
+size_t const NO_UNDO = std::numeric_limits<size_t>::max();
+
+void
+applyAdd(EntryState& state)
+{
+    if (state == ENTRY_DELETED)
+    {
+        // delete + new is an update
+        state = ENTRY_MOD;
+    }
+    else
+    {
+        assert(state != ENTRY_NEW); // double new
+        assert(state != ENTRY_MOD); // mod + new is invalid
+        state = ENTRY_NEW;
+    }
+}
+
+void
+applyDelete(EntryState& state)
+{
+    if (state == ENTRY_NEW)
+    {
+        // new + delete -> don't add it in the first place
+        state = ENTRY_NONE;
+    }
+    else
+    {
+        // double delete here means there is buggy code upstream
+        // and we cannot keep going as this may corrupt the bucket list
+        assert(state != ENTRY_DELETED);
+
+        // mod + delete -> delete
+        state = ENTRY_DELETED;
+    }
+}
+
+void
+applyMod(EntryState& state)
+{
+    // new + mod = new (with latest value), mod + mod = mod
+    if (state == ENTRY_NONE)
+    {
+        state = ENTRY_MOD;
+    }
+    assert(state != ENTRY_DELETED); // delete + mod is illegal
+}
+}
+
+// What a delta knows of an entry: how it changed it, and the value recorded
+// before it did (see recordEntry).
+struct LedgerDelta::ScopeState
+{
+    EntryState mState{ENTRY_NONE};
+    bool mHasPrevious{false};
+    LedgerEntry mPrevious;
+
+    void
+    setPrevious(LedgerEntry const& entry)
+    {
+        // keeps the old one around
+        if (!mHasPrevious)
+        {
+            mHasPrevious = true;
+            mPrevious = entry;
+        }
+    }
+
+    // what the outer delta of the delta in state `inner` knows once it is
+    // committed, as if each change was made again in the outer delta
+    void
+    merge(ScopeState& inner)
+    {
+        switch (inner.mState)
+        {
+        case ENTRY_NONE:
+            return;
+        case ENTRY_NEW:
+            applyAdd(mState);
+            return;
+        case ENTRY_MOD:
+            applyMod(mState);
+            break;
+        case ENTRY_DELETED:
+            applyDelete(mState);
+            break;
+        }
+        // propagates the previous value for deleted & modified entries
+        if (inner.mHasPrevious && !mHasPrevious)
+        {
+            mHasPrevious = true;
+            mPrevious = std::move(inner.mPrevious);
+        }
+    }
+};
+
+struct LedgerDelta::Entries
+{
+    struct Record
+    {
+        Record(LedgerKey const& key, LedgerEntryCacheKey const& id)
+            : mKey(key), mId(id)
+        {
+        }
+
+        LedgerKey mKey;
+        LedgerEntryCacheKey mId;
+        // state in the top level delta
+        ScopeState mTop;
+        // latest value, if the entry is live
+        bool mLive{false};
+        LedgerEntry mCurrent;
+        // last undo record of the entry, of the innermost delta touching it
+        size_t mLastUndo{NO_UNDO};
+    };
+
+    struct Undo
+    {
+        Undo(size_t record, size_t previousUndo)
+            : mRecord(record), mPreviousUndo(previousUndo)
+        {
+        }
+
+        size_t mRecord;
+        size_t mPreviousUndo;
+        // state in the delta owning this undo record
+        ScopeState mScope;
+        // value of the record before that delta changed it
+        bool mSaved{false};
+        bool mSavedLive{false};
+        LedgerEntry mSavedCurrent;
+    };
+
+    std::vector<Record> mRecords;
+    // indexes of records plus one, 0 for free slots; never more than half
+    // full
+    std::vector<size_t> mSlots;
+    std::vector<Undo> mUndo;
+
+    size_t
+    findOrAdd(LedgerKey const& key)
+    {
+        LedgerEntryCacheKey id(key);
+        if ((mRecords.size() + 1) * 2 > mSlots.size())
+        {
+            grow();
+        }
+        size_t mask = mSlots.size() - 1;
+        for (size_t i = id.hash() & mask;; i = (i + 1) & mask)
+        {
+            if (mSlots[i] == 0)
+            {
+                mRecords.emplace_back(key, id);
+                mSlots[i] = mRecords.size();
+                return mRecords.size() - 1;
+            }
+            if (mRecords[mSlots[i] - 1].mId == id)
+            {
+                return mSlots[i] - 1;
+            }
+        }
+    }
+
+    void
+    grow()
+    {
+        mSlots.assign(std::max<size_t>(mSlots.size() * 2, 64), 0);
+        size_t mask = mSlots.size() - 1;
+        for (size_t r = 0; r < mRecords.size(); ++r)
+        {
+            size_t i = mRecords[r].mId.hash() & mask;
+            while (mSlots[i] != 0)
+            {
+                i = (i + 1) & mask;
+            }
+            mSlots[i] = r + 1;
+        }
+    }
+};
+
 LedgerDelta::LedgerDelta(LedgerDelta& outerDelta)
     : mOuterDelta(&outerDelta)
+    , mInnerDelta(nullptr)
     , mHeader(&outerDelta.getHeader())
     , mCurrentHeader(outerDelta.getHeader())
     , mPreviousHeaderValue(outerDelta.getHeader())
+    , mEntries(outerDelta.mEntries)
+    , mUndoBegin(outerDelta.mEntries->mUndo.size())
     , mDb(outerDelta.mDb)
     , mUpdateLastModified(outerDelta.mUpdateLastModified)
 {
+    outerDelta.checkState();
+    outerDelta.mInnerDelta = this;
 }
 
 LedgerDelta::LedgerDelta(LedgerHeader& header, Database& db,
                          bool updateLastModified)
     : mOuterDelta(nullptr)
+    , mInnerDelta(nullptr)
     , mHeader(&header)
     , mCurrentHeader(header)
     , mPreviousHeaderValue(header)
+    , mOwnEntries(make_unique<Entries>())
+    , mEntries(mOwnEntries.get())
+    , mUndoBegin(0)
     , mDb(db)
     , mUpdateLastModified(updateLastModified)
 {
@@ -69,144 +290,141 @@ LedgerDelta::checkState()
         throw std::runtime_error(
             "Invalid operation: delta is already committed");
     }
+    if (mInnerDelta != nullptr)
+    {
+        throw std::runtime_error(
+            "Invalid operation: delta has a nested delta in progress");
+    }
 }
 
-void
-LedgerDelta::addEntry(EntryFrame const& entry)
-{
-    addEntry(entry.copy());
-}
-
-void
-LedgerDelta::deleteEntry(EntryFrame const& entry)
-{
-    deleteEntry(entry.copy());
-}
-
-void
-LedgerDelta::modEntry(EntryFrame const& entry)
+LedgerDelta::ScopeState&
+LedgerDelta::getScopeState(size_t record)
 {
-    modEntry(entry.copy());
+    auto& r = mEntries->mRecords[record];
+    if (!mOuterDelta)
+    {
+        return r.mTop;
+    }
+    // no delta is nested in this one, so an undo record of the entry past
+    // mUndoBegin is ours
+    if (r.mLastUndo == NO_UNDO || r.mLastUndo < mUndoBegin)
+    {
+        mEntries->mUndo.emplace_back(record, r.mLastUndo);
+        r.mLastUndo = mEntries->mUndo.size() - 1;
+    }
+    return mEntries->mUndo[r.mLastUndo].mScope;
 }
 
 void
-LedgerDelta::recordEntry(EntryFrame const& entry)
+LedgerDelta::saveCurrent(size_t record)
 {
-    recordEntry(entry.copy());
+    auto& r = mEntries->mRecords[record];
+    if (!mOuterDelta)
+    {
+        return;
+    }
+    auto& u = mEntries->mUndo[r.mLastUndo];
+    if (!u.mSaved)
+    {
+        u.mSaved = true;
+        u.mSavedLive = r.mLive;
+        u.mSavedCurrent = std::move(r.mCurrent);
+    }
 }
 
 void
-LedgerDelta::addEntry(EntryFrame::pointer entry)
+LedgerDelta::addEntry(EntryFrame const& entry)
 {
     checkState();
-    auto k = entry->getKey();
-    auto del_it = mDelete.find(k);
-    if (del_it != mDelete.end())
-    {
-        // delete + new is an update
-        mDelete.erase(del_it);
-        mMod[k] = entry;
-    }
-    else
-    {
-        assert(mNew.find(k) == mNew.end()); // double new
-        assert(mMod.find(k) == mMod.end()); // mod + new is invalid
-        mNew[k] = entry;
-    }
+    auto record = mEntries->findOrAdd(entry.getKey());
+    applyAdd(getScopeState(record).mState);
+    saveCurrent(record);
+    auto& r = mEntries->mRecords[record];
+    r.mLive = true;
+    r.mCurrent = entry.mEntry;
 }
 
 void
-LedgerDelta::deleteEntry(EntryFrame::pointer entry)
+LedgerDelta::deleteEntry(EntryFrame const& entry)
 {
-    auto k = entry->getKey();
-    deleteEntry(k);
+    deleteEntry(entry.getKey());
 }
 
 void
 LedgerDelta::deleteEntry(LedgerKey const& k)
 {
     checkState();
-    auto new_it = mNew.find(k);
-    if (new_it != mNew.end())
-    {
-        // new + delete -> don't add it in the first place
-        mNew.erase(new_it);
-    }
-    else
-    {
-        // double delete here means there is buggy code upstream
-        // and we cannot keep going as this may corrupt the bucket list
-        assert(mDelete.find(k) == mDelete.end());
-
-        // mod + delete -> delete
-        mMod.erase(k);
-        mDelete.insert(k);
-    }
+    auto record = mEntries->findOrAdd(k);
+    applyDelete(getScopeState(record).mState);
+    saveCurrent(record);
+    mEntries->mRecords[record].mLive = false;
 }
 
 void
-LedgerDelta::modEntry(EntryFrame::pointer entry)
+LedgerDelta::modEntry(EntryFrame const& entry)
 {
     checkState();
-    auto k = entry->getKey();
-    auto mod_it = mMod.find(k);
-    if (mod_it != mMod.end())
-    {
-        // collapse mod
-        mod_it->second = entry;
-    }
-    else
-    {
-        auto new_it = mNew.find(k);
-        if (new_it != mNew.end())
-        {
-            // new + mod = new (with latest value)
-            new_it->second = entry;
-        }
-        else
-        {
-            assert(mDelete.find(k) == mDelete.end()); // delete + mod is illegal
-            mMod[k] = entry;
-        }
-    }
+    auto record = mEntries->findOrAdd(entry.getKey());
+    applyMod(getScopeState(record).mState);
+    saveCurrent(record);
+    auto& r = mEntries->mRecords[record];
+    r.mLive = true;
+    r.mCurrent = entry.mEntry;
 }
 
 void
-LedgerDelta::recordEntry(EntryFrame::pointer entry)
+LedgerDelta::recordEntry(EntryFrame const& entry)
 {
     checkState();
-    // keeps the old one around
-    mPrevious.insert(std::make_pair(entry->getKey(), entry));
+    auto record = mEntries->findOrAdd(entry.getKey());
+    getScopeState(record).setPrevious(entry.mEntry);
 }
 
 void
-LedgerDelta::mergeEntries(LedgerDelta& other)
+LedgerDelta::mergeIntoOuter()
 {
-    checkState();
-
-    // propagates mPrevious for deleted & modified entries
-    for (auto& d : other.mDelete)
+    auto& records = mEntries->mRecords;
+    auto& undo = mEntries->mUndo;
+    bool outerIsTop = mOuterDelta->mOuterDelta == nullptr;
+
+    // undo records of entries the outer delta touched too are folded into
+    // its own; the others become its own, and are packed after them
+    size_t kept = mUndoBegin;
+    for (size_t i = mUndoBegin; i < undo.size(); ++i)
     {
-        deleteEntry(d);
-        auto it = other.mPrevious.find(d);
-        if (it != other.mPrevious.end())
+        auto& u = undo[i];
+        auto& r = records[u.mRecord];
+        if (outerIsTop)
         {
-            recordEntry(*it->second);
+            r.mTop.merge(u.mScope);
+            r.mLastUndo = NO_UNDO;
         }
-    }
-    for (auto& n : other.mNew)
-    {
-        addEntry(n.second);
-    }
-    for (auto& m : other.mMod)
-    {
-        modEntry(m.second);
-        auto it = other.mPrevious.find(m.first);
-        if (it != other.mPrevious.end())
+        else if (u.mPreviousUndo != NO_UNDO &&
+                 u.mPreviousUndo >= mOuterDelta->mUndoBegin)
         {
-            recordEntry(*it->second);
+            auto& outer = undo[u.mPreviousUndo];
+            outer.mScope.merge(u.mScope);
+            if (u.mSaved && !outer.mSaved)
+            {
+                outer.mSaved = true;
+                outer.mSavedLive = u.mSavedLive;
+                outer.mSavedCurrent = std::move(u.mSavedCurrent);
+            }
+            r.mLastUndo = u.mPreviousUndo;
+        }
+        else
+        {
+            ScopeState outer;
+            outer.merge(u.mScope);
+            u.mScope = std::move(outer);
+            if (kept != i)
+            {
+                undo[kept] = std::move(u);
+            }
+            r.mLastUndo = kept++;
         }
     }
+    undo.erase(undo.begin() + kept, undo.end());
 }
 
 void
@@ -222,8 +440,8 @@ LedgerDelta::commit()
 
     if (mOuterDelta)
     {
-        mOuterDelta->mergeEntries(*this);
-        mOuterDelta = nullptr;
+        mergeIntoOuter();
+        mOuterDelta->mInnerDelta = nullptr;
     }
     *mHeader = mCurrentHeader.mHeader;
     mHeader = nullptr;
@@ -235,79 +453,203 @@ LedgerDelta::rollback()
     checkState();
     mHeader = nullptr;
 
-    for (auto& d : mDelete)
+    if (!mOuterDelta)
     {
-        EntryFrame::flushCachedEntry(d, mDb);
-    }
-    for (auto& n : mNew)
-    {
-        EntryFrame::flushCachedEntry(n.first, mDb);
+        for (auto const& r : mEntries->mRecords)
+        {
+            rollbackEntry(r.mKey, r.mTop, r.mLive ? &r.mCurrent : nullptr);
+        }
+        return;
     }
-    for (auto& m : mMod)
+
+    auto& records = mEntries->mRecords;
+    auto& undo = mEntries->mUndo;
+    for (size_t i = undo.size(); i-- > mUndoBegin;)
     {
-        EntryFrame::flushCachedEntry(m.first, mDb);
+        auto& u = undo[i];
+        auto& r = records[u.mRecord];
+        rollbackEntry(r.mKey, u.mScope, r.mLive ? &r.mCurrent : nullptr);
+        if (u.mSaved)
+        {
+            r.mLive = u.mSavedLive;
+            r.mCurrent = std::move(u.mSavedCurrent);
+        }
+        r.mLastUndo = u.mPreviousUndo;
     }
+    undo.erase(undo.begin() + mUndoBegin, undo.end());
+    mOuterDelta->mInnerDelta = nullptr;
 }
 
 void
-LedgerDelta::addCurrentMeta(LedgerEntryChanges& changes,
-                            LedgerKey const& key) const
+LedgerDelta::rollbackEntry(LedgerKey const& key, ScopeState const& state,
+                           LedgerEntry const* current)
 {
-    auto it = mPrevious.find(key);
-    if (it != mPrevious.end())
+    if (state.mState == ENTRY_NONE)
+    {
+        return;
+    }
+    EntryFrame::flushCachedEntry(key, mDb);
+    if (key.type() != OFFER)
+    {
+        return;
+    }
+    // the order book mirrors the offers table: the offer is put back the
+    // way it was before this delta, which is what the enclosing SQL
+    // transaction rolls back to
+    auto& book = mDb.getOrderBook();
+    switch (state.mState)
     {
-        // if the old value is from a previous ledger we emit it
-        auto const& e = it->second->mEntry;
-        if (e.lastModifiedLedgerSeq != mCurrentHeader.mHeader.ledgerSeq)
+    case ENTRY_NEW:
+        book.remove(key.offer().offerID);
+        break;
+    case ENTRY_MOD:
+    case ENTRY_DELETED:
+        if (state.mHasPrevious)
+        {
+            book.addOrUpdate(state.mPrevious);
+        }
+        else
         {
-            changes.emplace_back(LEDGER_ENTRY_STATE);
-            changes.back().state() = e;
+            // the books this offer was or is in are reloaded once the SQL
+            // transaction is rolled back
+            book.markDirty(key, current);
         }
+        break;
+    default:
+        break;
     }
 }
 
-LedgerEntryChanges
-LedgerDelta::getChanges() const
+void
+LedgerDelta::forEachEntry(
+    std::function<void(LedgerKey const& key, ScopeState const& state,
+                       LedgerEntry const* current)> const& f) const
 {
-    LedgerEntryChanges changes;
-
-    for (auto const& k : mNew)
+    auto const& records = mEntries->mRecords;
+    if (!mOuterDelta)
     {
-        changes.emplace_back(LEDGER_ENTRY_CREATED);
-        changes.back().created() = k.second->mEntry;
+        for (auto const& r : records)
+        {
+            f(r.mKey, r.mTop, r.mLive ? &r.mCurrent : nullptr);
+        }
     }
-    for (auto const& k : mMod)
+    else if (mHeader)
     {
-        addCurrentMeta(changes, k.first);
-        changes.emplace_back(LEDGER_ENTRY_UPDATED);
-        changes.back().updated() = k.second->mEntry;
+        auto const& undo = mEntries->mUndo;
+        for (size_t i = mUndoBegin; i < undo.size(); ++i)
+        {
+            auto const& r = records[undo[i].mRecord];
+            f(r.mKey, undo[i].mScope, r.mLive ? &r.mCurrent : nullptr);
+        }
     }
+}
 
-    for (auto const& k : mDelete)
+void
+LedgerDelta::addCurrentMeta(LedgerEntryChanges& changes,
+                            LedgerEntry const* previous) const
+{
+    // if the old value is from a previous ledger we emit it
+    if (previous &&
+        previous->lastModifiedLedgerSeq != mCurrentHeader.mHeader.ledgerSeq)
     {
-        addCurrentMeta(changes, k);
-        changes.emplace_back(LEDGER_ENTRY_REMOVED);
-        changes.back().removed() = k;
+        changes.emplace_back(LEDGER_ENTRY_STATE);
+        changes.back().state() = *previous;
     }
+}
+
+LedgerEntryChanges
+LedgerDelta::getChanges() const
+{
+    LedgerEntryChanges changes;
+
+    forEachChange([&](LedgerEntryChangeType type, LedgerKey const& key,
+                      LedgerEntry const* previous,
+                      LedgerEntry const* current) {
+        switch (type)
+        {
+        case LEDGER_ENTRY_CREATED:
+            changes.emplace_back(LEDGER_ENTRY_CREATED);
+            changes.back().created() = *current;
+            break;
+        case LEDGER_ENTRY_UPDATED:
+            addCurrentMeta(changes, previous);
+            changes.emplace_back(LEDGER_ENTRY_UPDATED);
+            changes.back().updated() = *current;
+            break;
+        default:
+            addCurrentMeta(changes, previous);
+            changes.emplace_back(LEDGER_ENTRY_REMOVED);
+            changes.back().removed() = key;
+            break;
+        }
+    });
 
     return changes;
 }
 
+void
+LedgerDelta::forEachChange(
+    std::function<void(LedgerEntryChangeType type, LedgerKey const& key,
+                       LedgerEntry const* previous,
+                       LedgerEntry const* current)> const& f) const
+{
+    struct Change
+    {
+        LedgerEntryChangeType mType;
+        LedgerKey const* mKey;
+        LedgerEntry const* mPrevious;
+        LedgerEntry const* mCurrent;
+    };
+    std::vector<Change> changes;
+
+    forEachEntry([&changes](LedgerKey const& key, ScopeState const& state,
+                            LedgerEntry const* current) {
+        auto previous = state.mHasPrevious ? &state.mPrevious : nullptr;
+        switch (state.mState)
+        {
+        case ENTRY_NEW:
+            changes.push_back({LEDGER_ENTRY_CREATED, &key, nullptr, current});
+            break;
+        case ENTRY_MOD:
+            changes.push_back({LEDGER_ENTRY_UPDATED, &key, previous, current});
+            break;
+        case ENTRY_DELETED:
+            changes.push_back({LEDGER_ENTRY_REMOVED, &key, previous, nullptr});
+            break;
+        default:
+            break;
+        }
+    });
+
+    // created, then updated, then removed entries, each in key order
+    LedgerEntryIdCmp cmp;
+    std::sort(changes.begin(), changes.end(),
+              [&cmp](Change const& a, Change const& b) {
+                  if (a.mType != b.mType)
+                  {
+                      return a.mType < b.mType;
+                  }
+                  return cmp(*a.mKey, *b.mKey);
+              });
+
+    for (auto const& c : changes)
+    {
+        f(c.mType, *c.mKey, c.mPrevious, c.mCurrent);
+    }
+}
+
 std::vector<LedgerEntry>
 LedgerDelta::getLiveEntries() const
 {
     std::vector<LedgerEntry> live;
 
-    live.reserve(mNew.size() + mMod.size());
-
-    for (auto const& k : mNew)
-    {
-        live.push_back(k.second->mEntry);
-    }
-    for (auto const& k : mMod)
-    {
-        live.push_back(k.second->mEntry);
-    }
+    forEachEntry([&live](LedgerKey const&, ScopeState const& state,
+                         LedgerEntry const* current) {
+        if (state.mState == ENTRY_NEW || state.mState == ENTRY_MOD)
+        {
+            live.push_back(*current);
+        }
+    });
 
     return live;
 }
@@ -317,12 +659,14 @@ LedgerDelta::getDeadEntries() const
 {
     std::vector<LedgerKey> dead;
 
-    dead.reserve(mDelete.size());
+    forEachEntry([&dead](LedgerKey const& key, ScopeState const& state,
+                         LedgerEntry const*) {
+        if (state.mState == ENTRY_DELETED)
+        {
+            dead.push_back(key);
+        }
+    });
 
-    for (auto const& k : mDelete)
-    {
-        dead.push_back(k);
-    }
     return dead;
 }
 
@@ -335,85 +679,43 @@ LedgerDelta::updateLastModified() const
 void
 LedgerDelta::markMeters(Application& app) const
 {
-    for (auto const& ke : mNew)
-    {
-        switch (ke.first.type())
+    forEachEntry([&app](LedgerKey const& key, ScopeState const& state,
+                        LedgerEntry const*) {
+        char const* change;
+        switch (state.mState)
         {
-        case ACCOUNT:
-            app.getMetrics()
-                .NewMeter({"ledger", "account", "add"}, "entry")
-                .Mark();
+        case ENTRY_NEW:
+            change = "add";
             break;
-        case TRUSTLINE:
-            app.getMetrics()
-                .NewMeter({"ledger", "trust", "add"}, "entry")
-                .Mark();
-            break;
-        case OFFER:
-            app.getMetrics()
-                .NewMeter({"ledger", "offer", "add"}, "entry")
-                .Mark();
+        case ENTRY_MOD:
+            change = "modify";
             break;
-        case DATA:
-            app.getMetrics()
-                .NewMeter({"ledger", "data", "add"}, "entry")
-                .Mark();
+        case ENTRY_DELETED:
+            change = "delete";
             break;
+        default:
+            return;
         }
-    }
 
-    for (auto const& ke : mMod)
-    {
-        switch (ke.first.type())
+        char const* type;
+        switch (key.type())
         {
         case ACCOUNT:
-            app.getMetrics()
-                .NewMeter({"ledger", "account", "modify"}, "entry")
-                .Mark();
+            type = "account";
             break;
         case TRUSTLINE:
-            app.getMetrics()
-                .NewMeter({"ledger", "trust", "modify"}, "entry")
-                .Mark();
+            type = "trust";
             break;
         case OFFER:
-            app.getMetrics()
-                .NewMeter({"ledger", "offer", "modify"}, "entry")
-                .Mark();
+            type = "offer";
             break;
         case DATA:
-            app.getMetrics()
-                .NewMeter({"ledger", "data", "modify"}, "entry")
-                .Mark();
+            type = "data";
             break;
+        default:
+            return;
         }
-    }
-
-    for (auto const& ke : mDelete)
-    {
-        switch (ke.type())
-        {
-        case ACCOUNT:
-            app.getMetrics()
-                .NewMeter({"ledger", "account", "delete"}, "entry")
-                .Mark();
-            break;
-        case TRUSTLINE:
-            app.getMetrics()
-                .NewMeter({"ledger", "trust", "delete"}, "entry")
-                .Mark();
-            break;
-        case OFFER:
-            app.getMetrics()
-                .NewMeter({"ledger", "offer", "delete"}, "entry")
-                .Mark();
-            break;
-        case DATA:
-            app.getMetrics()
-                .NewMeter({"ledger", "data", "delete"}, "entry")
-                .Mark();
-            break;
-        }
-    }
+        app.getMetrics().NewMeter({"ledger", type, change}, "entry").Mark();
+    });
 }
 }
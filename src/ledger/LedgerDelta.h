@@ -8,7 +8,9 @@
 #include "ledger/EntryFrame.h"
 #include "ledger/LedgerHeaderFrame.h"
 #include "xdrpp/marshal.h"
+#include <functional>
 #include <map>
+#include <memory>
 #include <set>
 
 namespace stellar
@@ -18,40 +20,56 @@ class Database;
 
 class LedgerDelta
 {
-    typedef std::map<LedgerKey, EntryFrame::pointer, LedgerEntryIdCmp>
-        KeyEntryMap;
+    // The entries changed in a ledger, shared by the top level delta and the
+    // deltas nested inside it (see LedgerDelta.cpp).
+    struct Entries;
+    struct ScopeState;
 
     LedgerDelta*
         mOuterDelta;       // set when this delta is nested inside another delta
-    LedgerHeader* mHeader; // LedgerHeader to commit changes to
+    LedgerDelta* mInnerDelta; // set while a delta is nested inside this one
+    LedgerHeader* mHeader;    // LedgerHeader to commit changes to
 
     // objects to keep track of changes
     // ledger header itself
     LedgerHeaderFrame mCurrentHeader;
     LedgerHeader mPreviousHeaderValue;
-    // ledger entries
-    KeyEntryMap mNew;
-    KeyEntryMap mMod;
-    std::set<LedgerKey, LedgerEntryIdCmp> mDelete;
-    KeyEntryMap mPrevious;
+    // ledger entries: owned by the top level delta, a nested delta only adds
+    // undo records, from mUndoBegin on, to restore the entries it changes
+    std::unique_ptr<Entries> mOwnEntries;
+    Entries* mEntries;
+    size_t mUndoBegin;
 
     Database& mDb; // Used strictly for rollback of db entry cache.
 
     bool mUpdateLastModified;
 
     void checkState();
-    void addEntry(EntryFrame::pointer entry);
-    void deleteEntry(EntryFrame::pointer entry);
-    void modEntry(EntryFrame::pointer entry);
-    void recordEntry(EntryFrame::pointer entry);
 
-    // merge "other" into current ledgerDelta
-    void mergeEntries(LedgerDelta& other);
+    // state of the entry of record `record` as seen by this delta
+    ScopeState& getScopeState(size_t record);
+    // saves the value of the entry of record `record` before this delta
+    // changes it, so that it can be restored on rollback
+    void saveCurrent(size_t record);
+
+    // Calls `f` with the key, state and current value (null if not live) of
+    // each entry this delta knows of.
+    void forEachEntry(
+        std::function<void(LedgerKey const& key, ScopeState const& state,
+                           LedgerEntry const* current)> const& f) const;
+
+    // merge this delta into the outer delta
+    void mergeIntoOuter();
+
+    // flushes the db cache entry and restores the order book for an entry
+    // changed in this delta
+    void rollbackEntry(LedgerKey const& key, ScopeState const& state,
+                       LedgerEntry const* current);
 
     // helper method that adds a meta entry to "changes"
     // with the previous value of an entry if needed
     void addCurrentMeta(LedgerEntryChanges& changes,
-                        LedgerKey const& key) const;
+                        LedgerEntry const* previous) const;
 
   public:
     // keeps an internal reference to the outerDelta,
@@ -78,7 +96,8 @@ class LedgerDelta
     void modEntry(EntryFrame const& entry);
     void recordEntry(EntryFrame const& entry);
 
-    // commits this delta into outer delta
+    // commits this delta into outer delta. A nested delta must be committed
+    // or rolled back before its outer delta records any other change.
     void commit();
     // aborts any changes pending, flush db cache entries
     void rollback();
@@ -91,6 +110,18 @@ class LedgerDelta
     std::vector<LedgerEntry> getLiveEntries() const;
     std::vector<LedgerKey> getDeadEntries() const;
 
+    // Changes made by this delta; empty once a nested delta is committed or
+    // rolled back, as its changes then belong to the outer delta (or to
+    // nothing).
     LedgerEntryChanges getChanges() const;
+
+    // Calls `f` for each entry created, updated or removed by this delta
+    // with its key, its value before the delta (null if it was created, or
+    // if that value was not recorded, see recordEntry) and its value after
+    // the delta (null if it was removed).
+    void forEachChange(
+        std::function<void(LedgerEntryChangeType type, LedgerKey const& key,
+                           LedgerEntry const* previous,
+                           LedgerEntry const* current)> const& f) const;
 };
 }
@@ -11,6 +11,7 @@
 #include "main/Application.h"
 #include "test/test.h"
 #include "util/Timer.h"
+#include <algorithm>
 
 using namespace stellar;
 
@@ -331,3 +332,124 @@ TEST_CASE("Ledger delta", "[ledger][ledgerdelta]")
         }
     }
 }
+
+TEST_CASE("Ledger delta nested scopes", "[ledger][ledgerdelta]")
+{
+    Config cfg(getTestConfig());
+    VirtualClock clock;
+    Application::pointer app = Application::create(clock, cfg);
+    app->start();
+
+    LedgerHeader header = app->getLedgerManager().getCurrentLedgerHeader();
+    header.ledgerSeq++;
+    LedgerDelta delta(header, app->getDatabase());
+
+    std::vector<AccountFrame::pointer> accounts;
+    for (auto const& a : LedgerTestUtils::generateValidAccountEntries(3))
+    {
+        LedgerEntry le;
+        le.data.type(ACCOUNT);
+        le.data.account() = a;
+        le.lastModifiedLedgerSeq = header.ledgerSeq - 1;
+        accounts.emplace_back(std::make_shared<AccountFrame>(le));
+    }
+    auto& a0 = accounts[0];
+    auto& a1 = accounts[1];
+    auto& a2 = accounts[2];
+    auto const a1Before = a1->mEntry;
+
+    auto bump = [&](AccountFrame::pointer& a) {
+        a->setSeqNum(a->getSeqNum() + 1);
+        a->mEntry.lastModifiedLedgerSeq = header.ledgerSeq;
+    };
+    auto count = [](LedgerEntryChanges const& changes,
+                    LedgerEntryChangeType type) {
+        return std::count_if(
+            changes.begin(), changes.end(),
+            [type](LedgerEntryChange const& c) { return c.type() == type; });
+    };
+    auto updated = [](LedgerEntryChanges const& changes,
+                      LedgerKey const& k) -> LedgerEntry {
+        for (auto const& c : changes)
+        {
+            if (c.type() == LEDGER_ENTRY_UPDATED &&
+                LedgerEntryKey(c.updated()) == k)
+            {
+                return c.updated();
+            }
+        }
+        FAIL("no update of the entry");
+        return LedgerEntry{};
+    };
+
+    a0->mEntry.lastModifiedLedgerSeq = header.ledgerSeq;
+    delta.addEntry(*a0);
+    {
+        LedgerDelta txDelta(delta);
+        txDelta.recordEntry(*a1);
+        bump(a1);
+        txDelta.modEntry(*a1);
+        {
+            LedgerDelta opDelta(txDelta);
+            bump(a0);
+            opDelta.modEntry(*a0);
+            a2->mEntry.lastModifiedLedgerSeq = header.ledgerSeq;
+            opDelta.addEntry(*a2);
+            auto changes = opDelta.getChanges();
+            REQUIRE(changes.size() == 2);
+            REQUIRE(count(changes, LEDGER_ENTRY_CREATED) == 1);
+            REQUIRE(updated(changes, a0->getKey()) == a0->mEntry);
+            opDelta.commit();
+        }
+        auto const a0AfterOp = a0->mEntry;
+        {
+            LedgerDelta opDelta(txDelta);
+            opDelta.deleteEntry(*a2);
+            bump(a0);
+            opDelta.modEntry(*a0);
+            // changes go through the innermost delta
+            REQUIRE_THROWS(txDelta.modEntry(*a0));
+            REQUIRE_THROWS(LedgerDelta{txDelta});
+            opDelta.rollback();
+        }
+
+        // the rolled back operation left nothing behind
+        auto changes = txDelta.getChanges();
+        REQUIRE(changes.size() == 4);
+        REQUIRE(count(changes, LEDGER_ENTRY_CREATED) == 1);
+        REQUIRE(count(changes, LEDGER_ENTRY_STATE) == 1);
+        REQUIRE(count(changes, LEDGER_ENTRY_UPDATED) == 2);
+        REQUIRE(updated(changes, a0->getKey()) == a0AfterOp);
+        REQUIRE(updated(changes, a1->getKey()) == a1->mEntry);
+        for (auto const& c : changes)
+        {
+            if (c.type() == LEDGER_ENTRY_STATE)
+            {
+                REQUIRE(c.state() == a1Before);
+            }
+        }
+        txDelta.commit();
+    }
+
+    auto changes = delta.getChanges();
+    REQUIRE(changes.size() == 4);
+    REQUIRE(count(changes, LEDGER_ENTRY_CREATED) == 2);
+    REQUIRE(count(changes, LEDGER_ENTRY_STATE) == 1);
+    REQUIRE(delta.getLiveEntries().size() == 3);
+    REQUIRE(delta.getDeadEntries().empty());
+
+    {
+        LedgerDelta txDelta(delta);
+        txDelta.deleteEntry(*a0);
+        txDelta.deleteEntry(*a1);
+        txDelta.commit();
+    }
+    // new + delete is nothing, mod + delete a delete
+    REQUIRE(delta.getLiveEntries().size() == 1);
+    auto dead = delta.getDeadEntries();
+    REQUIRE(dead.size() == 1);
+    REQUIRE(dead[0] == a1->getKey());
+    changes = delta.getChanges();
+    REQUIRE(changes.size() == 3);
+    REQUIRE(count(changes, LEDGER_ENTRY_REMOVED) == 1);
+}
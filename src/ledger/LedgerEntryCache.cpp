@@ -0,0 +1,283 @@
+// Copyright 2017 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "ledger/LedgerEntryCache.h"
+
+#include "medida/counter.h"
+#include "medida/meter.h"
+#include "medida/metrics_registry.h"
+
+#include <cassert>
+#include <cstring>
+#include <sodium.h>
+
+namespace stellar
+{
+
+namespace
+{
+
+std::array<unsigned char, crypto_shorthash_KEYBYTES> const&
+cacheKeyHashSeed()
+{
+    static struct Seed
+    {
+        std::array<unsigned char, crypto_shorthash_KEYBYTES> mBytes;
+        Seed()
+        {
+            randombytes_buf(mBytes.data(), mBytes.size());
+        }
+    } const seed;
+    return seed.mBytes;
+}
+
+class KeyPacker
+{
+    uint8_t* mOut;
+    size_t mSize{0};
+
+  public:
+    explicit KeyPacker(uint8_t* out) : mOut(out)
+    {
+    }
+
+    void
+    add(uint8_t b)
+    {
+        mOut[mSize++] = b;
+    }
+
+    void
+    add(uint8_t const* p, size_t n)
+    {
+        std::memcpy(mOut + mSize, p, n);
+        mSize += n;
+    }
+
+    void
+    add(PublicKey const& pk)
+    {
+        auto const& k = pk.ed25519();
+        add(k.data(), k.size());
+    }
+
+    void
+    add(Asset const& asset)
+    {
+        add(static_cast<uint8_t>(asset.type()));
+        switch (asset.type())
+        {
+        case ASSET_TYPE_NATIVE:
+            break;
+        case ASSET_TYPE_CREDIT_ALPHANUM4:
+            add(asset.alphaNum4().assetCode.data(),
+                asset.alphaNum4().assetCode.size());
+            add(asset.alphaNum4().issuer);
+            break;
+        case ASSET_TYPE_CREDIT_ALPHANUM12:
+            add(asset.alphaNum12().assetCode.data(),
+                asset.alphaNum12().assetCode.size());
+            add(asset.alphaNum12().issuer);
+            break;
+        }
+    }
+
+    size_t
+    size() const
+    {
+        return mSize;
+    }
+};
+}
+
+LedgerEntryCacheKey::LedgerEntryCacheKey(LedgerKey const& key)
+    : mBytes{}, mType(key.type())
+{
+    KeyPacker packer(mBytes.data());
+    packer.add(static_cast<uint8_t>(key.type()));
+    switch (key.type())
+    {
+    case ACCOUNT:
+        packer.add(key.account().accountID);
+        break;
+    case TRUSTLINE:
+        packer.add(key.trustLine().accountID);
+        packer.add(key.trustLine().asset);
+        break;
+    case OFFER:
+    {
+        packer.add(key.offer().sellerID);
+        uint64_t id = key.offer().offerID;
+        for (int i = 0; i < 8; ++i)
+        {
+            packer.add(static_cast<uint8_t>(id >> (56 - 8 * i)));
+        }
+    }
+    break;
+    case DATA:
+    {
+        auto const& name = key.data().dataName;
+        packer.add(key.data().accountID);
+        packer.add(static_cast<uint8_t>(name.size()));
+        packer.add(reinterpret_cast<uint8_t const*>(name.data()),
+                   name.size());
+    }
+    break;
+    }
+    mSize = packer.size();
+    assert(mSize <= MAX_BYTES);
+
+    static_assert(crypto_shorthash_BYTES == sizeof(mHash),
+                  "Unexpected short hash length");
+    unsigned char out[crypto_shorthash_BYTES];
+    crypto_shorthash(out, mBytes.data(), mSize, cacheKeyHashSeed().data());
+    std::memcpy(&mHash, out, sizeof(mHash));
+}
+
+bool
+LedgerEntryCacheKey::operator==(LedgerEntryCacheKey const& other) const
+{
+    return mHash == other.mHash && mSize == other.mSize &&
+           std::memcmp(mBytes.data(), other.mBytes.data(), mSize) == 0;
+}
+
+LedgerEntryCache::LedgerEntryCache(medida::MetricsRegistry& metrics,
+                                   size_t capacity, size_t shards)
+    : mCapacity(capacity)
+    , mShardCapacity((capacity + shards - 1) / shards)
+    , mSize(metrics.NewCounter({"entry-cache", "memory", "entries"}))
+{
+    assert(capacity > 0);
+    assert(shards > 0);
+
+    mShards.reserve(shards);
+    for (size_t i = 0; i < shards; ++i)
+    {
+        mShards.emplace_back(new Shard());
+    }
+
+    // indexed by LedgerEntryType; names match the database timers
+    for (auto const& name : {"account", "trust", "offer", "data"})
+    {
+        mTypeMetrics.push_back(TypeMetrics{
+            metrics.NewMeter({"entry-cache", "hit", name}, "entry"),
+            metrics.NewMeter({"entry-cache", "miss", name}, "entry"),
+            metrics.NewMeter({"entry-cache", "evict", name}, "entry")});
+    }
+}
+
+LedgerEntryCache::Shard&
+LedgerEntryCache::shardFor(LedgerEntryCacheKey const& key) const
+{
+    // the low bits of the hash pick the bucket inside a shard's index, so
+    // shards are picked using the high bits.
+    return *mShards[(key.hash() >> 32) % mShards.size()];
+}
+
+LedgerEntryCache::TypeMetrics&
+LedgerEntryCache::metricsFor(LedgerEntryType type)
+{
+    assert(static_cast<size_t>(type) < mTypeMetrics.size());
+    return mTypeMetrics[type];
+}
+
+bool
+LedgerEntryCache::get(LedgerEntryCacheKey const& key, EntryPtr& entry)
+{
+    auto& shard = shardFor(key);
+    {
+        std::lock_guard<std::mutex> guard(shard.mMutex);
+        auto it = shard.mIndex.find(key);
+        if (it != shard.mIndex.end())
+        {
+            shard.mItems.splice(shard.mItems.begin(), shard.mItems,
+                                it->second);
+            entry = it->second->second;
+            metricsFor(key.type()).mHit.Mark();
+            return true;
+        }
+    }
+    metricsFor(key.type()).mMiss.Mark();
+    return false;
+}
+
+bool
+LedgerEntryCache::exists(LedgerEntryCacheKey const& key) const
+{
+    auto& shard = shardFor(key);
+    std::lock_guard<std::mutex> guard(shard.mMutex);
+    return shard.mIndex.find(key) != shard.mIndex.end();
+}
+
+void
+LedgerEntryCache::put(LedgerEntryCacheKey const& key, EntryPtr const& entry)
+{
+    auto& shard = shardFor(key);
+    std::lock_guard<std::mutex> guard(shard.mMutex);
+
+    auto it = shard.mIndex.find(key);
+    if (it != shard.mIndex.end())
+    {
+        it->second->second = entry;
+        shard.mItems.splice(shard.mItems.begin(), shard.mItems, it->second);
+        return;
+    }
+
+    if (shard.mIndex.size() >= mShardCapacity)
+    {
+        // recycle the least recently used node rather than freeing it and
+        // allocating a new one.
+        auto last = std::prev(shard.mItems.end());
+        metricsFor(last->first.type()).mEvict.Mark();
+        shard.mIndex.erase(last->first);
+        last->first = key;
+        last->second = entry;
+        shard.mItems.splice(shard.mItems.begin(), shard.mItems, last);
+    }
+    else
+    {
+        shard.mItems.emplace_front(key, entry);
+        mSize.inc();
+    }
+    shard.mIndex.emplace(key, shard.mItems.begin());
+}
+
+void
+LedgerEntryCache::erase(LedgerEntryCacheKey const& key)
+{
+    auto& shard = shardFor(key);
+    std::lock_guard<std::mutex> guard(shard.mMutex);
+    auto it = shard.mIndex.find(key);
+    if (it != shard.mIndex.end())
+    {
+        shard.mItems.erase(it->second);
+        shard.mIndex.erase(it);
+        mSize.dec();
+    }
+}
+
+void
+LedgerEntryCache::clear()
+{
+    for (auto& shard : mShards)
+    {
+        std::lock_guard<std::mutex> guard(shard->mMutex);
+        mSize.dec(shard->mIndex.size());
+        shard->mIndex.clear();
+        shard->mItems.clear();
+    }
+}
+
+size_t
+LedgerEntryCache::size() const
+{
+    size_t res = 0;
+    for (auto const& shard : mShards)
+    {
+        std::lock_guard<std::mutex> guard(shard->mMutex);
+        res += shard->mIndex.size();
+    }
+    return res;
+}
+}
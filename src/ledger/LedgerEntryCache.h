@@ -0,0 +1,154 @@
+#pragma once
+
+// Copyright 2017 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "overlay/StellarXDR.h"
+#include "util/NonCopyable.h"
+#include <array>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace medida
+{
+class Counter;
+class Meter;
+class MetricsRegistry;
+}
+
+namespace stellar
+{
+
+/**
+ * Fixed-size binary identity of a LedgerKey.
+ *
+ * The key is packed as the entry type, the 32-byte account ID and whatever
+ * else distinguishes entries of that type (asset, offer ID or data name).
+ * Building one never allocates, and its hash is computed once on
+ * construction with a process-wide random SipHash key, so lookups in the
+ * LedgerEntryCache never need to serialize or hex-encode the LedgerKey.
+ */
+class LedgerEntryCacheKey
+{
+  public:
+    // type + account + longest discriminator: a 64-byte data name preceded
+    // by its length.
+    static size_t const MAX_BYTES = 1 + 32 + 1 + 64;
+
+    explicit LedgerEntryCacheKey(LedgerKey const& key);
+
+    LedgerEntryType
+    type() const
+    {
+        return mType;
+    }
+
+    uint64_t
+    hash() const
+    {
+        return mHash;
+    }
+
+    bool operator==(LedgerEntryCacheKey const& other) const;
+
+  private:
+    std::array<uint8_t, MAX_BYTES> mBytes;
+    size_t mSize;
+    LedgerEntryType mType;
+    uint64_t mHash;
+};
+
+struct LedgerEntryCacheKeyHash
+{
+    size_t
+    operator()(LedgerEntryCacheKey const& key) const
+    {
+        return static_cast<size_t>(key.hash());
+    }
+};
+
+/**
+ * LRU cache of LedgerEntries, keyed by LedgerEntryCacheKey. A cached nullptr
+ * records that an entry is known not to exist in the database.
+ *
+ * The cache is split into one or more shards, each with its own LRU list and
+ * mutex, and a key always maps to the same shard. With a single shard (the
+ * default) the cache behaves as a plain LRU of the configured capacity; with
+ * several shards, threads touching different keys rarely contend, which lets
+ * worker threads read through the cache while the main thread writes to it.
+ *
+ * Hits, misses and evictions are recorded per entry type in the
+ * "entry-cache" metrics.
+ */
+class LedgerEntryCache : NonMovableOrCopyable
+{
+  public:
+    typedef std::shared_ptr<LedgerEntry const> EntryPtr;
+
+    LedgerEntryCache(medida::MetricsRegistry& metrics, size_t capacity,
+                     size_t shards = 1);
+
+    // Return true and set `entry` if `key` is cached, marking it as the most
+    // recently used entry of its shard. Records a hit or a miss.
+    bool get(LedgerEntryCacheKey const& key, EntryPtr& entry);
+
+    // Return true if `key` is cached, without touching the LRU order or the
+    // hit/miss metrics.
+    bool exists(LedgerEntryCacheKey const& key) const;
+
+    // Insert or replace `key`, evicting the least recently used entry of its
+    // shard if the shard is full.
+    void put(LedgerEntryCacheKey const& key, EntryPtr const& entry);
+
+    void erase(LedgerEntryCacheKey const& key);
+    void clear();
+
+    size_t size() const;
+
+    size_t
+    getCapacity() const
+    {
+        return mCapacity;
+    }
+
+    size_t
+    getShardCount() const
+    {
+        return mShards.size();
+    }
+
+  private:
+    struct Shard
+    {
+        typedef std::list<std::pair<LedgerEntryCacheKey, EntryPtr>> List;
+
+        mutable std::mutex mMutex;
+        // most recently used entries at the front
+        List mItems;
+        std::unordered_map<LedgerEntryCacheKey, List::iterator,
+                           LedgerEntryCacheKeyHash>
+            mIndex;
+    };
+
+    struct TypeMetrics
+    {
+        medida::Meter& mHit;
+        medida::Meter& mMiss;
+        medida::Meter& mEvict;
+    };
+
+    size_t const mCapacity;
+    size_t const mShardCapacity;
+    std::vector<std::unique_ptr<Shard>> mShards;
+    std::vector<TypeMetrics> mTypeMetrics;
+    medida::Counter& mSize;
+
+    Shard& shardFor(LedgerEntryCacheKey const& key) const;
+    TypeMetrics& metricsFor(LedgerEntryType type);
+};
+}
@@ -0,0 +1,121 @@
+// Copyright 2017 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "ledger/EntryFrame.h"
+#include "ledger/LedgerEntryCache.h"
+#include "ledger/LedgerTestUtils.h"
+#include "lib/catch.hpp"
+#include "medida/meter.h"
+#include "medida/metrics_registry.h"
+
+using namespace stellar;
+using xdr::operator==;
+
+TEST_CASE("ledger entry cache key", "[ledger][entrycache]")
+{
+    auto entries = LedgerTestUtils::generateValidLedgerEntries(100);
+    for (auto const& a : entries)
+    {
+        auto ka = LedgerEntryKey(a);
+        LedgerEntryCacheKey ca(ka);
+        REQUIRE(ca == LedgerEntryCacheKey(ka));
+        REQUIRE(ca.type() == a.data.type());
+        for (auto const& b : entries)
+        {
+            auto kb = LedgerEntryKey(b);
+            REQUIRE((ca == LedgerEntryCacheKey(kb)) == (ka == kb));
+        }
+    }
+}
+
+static void
+checkLedgerEntryCache(size_t shards)
+{
+    medida::MetricsRegistry metrics;
+    size_t const capacity = 64;
+    LedgerEntryCache cache(metrics, capacity, shards);
+
+    auto entries = LedgerTestUtils::generateValidLedgerEntries(capacity);
+    for (auto const& le : entries)
+    {
+        cache.put(LedgerEntryCacheKey(LedgerEntryKey(le)),
+                  std::make_shared<LedgerEntry const>(le));
+    }
+    REQUIRE(cache.size() <= capacity);
+
+    size_t hits = 0;
+    for (auto const& le : entries)
+    {
+        LedgerEntryCache::EntryPtr p;
+        if (cache.get(LedgerEntryCacheKey(LedgerEntryKey(le)), p))
+        {
+            REQUIRE(p);
+            REQUIRE(*p == le);
+            ++hits;
+        }
+    }
+    if (shards == 1)
+    {
+        REQUIRE(hits == entries.size());
+    }
+
+    uint64_t metered = 0;
+    for (auto const& name : {"account", "trust", "offer", "data"})
+    {
+        metered += metrics.NewMeter({"entry-cache", "hit", name}, "entry")
+                       .count();
+    }
+    REQUIRE(metered == hits);
+
+    SECTION("missing entries are cached as nullptr")
+    {
+        auto key = LedgerEntryCacheKey(LedgerEntryKey(entries[0]));
+        cache.put(key, nullptr);
+        LedgerEntryCache::EntryPtr p =
+            std::make_shared<LedgerEntry const>(entries[0]);
+        REQUIRE(cache.get(key, p));
+        REQUIRE(!p);
+    }
+
+    SECTION("erase and clear")
+    {
+        auto key = LedgerEntryCacheKey(LedgerEntryKey(entries[0]));
+        cache.put(key, std::make_shared<LedgerEntry const>(entries[0]));
+        REQUIRE(cache.exists(key));
+        cache.erase(key);
+        REQUIRE(!cache.exists(key));
+        cache.clear();
+        REQUIRE(cache.size() == 0);
+    }
+
+    SECTION("capacity is bounded")
+    {
+        auto more = LedgerTestUtils::generateValidLedgerEntries(capacity * 4);
+        for (auto const& le : more)
+        {
+            cache.put(LedgerEntryCacheKey(LedgerEntryKey(le)),
+                      std::make_shared<LedgerEntry const>(le));
+        }
+        // each shard holds at most its share of the capacity, rounded up
+        REQUIRE(cache.size() <= capacity + shards);
+        if (shards == 1)
+        {
+            REQUIRE(cache.size() == capacity);
+            REQUIRE(cache.exists(
+                LedgerEntryCacheKey(LedgerEntryKey(more.back()))));
+        }
+    }
+}
+
+TEST_CASE("ledger entry cache", "[ledger][entrycache]")
+{
+    SECTION("single shard")
+    {
+        checkLedgerEntryCache(1);
+    }
+    SECTION("sharded")
+    {
+        checkLedgerEntryCache(8);
+    }
+}
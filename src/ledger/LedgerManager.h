@@ -163,8 +163,11 @@ class LedgerManager
     // permit testing.
     virtual void closeLedger(LedgerCloseData const& ledgerData) = 0;
 
-    // deletes old entries stored in the database
-    virtual void deleteOldEntries(Database& db, uint32_t ledgerSeq) = 0;
+    // deletes the history stored in the database for at most `count`
+    // ledgers, oldest first, up to `ledgerSeq` included; returns the number
+    // of rows deleted
+    virtual size_t deleteOldEntries(Database& db, uint32_t ledgerSeq,
+                                    uint32_t count) = 0;
 
     // checks the database for inconsistencies between objects
     virtual void checkDbState() = 0;
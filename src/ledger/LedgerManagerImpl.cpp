@@ -19,16 +19,20 @@
 #include "history/HistoryManager.h"
 #include "invariant/InvariantDoesNotHold.h"
 #include "invariant/InvariantManager.h"
+#include "ledger/ApplyPartition.h"
+#include "ledger/EntryPrefetch.h"
 #include "ledger/LedgerDelta.h"
 #include "ledger/LedgerHeaderFrame.h"
 #include "main/Application.h"
 #include "main/Config.h"
 #include "overlay/OverlayManager.h"
+#include "transactions/BatchSignatureVerifier.h"
 #include "util/Logging.h"
 #include "util/format.h"
 #include "util/make_unique.h"
 
 #include "medida/counter.h"
+#include "medida/histogram.h"
 #include "medida/meter.h"
 #include "medida/metrics_registry.h"
 #include "medida/timer.h"
@@ -106,6 +110,32 @@ LedgerManagerImpl::LedgerManagerImpl(Application& app)
     , mTransactionApply(
           app.getMetrics().NewTimer({"ledger", "transaction", "apply"}))
     , mLedgerClose(app.getMetrics().NewTimer({"ledger", "ledger", "close"}))
+    , mHistoryWrite(app.getMetrics().NewTimer({"ledger", "history", "write"}))
+    , mLedgerClosePrefetch(
+          app.getMetrics().NewTimer({"ledger", "close", "prefetch"}))
+    , mLedgerCloseFees(app.getMetrics().NewTimer({"ledger", "close", "fees"}))
+    , mLedgerCloseApply(
+          app.getMetrics().NewTimer({"ledger", "close", "apply"}))
+    , mLedgerCloseInvariants(
+          app.getMetrics().NewTimer({"ledger", "close", "invariants"}))
+    , mLedgerCloseBuckets(
+          app.getMetrics().NewTimer({"ledger", "close", "buckets"}))
+    , mLedgerCloseStore(
+          app.getMetrics().NewTimer({"ledger", "close", "store"}))
+    , mLedgerCloseCommit(
+          app.getMetrics().NewTimer({"ledger", "close", "commit"}))
+    , mApplyClusters(
+          app.getMetrics().NewHistogram({"ledger", "apply", "clusters"}))
+    , mApplyLargestCluster(
+          app.getMetrics().NewHistogram({"ledger", "apply", "largest-cluster"}))
+    , mApplyBarriers(
+          app.getMetrics().NewHistogram({"ledger", "apply", "barriers"}))
+    , mPrefetchCached(app.getMetrics().NewMeter(
+          {"ledger", "prefetch", "cached"}, "entry"))
+    , mPrefetchLoaded(app.getMetrics().NewMeter(
+          {"ledger", "prefetch", "loaded"}, "entry"))
+    , mPrefetchSavedQueries(app.getMetrics().NewMeter(
+          {"ledger", "prefetch", "saved-queries"}, "query"))
     , mLedgerAgeClosed(app.getMetrics().NewTimer({"ledger", "age", "closed"}))
     , mLedgerAge(
           app.getMetrics().NewCounter({"ledger", "age", "current-seconds"}))
@@ -184,6 +214,9 @@ LedgerManagerImpl::startNewLedger(int64_t balance, uint32_t baseFee,
     mCurrentLedger = make_shared<LedgerHeaderFrame>(genesisHeader);
     CLOG(INFO, "Ledger") << "Established genesis ledger, closing";
     CLOG(INFO, "Ledger") << "Root account seed: " << skey.getStrKeySeed().value;
+    mApp.getBucketManager().prepareBatch(mApp, genesisHeader.ledgerSeq,
+                                         delta.getLiveEntries(),
+                                         delta.getDeadEntries());
     ledgerClosed(delta);
 }
 
@@ -220,6 +253,8 @@ LedgerManagerImpl::loadLastKnownLedger(
             throw std::runtime_error("Could not load ledger from database");
         }
 
+        getDatabase().getOrderBook().load();
+
         if (handler)
         {
             string hasString = mApp.getPersistentState().getState(
@@ -697,6 +732,9 @@ LedgerManagerImpl::closeLedger(LedgerCloseData const& ledgerData)
     CLOG(DEBUG, "Ledger") << "starting closeLedger() on ledgerSeq="
                           << mCurrentLedger->mHeader.ledgerSeq;
 
+    // invariants checked asynchronously on the previous ledgers
+    mApp.getInvariantManager().reportFailedChecks();
+
     auto now = mApp.getClock().now();
     mLedgerAgeClosed.Update(now - mLastClose);
     mLastClose = now;
@@ -731,19 +769,57 @@ LedgerManagerImpl::closeLedger(LedgerCloseData const& ledgerData)
     mCurrentLedger->mHeader.scpValue = sv;
 
     LedgerDelta ledgerDelta(mCurrentLedger->mHeader, getDatabase());
+    mTxHistory.reset(mCurrentLedger->mHeader.ledgerSeq);
 
     // the transaction set that was agreed upon by consensus
     // was sorted by hash; we reorder it so that transactions are
     // sorted such that sequence numbers are respected
     vector<TransactionFramePtr> txs = ledgerData.getTxSet()->sortForApply();
 
+    // signatures were usually verified when the set was validated, but not
+    // when replaying history during catchup
+    BatchSignatureVerifier::preVerify(mApp, txs);
+
+    // load what the transactions name with a few bulk queries, rather than
+    // entry by entry as they are applied
+    {
+        auto prefetchTime = mLedgerClosePrefetch.TimeScope();
+        auto counts = EntryPrefetch::prefetch(txs, getDatabase());
+        mPrefetchCached.Mark(counts.mCached);
+        mPrefetchLoaded.Mark(counts.mLoaded);
+        if (counts.mReplacedQueries > counts.mQueries)
+        {
+            mPrefetchSavedQueries.Mark(counts.mReplacedQueries -
+                                       counts.mQueries);
+        }
+    }
+
     // first, charge fees
-    processFeesSeqNums(txs, ledgerDelta);
+    {
+        auto feesTime = mLedgerCloseFees.TimeScope();
+        processFeesSeqNums(txs, ledgerDelta);
+    }
 
     TransactionResultSet txResultSet;
     txResultSet.results.reserve(txs.size());
 
-    applyTransactions(txs, ledgerDelta, txResultSet);
+    {
+        auto applyTime = mLedgerCloseApply.TimeScope();
+        applyTransactions(txs, ledgerDelta, txResultSet);
+    }
+
+    // No entry changes past this point (upgrades only touch the header), so
+    // the new entries can be made into a bucket on a worker thread while the
+    // history is written and the invariants are checked; ledgerClosed picks
+    // it up.
+    mApp.getBucketManager().prepareBatch(
+        mApp, mCurrentLedger->mHeader.ledgerSeq, ledgerDelta.getLiveEntries(),
+        ledgerDelta.getDeadEntries());
+
+    {
+        auto historyTime = mHistoryWrite.TimeScope();
+        mTxHistory.flush(getDatabase());
+    }
 
     ledgerDelta.getHeader().txSetResultHash =
         sha256(xdr::xdr_to_opaque(txResultSet));
@@ -784,13 +860,16 @@ LedgerManagerImpl::closeLedger(LedgerCloseData const& ledgerData)
         }
     }
 
-    mApp.getInvariantManager().checkOnLedgerClose(ledgerData.getTxSet(),
-                                                  ledgerDelta);
+    {
+        auto invariantsTime = mLedgerCloseInvariants.TimeScope();
+        mApp.getInvariantManager().checkOnLedgerClose(ledgerData.getTxSet(),
+                                                      ledgerDelta);
+    }
 
     ledgerDelta.commit();
     ledgerClosed(ledgerDelta);
 
-    // The next 4 steps happen in a relatively non-obvious, subtle order.
+    // The next 5 steps happen in a relatively non-obvious, subtle order.
     // This is unfortunate and it would be nice if we could make it not
     // be so subtle, but for the time being this is where we are.
     //
@@ -806,6 +885,11 @@ LedgerManagerImpl::closeLedger(LedgerCloseData const& ledgerData)
     //    bucket refcounts are incremented for the duration of the publish).
     //
     // 4. GC unreferenced buckets. Only do this once publishes are in progress.
+    //
+    // 5. Start any asynchronous invariant checks, _after_ the commit so that
+    //    they read the committed state.
+
+    auto commitTime = mLedgerCloseCommit.TimeScope();
 
     // step 1
     auto& hm = mApp.getHistoryManager();
@@ -824,14 +908,21 @@ LedgerManagerImpl::closeLedger(LedgerCloseData const& ledgerData)
     {
         mApp.getBucketManager().forgetUnreferencedBuckets();
     }
+
+    // step 5
+    mApp.getInvariantManager().checkOnLedgerCommit();
 }
 
-void
-LedgerManagerImpl::deleteOldEntries(Database& db, uint32_t ledgerSeq)
+size_t
+LedgerManagerImpl::deleteOldEntries(Database& db, uint32_t ledgerSeq,
+                                    uint32_t count)
 {
-    LedgerHeaderFrame::deleteOldEntries(db, ledgerSeq);
-    TransactionFrame::deleteOldEntries(db, ledgerSeq);
-    HerderPersistence::deleteOldEntries(db, ledgerSeq);
+    soci::transaction txscope(db.getSession());
+    size_t res = LedgerHeaderFrame::deleteOldEntries(db, ledgerSeq, count) +
+                 TransactionFrame::deleteOldEntries(db, ledgerSeq, count) +
+                 HerderPersistence::deleteOldEntries(db, ledgerSeq, count);
+    txscope.commit();
+    return res;
 }
 
 void
@@ -926,7 +1017,8 @@ LedgerManagerImpl::processFeesSeqNums(std::vector<TransactionFramePtr>& txs,
         {
             LedgerDelta thisTxDelta(delta);
             tx->processFeeSeqNum(thisTxDelta, *this);
-            tx->storeTransactionFee(*this, thisTxDelta.getChanges(), ++index);
+            tx->storeTransactionFee(mTxHistory, thisTxDelta.getChanges(),
+                                    ++index);
             thisTxDelta.commit();
         }
         sqlTx.commit();
@@ -946,45 +1038,95 @@ LedgerManagerImpl::applyTransactions(std::vector<TransactionFramePtr>& txs,
 {
     CLOG(DEBUG, "Tx") << "applyTransactions: ledger = "
                       << mCurrentLedger->mHeader.ledgerSeq;
+    if (mApp.getConfig().CLUSTERED_TX_APPLY)
+    {
+        applyTransactionsByCluster(txs, ledgerDelta, txResultSet);
+        return;
+    }
+
     int index = 0;
     for (auto tx : txs)
     {
-        auto txTime = mTransactionApply.TimeScope();
-        LedgerDelta delta(ledgerDelta);
         TransactionMeta tm;
-        try
-        {
-            CLOG(DEBUG, "Tx")
-                << " tx#" << index << " = " << hexAbbrev(tx->getFullHash())
-                << " txseq=" << tx->getSeqNum() << " (@ "
-                << mApp.getConfig().toShortString(tx->getSourceID()) << ")";
+        applyTransaction(tx, index, ledgerDelta, tm);
+        tx->storeTransaction(mTxHistory, tm, ++index, txResultSet);
+    }
+}
 
-            if (tx->apply(delta, tm, mApp))
-            {
-                delta.commit();
-            }
-            else
+void
+LedgerManagerImpl::applyTransactionsByCluster(
+    std::vector<TransactionFramePtr>& txs, LedgerDelta& ledgerDelta,
+    TransactionResultSet& txResultSet)
+{
+    ApplyPartition partition(txs);
+    mApplyClusters.Update(partition.getClusterCount());
+    mApplyLargestCluster.Update(partition.getLargestCluster());
+    mApplyBarriers.Update(partition.getBarrierCount());
+
+    // Clusters of a stage touch disjoint accounts, so each one gets a delta
+    // of its own and the order they are applied in doesn't matter; results
+    // and meta are then stored in the original order, as serial apply does.
+    std::vector<TransactionMeta> metas(txs.size());
+    for (auto const& stage : partition.getStages())
+    {
+        for (auto const& cluster : stage)
+        {
+            LedgerDelta clusterDelta(ledgerDelta);
+            for (auto i : cluster)
             {
-                // failure means there should be no side effects
-                assert(delta.getChanges().size() == 0);
-                assert(delta.getHeader() == ledgerDelta.getHeader());
+                applyTransaction(txs[i], static_cast<int>(i), clusterDelta,
+                                 metas[i]);
             }
+            clusterDelta.commit();
         }
-        catch (InvariantDoesNotHold& e)
-        {
-            throw e;
-        }
-        catch (std::runtime_error& e)
+    }
+
+    for (size_t i = 0; i < txs.size(); ++i)
+    {
+        txs[i]->storeTransaction(mTxHistory, metas[i], static_cast<int>(i + 1),
+                                 txResultSet);
+    }
+}
+
+void
+LedgerManagerImpl::applyTransaction(TransactionFramePtr const& tx, int index,
+                                    LedgerDelta& ledgerDelta,
+                                    TransactionMeta& tm)
+{
+    auto txTime = mTransactionApply.TimeScope();
+    LedgerDelta delta(ledgerDelta);
+    try
+    {
+        CLOG(DEBUG, "Tx") << " tx#" << index << " = "
+                          << hexAbbrev(tx->getFullHash())
+                          << " txseq=" << tx->getSeqNum() << " (@ "
+                          << mApp.getConfig().toShortString(tx->getSourceID())
+                          << ")";
+
+        if (tx->apply(delta, tm, mApp))
         {
-            CLOG(ERROR, "Ledger") << "Exception during tx->apply: " << e.what();
-            tx->getResult().result.code(txINTERNAL_ERROR);
+            delta.commit();
         }
-        catch (...)
+        else
         {
-            CLOG(ERROR, "Ledger") << "Unknown exception during tx->apply";
-            tx->getResult().result.code(txINTERNAL_ERROR);
+            // failure means there should be no side effects
+            assert(delta.getChanges().size() == 0);
+            assert(delta.getHeader() == ledgerDelta.getHeader());
         }
-        tx->storeTransaction(*this, tm, ++index, txResultSet);
+    }
+    catch (InvariantDoesNotHold& e)
+    {
+        throw e;
+    }
+    catch (std::runtime_error& e)
+    {
+        CLOG(ERROR, "Ledger") << "Exception during tx->apply: " << e.what();
+        tx->getResult().result.code(txINTERNAL_ERROR);
+    }
+    catch (...)
+    {
+        CLOG(ERROR, "Ledger") << "Unknown exception during tx->apply";
+        tx->getResult().result.code(txINTERNAL_ERROR);
     }
 }
 
@@ -1026,12 +1168,21 @@ void
 LedgerManagerImpl::ledgerClosed(LedgerDelta const& delta)
 {
     delta.markMeters(mApp);
-    mApp.getBucketManager().addBatch(mApp, mCurrentLedger->mHeader.ledgerSeq,
-                                     delta.getLiveEntries(),
-                                     delta.getDeadEntries());
+    {
+        // the batch was prepared by our caller
+        auto bucketsTime = mLedgerCloseBuckets.TimeScope();
+        mApp.getBucketManager().addPreparedBatch(
+            mApp, mCurrentLedger->mHeader.ledgerSeq);
+        mApp.getBucketManager().snapshotLedger(mCurrentLedger->mHeader);
+    }
 
-    mApp.getBucketManager().snapshotLedger(mCurrentLedger->mHeader);
-    storeCurrentLedger();
+    // The header and the HAS are stored within the transaction of the
+    // ledger, so that a restart finds them consistent with the rest of the
+    // database: this part can't be moved off the close.
+    {
+        auto storeTime = mLedgerCloseStore.TimeScope();
+        storeCurrentLedger();
+    }
     advanceLedgerPointers();
 }
 }
@@ -11,6 +11,7 @@
 #include "ledger/SyncingLedgerChain.h"
 #include "main/PersistentState.h"
 #include "transactions/TransactionFrame.h"
+#include "transactions/TransactionHistoryWriter.h"
 #include "util/Timer.h"
 #include "xdr/Stellar-ledger.h"
 #include <string>
@@ -25,6 +26,8 @@ namespace medida
 {
 class Timer;
 class Counter;
+class Meter;
+class Histogram;
 }
 
 namespace stellar
@@ -41,6 +44,23 @@ class LedgerManagerImpl : public LedgerManager
     Application& mApp;
     medida::Timer& mTransactionApply;
     medida::Timer& mLedgerClose;
+    medida::Timer& mHistoryWrite;
+    // phases of closeLedger
+    medida::Timer& mLedgerClosePrefetch;
+    medida::Timer& mLedgerCloseFees;
+    medida::Timer& mLedgerCloseApply;
+    medida::Timer& mLedgerCloseInvariants;
+    medida::Timer& mLedgerCloseBuckets;
+    medida::Timer& mLedgerCloseStore;
+    medida::Timer& mLedgerCloseCommit;
+    // shape of the transaction sets applied with CLUSTERED_TX_APPLY
+    medida::Histogram& mApplyClusters;
+    medida::Histogram& mApplyLargestCluster;
+    medida::Histogram& mApplyBarriers;
+    // entries loaded ahead of applying transaction sets, see EntryPrefetch
+    medida::Meter& mPrefetchCached;
+    medida::Meter& mPrefetchLoaded;
+    medida::Meter& mPrefetchSavedQueries;
     medida::Timer& mLedgerAgeClosed;
     medida::Counter& mLedgerAge;
     medida::Counter& mLedgerStateCurrent;
@@ -52,6 +72,9 @@ class LedgerManagerImpl : public LedgerManager
 
     SyncingLedgerChain mSyncingLedgers;
 
+    // txhistory and txfeehistory rows of the ledger being closed
+    TransactionHistoryWriter mTxHistory;
+
     void historyCaughtup(asio::error_code const& ec,
                          CatchupWork::ProgressState progressState,
                          LedgerHeaderHistoryEntry const& lastClosed);
@@ -61,6 +84,11 @@ class LedgerManagerImpl : public LedgerManager
     void applyTransactions(std::vector<TransactionFramePtr>& txs,
                            LedgerDelta& ledgerDelta,
                            TransactionResultSet& txResultSet);
+    void applyTransactionsByCluster(std::vector<TransactionFramePtr>& txs,
+                                    LedgerDelta& ledgerDelta,
+                                    TransactionResultSet& txResultSet);
+    void applyTransaction(TransactionFramePtr const& tx, int index,
+                          LedgerDelta& ledgerDelta, TransactionMeta& tm);
 
     void ledgerClosed(LedgerDelta const& delta);
     void storeCurrentLedger();
@@ -105,7 +133,8 @@ class LedgerManagerImpl : public LedgerManager
     HistoryManager::VerifyHashStatus
     verifyCatchupCandidate(LedgerHeaderHistoryEntry const&) const override;
     void closeLedger(LedgerCloseData const& ledgerData) override;
-    void deleteOldEntries(Database& db, uint32_t ledgerSeq) override;
+    size_t deleteOldEntries(Database& db, uint32_t ledgerSeq,
+                            uint32_t count) override;
     void checkDbState() override;
 };
 }
@@ -5,13 +5,16 @@
 #include "bucket/BucketManager.h"
 #include "database/Database.h"
 #include "herder/LedgerCloseData.h"
+#include "herder/TxSetFrame.h"
 #include "ledger/LedgerHeaderFrame.h"
 #include "ledger/LedgerManager.h"
 #include "lib/catch.hpp"
+#include "lib/json/json.h"
 #include "main/Application.h"
 #include "main/Config.h"
 #include "main/PersistentState.h"
 #include "simulation/Simulation.h"
+#include "test/TestAccount.h"
 #include "test/TxTests.h"
 #include "test/test.h"
 #include "util/Logging.h"
@@ -20,6 +23,11 @@
 #include "util/Timer.h"
 #include "util/make_unique.h"
 #include "util/optional.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <random>
 
 using namespace stellar;
 using namespace std;
@@ -223,3 +231,328 @@ TEST_CASE("ledger performance test", "[performance][hide]")
         LOG(INFO) << "done";
     }
 }
+
+static std::chrono::nanoseconds
+pathPaymentThroughput(bool inMemoryOrderBook, int nOffers, int nPayments)
+{
+    Config cfg(getTestConfig());
+    cfg.IN_MEMORY_ORDER_BOOK = inMemoryOrderBook;
+    VirtualClock clock;
+    Application::pointer app = Application::create(clock, cfg);
+    app->start();
+
+    auto root = TestAccount::createRoot(*app);
+    auto xlm = txtest::makeNativeAsset();
+    auto const trustLineLimit = INT64_MAX;
+
+    auto issuer = root.create("issuer", 1000000000000);
+    auto idr = txtest::makeAsset(issuer, "IDR");
+    auto usd = txtest::makeAsset(issuer, "USD");
+
+    // a market maker providing deep XLM -> IDR -> USD books
+    auto mm = root.create("mm", 1000000000000000);
+    mm.changeTrust(idr, trustLineLimit);
+    mm.changeTrust(usd, trustLineLimit);
+    issuer.pay(mm, idr, 10000000000000);
+    issuer.pay(mm, usd, 10000000000000);
+    for (int i = 0; i < nOffers; i++)
+    {
+        Price price{100 + i % 50, 100};
+        mm.manageOffer(0, idr, xlm, price, 100);
+        mm.manageOffer(0, usd, idr, price, 100);
+    }
+
+    auto source = root.create("source", 100000000000000);
+    auto dest = root.create("dest", 1000000000000);
+    dest.changeTrust(usd, trustLineLimit);
+
+    LOG(INFO) << "Path payment benchmark ("
+              << (inMemoryOrderBook ? "in-memory order book" : "SQL")
+              << "): " << nOffers << " offers per book, " << nPayments
+              << " payments";
+
+    // each payment crosses about 10 offers in each book
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < nPayments; i++)
+    {
+        source.pay(dest, xlm, INT64_MAX, usd, 1000, {idr});
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    LOG(INFO) << "Path payment benchmark ("
+              << (inMemoryOrderBook ? "in-memory order book" : "SQL")
+              << "): "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(elapsed)
+                     .count()
+              << "ms, "
+              << (nPayments * 1e9 /
+                  std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed)
+                      .count())
+              << " payments/s";
+    return elapsed;
+}
+
+TEST_CASE("path payment performance with and without order book index",
+          "[performance][orderbook][hide]")
+{
+    int nOffers = 5000;
+    int nPayments = 400;
+
+    auto withIndex = pathPaymentThroughput(true, nOffers, nPayments);
+    auto withoutIndex = pathPaymentThroughput(false, nOffers, nPayments);
+
+    LOG(INFO) << "Order book index speedup: "
+              << (double(withoutIndex.count()) / double(withIndex.count()))
+              << "x";
+}
+
+namespace
+{
+// Parameters of the ledger close benchmark. Each can be overridden from the
+// environment, e.g.:
+//
+//   STELLAR_BENCH_ACCOUNTS=100000 stellar-core --test "[benchclose]"
+struct CloseBenchmarkParams
+{
+    // seeded state: every account trusts one asset, which a market maker
+    // offers against XLM
+    size_t mAccounts;
+    size_t mOffers;
+
+    // closes timed, and transactions in each of them, picked at random
+    // between payments, path payments (crossing offers of the market maker)
+    // and new offers in proportion to their weights
+    size_t mLedgers;
+    size_t mTxsPerLedger;
+    size_t mPaymentWeight;
+    size_t mPathPaymentWeight;
+    size_t mOfferWeight;
+
+    // where the report is written
+    std::string mOutput;
+
+    static size_t
+    get(char const* name, size_t def)
+    {
+        auto v = std::getenv(name);
+        return v ? std::stoul(v) : def;
+    }
+
+    CloseBenchmarkParams()
+        : mAccounts(get("STELLAR_BENCH_ACCOUNTS", 1000))
+        , mOffers(get("STELLAR_BENCH_OFFERS", 1000))
+        , mLedgers(get("STELLAR_BENCH_LEDGERS", 100))
+        , mTxsPerLedger(get("STELLAR_BENCH_TXS_PER_LEDGER", 500))
+        , mPaymentWeight(get("STELLAR_BENCH_PAYMENT_WEIGHT", 70))
+        , mPathPaymentWeight(get("STELLAR_BENCH_PATH_PAYMENT_WEIGHT", 20))
+        , mOfferWeight(get("STELLAR_BENCH_OFFER_WEIGHT", 10))
+        , mOutput(std::getenv("STELLAR_BENCH_OUTPUT")
+                      ? std::getenv("STELLAR_BENCH_OUTPUT")
+                      : "ledger-close-bench.json")
+    {
+    }
+};
+
+// phases of LedgerManagerImpl::closeLedger, by the timer covering them
+std::vector<std::pair<std::string, std::vector<std::string>>> const
+    closePhases = {{"prefetch", {"ledger", "close", "prefetch"}},
+                   {"fees", {"ledger", "close", "fees"}},
+                   {"apply", {"ledger", "close", "apply"}},
+                   {"history", {"ledger", "history", "write"}},
+                   {"invariants", {"ledger", "close", "invariants"}},
+                   {"buckets", {"ledger", "close", "buckets"}},
+                   {"store", {"ledger", "close", "store"}},
+                   {"commit", {"ledger", "close", "commit"}},
+                   {"total", {"ledger", "ledger", "close"}}};
+
+void
+closeBenchLedger(Application& app, std::vector<TransactionFramePtr> const& txs)
+{
+    auto& lm = app.getLedgerManager();
+    auto const& lcl = lm.getLastClosedLedgerHeader();
+    auto txSet = std::make_shared<TxSetFrame>(lcl.hash);
+    for (auto const& tx : txs)
+    {
+        txSet->add(tx);
+    }
+    txSet->sortForHash();
+
+    StellarValue sv(txSet->getContentsHash(),
+                    lcl.header.scpValue.closeTime + 5, emptyUpgradeSteps, 0);
+    LedgerCloseData ledgerData(lm.getLedgerNum(), txSet, sv);
+    lm.closeLedger(ledgerData);
+}
+
+// Splits `ops` in transactions of at most 100 operations from `source`.
+void
+addBatchedTxs(TestAccount& source, std::vector<Operation> const& ops,
+              std::vector<TransactionFramePtr>& txs)
+{
+    for (size_t i = 0; i < ops.size(); i += 100)
+    {
+        auto end = std::min(ops.size(), i + 100);
+        txs.emplace_back(source.tx(
+            std::vector<Operation>(ops.begin() + i, ops.begin() + end)));
+    }
+}
+
+// nearest-rank percentile of sorted `v`
+double
+percentile(std::vector<double> const& v, double p)
+{
+    if (v.empty())
+    {
+        return 0;
+    }
+    auto rank = static_cast<size_t>(std::ceil(p / 100 * v.size()));
+    return v[std::max<size_t>(rank, 1) - 1];
+}
+}
+
+TEST_CASE("ledger close benchmark", "[performance][benchclose][hide]")
+{
+    CloseBenchmarkParams params;
+    Config cfg(getTestConfig());
+    VirtualClock clock;
+    Application::pointer app = Application::create(clock, cfg);
+    app->start();
+
+    LOG(INFO) << "Close benchmark: seeding " << params.mAccounts
+              << " accounts and " << params.mOffers << " offers";
+
+    auto root = TestAccount::createRoot(*app);
+    auto issuer = TestAccount{*app, txtest::getAccount("bench-issuer")};
+    auto mm = TestAccount{*app, txtest::getAccount("bench-market-maker")};
+    std::vector<TestAccount> accounts;
+    for (size_t i = 0; i < params.mAccounts; ++i)
+    {
+        auto name = "bench-" + std::to_string(i);
+        accounts.emplace_back(*app, txtest::getAccount(name.c_str()));
+    }
+    auto xlm = txtest::makeNativeAsset();
+    auto usd = txtest::makeAsset(issuer, "USD");
+
+    {
+        std::vector<Operation> ops{
+            txtest::createAccount(issuer, 1000000000000),
+            txtest::createAccount(mm, 1000000000000000)};
+        for (auto const& a : accounts)
+        {
+            ops.emplace_back(txtest::createAccount(a, 10000000000000));
+        }
+        std::vector<TransactionFramePtr> txs;
+        addBatchedTxs(root, ops, txs);
+        closeBenchLedger(*app, txs);
+    }
+    {
+        std::vector<TransactionFramePtr> txs{
+            mm.tx({txtest::changeTrust(usd, INT64_MAX)})};
+        for (auto& a : accounts)
+        {
+            txs.emplace_back(a.tx({txtest::changeTrust(usd, INT64_MAX)}));
+        }
+        closeBenchLedger(*app, txs);
+    }
+    {
+        std::vector<Operation> ops{txtest::payment(mm, usd, 1000000000000000)};
+        for (auto const& a : accounts)
+        {
+            ops.emplace_back(txtest::payment(a, usd, 1000000000));
+        }
+        std::vector<TransactionFramePtr> txs;
+        addBatchedTxs(issuer, ops, txs);
+        closeBenchLedger(*app, txs);
+    }
+    {
+        std::vector<Operation> ops;
+        for (size_t i = 0; i < params.mOffers; ++i)
+        {
+            Price price{static_cast<int32_t>(100 + i % 50), 100};
+            ops.emplace_back(txtest::manageOffer(0, usd, xlm, price, 100000));
+        }
+        std::vector<TransactionFramePtr> txs;
+        addBatchedTxs(mm, ops, txs);
+        closeBenchLedger(*app, txs);
+    }
+
+    LOG(INFO) << "Close benchmark: closing " << params.mLedgers
+              << " ledgers of " << params.mTxsPerLedger << " transactions";
+
+    // a fixed seed, so runs of the same parameters apply the same transactions
+    std::default_random_engine rng(1);
+    std::uniform_int_distribution<size_t> pickAccount(0, accounts.size() - 1);
+    std::uniform_int_distribution<size_t> pickType(
+        0, params.mPaymentWeight + params.mPathPaymentWeight +
+               params.mOfferWeight - 1);
+
+    std::vector<medida::Timer*> timers;
+    for (auto const& phase : closePhases)
+    {
+        timers.emplace_back(&app->getMetrics().NewTimer(phase.second));
+    }
+    std::vector<std::vector<double>> samples(closePhases.size());
+
+    for (size_t l = 0; l < params.mLedgers; ++l)
+    {
+        std::vector<TransactionFramePtr> txs;
+        for (size_t t = 0; t < params.mTxsPerLedger; ++t)
+        {
+            auto& from = accounts[pickAccount(rng)];
+            auto& to = accounts[pickAccount(rng)];
+            auto type = pickType(rng);
+            if (type < params.mPaymentWeight)
+            {
+                txs.emplace_back(from.tx({txtest::payment(to, 1000)}));
+            }
+            else if (type < params.mPaymentWeight + params.mPathPaymentWeight)
+            {
+                txs.emplace_back(from.tx(
+                    {txtest::pathPayment(to, xlm, 10000000, usd, 1000, {})}));
+            }
+            else
+            {
+                // priced away from the market maker's offers: rests in the book
+                txs.emplace_back(from.tx({txtest::manageOffer(
+                    0, xlm, usd, Price{2, 1}, 1000)}));
+            }
+        }
+
+        std::vector<double> before;
+        for (auto t : timers)
+        {
+            before.emplace_back(t->sum());
+        }
+        closeBenchLedger(*app, txs);
+        for (size_t i = 0; i < timers.size(); ++i)
+        {
+            samples[i].emplace_back(timers[i]->sum() - before[i]);
+        }
+    }
+
+    Json::Value report;
+    report["accounts"] = static_cast<Json::UInt64>(params.mAccounts);
+    report["offers"] = static_cast<Json::UInt64>(params.mOffers);
+    report["ledgers"] = static_cast<Json::UInt64>(params.mLedgers);
+    report["txsPerLedger"] = static_cast<Json::UInt64>(params.mTxsPerLedger);
+    report["mix"]["payment"] = static_cast<Json::UInt64>(params.mPaymentWeight);
+    report["mix"]["pathPayment"] =
+        static_cast<Json::UInt64>(params.mPathPaymentWeight);
+    report["mix"]["offer"] = static_cast<Json::UInt64>(params.mOfferWeight);
+    report["unit"] = "ms";
+    for (size_t i = 0; i < closePhases.size(); ++i)
+    {
+        auto& v = samples[i];
+        std::sort(v.begin(), v.end());
+        auto& phase = report["phases"][closePhases[i].first];
+        phase["p50"] = percentile(v, 50);
+        phase["p99"] = percentile(v, 99);
+        phase["max"] = v.empty() ? 0 : v.back();
+    }
+
+    auto json = Json::StyledWriter().write(report);
+    std::ofstream out(params.mOutput);
+    out << json;
+    LOG(INFO) << "Close benchmark: results written to " << params.mOutput
+              << std::endl
+              << json;
+}
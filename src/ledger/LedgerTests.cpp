@@ -3,14 +3,22 @@
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
 #include "LedgerTestUtils.h"
+#include "crypto/Hex.h"
+#include "crypto/SecretKey.h"
 #include "database/Database.h"
 #include "ledger/AccountFrame.h"
 #include "ledger/EntryFrame.h"
 #include "ledger/LedgerDelta.h"
 #include "ledger/LedgerManager.h"
+#include "ledger/OfferFrame.h"
 #include "lib/catch.hpp"
 #include "main/Application.h"
 #include "main/Config.h"
+#include "medida/meter.h"
+#include "medida/metrics_registry.h"
+#include "medida/timer.h"
+#include "test/TestAccount.h"
+#include "test/TxTests.h"
 #include "test/test.h"
 #include "util/Logging.h"
 #include "util/Timer.h"
@@ -18,6 +26,7 @@
 #include <xdrpp/autocheck.h>
 
 using namespace stellar;
+using xdr::operator==;
 
 TEST_CASE("Ledger entry db lifecycle", "[ledger]")
 {
@@ -137,3 +146,203 @@ TEST_CASE("DB cache interaction with transactions", "[ledger][dbcache]")
 
     CHECK(balance0 == acc->getAccount().balance);
 }
+
+static void
+checkOrderBookMatchesDatabase(std::vector<Asset> const& assets, Database& db)
+{
+    for (auto const& selling : assets)
+    {
+        for (auto const& buying : assets)
+        {
+            for (size_t offset = 0; offset < 40; offset += 7)
+            {
+                std::vector<OfferFrame::pointer> fromBook, fromDb;
+                OfferFrame::loadBestOffers(5, offset, selling, buying,
+                                           fromBook, db);
+                OfferFrame::loadBestOffersFromDatabase(5, offset, selling,
+                                                       buying, fromDb, db);
+                REQUIRE(fromBook.size() == fromDb.size());
+                for (size_t i = 0; i < fromBook.size(); ++i)
+                {
+                    REQUIRE(fromBook[i]->mEntry == fromDb[i]->mEntry);
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("order book matches offers table", "[ledger][orderbook]")
+{
+    Config cfg(getTestConfig());
+    cfg.IN_MEMORY_ORDER_BOOK = true;
+    VirtualClock clock;
+    Application::pointer app = Application::create(clock, cfg);
+    app->start();
+
+    auto& db = app->getDatabase();
+    auto& session = db.getSession();
+
+    std::vector<Asset> assets(3);
+    assets[0].type(ASSET_TYPE_NATIVE);
+    for (size_t i = 1; i < assets.size(); ++i)
+    {
+        assets[i].type(ASSET_TYPE_CREDIT_ALPHANUM4);
+        strToAssetCode(assets[i].alphaNum4().assetCode,
+                       "CUR" + std::to_string(i));
+        assets[i].alphaNum4().issuer = PubKeyUtils::random();
+    }
+
+    std::vector<OfferFrame::pointer> offers;
+    for (uint64_t id = 1; id <= 200; ++id)
+    {
+        LedgerEntry le;
+        le.data.type(OFFER);
+        auto& oe = le.data.offer();
+        oe = LedgerTestUtils::generateValidOfferEntry(3);
+        oe.offerID = id;
+        oe.selling = assets[id % assets.size()];
+        oe.buying = assets[(id / assets.size()) % assets.size()];
+        // few distinct prices, so that ordering by offer ID matters
+        oe.price.n = static_cast<int32>(1 + id % 4);
+        oe.price.d = static_cast<int32>(1 + id % 3);
+        offers.emplace_back(std::make_shared<OfferFrame>(le));
+    }
+
+    LedgerDelta delta(app->getLedgerManager().getCurrentLedgerHeader(), db);
+    for (auto& of : offers)
+    {
+        of->storeAdd(delta, db);
+    }
+    checkOrderBookMatchesDatabase(assets, db);
+
+    SECTION("rebuilt from the database")
+    {
+        db.getOrderBook().load();
+        REQUIRE(db.getOrderBook().size() == offers.size());
+        checkOrderBookMatchesDatabase(assets, db);
+    }
+
+    SECTION("changes are mirrored")
+    {
+        for (size_t i = 0; i < offers.size(); i += 3)
+        {
+            offers[i]->storeDelete(delta, db);
+        }
+        for (size_t i = 1; i < offers.size(); i += 3)
+        {
+            offers[i]->getOffer().price.n += 3;
+            offers[i]->getOffer().selling = assets[i % 2];
+            offers[i]->storeChange(delta, db);
+        }
+        checkOrderBookMatchesDatabase(assets, db);
+    }
+
+    SECTION("rollback is mirrored")
+    {
+        {
+            soci::transaction sqltx(session);
+            LedgerDelta inner(delta);
+            for (size_t i = 0; i < offers.size(); i += 3)
+            {
+                inner.recordEntry(*offers[i]);
+                offers[i]->storeDelete(inner, db);
+            }
+            for (size_t i = 1; i < offers.size(); i += 3)
+            {
+                offers[i]->getOffer().price.d += 7;
+                offers[i]->storeChange(inner, db);
+            }
+            checkOrderBookMatchesDatabase(assets, db);
+            // scope-end rolls back the delta, then sqltx
+        }
+        checkOrderBookMatchesDatabase(assets, db);
+    }
+    SECTION("rollback restores recorded offers in place")
+    {
+        auto& reloads = app->getMetrics().NewMeter(
+            {"ledger", "order-book", "reload"}, "book");
+        auto reloadsBefore = reloads.count();
+        {
+            soci::transaction sqltx(session);
+            LedgerDelta inner(delta);
+            for (size_t i = 0; i < offers.size(); i += 3)
+            {
+                inner.recordEntry(*offers[i]);
+                offers[i]->storeDelete(inner, db);
+            }
+            for (size_t i = 1; i < offers.size(); i += 3)
+            {
+                inner.recordEntry(*offers[i]);
+                auto changed = std::make_shared<OfferFrame>(offers[i]->mEntry);
+                changed->getOffer().price.d += 7;
+                changed->getOffer().selling = assets[(i + 1) % assets.size()];
+                changed->storeChange(inner, db);
+            }
+            auto added = std::make_shared<OfferFrame>(offers[2]->mEntry);
+            added->getOffer().offerID = offers.size() + 1;
+            added->storeAdd(inner, db);
+            checkOrderBookMatchesDatabase(assets, db);
+        }
+        checkOrderBookMatchesDatabase(assets, db);
+        REQUIRE(reloads.count() == reloadsBefore);
+    }
+}
+
+TEST_CASE("transaction history written at ledger close",
+          "[ledger][txhistory]")
+{
+    using namespace txtest;
+
+    Config cfg(getTestConfig());
+    VirtualClock clock;
+    Application::pointer app = Application::create(clock, cfg);
+    app->start();
+
+    auto& db = app->getDatabase();
+    auto root = TestAccount::createRoot(*app);
+    auto dest = root.create("dest", 1000000000);
+
+    // as many as the genesis ledger allows in a set
+    std::vector<TransactionFramePtr> txs;
+    auto maxTxs = app->getLedgerManager().getCurrentLedgerHeader().maxTxSetSize;
+    for (uint32_t i = 0; i < maxTxs; ++i)
+    {
+        txs.emplace_back(root.tx({payment(dest, 1)}));
+    }
+
+    auto& historyWrite =
+        app->getMetrics().NewTimer({"ledger", "history", "write"});
+    auto writes = historyWrite.count();
+
+    auto ledgerSeq = app->getLedgerManager().getLedgerNum();
+    auto r = closeLedgerOn(*app, ledgerSeq, 1, 1, 2016, txs);
+    REQUIRE(r.size() == txs.size());
+    REQUIRE(historyWrite.count() == writes + 1);
+
+    // applied in sequence number order, so in the order they were made
+    std::vector<std::string> txIDs;
+    std::string txID;
+    soci::statement st =
+        (db.getSession().prepare << "SELECT txid FROM txhistory "
+                                    "WHERE ledgerseq = :seq ORDER BY txindex",
+         soci::into(txID), soci::use(ledgerSeq));
+    st.execute(true);
+    while (st.got_data())
+    {
+        txIDs.emplace_back(txID);
+        st.fetch();
+    }
+    REQUIRE(txIDs.size() == txs.size());
+    for (size_t i = 0; i < txs.size(); ++i)
+    {
+        REQUIRE(txIDs[i] == binToHex(txs[i]->getContentsHash()));
+        REQUIRE(r[i].first.transactionHash == txs[i]->getContentsHash());
+        REQUIRE(r[i].first.result.result.code() == txSUCCESS);
+    }
+
+    int feeRows = 0;
+    db.getSession() << "SELECT COUNT(*) FROM txfeehistory "
+                       "WHERE ledgerseq = :seq",
+        soci::into(feeRows), soci::use(ledgerSeq);
+    REQUIRE(feeRows == static_cast<int>(txs.size()));
+}
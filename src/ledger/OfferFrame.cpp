@@ -7,9 +7,11 @@
 #include "crypto/KeyUtils.h"
 #include "crypto/SHA.h"
 #include "crypto/SecretKey.h"
+#include "database/BulkInserter.h"
 #include "database/Database.h"
 #include "transactions/ManageOfferOpFrame.h"
 #include "util/types.h"
+#include <cstdio>
 
 using namespace std;
 using namespace soci;
@@ -270,6 +272,27 @@ void
 OfferFrame::loadBestOffers(size_t numOffers, size_t offset,
                            Asset const& selling, Asset const& buying,
                            vector<OfferFrame::pointer>& retOffers, Database& db)
+{
+    auto& book = db.getOrderBook();
+    if (!book.isEnabled())
+    {
+        loadBestOffersFromDatabase(numOffers, offset, selling, buying,
+                                   retOffers, db);
+        return;
+    }
+
+    book.loadBestOffers(numOffers, offset, selling, buying,
+                        [&retOffers](LedgerEntry const& of) {
+                            retOffers.emplace_back(make_shared<OfferFrame>(of));
+                        });
+}
+
+void
+OfferFrame::loadBestOffersFromDatabase(size_t numOffers, size_t offset,
+                                       Asset const& selling,
+                                       Asset const& buying,
+                                       vector<OfferFrame::pointer>& retOffers,
+                                       Database& db)
 {
     std::string sql = offerColumnSelector;
 
@@ -363,16 +386,23 @@ std::unordered_map<AccountID, std::vector<OfferFrame::pointer>>
 OfferFrame::loadAllOffers(Database& db)
 {
     std::unordered_map<AccountID, std::vector<OfferFrame::pointer>> retOffers;
+    loadAllOffers(db, [&retOffers](LedgerEntry const& of) {
+        auto& thisUserOffers = retOffers[of.data.offer().sellerID];
+        thisUserOffers.emplace_back(make_shared<OfferFrame>(of));
+    });
+    return retOffers;
+}
+
+void
+OfferFrame::loadAllOffers(
+    Database& db, std::function<void(LedgerEntry const&)> offerProcessor)
+{
     std::string sql = offerColumnSelector;
     sql += " ORDER BY sellerid";
     auto prep = db.getPreparedStatement(sql);
 
     auto timer = db.getSelectTimer("offer");
-    loadOffers(prep, [&retOffers](LedgerEntry const& of) {
-        auto& thisUserOffers = retOffers[of.data.offer().sellerID];
-        thisUserOffers.emplace_back(make_shared<OfferFrame>(of));
-    });
-    return retOffers;
+    loadOffers(prep, offerProcessor);
 }
 
 bool
@@ -416,6 +446,7 @@ OfferFrame::storeDelete(LedgerDelta& delta, Database& db, LedgerKey const& key)
     st.exchange(use(key.offer().offerID));
     st.define_and_bind();
     st.execute(true);
+    db.getOrderBook().remove(key.offer().offerID);
     delta.deleteEntry(key);
 }
 
@@ -536,6 +567,8 @@ OfferFrame::storeUpdateHelper(LedgerDelta& delta, Database& db, bool insert)
         throw std::runtime_error("could not update SQL");
     }
 
+    db.getOrderBook().addOrUpdate(mEntry);
+
     if (insert)
     {
         delta.addEntry(*this);
@@ -549,10 +582,92 @@ OfferFrame::storeUpdateHelper(LedgerDelta& delta, Database& db, bool insert)
 void
 OfferFrame::dropAll(Database& db)
 {
+    db.getOrderBook().clear();
     db.getSession() << "DROP TABLE IF EXISTS offers;";
     db.getSession() << kSQLCreateStatement1;
     db.getSession() << kSQLCreateStatement2;
     db.getSession() << kSQLCreateStatement3;
     db.getSession() << kSQLCreateStatement4;
 }
+
+void
+OfferFrame::bulkDelete(Database& db, std::vector<LedgerKey> const& keys)
+{
+    std::vector<std::string> ids;
+    ids.reserve(keys.size());
+    for (auto const& k : keys)
+    {
+        ids.emplace_back(std::to_string(k.offer().offerID));
+    }
+    stellar::bulkDelete(db, "offers", "offerid", ids);
+}
+
+static void
+addAsset(BulkInserter& offers, Asset const& asset)
+{
+    offers.add(std::to_string(asset.type()));
+    std::string issuer, code;
+    switch (asset.type())
+    {
+    case ASSET_TYPE_CREDIT_ALPHANUM4:
+        assetCodeToStr(asset.alphaNum4().assetCode, code);
+        offers.add(code);
+        offers.add(KeyUtils::toStrKey(asset.alphaNum4().issuer));
+        break;
+    case ASSET_TYPE_CREDIT_ALPHANUM12:
+        assetCodeToStr(asset.alphaNum12().assetCode, code);
+        offers.add(code);
+        offers.add(KeyUtils::toStrKey(asset.alphaNum12().issuer));
+        break;
+    default:
+        offers.addNull();
+        offers.addNull();
+        break;
+    }
+}
+
+void
+OfferFrame::bulkInsert(Database& db, std::vector<LedgerEntry> const& entries)
+{
+    BulkInserter offers(
+        db, "offers",
+        {"sellerid", "offerid", "sellingassettype", "sellingassetcode",
+         "sellingissuer", "buyingassettype", "buyingassetcode", "buyingissuer",
+         "amount", "pricen", "priced", "price", "flags", "lastmodified"});
+    char price[32];
+    for (auto const& e : entries)
+    {
+        auto const& o = e.data.offer();
+        offers.add(KeyUtils::toStrKey(o.sellerID));
+        offers.add(std::to_string(o.offerID));
+        addAsset(offers, o.selling);
+        addAsset(offers, o.buying);
+        offers.add(std::to_string(o.amount));
+        offers.add(std::to_string(o.price.n));
+        offers.add(std::to_string(o.price.d));
+        // enough digits for the value to read back exactly as computePrice()
+        snprintf(price, sizeof(price), "%.17g",
+                 double(o.price.n) / double(o.price.d));
+        offers.add(price);
+        offers.add(std::to_string(o.flags));
+        offers.add(std::to_string(e.lastModifiedLedgerSeq));
+    }
+    offers.flush();
+}
+
+void
+OfferFrame::dropIndexes(Database& db)
+{
+    db.getSession() << "DROP INDEX IF EXISTS sellingissuerindex;";
+    db.getSession() << "DROP INDEX IF EXISTS buyingissuerindex;";
+    db.getSession() << "DROP INDEX IF EXISTS priceindex;";
+}
+
+void
+OfferFrame::createIndexes(Database& db)
+{
+    db.getSession() << kSQLCreateStatement2;
+    db.getSession() << kSQLCreateStatement3;
+    db.getSession() << kSQLCreateStatement4;
+}
 }
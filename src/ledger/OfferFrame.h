@@ -87,17 +87,37 @@ class OfferFrame : public EntryFrame
     static pointer loadOffer(AccountID const& accountID, uint64_t offerID,
                              Database& db, LedgerDelta* delta = nullptr);
 
+    // served from the database's OrderBook when it is enabled
     static void loadBestOffers(size_t numOffers, size_t offset,
                                Asset const& pays, Asset const& gets,
                                std::vector<OfferFrame::pointer>& retOffers,
                                Database& db);
 
+    // same as loadBestOffers, but always queries the offers table
+    static void
+    loadBestOffersFromDatabase(size_t numOffers, size_t offset,
+                               Asset const& pays, Asset const& gets,
+                               std::vector<OfferFrame::pointer>& retOffers,
+                               Database& db);
+
     // load all offers from the database (very slow)
     static std::unordered_map<AccountID, std::vector<OfferFrame::pointer>>
     loadAllOffers(Database& db);
+    static void
+    loadAllOffers(Database& db,
+                  std::function<void(LedgerEntry const&)> offerProcessor);
 
     static void dropAll(Database& db);
 
+    // Bulk loading (see BucketApplicator): delete the rows of `keys` and
+    // insert `entries`, bypassing the entry cache and LedgerDelta.
+    static void bulkDelete(Database& db, std::vector<LedgerKey> const& keys);
+    static void bulkInsert(Database& db,
+                           std::vector<LedgerEntry> const& entries);
+    // Secondary indexes, dropped while bulk loading and rebuilt after.
+    static void dropIndexes(Database& db);
+    static void createIndexes(Database& db);
+
   private:
     static const char* kSQLCreateStatement1;
     static const char* kSQLCreateStatement2;
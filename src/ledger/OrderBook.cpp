@@ -0,0 +1,245 @@
+// Copyright 2017 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "ledger/OrderBook.h"
+#include "database/Database.h"
+#include "ledger/OfferFrame.h"
+#include "util/Logging.h"
+
+#include "medida/counter.h"
+#include "medida/meter.h"
+#include "medida/metrics_registry.h"
+
+namespace stellar
+{
+using xdr::operator<;
+
+// Number of offers fetched per query when reloading a single book.
+static size_t const RELOAD_PAGE_SIZE = 1000;
+
+bool
+OrderBook::AssetPairCmp::operator()(AssetPair const& a,
+                                    AssetPair const& b) const
+{
+    if (a.first < b.first)
+    {
+        return true;
+    }
+    if (b.first < a.first)
+    {
+        return false;
+    }
+    return a.second < b.second;
+}
+
+OrderBook::OrderBook(Database& db, medida::MetricsRegistry& metrics,
+                     bool enabled)
+    : mDb(db)
+    , mEnabled(enabled)
+    , mLoaded(false)
+    , mReloads(metrics.NewMeter({"ledger", "order-book", "reload"}, "book"))
+    , mSize(metrics.NewCounter({"ledger", "order-book", "offers"}))
+{
+}
+
+OrderBook::OfferPosition
+OrderBook::positionOf(LedgerEntry const& offer)
+{
+    // must match the `price` column used by the SQL ordering
+    auto const& oe = offer.data.offer();
+    return OfferPosition{double(oe.price.n) / double(oe.price.d), oe.offerID};
+}
+
+OrderBook::AssetPair
+OrderBook::assetPairOf(LedgerEntry const& offer)
+{
+    auto const& oe = offer.data.offer();
+    return std::make_pair(oe.selling, oe.buying);
+}
+
+void
+OrderBook::load()
+{
+    if (!mEnabled)
+    {
+        return;
+    }
+
+    clear();
+    OfferFrame::loadAllOffers(
+        mDb, [this](LedgerEntry const& offer) { insert(offer); });
+    mLoaded = true;
+    CLOG(DEBUG, "Ledger") << "Loaded order book: " << mOffers.size()
+                          << " offers in " << mBooks.size() << " books";
+}
+
+void
+OrderBook::clear()
+{
+    mBooks.clear();
+    mOffers.clear();
+    mDirty.clear();
+    mSize.set_count(0);
+    mLoaded = false;
+}
+
+void
+OrderBook::ensureLoaded()
+{
+    if (!mLoaded)
+    {
+        load();
+    }
+}
+
+void
+OrderBook::insert(LedgerEntry const& offer)
+{
+    erase(offer.data.offer().offerID);
+    auto books = mBooks.emplace(assetPairOf(offer), Book()).first;
+    auto pos = positionOf(offer);
+    books->second.emplace(pos, offer);
+    mOffers.emplace(offer.data.offer().offerID, std::make_pair(books, pos));
+    mSize.set_count(mOffers.size());
+}
+
+void
+OrderBook::erase(uint64_t offerID)
+{
+    auto it = mOffers.find(offerID);
+    if (it == mOffers.end())
+    {
+        return;
+    }
+
+    auto books = it->second.first;
+    books->second.erase(it->second.second);
+    if (books->second.empty())
+    {
+        mBooks.erase(books);
+    }
+    mOffers.erase(it);
+    mSize.set_count(mOffers.size());
+}
+
+void
+OrderBook::addOrUpdate(LedgerEntry const& offer)
+{
+    if (!mLoaded)
+    {
+        // the whole book will be read from the database when first used
+        return;
+    }
+    insert(offer);
+}
+
+void
+OrderBook::remove(uint64_t offerID)
+{
+    if (!mLoaded)
+    {
+        return;
+    }
+    erase(offerID);
+}
+
+void
+OrderBook::markDirty(LedgerKey const& key, LedgerEntry const* offer)
+{
+    if (!mLoaded)
+    {
+        return;
+    }
+
+    bool known = false;
+    auto it = mOffers.find(key.offer().offerID);
+    if (it != mOffers.end())
+    {
+        mDirty.insert(it->second.first->first);
+        known = true;
+    }
+    if (offer)
+    {
+        mDirty.insert(assetPairOf(*offer));
+        known = true;
+    }
+    if (!known)
+    {
+        // the offer is gone and we don't know which book it was in
+        clear();
+    }
+}
+
+void
+OrderBook::reloadBook(AssetPair const& assets)
+{
+    mReloads.Mark();
+
+    auto books = mBooks.find(assets);
+    if (books != mBooks.end())
+    {
+        for (auto const& offer : books->second)
+        {
+            mOffers.erase(offer.first.mOfferID);
+        }
+        mBooks.erase(books);
+    }
+
+    std::vector<OfferFrame::pointer> offers;
+    for (size_t offset = 0;; offset += RELOAD_PAGE_SIZE)
+    {
+        offers.clear();
+        OfferFrame::loadBestOffersFromDatabase(RELOAD_PAGE_SIZE, offset,
+                                               assets.first, assets.second,
+                                               offers, mDb);
+        for (auto const& offer : offers)
+        {
+            insert(offer->mEntry);
+        }
+        if (offers.size() < RELOAD_PAGE_SIZE)
+        {
+            break;
+        }
+    }
+    mSize.set_count(mOffers.size());
+}
+
+void
+OrderBook::loadBestOffers(
+    size_t numOffers, size_t offset, Asset const& selling, Asset const& buying,
+    std::function<void(LedgerEntry const&)> offerProcessor)
+{
+    ensureLoaded();
+
+    auto assets = std::make_pair(selling, buying);
+    if (mDirty.erase(assets) != 0)
+    {
+        reloadBook(assets);
+    }
+
+    auto books = mBooks.find(assets);
+    if (books == mBooks.end())
+    {
+        return;
+    }
+
+    auto const& book = books->second;
+    if (offset >= book.size())
+    {
+        return;
+    }
+
+    auto it = std::next(book.begin(), offset);
+    for (; it != book.end() && numOffers != 0; ++it, --numOffers)
+    {
+        offerProcessor(it->second);
+    }
+}
+
+size_t
+OrderBook::size() const
+{
+    return mOffers.size();
+}
+}
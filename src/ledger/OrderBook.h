@@ -0,0 +1,124 @@
+#pragma once
+
+// Copyright 2017 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "overlay/StellarXDR.h"
+#include "util/NonCopyable.h"
+#include <functional>
+#include <map>
+#include <set>
+#include <unordered_map>
+
+namespace medida
+{
+class Counter;
+class Meter;
+class MetricsRegistry;
+}
+
+namespace stellar
+{
+class Database;
+
+/**
+ * In-memory mirror of the offers table, organized as one book per
+ * (selling, buying) asset pair and ordered the same way as the SQL query it
+ * replaces: by the floating-point approximation of the price stored in the
+ * `price` column, then by offer ID.
+ *
+ * The book is written through by OfferFrame at the same time as the offers
+ * table, so it always reflects the current, possibly uncommitted, state of
+ * the database session. When a LedgerDelta is rolled back, the offers it
+ * touched are put back to the values it recorded before changing them; the
+ * books of offers whose previous value it doesn't know are marked dirty and
+ * reloaded from the database the next time they are read, by which point the
+ * matching SQL transaction has been rolled back as well.
+ *
+ * The book is built from the database when the last known ledger is loaded,
+ * or lazily on first use, and is only ever accessed from the main thread.
+ */
+class OrderBook : NonMovableOrCopyable
+{
+  public:
+    OrderBook(Database& db, medida::MetricsRegistry& metrics, bool enabled);
+
+    bool
+    isEnabled() const
+    {
+        return mEnabled;
+    }
+
+    // (Re)build every book from the offers table.
+    void load();
+
+    // Forget every book; they will be rebuilt on next use.
+    void clear();
+
+    // Mirror an INSERT/UPDATE or DELETE of the offers table.
+    void addOrUpdate(LedgerEntry const& offer);
+    void remove(uint64_t offerID);
+
+    // Mark as dirty the book currently holding the offer identified by
+    // `key` and, if provided, the book `offer` belongs to. If neither is
+    // known, every book is forgotten.
+    void markDirty(LedgerKey const& key, LedgerEntry const* offer);
+
+    // Invoke `offerProcessor` on at most `numOffers` offers selling `selling`
+    // for `buying`, skipping the `offset` best ones.
+    void loadBestOffers(size_t numOffers, size_t offset, Asset const& selling,
+                        Asset const& buying,
+                        std::function<void(LedgerEntry const&)> offerProcessor);
+
+    size_t size() const;
+
+  private:
+    typedef std::pair<Asset, Asset> AssetPair;
+
+    struct AssetPairCmp
+    {
+        bool operator()(AssetPair const& a, AssetPair const& b) const;
+    };
+
+    struct OfferPosition
+    {
+        double mPrice;
+        uint64_t mOfferID;
+
+        bool
+        operator<(OfferPosition const& other) const
+        {
+            if (mPrice != other.mPrice)
+            {
+                return mPrice < other.mPrice;
+            }
+            return mOfferID < other.mOfferID;
+        }
+    };
+
+    typedef std::map<OfferPosition, LedgerEntry> Book;
+    typedef std::map<AssetPair, Book, AssetPairCmp> BookMap;
+
+    Database& mDb;
+    bool const mEnabled;
+    bool mLoaded;
+
+    BookMap mBooks;
+    std::unordered_map<uint64_t, std::pair<BookMap::iterator, OfferPosition>>
+        mOffers;
+    std::set<AssetPair, AssetPairCmp> mDirty;
+
+    medida::Meter& mReloads;
+    medida::Counter& mSize;
+
+    static OfferPosition positionOf(LedgerEntry const& offer);
+    static AssetPair assetPairOf(LedgerEntry const& offer);
+
+    // insert or move an offer, keeping mBooks and mOffers in sync
+    void insert(LedgerEntry const& offer);
+    void erase(uint64_t offerID);
+    void reloadBook(AssetPair const& assets);
+    void ensureLoaded();
+};
+}
@@ -7,8 +7,11 @@
 #include "crypto/KeyUtils.h"
 #include "crypto/SHA.h"
 #include "crypto/SecretKey.h"
+#include "database/BulkInserter.h"
 #include "database/Database.h"
+#include "ledger/EntryPrefetch.h"
 #include "util/types.h"
+#include <set>
 
 using namespace std;
 using namespace soci;
@@ -164,7 +167,8 @@ TrustFrame::isValid() const
 bool
 TrustFrame::exists(Database& db, LedgerKey const& key)
 {
-    if (cachedEntryExists(key, db) && getCachedEntry(key, db) != nullptr)
+    std::shared_ptr<LedgerEntry const> cached;
+    if (getCachedEntry(key, cached, db) && cached)
     {
         return true;
     }
@@ -349,18 +353,19 @@ TrustFrame::loadTrustLine(AccountID const& accountID, Asset const& asset,
     key.type(TRUSTLINE);
     key.trustLine().accountID = accountID;
     key.trustLine().asset = asset;
-    if (cachedEntryExists(key, db))
+    std::shared_ptr<LedgerEntry const> cached;
+    if (getCachedEntry(key, cached, db))
     {
-        auto p = getCachedEntry(key, db);
-        if (p)
+        if (!cached)
         {
-            pointer ret = std::make_shared<TrustFrame>(*p);
-            if (delta)
-            {
-                delta->recordEntry(*ret);
-            }
-            return ret;
+            return nullptr;
         }
+        pointer ret = std::make_shared<TrustFrame>(*cached);
+        if (delta)
+        {
+            delta->recordEntry(*ret);
+        }
+        return ret;
     }
 
     std::string accStr, issuerStr, assetStr;
@@ -409,6 +414,58 @@ TrustFrame::loadTrustLine(AccountID const& accountID, Asset const& asset,
     return retLine;
 }
 
+void
+TrustFrame::prefetch(std::vector<LedgerKey> const& keys, Database& db,
+                     PrefetchCounts& counts)
+{
+    std::set<LedgerKey, LedgerEntryIdCmp> toLoad;
+    std::set<std::string> accounts;
+    for (auto const& key : keys)
+    {
+        if (cachedEntryExists(key, db))
+        {
+            counts.mCached++;
+        }
+        else
+        {
+            toLoad.insert(key);
+            accounts.insert(KeyUtils::toStrKey(key.trustLine().accountID));
+        }
+    }
+    counts.mLoaded += toLoad.size();
+    counts.mReplacedQueries += toLoad.size();
+
+    std::vector<std::string> accountKeys(accounts.begin(), accounts.end());
+    forEachKeyChunk(accountKeys, [&](std::vector<std::string>& chunk,
+                                     std::string const& placeholders) {
+        auto query = std::string(trustLineColumnSelector);
+        query += " WHERE accountid IN (" + placeholders + ")";
+        auto prep = db.getPreparedStatement(query);
+        auto& st = prep.statement();
+        for (auto& k : chunk)
+        {
+            st.exchange(use(k));
+        }
+
+        auto timer = db.getSelectTimer("trust");
+        loadLines(prep, [&](LedgerEntry const& trust) {
+            auto it = toLoad.find(LedgerEntryKey(trust));
+            if (it != toLoad.end())
+            {
+                putCachedEntry(*it, std::make_shared<LedgerEntry const>(trust),
+                               db);
+                toLoad.erase(it);
+            }
+        });
+        counts.mQueries++;
+    });
+
+    for (auto const& key : toLoad)
+    {
+        putCachedEntry(key, nullptr, db);
+    }
+}
+
 std::pair<TrustFrame::pointer, AccountFrame::pointer>
 TrustFrame::loadTrustLineIssuer(AccountID const& accountID, Asset const& asset,
                                 Database& db, LedgerDelta& delta)
@@ -515,4 +572,47 @@ TrustFrame::dropAll(Database& db)
     db.getSession() << "DROP TABLE IF EXISTS trustlines;";
     db.getSession() << kSQLCreateStatement1;
 }
+
+void
+TrustFrame::bulkDelete(Database& db, std::vector<LedgerKey> const& keys)
+{
+    std::string actIDStrKey, issuerStrKey, assetCode;
+    for (auto const& k : keys)
+    {
+        getKeyFields(k, actIDStrKey, issuerStrKey, assetCode);
+        auto prep = db.getPreparedStatement(
+            "DELETE FROM trustlines "
+            "WHERE accountid=:v1 AND issuer=:v2 AND assetcode=:v3");
+        auto& st = prep.statement();
+        st.exchange(use(actIDStrKey));
+        st.exchange(use(issuerStrKey));
+        st.exchange(use(assetCode));
+        st.define_and_bind();
+        auto timer = db.getDeleteTimer("trust");
+        st.execute(true);
+    }
+}
+
+void
+TrustFrame::bulkInsert(Database& db, std::vector<LedgerEntry> const& entries)
+{
+    BulkInserter trustlines(db, "trustlines",
+                            {"accountid", "assettype", "issuer", "assetcode",
+                             "balance", "tlimit", "flags", "lastmodified"});
+    std::string actIDStrKey, issuerStrKey, assetCode;
+    for (auto const& e : entries)
+    {
+        auto const& tl = e.data.trustLine();
+        getKeyFields(LedgerEntryKey(e), actIDStrKey, issuerStrKey, assetCode);
+        trustlines.add(actIDStrKey);
+        trustlines.add(std::to_string(tl.asset.type()));
+        trustlines.add(issuerStrKey);
+        trustlines.add(assetCode);
+        trustlines.add(std::to_string(tl.balance));
+        trustlines.add(std::to_string(tl.limit));
+        trustlines.add(std::to_string(tl.flags));
+        trustlines.add(std::to_string(e.lastModifiedLedgerSeq));
+    }
+    trustlines.flush();
+}
 }
@@ -70,6 +70,13 @@ class TrustFrame : public EntryFrame
     static pointer loadTrustLine(AccountID const& accountID, Asset const& asset,
                                  Database& db, LedgerDelta* delta = nullptr);
 
+    // Loads the trust lines of `keys` (without repeats, and not of issuers)
+    // that are not cached yet into the entry cache, with a query per few
+    // hundred accounts. Every trust line of these accounts is read, only
+    // the ones of `keys` are kept.
+    static void prefetch(std::vector<LedgerKey> const& keys, Database& db,
+                         PrefetchCounts& counts);
+
     // overload that also returns the issuer
     static std::pair<TrustFrame::pointer, AccountFrame::pointer>
     loadTrustLineIssuer(AccountID const& accountID, Asset const& asset,
@@ -106,6 +113,12 @@ class TrustFrame : public EntryFrame
 
     static void dropAll(Database& db);
 
+    // Bulk loading (see BucketApplicator): delete the rows of `keys` and
+    // insert `entries`, bypassing the entry cache and LedgerDelta.
+    static void bulkDelete(Database& db, std::vector<LedgerKey> const& keys);
+    static void bulkInsert(Database& db,
+                           std::vector<LedgerEntry> const& entries);
+
   private:
     static bool isValid(LedgerEntry const& le);
     bool isValid() const;
@@ -38,6 +38,7 @@ class LoadGenerator;
 class CommandHandler;
 class WorkManager;
 class BanManager;
+class Maintainer;
 class StatusManager;
 
 /*
@@ -194,6 +195,7 @@ class Application
     virtual CommandHandler& getCommandHandler() = 0;
     virtual WorkManager& getWorkManager() = 0;
     virtual BanManager& getBanManager() = 0;
+    virtual Maintainer& getMaintainer() = 0;
     virtual StatusManager& getStatusManager() = 0;
 
     // Get the worker IO service, served by background threads. Work posted to
@@ -232,9 +234,6 @@ class Application
     // Run a consistency check between the database and the bucketlist.
     virtual void checkDB() = 0;
 
-    // perform maintenance tasks
-    virtual void maintenance() = 0;
-
     // Execute any administrative commands written in the Config.COMMANDS
     // variable of the config file. This permits scripting certain actions to
     // occur automatically at startup.
@@ -23,7 +23,7 @@
 #include "invariant/TotalCoinsEqualsBalancesPlusFeePool.h"
 #include "ledger/LedgerManager.h"
 #include "main/CommandHandler.h"
-#include "main/ExternalQueue.h"
+#include "main/Maintainer.h"
 #include "main/NtpSynchronizationChecker.h"
 #include "medida/counter.h"
 #include "medida/meter.h"
@@ -74,6 +74,9 @@ ApplicationImpl::ApplicationImpl(VirtualClock& clock, Config const& cfg)
 
     std::srand(static_cast<uint32>(clock.now().time_since_epoch().count()));
 
+    // process-wide, so the last application constructed wins
+    PubKeyUtils::resizeVerifySigCache(mConfig.VERIFY_SIG_CACHE_SIZE);
+
     mNetworkID = sha256(mConfig.NETWORK_PASSPHRASE);
 
     unsigned t = std::thread::hardware_concurrency();
@@ -105,6 +108,7 @@ ApplicationImpl::ApplicationImpl(VirtualClock& clock, Config const& cfg)
     mCommandHandler = make_unique<CommandHandler>(*this);
     mWorkManager = WorkManager::create(*this);
     mBanManager = BanManager::create(*this);
+    mMaintainer = make_unique<Maintainer>(*this);
     mStatusManager = make_unique<StatusManager>();
 
     CacheIsConsistentWithDatabase::registerInvariant(*this);
@@ -284,9 +288,14 @@ ApplicationImpl::start()
             mHerder->restoreSCPState();
             // perform maintenance tasks if configured to do so
             // for now, we only perform it when CATCHUP_COMPLETE is not set
-            if (mConfig.MAINTENANCE_ON_STARTUP && !mConfig.CATCHUP_COMPLETE)
+            if (!mConfig.CATCHUP_COMPLETE)
             {
-                maintenance();
+                if (mConfig.MAINTENANCE_ON_STARTUP)
+                {
+                    mMaintainer->performMaintenance(
+                        mConfig.AUTOMATIC_MAINTENANCE_COUNT);
+                }
+                mMaintainer->start();
             }
             mOverlayManager->start();
             auto npub = mHistoryManager->publishQueuedHistory();
@@ -427,6 +436,7 @@ ApplicationImpl::getLoadGenerator()
 void
 ApplicationImpl::checkDB()
 {
+    getInvariantManager().requestFullChecks();
     getClock().getIOService().post([this] {
         checkDBAgainstBuckets(this->getMetrics(), this->getBucketManager(),
                               this->getDatabase(),
@@ -434,14 +444,6 @@ ApplicationImpl::checkDB()
     });
 }
 
-void
-ApplicationImpl::maintenance()
-{
-    LOG(INFO) << "Performing maintenance";
-    ExternalQueue ps(*this);
-    ps.process();
-}
-
 void
 ApplicationImpl::applyCfgCommands()
 {
@@ -532,8 +534,19 @@ ApplicationImpl::syncOwnMetrics()
     // Flush crypto pure-global-cache stats. They don't belong
     // to a single app instance but first one to flush will claim
     // them.
+    std::vector<uint64_t> shardHits, shardMisses;
+    PubKeyUtils::flushVerifySigCacheCounts(shardHits, shardMisses);
     uint64_t vhit = 0, vmiss = 0;
-    PubKeyUtils::flushVerifySigCacheCounts(vhit, vmiss);
+    for (size_t i = 0; i < shardHits.size(); ++i)
+    {
+        auto shard = "verify-shard-" + std::to_string(i);
+        mMetrics->NewMeter({"crypto", shard, "hit"}, "signature")
+            .Mark(shardHits[i]);
+        mMetrics->NewMeter({"crypto", shard, "miss"}, "signature")
+            .Mark(shardMisses[i]);
+        vhit += shardHits[i];
+        vmiss += shardMisses[i];
+    }
     mMetrics->NewMeter({"crypto", "verify", "hit"}, "signature").Mark(vhit);
     mMetrics->NewMeter({"crypto", "verify", "miss"}, "signature").Mark(vmiss);
     mMetrics->NewMeter({"crypto", "verify", "total"}, "signature")
@@ -642,6 +655,12 @@ ApplicationImpl::getBanManager()
     return *mBanManager;
 }
 
+Maintainer&
+ApplicationImpl::getMaintainer()
+{
+    return *mMaintainer;
+}
+
 StatusManager&
 ApplicationImpl::getStatusManager()
 {
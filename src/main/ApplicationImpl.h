@@ -63,6 +63,7 @@ class ApplicationImpl : public Application
     virtual CommandHandler& getCommandHandler() override;
     virtual WorkManager& getWorkManager() override;
     virtual BanManager& getBanManager() override;
+    virtual Maintainer& getMaintainer() override;
     virtual StatusManager& getStatusManager() override;
 
     virtual asio::io_service& getWorkerIOService() override;
@@ -90,8 +91,6 @@ class ApplicationImpl : public Application
 
     virtual void checkDB() override;
 
-    virtual void maintenance() override;
-
     virtual void applyCfgCommands() override;
 
     virtual void reportCfgMetrics() override;
@@ -137,6 +136,7 @@ class ApplicationImpl : public Application
     std::unique_ptr<PersistentState> mPersistentState;
     std::unique_ptr<LoadGenerator> mLoadGenerator;
     std::unique_ptr<BanManager> mBanManager;
+    std::unique_ptr<Maintainer> mMaintainer;
     std::shared_ptr<NtpSynchronizationChecker> mNtpSynchronizationChecker;
     std::unique_ptr<StatusManager> mStatusManager;
 
@@ -13,6 +13,7 @@
 #include "lib/util/format.h"
 #include "main/Application.h"
 #include "main/Config.h"
+#include "main/Maintainer.h"
 #include "overlay/BanManager.h"
 #include "overlay/OverlayManager.h"
 #include "util/Logging.h"
@@ -291,12 +292,16 @@ CommandHandler::fileNotFound(std::string const& params, std::string& retStr)
         "The data is historical data stored in the SQL tables such as "
         "txhistory or ledgerheaders.When all consumers processed the data for "
         "ledger sequence N the data can be safely removed by the instance."
-        "The actual deletion is performed by invoking the `maintenance` "
+        "The actual deletion is performed in the background (see "
+        "AUTOMATIC_MAINTENANCE_PERIOD) or by invoking the `maintenance` "
         "endpoint."
-        "</p><p><h1> /maintenance[?queue=true]</h1> Performs maintenance tasks "
-        "on the instance."
-        "<ul><li><i>queue</i> performs deletion of queue data.See setcursor "
-        "for more information</li></ul>"
+        "</p><p><h1> /maintenance[?queue=true[&count=N]][&automatic=BOOL]"
+        "</h1> Performs maintenance tasks on the instance."
+        "<ul><li><i>queue</i> performs deletion of queue data, for at most "
+        "<i>count</i> ledgers (default 50000). See setcursor for more "
+        "information</li>"
+        "<li><i>automatic</i> turns the periodic deletion of queue data on "
+        "or off</li></ul>"
         "</p><p><h1> "
         "/unban?node=NODE_ID</h1>"
         "remove ban for PEER_ID"
@@ -411,6 +416,12 @@ CommandHandler::peers(std::string const& params, std::string& retStr)
         root["peers"][counter]["olver"] = (int)peer->getRemoteOverlayVersion();
         root["peers"][counter]["id"] =
             mApp.getConfig().toStrKey(peer->getPeerID());
+        root["peers"][counter]["write_queue"] =
+            (Json::UInt64)peer->getWriteQueueSize();
+        root["peers"][counter]["write_queue_drops"] =
+            (Json::UInt64)peer->getWriteQueueDrops();
+        root["peers"][counter]["ingress_queue"] =
+            (Json::UInt64)peer->getIngressQueueSize();
 
         counter++;
     }
@@ -940,14 +951,37 @@ CommandHandler::maintenance(std::string const& params, std::string& retStr)
 {
     std::map<std::string, std::string> map;
     http::server::server::parseParams(params, map);
+    auto& maintainer = mApp.getMaintainer();
+
+    std::ostringstream out;
+    auto automatic = map.find("automatic");
+    if (automatic != map.end())
+    {
+        if (automatic->second != "true" && automatic->second != "false")
+        {
+            retStr = "Invalid automatic, must be true or false";
+            return;
+        }
+        maintainer.setEnabled(automatic->second == "true");
+        out << "Automatic maintenance "
+            << (maintainer.isEnabled() ? "enabled" : "disabled") << ". ";
+    }
+
     if (map["queue"] == "true")
     {
-        mApp.maintenance();
-        retStr = "Done";
+        uint32_t count = 50000;
+        if (!parseNumParam(map, "count", count, retStr,
+                           Requirement::OPTIONAL_REQ))
+        {
+            return;
+        }
+        maintainer.performMaintenance(count);
+        out << "Done";
     }
     else
     {
-        retStr = "No work performed";
+        out << "No work performed";
     }
+    retStr = out.str();
 }
 }
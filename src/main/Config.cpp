@@ -39,6 +39,8 @@ Config::Config() : NODE_SEED(SecretKey::random())
     CATCHUP_COMPLETE = false;
     CATCHUP_RECENT = 0;
     MAINTENANCE_ON_STARTUP = true;
+    AUTOMATIC_MAINTENANCE_PERIOD = std::chrono::seconds{60};
+    AUTOMATIC_MAINTENANCE_COUNT = 100;
     ARTIFICIALLY_GENERATE_LOAD_FOR_TESTING = false;
     ARTIFICIALLY_ACCELERATE_TIME_FOR_TESTING = false;
     ARTIFICIALLY_SET_CLOSE_TIME_FOR_TESTING = 0;
@@ -59,11 +61,23 @@ Config::Config() : NODE_SEED(SecretKey::random())
     PEER_PORT = DEFAULT_PEER_PORT;
     TARGET_PEER_CONNECTIONS = 8;
     MAX_PEER_CONNECTIONS = 12;
+    PEER_WRITE_QUEUE_HIGH_WATER_MARK = 4 * 1024 * 1024;
+    PEER_BACKGROUND_DECODE = false;
     PREFERRED_PEERS_ONLY = false;
 
     MINIMUM_IDLE_PERCENT = 0;
 
     MAX_CONCURRENT_SUBPROCESSES = 16;
+    CATCHUP_LOOKAHEAD_CHECKPOINTS = 32;
+    CATCHUP_LOOKAHEAD_MAX_BYTES = 1024 * 1024 * 1024;
+    ENTRY_CACHE_SIZE = 4096;
+    ENTRY_CACHE_SHARDS = 1;
+    VERIFY_SIG_CACHE_SIZE = 0xffff;
+    BUCKET_MERGE_PARTITION_SIZE = 128 * 1024 * 1024;
+    IN_MEMORY_ORDER_BOOK = true;
+    CLUSTERED_TX_APPLY = false;
+    INVARIANT_FULL_CHECK_PERIOD = 256;
+    ASYNC_INVARIANT_CHECKS = false;
     NODE_IS_VALIDATOR = false;
 
     DATABASE = SecretValue{"sqlite3://:memory:"};
@@ -350,6 +364,29 @@ Config::load(std::string const& filename)
                 }
                 MAINTENANCE_ON_STARTUP = item.second->as<bool>()->value();
             }
+            else if (item.first == "AUTOMATIC_MAINTENANCE_PERIOD")
+            {
+                if (!item.second->as<int64_t>() ||
+                    item.second->as<int64_t>()->value() < 0)
+                {
+                    throw std::invalid_argument(
+                        "invalid AUTOMATIC_MAINTENANCE_PERIOD");
+                }
+                AUTOMATIC_MAINTENANCE_PERIOD =
+                    std::chrono::seconds{item.second->as<int64_t>()->value()};
+            }
+            else if (item.first == "AUTOMATIC_MAINTENANCE_COUNT")
+            {
+                if (!item.second->as<int64_t>() ||
+                    item.second->as<int64_t>()->value() < 0 ||
+                    item.second->as<int64_t>()->value() > UINT32_MAX)
+                {
+                    throw std::invalid_argument(
+                        "invalid AUTOMATIC_MAINTENANCE_COUNT");
+                }
+                AUTOMATIC_MAINTENANCE_COUNT =
+                    (uint32_t)item.second->as<int64_t>()->value();
+            }
             else if (item.first == "MANUAL_CLOSE")
             {
                 if (!item.second->as<bool>())
@@ -435,6 +472,26 @@ Config::load(std::string const& filename)
                 }
                 MAX_PEER_CONNECTIONS = (int)item.second->as<int64_t>()->value();
             }
+            else if (item.first == "PEER_WRITE_QUEUE_HIGH_WATER_MARK")
+            {
+                if (!item.second->as<int64_t>() ||
+                    item.second->as<int64_t>()->value() < 0)
+                {
+                    throw std::invalid_argument(
+                        "invalid PEER_WRITE_QUEUE_HIGH_WATER_MARK");
+                }
+                PEER_WRITE_QUEUE_HIGH_WATER_MARK =
+                    (size_t)item.second->as<int64_t>()->value();
+            }
+            else if (item.first == "PEER_BACKGROUND_DECODE")
+            {
+                if (!item.second->as<bool>())
+                {
+                    throw std::invalid_argument(
+                        "invalid PEER_BACKGROUND_DECODE");
+                }
+                PEER_BACKGROUND_DECODE = item.second->as<bool>()->value();
+            }
             else if (item.first == "PREFERRED_PEERS")
             {
                 if (!item.second->is_array())
@@ -510,6 +567,87 @@ Config::load(std::string const& filename)
                 MAX_CONCURRENT_SUBPROCESSES =
                     (size_t)item.second->as<int64_t>()->value();
             }
+            else if (item.first == "CATCHUP_LOOKAHEAD_CHECKPOINTS")
+            {
+                if (!item.second->as<int64_t>() ||
+                    item.second->as<int64_t>()->value() <= 0 ||
+                    item.second->as<int64_t>()->value() > UINT32_MAX)
+                {
+                    throw std::invalid_argument(
+                        "invalid CATCHUP_LOOKAHEAD_CHECKPOINTS");
+                }
+                CATCHUP_LOOKAHEAD_CHECKPOINTS =
+                    (uint32_t)item.second->as<int64_t>()->value();
+            }
+            else if (item.first == "CATCHUP_LOOKAHEAD_MAX_BYTES")
+            {
+                if (!item.second->as<int64_t>() ||
+                    item.second->as<int64_t>()->value() < 0)
+                {
+                    throw std::invalid_argument(
+                        "invalid CATCHUP_LOOKAHEAD_MAX_BYTES");
+                }
+                CATCHUP_LOOKAHEAD_MAX_BYTES =
+                    (size_t)item.second->as<int64_t>()->value();
+            }
+            else if (item.first == "ENTRY_CACHE_SIZE")
+            {
+                if (!item.second->as<int64_t>() ||
+                    item.second->as<int64_t>()->value() <= 0)
+                {
+                    throw std::invalid_argument("invalid ENTRY_CACHE_SIZE");
+                }
+                ENTRY_CACHE_SIZE = (size_t)item.second->as<int64_t>()->value();
+            }
+            else if (item.first == "ENTRY_CACHE_SHARDS")
+            {
+                if (!item.second->as<int64_t>() ||
+                    item.second->as<int64_t>()->value() <= 0 ||
+                    item.second->as<int64_t>()->value() > 256)
+                {
+                    throw std::invalid_argument("invalid ENTRY_CACHE_SHARDS");
+                }
+                ENTRY_CACHE_SHARDS =
+                    (size_t)item.second->as<int64_t>()->value();
+            }
+            else if (item.first == "VERIFY_SIG_CACHE_SIZE")
+            {
+                if (!item.second->as<int64_t>() ||
+                    item.second->as<int64_t>()->value() <= 0)
+                {
+                    throw std::invalid_argument(
+                        "invalid VERIFY_SIG_CACHE_SIZE");
+                }
+                VERIFY_SIG_CACHE_SIZE =
+                    (size_t)item.second->as<int64_t>()->value();
+            }
+            else if (item.first == "BUCKET_MERGE_PARTITION_SIZE")
+            {
+                if (!item.second->as<int64_t>() ||
+                    item.second->as<int64_t>()->value() < 0)
+                {
+                    throw std::invalid_argument(
+                        "invalid BUCKET_MERGE_PARTITION_SIZE");
+                }
+                BUCKET_MERGE_PARTITION_SIZE =
+                    (size_t)item.second->as<int64_t>()->value();
+            }
+            else if (item.first == "IN_MEMORY_ORDER_BOOK")
+            {
+                if (!item.second->as<bool>())
+                {
+                    throw std::invalid_argument("invalid IN_MEMORY_ORDER_BOOK");
+                }
+                IN_MEMORY_ORDER_BOOK = item.second->as<bool>()->value();
+            }
+            else if (item.first == "CLUSTERED_TX_APPLY")
+            {
+                if (!item.second->as<bool>())
+                {
+                    throw std::invalid_argument("invalid CLUSTERED_TX_APPLY");
+                }
+                CLUSTERED_TX_APPLY = item.second->as<bool>()->value();
+            }
             else if (item.first == "MINIMUM_IDLE_PERCENT")
             {
                 if (!item.second->as<int64_t>() ||
@@ -621,6 +759,27 @@ Config::load(std::string const& filename)
                     INVARIANT_CHECKS.push_back(v->as<std::string>()->value());
                 }
             }
+            else if (item.first == "INVARIANT_FULL_CHECK_PERIOD")
+            {
+                if (!item.second->as<int64_t>() ||
+                    item.second->as<int64_t>()->value() < 0 ||
+                    item.second->as<int64_t>()->value() > UINT32_MAX)
+                {
+                    throw std::invalid_argument(
+                        "invalid INVARIANT_FULL_CHECK_PERIOD");
+                }
+                INVARIANT_FULL_CHECK_PERIOD =
+                    (uint32_t)item.second->as<int64_t>()->value();
+            }
+            else if (item.first == "ASYNC_INVARIANT_CHECKS")
+            {
+                if (!item.second->as<bool>())
+                {
+                    throw std::invalid_argument(
+                        "invalid ASYNC_INVARIANT_CHECKS");
+                }
+                ASYNC_INVARIANT_CHECKS = item.second->as<bool>()->value();
+            }
             else
             {
                 std::string err("Unknown configuration entry: '");
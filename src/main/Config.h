@@ -8,6 +8,7 @@
 #include "overlay/StellarXDR.h"
 #include "util/SecretValue.h"
 #include "util/optional.h"
+#include <chrono>
 #include <map>
 #include <memory>
 #include <string>
@@ -80,6 +81,13 @@ class Config : public std::enable_shared_from_this<Config>
     // Enables or disables automatic maintenance on startup
     bool MAINTENANCE_ON_STARTUP;
 
+    // Every AUTOMATIC_MAINTENANCE_PERIOD, the history of up to
+    // AUTOMATIC_MAINTENANCE_COUNT ledgers that is no longer needed is deleted
+    // from the database; startup maintenance deletes one such batch too. A
+    // period or count of 0 disables periodic maintenance.
+    std::chrono::seconds AUTOMATIC_MAINTENANCE_PERIOD;
+    uint32_t AUTOMATIC_MAINTENANCE_COUNT;
+
     // A config parameter that enables synthetic load generation on demand,
     // using the `generateload` runtime command (see CommandHandler.cpp). This
     // option only exists for stress-testing and should not be enabled in
@@ -139,6 +147,13 @@ class Config : public std::enable_shared_from_this<Config>
     unsigned short PEER_PORT;
     unsigned TARGET_PEER_CONNECTIONS;
     unsigned MAX_PEER_CONNECTIONS;
+    // Bytes queued for writing to a peer above which transactions sent to it
+    // are dropped, so that SCP traffic isn't stuck behind them. 0 disables.
+    size_t PEER_WRITE_QUEUE_HIGH_WATER_MARK;
+    // Whether messages of authenticated peers are decoded and their MAC
+    // checked on the worker threads, then handed to the main thread in
+    // batches.
+    bool PEER_BACKGROUND_DECODE;
     // Peers we will always try to stay connected to
     std::vector<std::string> PREFERRED_PEERS;
     std::vector<std::string> KNOWN_PEERS;
@@ -160,6 +175,35 @@ class Config : public std::enable_shared_from_this<Config>
     // process-management config
     size_t MAX_CONCURRENT_SUBPROCESSES;
 
+    // While replaying transactions during catchup, how many checkpoints may
+    // be downloaded ahead of the one being applied, and how many bytes of
+    // downloaded-but-unapplied transaction files may sit in the download
+    // directory before further downloads wait (0 for no limit).
+    uint32_t CATCHUP_LOOKAHEAD_CHECKPOINTS;
+    size_t CATCHUP_LOOKAHEAD_MAX_BYTES;
+
+    // Number of LedgerEntries kept in the database entry cache, and number of
+    // independently locked shards that capacity is split across.
+    size_t ENTRY_CACHE_SIZE;
+    size_t ENTRY_CACHE_SHARDS;
+
+    // Number of signature-verification results kept in the process-wide
+    // verify-signature cache.
+    size_t VERIFY_SIG_CACHE_SIZE;
+
+    // Whether OfferFrame::loadBestOffers is served from an in-memory index of
+    // the offers table rather than by querying the database.
+    bool IN_MEMORY_ORDER_BOOK;
+
+    // Whether the transactions of a ledger are applied cluster by cluster,
+    // as split by ApplyPartition, each in a delta of its own.
+    bool CLUSTERED_TX_APPLY;
+
+    // Bucket merges whose inputs add up to at least twice this many bytes
+    // are split into key ranges of about this size, merged concurrently on
+    // the worker threads. 0 disables.
+    size_t BUCKET_MERGE_PARTITION_SIZE;
+
     // SCP config
     SecretKey NODE_SEED;
     bool NODE_IS_VALIDATOR;
@@ -168,6 +212,18 @@ class Config : public std::enable_shared_from_this<Config>
     // Invariants
     std::vector<std::string> INVARIANT_CHECKS;
 
+    // TotalCoinsEqualsBalancesPlusFeePool keeps a running total of balances
+    // from the changes of each ledger, and checks it against a sum over all
+    // accounts every this many ledgers. 0 only checks it on startup and
+    // when the database is checked.
+    uint32_t INVARIANT_FULL_CHECK_PERIOD;
+
+    // Checks the invariants that allow it on a worker thread once each
+    // ledger is committed, while the next ledger closes, rather than before
+    // committing it. Needs a database that a connection pool can be made to
+    // (not in-memory SQLite).
+    bool ASYNC_INVARIANT_CHECKS;
+
     std::map<std::string, std::string> VALIDATOR_NAMES;
 
     // History config
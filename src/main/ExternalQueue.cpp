@@ -7,6 +7,9 @@
 #include "Application.h"
 #include "database/Database.h"
 #include "ledger/LedgerManager.h"
+#include "medida/counter.h"
+#include "medida/meter.h"
+#include "medida/metrics_registry.h"
 #include "util/Logging.h"
 #include <limits>
 #include <regex>
@@ -95,7 +98,43 @@ ExternalQueue::deleteCursor(std::string const& resid)
 }
 
 void
-ExternalQueue::process()
+ExternalQueue::deleteOldEntries(uint32 count)
+{
+    auto& db = mApp.getDatabase();
+    uint32_t cmin = getMaxLedgerToDelete();
+
+    auto rows = mApp.getLedgerManager().deleteOldEntries(db, cmin, count);
+    mApp.getMetrics()
+        .NewMeter({"maintenance", "trim", "rows"}, "row")
+        .Mark(rows);
+
+    // ledgers left to trim, going by the oldest ledger header kept
+    int64_t oldest;
+    soci::indicator oldestIndicator;
+    {
+        auto timer = db.getSelectTimer("ledgerheaders");
+        db.getSession() << "SELECT MIN(ledgerseq) FROM ledgerheaders",
+            soci::into(oldest, oldestIndicator);
+    }
+    int64_t lag = 0;
+    if (oldestIndicator == soci::indicator::i_ok && oldest <= cmin)
+    {
+        lag = cmin - oldest + 1;
+    }
+    mApp.getMetrics()
+        .NewCounter({"maintenance", "trim", "lag"})
+        .set_count(lag);
+
+    if (rows != 0)
+    {
+        CLOG(INFO, "History") << "Trimmed " << rows
+                              << " rows of history <= ledger " << cmin << ", "
+                              << lag << " ledgers left to trim";
+    }
+}
+
+uint32_t
+ExternalQueue::getMaxLedgerToDelete()
 {
     auto& db = mApp.getDatabase();
     int m;
@@ -134,11 +173,10 @@ ExternalQueue::process()
     // publication and the requirements of our pubsub subscribers.
     uint32_t cmin = std::min(lmin, rmin);
 
-    CLOG(INFO, "History") << "Trimming history <= ledger " << cmin
-                          << " (rmin=" << rmin << ", qmin=" << qmin
-                          << ", lmin=" << lmin << ")";
-
-    mApp.getLedgerManager().deleteOldEntries(mApp.getDatabase(), cmin);
+    CLOG(DEBUG, "History") << "History can be trimmed <= ledger " << cmin
+                           << " (rmin=" << rmin << ", qmin=" << qmin
+                           << ", lmin=" << lmin << ")";
+    return cmin;
 }
 
 void
@@ -26,12 +26,15 @@ class ExternalQueue
     // deletes the subscription for the resource
     void deleteCursor(std::string const& resid);
 
-    // safely delete data
-    void process();
+    // safely delete the history of up to `count` ledgers, oldest first
+    void deleteOldEntries(uint32 count);
 
   private:
     void checkID(std::string const& resid);
     std::string getCursor(std::string const& resid);
+    // highest ledger whose history is needed neither for publishing nor by
+    // any subscriber
+    uint32_t getMaxLedgerToDelete();
 
     static std::string kSQLCreateStatement;
 
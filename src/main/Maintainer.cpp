@@ -0,0 +1,103 @@
+// Copyright 2017 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "main/Maintainer.h"
+#include "ledger/LedgerManager.h"
+#include "main/Application.h"
+#include "main/Config.h"
+#include "main/ExternalQueue.h"
+#include "util/Logging.h"
+
+#include "medida/meter.h"
+#include "medida/metrics_registry.h"
+#include "medida/timer.h"
+
+namespace stellar
+{
+
+Maintainer::Maintainer(Application& app)
+    : mApp{app}
+    , mTimer{mApp}
+    , mEnabled{true}
+    , mMaintenanceTime{
+          app.getMetrics().NewTimer({"maintenance", "trim", "run"})}
+    , mSkipped{app.getMetrics().NewMeter({"maintenance", "trim", "skipped"},
+                                         "tick")}
+{
+}
+
+void
+Maintainer::start()
+{
+    auto const& cfg = mApp.getConfig();
+    // for now, history is only trimmed when CATCHUP_COMPLETE is not set
+    if (cfg.CATCHUP_COMPLETE ||
+        cfg.AUTOMATIC_MAINTENANCE_PERIOD.count() == 0 ||
+        cfg.AUTOMATIC_MAINTENANCE_COUNT == 0)
+    {
+        return;
+    }
+
+    CLOG(INFO, "History") << "Trimming history of up to "
+                          << cfg.AUTOMATIC_MAINTENANCE_COUNT
+                          << " ledgers every "
+                          << cfg.AUTOMATIC_MAINTENANCE_PERIOD.count() << "s";
+    scheduleMaintenance();
+}
+
+void
+Maintainer::setEnabled(bool enabled)
+{
+    if (mEnabled == enabled)
+    {
+        return;
+    }
+    mEnabled = enabled;
+    if (mEnabled)
+    {
+        start();
+    }
+    else
+    {
+        mTimer.cancel();
+    }
+}
+
+void
+Maintainer::scheduleMaintenance()
+{
+    mTimer.expires_from_now(mApp.getConfig().AUTOMATIC_MAINTENANCE_PERIOD);
+    mTimer.async_wait([this]() { this->tick(); },
+                      VirtualTimer::onFailureNoop);
+}
+
+void
+Maintainer::tick()
+{
+    if (!mEnabled)
+    {
+        return;
+    }
+
+    // catchup applies ledgers back to back: trimming in between would only
+    // slow it down, and there is nothing urgent about it
+    if (mApp.getLedgerManager().isSynced())
+    {
+        performMaintenance(mApp.getConfig().AUTOMATIC_MAINTENANCE_COUNT);
+    }
+    else
+    {
+        mSkipped.Mark();
+    }
+    scheduleMaintenance();
+}
+
+void
+Maintainer::performMaintenance(uint32_t count)
+{
+    auto timer = mMaintenanceTime.TimeScope();
+    ExternalQueue ps{mApp};
+    ps.deleteOldEntries(count);
+}
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+// Copyright 2017 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/Timer.h"
+
+namespace medida
+{
+class Meter;
+class Timer;
+}
+
+namespace stellar
+{
+
+class Application;
+
+/**
+ * Trims the history kept in the database in the background: every
+ * AUTOMATIC_MAINTENANCE_PERIOD, the history of up to
+ * AUTOMATIC_MAINTENANCE_COUNT ledgers that is no longer needed (see
+ * ExternalQueue) is deleted. Small batches keep each DELETE short instead of
+ * locking the history tables for as long as it takes to drop everything at
+ * once.
+ *
+ * Ticks are skipped while the node isn't in sync, so that trimming doesn't
+ * compete with catchup applying ledgers. Ledgers are closed on the main
+ * thread, so a tick never runs in the middle of a ledger close.
+ */
+class Maintainer
+{
+  public:
+    explicit Maintainer(Application& app);
+
+    // Starts the periodic trimming if it's configured (and enabled), unless
+    // CATCHUP_COMPLETE is set.
+    void start();
+
+    // Turns periodic trimming on or off at runtime.
+    void setEnabled(bool enabled);
+    bool
+    isEnabled() const
+    {
+        return mEnabled;
+    }
+
+    // Deletes the history of up to `count` ledgers right away.
+    void performMaintenance(uint32_t count);
+
+  private:
+    Application& mApp;
+    VirtualTimer mTimer;
+    bool mEnabled;
+
+    medida::Timer& mMaintenanceTime;
+    medida::Meter& mSkipped;
+
+    void scheduleMaintenance();
+    void tick();
+};
+}
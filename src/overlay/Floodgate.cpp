@@ -60,7 +60,17 @@ Floodgate::addRecord(StellarMessage const& msg, Peer::pointer peer)
     {
         return false;
     }
-    Hash index = sha256(xdr::xdr_to_opaque(msg));
+    return addRecord(msg, peer, sha256(xdr::xdr_to_opaque(msg)));
+}
+
+bool
+Floodgate::addRecord(StellarMessage const& msg, Peer::pointer peer,
+                     Hash const& index)
+{
+    if (mShuttingDown)
+    {
+        return false;
+    }
     auto result = mFloodMap.find(index);
     if (result == mFloodMap.end())
     { // we have never seen this message
@@ -84,7 +94,9 @@ Floodgate::broadcast(StellarMessage const& msg, bool force)
     {
         return;
     }
-    Hash index = sha256(xdr::xdr_to_opaque(msg));
+    // serialized once, then shared by the index and every peer it is sent to
+    auto body = OutgoingMessage::serialize(msg);
+    Hash index = sha256(*body);
     CLOG(TRACE, "Overlay") << "broadcast " << hexAbbrev(index);
 
     auto result = mFloodMap.find(index);
@@ -106,7 +118,7 @@ Floodgate::broadcast(StellarMessage const& msg, bool force)
         if (peersTold.find(peer) == peersTold.end() && peer->isAuthenticated())
         {
             mSendFromBroadcast.Mark();
-            peer->sendMessage(msg);
+            peer->sendMessage(msg, body);
             peersTold.insert(peer);
         }
     }
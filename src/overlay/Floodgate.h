@@ -56,6 +56,9 @@ class Floodgate
     void clearBelow(uint32_t currentLedger);
     // returns true if this is a new record
     bool addRecord(StellarMessage const& msg, Peer::pointer fromPeer);
+    // same, with `index` the hash of the XDR of `msg`
+    bool addRecord(StellarMessage const& msg, Peer::pointer fromPeer,
+                   Hash const& index);
 
     void broadcast(StellarMessage const& msg, bool force);
 
@@ -0,0 +1,69 @@
+// Copyright 2017 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "overlay/OutgoingMessage.h"
+#include "xdrpp/marshal.h"
+
+#include <cstring>
+
+namespace stellar
+{
+
+size_t const OutgoingMessage::HEADER_SIZE;
+
+static void
+putUint32(uint8_t* out, uint32_t v)
+{
+    out[0] = static_cast<uint8_t>(v >> 24);
+    out[1] = static_cast<uint8_t>(v >> 16);
+    out[2] = static_cast<uint8_t>(v >> 8);
+    out[3] = static_cast<uint8_t>(v);
+}
+
+OutgoingMessage::Body
+OutgoingMessage::serialize(StellarMessage const& msg)
+{
+    return std::make_shared<xdr::opaque_vec<> const>(xdr::xdr_to_opaque(msg));
+}
+
+OutgoingMessage::OutgoingMessage(Body body, uint64_t sequence,
+                                 HmacSha256Mac const& mac)
+    : mBody(std::move(body)), mMac(mac)
+{
+    // record mark: length of the record, with the 'last fragment' bit set
+    auto length = getSize() - 4;
+    putUint32(mHeader.data(), static_cast<uint32_t>(length) | 0x80000000);
+    // AuthenticatedMessage discriminant, always 0
+    putUint32(mHeader.data() + 4, 0);
+    putUint32(mHeader.data() + 8, static_cast<uint32_t>(sequence >> 32));
+    putUint32(mHeader.data() + 12, static_cast<uint32_t>(sequence));
+}
+
+std::array<asio::const_buffer, 3>
+OutgoingMessage::getBuffers() const
+{
+    return {{asio::buffer(mHeader.data(), mHeader.size()),
+             asio::buffer(mBody->data(), mBody->size()),
+             asio::buffer(mMac.mac.data(), mMac.mac.size())}};
+}
+
+size_t
+OutgoingMessage::getSize() const
+{
+    return HEADER_SIZE + mBody->size() + mMac.mac.size();
+}
+
+xdr::msg_ptr
+OutgoingMessage::toMsg() const
+{
+    auto msg = xdr::message_t::alloc(getSize() - 4);
+    auto out = msg->raw_data();
+    std::memcpy(out, mHeader.data(), mHeader.size());
+    out += mHeader.size();
+    std::memcpy(out, mBody->data(), mBody->size());
+    out += mBody->size();
+    std::memcpy(out, mMac.mac.data(), mMac.mac.size());
+    return msg;
+}
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+// Copyright 2017 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/asio.h"
+#include "overlay/StellarXDR.h"
+#include "xdrpp/message.h"
+
+#include <array>
+#include <memory>
+
+namespace stellar
+{
+
+/**
+ * The wire form of an AuthenticatedMessage, kept as three parts: a small
+ * header (XDR record mark, union discriminant and sequence number), the
+ * serialized StellarMessage, and the MAC.
+ *
+ * The serialized StellarMessage is immutable and reference counted, so a
+ * message broadcast to many peers is serialized once and each peer only adds
+ * its own header and MAC around the shared bytes.
+ */
+class OutgoingMessage
+{
+  public:
+    typedef std::shared_ptr<xdr::opaque_vec<> const> Body;
+
+    static Body serialize(StellarMessage const& msg);
+
+    OutgoingMessage(Body body, uint64_t sequence, HmacSha256Mac const& mac);
+
+    // Buffers to hand to a gather-write; they point into this object and
+    // the shared body.
+    std::array<asio::const_buffer, 3> getBuffers() const;
+
+    // Bytes on the wire, record mark included.
+    size_t getSize() const;
+
+    // Contiguous copy, for peers that don't write to a socket.
+    xdr::msg_ptr toMsg() const;
+
+  private:
+    static size_t const HEADER_SIZE = 4 + 4 + 8;
+
+    std::array<uint8_t, HEADER_SIZE> mHeader;
+    Body mBody;
+    HmacSha256Mac mMac;
+};
+}
@@ -74,6 +74,9 @@ class OverlayManager
     // that, call broadcastMessage, above.
     virtual void recvFloodedMsg(StellarMessage const& msg,
                                 Peer::pointer peer) = 0;
+    // Same, with `index` the hash of the XDR of `msg`, as already computed.
+    virtual void recvFloodedMsg(StellarMessage const& msg, Peer::pointer peer,
+                                Hash const& index) = 0;
 
     // Return a list of random peers from the set of authenticated peers.
     virtual std::vector<Peer::pointer> getRandomPeers() = 0;
@@ -379,6 +379,14 @@ OverlayManagerImpl::recvFloodedMsg(StellarMessage const& msg,
     mFloodGate.addRecord(msg, peer);
 }
 
+void
+OverlayManagerImpl::recvFloodedMsg(StellarMessage const& msg,
+                                   Peer::pointer peer, Hash const& index)
+{
+    mMessagesReceived.Mark();
+    mFloodGate.addRecord(msg, peer, index);
+}
+
 void
 OverlayManagerImpl::broadcastMessage(StellarMessage const& msg, bool force)
 {
@@ -4,11 +4,13 @@
 
 #include "BanManager.h"
 #include "crypto/KeyUtils.h"
+#include "crypto/SHA.h"
 #include "crypto/SecretKey.h"
 #include "lib/catch.hpp"
 #include "main/Application.h"
 #include "main/Config.h"
 #include "overlay/LoopbackPeer.h"
+#include "overlay/OutgoingMessage.h"
 #include "overlay/OverlayManagerImpl.h"
 #include "overlay/PeerRecord.h"
 #include "overlay/TCPPeer.h"
@@ -20,6 +22,7 @@
 #include "medida/meter.h"
 #include "medida/metrics_registry.h"
 #include "medida/timer.h"
+#include "xdrpp/marshal.h"
 
 using namespace stellar;
 
@@ -34,6 +37,43 @@ crankSome(VirtualClock& clock)
         ;
 }
 
+TEST_CASE("outgoing message wire format", "[overlay]")
+{
+    StellarMessage msg;
+    msg.type(GET_TX_SET);
+    msg.txSetHash() = sha256("txset");
+
+    HmacSha256Key key;
+    key.key = sha256("key");
+    uint64_t sequence = 0x0102030405060708;
+
+    AuthenticatedMessage amsg;
+    amsg.v0().message = msg;
+    amsg.v0().sequence = sequence;
+    amsg.v0().mac = hmacSha256(key, xdr::xdr_to_opaque(sequence, msg));
+    auto expected = xdr::xdr_to_msg(amsg);
+
+    auto body = OutgoingMessage::serialize(msg);
+    auto mac = hmacSha256(key, xdr::xdr_to_opaque(sequence), *body);
+    REQUIRE(mac == amsg.v0().mac);
+
+    OutgoingMessage out(msg.type(), body, sequence, mac);
+    REQUIRE(out.getSize() == expected->raw_size());
+
+    auto actual = out.toMsg();
+    REQUIRE(actual->raw_size() == expected->raw_size());
+    REQUIRE(std::equal(expected->raw_data(),
+                       expected->raw_data() + expected->raw_size(),
+                       actual->raw_data()));
+
+    size_t total = 0;
+    for (auto const& b : out.getBuffers())
+    {
+        total += asio::buffer_size(b);
+    }
+    REQUIRE(total == expected->raw_size());
+}
+
 TEST_CASE("loopback peer hello", "[overlay]")
 {
     VirtualClock clock;
@@ -444,6 +444,12 @@ msgSummary(StellarMessage const& msg)
 
 void
 Peer::sendMessage(StellarMessage const& msg)
+{
+    sendMessage(msg, OutgoingMessage::serialize(msg));
+}
+
+void
+Peer::sendMessage(StellarMessage const& msg, OutgoingMessage::Body const& body)
 {
     if (Logging::logTrace("Overlay"))
         CLOG(TRACE, "Overlay")
@@ -453,6 +459,11 @@ Peer::sendMessage(StellarMessage const& msg)
             << ") send: " << msgSummary(msg)
             << " to : " << mApp.getConfig().toShortString(mPeerID);
 
+    if (msg.type() == TRANSACTION && shouldDropTransaction())
+    {
+        return;
+    }
+
     switch (msg.type())
     {
     case ERROR_MSG:
@@ -496,17 +507,15 @@ Peer::sendMessage(StellarMessage const& msg)
         break;
     };
 
-    AuthenticatedMessage amsg;
-    amsg.v0().message = msg;
+    uint64_t sequence = 0;
+    HmacSha256Mac mac;
     if (msg.type() != HELLO && msg.type() != ERROR_MSG)
     {
-        amsg.v0().sequence = mSendMacSeq;
-        amsg.v0().mac =
-            hmacSha256(mSendMacKey, xdr::xdr_to_opaque(mSendMacSeq, msg));
+        sequence = mSendMacSeq;
+        mac = hmacSha256(mSendMacKey, xdr::xdr_to_opaque(sequence), *body);
         ++mSendMacSeq;
     }
-    xdr::msg_ptr xdrBytes(xdr::xdr_to_msg(amsg));
-    this->sendMessage(std::move(xdrBytes));
+    this->sendMessage(OutgoingMessage(body, sequence, mac));
 }
 
 void
@@ -553,6 +562,12 @@ Peer::shouldAbort() const
     return (mState == CLOSING) || mApp.getOverlayManager().isShuttingDown();
 }
 
+bool
+Peer::needsMacCheck(AuthenticatedMessage const& msg) const
+{
+    return mState >= GOT_HELLO && msg.v0().message.type() != ERROR_MSG;
+}
+
 void
 Peer::recvMessage(AuthenticatedMessage const& msg)
 {
@@ -561,7 +576,24 @@ Peer::recvMessage(AuthenticatedMessage const& msg)
         return;
     }
 
-    if (mState >= GOT_HELLO && msg.v0().message.type() != ERROR_MSG)
+    bool macValid =
+        !needsMacCheck(msg) ||
+        hmacSha256Verify(
+            msg.v0().mac, mRecvMacKey,
+            xdr::xdr_to_opaque(msg.v0().sequence, msg.v0().message));
+    recvMessage(msg, macValid, nullptr);
+}
+
+void
+Peer::recvMessage(AuthenticatedMessage const& msg, bool macValid,
+                  Hash const* floodHash)
+{
+    if (shouldAbort())
+    {
+        return;
+    }
+
+    if (needsMacCheck(msg))
     {
         if (msg.v0().sequence != mRecvMacSeq)
         {
@@ -572,9 +604,7 @@ Peer::recvMessage(AuthenticatedMessage const& msg)
             return;
         }
 
-        if (!hmacSha256Verify(
-                msg.v0().mac, mRecvMacKey,
-                xdr::xdr_to_opaque(msg.v0().sequence, msg.v0().message)))
+        if (!macValid)
         {
             CLOG(ERROR, "Overlay") << "Message-auth check failed";
             mDropInRecvMessageMacMeter.Mark();
@@ -584,11 +614,11 @@ Peer::recvMessage(AuthenticatedMessage const& msg)
         }
         ++mRecvMacSeq;
     }
-    recvMessage(msg.v0().message);
+    recvMessage(msg.v0().message, floodHash);
 }
 
 void
-Peer::recvMessage(StellarMessage const& stellarMsg)
+Peer::recvMessage(StellarMessage const& stellarMsg, Hash const* floodHash)
 {
     if (shouldAbort())
     {
@@ -677,7 +707,7 @@ Peer::recvMessage(StellarMessage const& stellarMsg)
     case TRANSACTION:
     {
         auto t = mRecvTransactionTimer.TimeScope();
-        recvTransaction(stellarMsg);
+        recvTransaction(stellarMsg, floodHash);
     }
     break;
 
@@ -698,7 +728,7 @@ Peer::recvMessage(StellarMessage const& stellarMsg)
     case SCP_MESSAGE:
     {
         auto t = mRecvSCPMessageTimer.TimeScope();
-        recvSCPMessage(stellarMsg);
+        recvSCPMessage(stellarMsg, floodHash);
     }
     break;
 
@@ -744,7 +774,21 @@ Peer::recvTxSet(StellarMessage const& msg)
 }
 
 void
-Peer::recvTransaction(StellarMessage const& msg)
+Peer::recvFloodedMsg(StellarMessage const& msg, Hash const* floodHash)
+{
+    if (floodHash)
+    {
+        mApp.getOverlayManager().recvFloodedMsg(msg, shared_from_this(),
+                                                *floodHash);
+    }
+    else
+    {
+        mApp.getOverlayManager().recvFloodedMsg(msg, shared_from_this());
+    }
+}
+
+void
+Peer::recvTransaction(StellarMessage const& msg, Hash const* floodHash)
 {
     TransactionFramePtr transaction = TransactionFrame::makeTransactionFromWire(
         mApp.getNetworkID(), msg.transaction());
@@ -758,7 +802,7 @@ Peer::recvTransaction(StellarMessage const& msg)
             recvRes == Herder::TX_STATUS_DUPLICATE)
         {
             // record that this peer sent us this transaction
-            mApp.getOverlayManager().recvFloodedMsg(msg, shared_from_this());
+            recvFloodedMsg(msg, floodHash);
 
             if (recvRes == Herder::TX_STATUS_PENDING)
             {
@@ -795,7 +839,7 @@ Peer::recvSCPQuorumSet(StellarMessage const& msg)
 }
 
 void
-Peer::recvSCPMessage(StellarMessage const& msg)
+Peer::recvSCPMessage(StellarMessage const& msg, Hash const* floodHash)
 {
     SCPEnvelope const& envelope = msg.envelope();
     if (Logging::logTrace("Overlay"))
@@ -803,7 +847,7 @@ Peer::recvSCPMessage(StellarMessage const& msg)
             << "recvSCPMessage node: "
             << mApp.getConfig().toShortString(msg.envelope().statement.nodeID);
 
-    mApp.getOverlayManager().recvFloodedMsg(msg, shared_from_this());
+    recvFloodedMsg(msg, floodHash);
 
     auto type = msg.envelope().statement.pledges.type();
     auto t = (type == SCP_ST_PREPARE
@@ -6,6 +6,7 @@
 
 #include "util/asio.h"
 #include "database/Database.h"
+#include "overlay/OutgoingMessage.h"
 #include "overlay/StellarXDR.h"
 #include "util/NonCopyable.h"
 #include "util/Timer.h"
@@ -136,10 +137,21 @@ class Peer : public std::enable_shared_from_this<Peer>,
     medida::Meter& mDropInRecvErrorMeter;
 
     bool shouldAbort() const;
-    void recvMessage(StellarMessage const& msg);
+    // `floodHash`, if set, is the hash of the XDR of a flooded message,
+    // computed while it was decoded
+    void recvMessage(StellarMessage const& msg,
+                     Hash const* floodHash = nullptr);
     void recvMessage(AuthenticatedMessage const& msg);
+    // `msg`, with its MAC already checked (see needsMacCheck) off the main
+    // thread
+    void recvMessage(AuthenticatedMessage const& msg, bool macValid,
+                     Hash const* floodHash);
     void recvMessage(xdr::msg_ptr const& xdrBytes);
 
+    // whether the MAC of `msg` must be checked in the current state
+    bool needsMacCheck(AuthenticatedMessage const& msg) const;
+    void recvFloodedMsg(StellarMessage const& msg, Hash const* floodHash);
+
     virtual void recvError(StellarMessage const& msg);
     // returns false if we should drop this peer
     void noteHandshakeSuccessInPeerRecord();
@@ -151,10 +163,10 @@ class Peer : public std::enable_shared_from_this<Peer>,
 
     void recvGetTxSet(StellarMessage const& msg);
     void recvTxSet(StellarMessage const& msg);
-    void recvTransaction(StellarMessage const& msg);
+    void recvTransaction(StellarMessage const& msg, Hash const* floodHash);
     void recvGetSCPQuorumSet(StellarMessage const& msg);
     void recvSCPQuorumSet(StellarMessage const& msg);
-    void recvSCPMessage(StellarMessage const& msg);
+    void recvSCPMessage(StellarMessage const& msg, Hash const* floodHash);
     void recvGetSCPState(StellarMessage const& msg);
 
     void sendHello();
@@ -165,12 +177,18 @@ class Peer : public std::enable_shared_from_this<Peer>,
 
     // NB: This is a move-argument because the write-buffer has to travel
     // with the write-request through the async IO system, and we might have
-    // several queued at once. We have carefully arranged this to not copy
-    // data more than the once necessary into this buffer, but it can't be
-    // put in a reused/non-owned buffer without having to buffer/queue
-    // messages somewhere else. The async write request will point _into_
-    // this owned buffer. This is really the best we can do.
-    virtual void sendMessage(xdr::msg_ptr&& xdrBytes) = 0;
+    // several queued at once. The serialized StellarMessage inside it is
+    // shared with every other peer the same message is being sent to; the
+    // async write request points _into_ it, so it is never copied.
+    virtual void sendMessage(OutgoingMessage&& msg) = 0;
+    // Whether a TRANSACTION about to be sent should be dropped instead,
+    // because the peer isn't keeping up; asked before the message is given
+    // a MAC sequence number.
+    virtual bool
+    shouldDropTransaction()
+    {
+        return false;
+    }
     virtual void
     connected()
     {
@@ -200,6 +218,10 @@ class Peer : public std::enable_shared_from_this<Peer>,
     void sendGetScpState(uint32 ledgerSeq);
 
     void sendMessage(StellarMessage const& msg);
+    // Send `msg`, already serialized as `body` by OutgoingMessage::serialize;
+    // lets a message sent to several peers be serialized only once.
+    void sendMessage(StellarMessage const& msg,
+                     OutgoingMessage::Body const& body);
 
     PeerRole
     getRole() const
@@ -269,6 +291,29 @@ class Peer : public std::enable_shared_from_this<Peer>,
     void drop(ErrorCode err, std::string const& msg);
     virtual void drop() = 0;
     virtual std::string getIP() = 0;
+
+    // Number of messages waiting to be written to the peer.
+    virtual size_t
+    getWriteQueueSize() const
+    {
+        return 0;
+    }
+
+    // Number of transactions not sent to the peer because it wasn't keeping
+    // up.
+    virtual uint64_t
+    getWriteQueueDrops() const
+    {
+        return 0;
+    }
+
+    // Number of messages read from the peer waiting to be decoded or
+    // processed.
+    virtual size_t
+    getIngressQueueSize() const
+    {
+        return 0;
+    }
     virtual ~Peer()
     {
     }
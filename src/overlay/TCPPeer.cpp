@@ -3,9 +3,11 @@
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
 #include "overlay/TCPPeer.h"
+#include "crypto/SHA.h"
 #include "database/Database.h"
 #include "main/Application.h"
 #include "main/Config.h"
+#include "medida/histogram.h"
 #include "medida/meter.h"
 #include "medida/metrics_registry.h"
 #include "overlay/LoadManager.h"
@@ -15,6 +17,7 @@
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
 #include "xdrpp/marshal.h"
+#include <mutex>
 
 using namespace soci;
 
@@ -23,14 +26,115 @@ namespace stellar
 
 using namespace std;
 
+// Limits on how much of the write queue goes into a single gather write; a
+// single message larger than MAX_WRITE_BATCH_BYTES is still written whole.
+static size_t const MAX_WRITE_BATCH_MESSAGES = 64;
+static size_t const MAX_WRITE_BATCH_BYTES = 256 * 1024;
+
+// Messages read from a peer and not processed yet above which reading from
+// it waits for the main thread to catch up.
+static size_t const MAX_INGRESS_MESSAGES = 256;
+
+struct TCPPeer::Ingress
+{
+    struct Message
+    {
+        AuthenticatedMessage mMessage;
+        bool mCorrupt{false};
+        std::string mError;
+        bool mMacValid{false};
+        bool mFlooded{false};
+        Hash mFloodHash;
+
+        // Decodes `body`, checks its MAC with `macKey` and hashes it if it
+        // is flooded. Runs on a worker thread.
+        void
+        decode(std::vector<uint8_t> const& body, HmacSha256Key const& macKey)
+        {
+            try
+            {
+                xdr::xdr_get g(body.data(), body.data() + body.size());
+                xdr::xdr_argpack_archive(g, mMessage);
+            }
+            catch (xdr::xdr_runtime_error& e)
+            {
+                mCorrupt = true;
+                mError = e.what();
+                return;
+            }
+
+            auto const& v0 = mMessage.v0();
+            // the peer is authenticated: every message but errors has a MAC
+            if (v0.message.type() != ERROR_MSG)
+            {
+                // the MAC is of the sequence and the message as sent, which
+                // is the body without the union discriminant and the MAC,
+                // unless there are bytes past the message
+                size_t const discriminantSize = 4;
+                size_t const macSize = v0.mac.mac.size();
+                if (xdr::xdr_size(mMessage) == body.size())
+                {
+                    mMacValid = hmacSha256Verify(
+                        v0.mac, macKey,
+                        ByteSlice(body.data() + discriminantSize,
+                                  body.size() - discriminantSize - macSize));
+                }
+                else
+                {
+                    mMacValid = hmacSha256Verify(
+                        v0.mac, macKey,
+                        xdr::xdr_to_opaque(v0.sequence, v0.message));
+                }
+            }
+            if (v0.message.type() == TRANSACTION ||
+                v0.message.type() == SCP_MESSAGE)
+            {
+                mFlooded = true;
+                mFloodHash = sha256(xdr::xdr_to_opaque(v0.message));
+            }
+        }
+    };
+
+    explicit Ingress(asio::io_service& workers) : mStrand(workers)
+    {
+    }
+
+    // decodes the messages of the peer one at a time, in order
+    asio::io_service::strand mStrand;
+
+    std::mutex mMutex;
+    std::vector<Message> mDecoded;
+    // whether processIngress is posted to the main thread already
+    bool mProcessPosted{false};
+};
+
 ///////////////////////////////////////////////////////////////////////
 // TCPPeer
 ///////////////////////////////////////////////////////////////////////
 
 TCPPeer::TCPPeer(Application& app, Peer::PeerRole role,
                  std::shared_ptr<TCPPeer::SocketType> socket)
-    : Peer(app, role), mSocket(socket)
+    : Peer(app, role)
+    , mSocket(socket)
+    , mWriteBatchMessagesHistogram(app.getMetrics().NewHistogram(
+          {"overlay", "write-batch", "messages"}))
+    , mWriteBatchBytesHistogram(
+          app.getMetrics().NewHistogram({"overlay", "write-batch", "bytes"}))
+    , mWriteQueueDepthHistogram(
+          app.getMetrics().NewHistogram({"overlay", "write-queue", "depth"}))
+    , mWriteQueueDropMeter(app.getMetrics().NewMeter(
+          {"overlay", "write-queue", "drop"}, "message"))
+    , mIngressQueueDepthHistogram(
+          app.getMetrics().NewHistogram({"overlay", "ingress-queue", "depth"}))
+    , mIngressBatchHistogram(app.getMetrics().NewHistogram(
+          {"overlay", "ingress-batch", "messages"}))
+    , mIngressPauseMeter(app.getMetrics().NewMeter(
+          {"overlay", "ingress-queue", "pause"}, "read"))
 {
+    if (app.getConfig().PEER_BACKGROUND_DECODE)
+    {
+        mIngress = make_shared<Ingress>(app.getWorkerIOService());
+    }
 }
 
 TCPPeer::pointer
@@ -120,19 +224,54 @@ TCPPeer::getIP()
     return mIP;
 }
 
+size_t
+TCPPeer::getWriteQueueSize() const
+{
+    return mWriteQueue.size();
+}
+
+uint64_t
+TCPPeer::getWriteQueueDrops() const
+{
+    return mWriteQueueDrops;
+}
+
+size_t
+TCPPeer::getIngressQueueSize() const
+{
+    return mIngressMessages;
+}
+
+bool
+TCPPeer::shouldDropTransaction()
+{
+    auto highWaterMark = mApp.getConfig().PEER_WRITE_QUEUE_HIGH_WATER_MARK;
+    if (highWaterMark != 0 && mWriteQueueBytes >= highWaterMark)
+    {
+        // the peer isn't keeping up: keep the queue for consensus traffic,
+        // transactions will reach it through other peers or be resent
+        mWriteQueueDrops++;
+        mWriteQueueDropMeter.Mark();
+        return true;
+    }
+    return false;
+}
+
 void
-TCPPeer::sendMessage(xdr::msg_ptr&& xdrBytes)
+TCPPeer::sendMessage(OutgoingMessage&& msg)
 {
     if (Logging::logTrace("Overlay"))
         CLOG(TRACE, "Overlay") << "TCPPeer:sendMessage to " << toString();
     assertThreadIsMain();
 
-    // places the buffer to write into the write queue
-    auto buf = std::make_shared<xdr::msg_ptr>(std::move(xdrBytes));
-
     auto self = static_pointer_cast<TCPPeer>(shared_from_this());
 
-    self->mWriteQueue.emplace(buf);
+    // places the message to write into the write queue; elements of the
+    // queue don't move while it grows, so the ones at the front can be
+    // written from
+    self->mWriteQueueBytes += msg.getSize();
+    self->mWriteQueue.emplace_back(std::move(msg));
+    mWriteQueueDepthHistogram.Update(mWriteQueue.size());
 
     if (!self->mWriting)
     {
@@ -169,23 +308,47 @@ TCPPeer::messageSender()
         return;
     }
 
-    // peek the buffer from the queue
-    // do not remove it yet as we need the buffer for the duration of the
-    // write operation
-    auto buf = mWriteQueue.front();
-
-    asio::async_write(*(mSocket.get()),
-                      asio::buffer((*buf)->raw_data(), (*buf)->raw_size()),
-                      [self](asio::error_code const& ec, std::size_t length) {
-                          self->writeHandler(ec, length);
-                          self->mWriteQueue.pop(); // done with front element
-
-                          // continue processing the queue/flush
-                          if (!ec)
-                          {
-                              self->messageSender();
-                          }
-                      });
+    // gather as many queued messages as the batch limits allow into a
+    // single write; do not remove them from the queue yet as we need their
+    // buffers for the duration of the write operation
+    mWriteBuffers.clear();
+    mWriteBatchMessages = 0;
+    size_t batchBytes = 0;
+    auto n = std::min(mWriteQueue.size(), MAX_WRITE_BATCH_MESSAGES);
+    for (size_t i = 0; i < n; ++i)
+    {
+        auto const& msg = mWriteQueue.at(i);
+        if (i != 0 && batchBytes + msg.getSize() > MAX_WRITE_BATCH_BYTES)
+        {
+            break;
+        }
+        auto buffers = msg.getBuffers();
+        mWriteBuffers.insert(mWriteBuffers.end(), buffers.begin(),
+                             buffers.end());
+        batchBytes += msg.getSize();
+        ++mWriteBatchMessages;
+    }
+    mWriteBatchMessagesHistogram.Update(mWriteBatchMessages);
+    mWriteBatchBytesHistogram.Update(batchBytes);
+
+    asio::async_write(
+        *(mSocket.get()), mWriteBuffers,
+        [self](asio::error_code const& ec, std::size_t length) {
+            self->writeHandler(ec, length);
+            // done with the messages of the batch
+            for (size_t i = 0; i < self->mWriteBatchMessages; ++i)
+            {
+                self->mWriteQueueBytes -= self->mWriteQueue.front().getSize();
+                self->mWriteQueue.pop_front();
+            }
+            self->mWriteBatchMessages = 0;
+
+            // continue processing the queue/flush
+            if (!ec)
+            {
+                self->messageSender();
+            }
+        });
 }
 
 void
@@ -210,7 +373,8 @@ TCPPeer::writeHandler(asio::error_code const& error,
     else if (bytes_transferred != 0)
     {
         LoadManager::PeerContext loadCtx(mApp, mPeerID);
-        mMessageWrite.Mark();
+        // one write carries a whole batch of messages
+        mMessageWrite.Mark(mWriteBatchMessages);
         mByteWrite.Mark(bytes_transferred);
     }
 }
@@ -326,8 +490,24 @@ TCPPeer::readBodyHandler(asio::error_code const& error,
     if (!error)
     {
         receivedBytes(bytes_transferred, true);
-        recvMessage();
-        mIncomingHeader.clear();
+        if (mIngress && isAuthenticated())
+        {
+            // the MAC key is set for good once authenticated, so messages
+            // can be decoded and checked ahead of being processed
+            decodeInBackground();
+            mIncomingHeader.clear();
+            if (mIngressMessages >= MAX_INGRESS_MESSAGES)
+            {
+                mReadPaused = true;
+                mIngressPauseMeter.Mark();
+                return;
+            }
+        }
+        else
+        {
+            recvMessage();
+            mIncomingHeader.clear();
+        }
         startRead();
     }
     else
@@ -364,6 +544,81 @@ TCPPeer::recvMessage()
     }
 }
 
+void
+TCPPeer::decodeInBackground()
+{
+    assertThreadIsMain();
+    auto body = make_shared<std::vector<uint8_t>>();
+    body->swap(mIncomingBody);
+    auto ingress = mIngress;
+    auto macKey = mRecvMacKey;
+    // the last reference to a peer must be released on the main thread
+    std::weak_ptr<TCPPeer> weak =
+        static_pointer_cast<TCPPeer>(shared_from_this());
+    auto mainIO = &mApp.getClock().getIOService();
+
+    ++mIngressMessages;
+    mIngressQueueDepthHistogram.Update(mIngressMessages);
+
+    ingress->mStrand.post([ingress, body, macKey, weak, mainIO]() {
+        Ingress::Message msg;
+        msg.decode(*body, macKey);
+        bool post;
+        {
+            std::lock_guard<std::mutex> lock(ingress->mMutex);
+            ingress->mDecoded.emplace_back(std::move(msg));
+            post = !ingress->mProcessPosted;
+            ingress->mProcessPosted = true;
+        }
+        // messages decoded while this is pending are processed with it
+        if (post)
+        {
+            mainIO->post([weak]() {
+                if (auto self = weak.lock())
+                {
+                    self->processIngress();
+                }
+            });
+        }
+    });
+}
+
+void
+TCPPeer::processIngress()
+{
+    assertThreadIsMain();
+    std::vector<Ingress::Message> batch;
+    {
+        std::lock_guard<std::mutex> lock(mIngress->mMutex);
+        batch.swap(mIngress->mDecoded);
+        mIngress->mProcessPosted = false;
+    }
+    mIngressBatchHistogram.Update(batch.size());
+
+    for (auto const& msg : batch)
+    {
+        --mIngressMessages;
+        if (msg.mCorrupt)
+        {
+            if (!shouldAbort())
+            {
+                CLOG(ERROR, "Overlay")
+                    << "recvMessage got a corrupt xdr: " << msg.mError;
+                Peer::drop(ERR_DATA, "received corrupt XDR");
+            }
+            continue;
+        }
+        Peer::recvMessage(msg.mMessage, msg.mMacValid,
+                          msg.mFlooded ? &msg.mFloodHash : nullptr);
+    }
+
+    if (mReadPaused && mIngressMessages < MAX_INGRESS_MESSAGES)
+    {
+        mReadPaused = false;
+        startRead();
+    }
+}
+
 void
 TCPPeer::drop()
 {
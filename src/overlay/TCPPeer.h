@@ -6,10 +6,11 @@
 
 #include "overlay/Peer.h"
 #include "util/Timer.h"
-#include <queue>
+#include <deque>
 
 namespace medida
 {
+class Histogram;
 class Meter;
 }
 
@@ -31,11 +32,41 @@ class TCPPeer : public Peer
     std::vector<uint8_t> mIncomingHeader;
     std::vector<uint8_t> mIncomingBody;
 
-    std::queue<std::shared_ptr<xdr::msg_ptr>> mWriteQueue;
+    std::deque<OutgoingMessage> mWriteQueue;
+    size_t mWriteQueueBytes{0};
+    uint64_t mWriteQueueDrops{0};
     bool mWriting{false};
+    // buffers of the messages at the front of mWriteQueue being written;
+    // reused between writes
+    std::vector<asio::const_buffer> mWriteBuffers;
+    size_t mWriteBatchMessages{0};
+
+    medida::Histogram& mWriteBatchMessagesHistogram;
+    medida::Histogram& mWriteBatchBytesHistogram;
+    medida::Histogram& mWriteQueueDepthHistogram;
+    medida::Meter& mWriteQueueDropMeter;
+
+    // Messages decoded on the worker threads (see PEER_BACKGROUND_DECODE),
+    // shared with the jobs decoding them; null if messages are decoded on
+    // the main thread.
+    struct Ingress;
+    std::shared_ptr<Ingress> mIngress;
+    // messages read and not processed yet; reading is paused while there
+    // are too many
+    size_t mIngressMessages{0};
+    bool mReadPaused{false};
+
+    medida::Histogram& mIngressQueueDepthHistogram;
+    medida::Histogram& mIngressBatchHistogram;
+    medida::Meter& mIngressPauseMeter;
 
     void recvMessage();
-    void sendMessage(xdr::msg_ptr&& xdrBytes) override;
+    // hands mIncomingBody to the worker threads to decode
+    void decodeInBackground();
+    // processes the messages decoded so far, in the order they were read
+    void processIngress();
+    bool shouldDropTransaction() override;
+    void sendMessage(OutgoingMessage&& msg) override;
 
     void messageSender();
 
@@ -67,5 +98,8 @@ class TCPPeer : public Peer
 
     virtual void drop() override;
     virtual std::string getIP() override;
+    virtual size_t getWriteQueueSize() const override;
+    virtual uint64_t getWriteQueueDrops() const override;
+    virtual size_t getIngressQueueSize() const override;
 };
 }
@@ -0,0 +1,305 @@
+// Copyright 2017 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "scp/QuorumEvaluator.h"
+#include "scp/LocalNode.h"
+
+#include <algorithm>
+#include <bitset>
+
+namespace stellar
+{
+
+size_t const QuorumEvaluator::MAX_CACHED_QUORUM_SETS;
+
+void
+NodeBitSet::set(size_t i)
+{
+    size_t w = i / 64;
+    if (w >= mWords.size())
+    {
+        mWords.resize(w + 1, 0);
+    }
+    mWords[w] |= uint64_t(1) << (i % 64);
+}
+
+void
+NodeBitSet::reset(size_t i)
+{
+    size_t w = i / 64;
+    if (w < mWords.size())
+    {
+        mWords[w] &= ~(uint64_t(1) << (i % 64));
+    }
+}
+
+bool
+NodeBitSet::test(size_t i) const
+{
+    size_t w = i / 64;
+    return w < mWords.size() && (mWords[w] & (uint64_t(1) << (i % 64))) != 0;
+}
+
+void
+NodeBitSet::clear()
+{
+    std::fill(mWords.begin(), mWords.end(), 0);
+}
+
+size_t
+NodeBitSet::countCommon(NodeBitSet const& other) const
+{
+    size_t n = std::min(mWords.size(), other.mWords.size());
+    size_t res = 0;
+    for (size_t i = 0; i < n; ++i)
+    {
+        auto w = mWords[i] & other.mWords[i];
+        if (w)
+        {
+            res += std::bitset<64>(w).count();
+        }
+    }
+    return res;
+}
+
+CompiledQuorumSet::CompiledQuorumSet(
+    SCPQuorumSet const& qSet,
+    std::function<size_t(NodeID const&)> const& nodeIndex)
+{
+    compile(qSet, nodeIndex);
+}
+
+size_t
+CompiledQuorumSet::compile(
+    SCPQuorumSet const& qSet,
+    std::function<size_t(NodeID const&)> const& nodeIndex)
+{
+    size_t res = mLevels.size();
+    mLevels.emplace_back();
+    {
+        auto& level = mLevels.back();
+        level.mThreshold = qSet.threshold;
+        level.mEntries = qSet.validators.size() + qSet.innerSets.size();
+        for (auto const& v : qSet.validators)
+        {
+            auto i = nodeIndex(v);
+            if (level.mValidators.test(i))
+            {
+                level.mRepeated.emplace_back(i);
+            }
+            else
+            {
+                level.mValidators.set(i);
+            }
+        }
+    }
+
+    // mLevels may be reallocated while compiling inner sets
+    std::vector<size_t> inner;
+    inner.reserve(qSet.innerSets.size());
+    for (auto const& q : qSet.innerSets)
+    {
+        inner.emplace_back(compile(q, nodeIndex));
+    }
+    mLevels[res].mInnerSets = std::move(inner);
+    return res;
+}
+
+size_t
+CompiledQuorumSet::countAt(Level const& level, NodeBitSet const& nodes) const
+{
+    size_t res = level.mValidators.countCommon(nodes);
+    for (auto i : level.mRepeated)
+    {
+        if (nodes.test(i))
+        {
+            res++;
+        }
+    }
+    return res;
+}
+
+bool
+CompiledQuorumSet::isQuorumSliceAt(size_t l, NodeBitSet const& nodes) const
+{
+    auto const& level = mLevels[l];
+    // like LocalNode::isQuorumSliceInternal, a threshold of 0 is never met
+    if (level.mThreshold == 0)
+    {
+        return false;
+    }
+
+    size_t count = countAt(level, nodes);
+    for (auto it = level.mInnerSets.begin();
+         count < level.mThreshold && it != level.mInnerSets.end(); ++it)
+    {
+        if (isQuorumSliceAt(*it, nodes))
+        {
+            count++;
+        }
+    }
+    return count >= level.mThreshold;
+}
+
+bool
+CompiledQuorumSet::isVBlockingAt(size_t l, NodeBitSet const& nodes) const
+{
+    auto const& level = mLevels[l];
+    // There is no v-blocking set for {\empty}
+    if (level.mThreshold == 0)
+    {
+        return false;
+    }
+
+    // at least one entry is needed even when the threshold is out of range,
+    // as in LocalNode::isVBlockingInternal
+    size_t needed = 1;
+    if (level.mEntries + 1 > level.mThreshold)
+    {
+        needed = level.mEntries + 1 - level.mThreshold;
+    }
+
+    size_t count = countAt(level, nodes);
+    for (auto it = level.mInnerSets.begin();
+         count < needed && it != level.mInnerSets.end(); ++it)
+    {
+        if (isVBlockingAt(*it, nodes))
+        {
+            count++;
+        }
+    }
+    return count >= needed;
+}
+
+bool
+CompiledQuorumSet::isQuorumSlice(NodeBitSet const& nodes) const
+{
+    return isQuorumSliceAt(0, nodes);
+}
+
+bool
+CompiledQuorumSet::isVBlocking(NodeBitSet const& nodes) const
+{
+    return isVBlockingAt(0, nodes);
+}
+
+size_t
+QuorumEvaluator::getNodeIndex(NodeID const& nodeID)
+{
+    return mNodeIndex.emplace(nodeID, mNodeIndex.size()).first->second;
+}
+
+CompiledQuorumSetPtr
+QuorumEvaluator::getQuorumSet(Hash const& qSetHash, SCPQuorumSet const& qSet)
+{
+    auto& res = mQuorumSets[qSetHash];
+    if (!res)
+    {
+        res = std::make_shared<CompiledQuorumSet>(
+            qSet, [this](NodeID const& n) { return getNodeIndex(n); });
+    }
+    return res;
+}
+
+CompiledQuorumSetPtr
+QuorumEvaluator::findQuorumSet(Hash const& qSetHash) const
+{
+    auto it = mQuorumSets.find(qSetHash);
+    return it == mQuorumSets.end() ? nullptr : it->second;
+}
+
+CompiledQuorumSetPtr
+QuorumEvaluator::getSingletonQuorumSet(NodeID const& nodeID)
+{
+    auto& res = mSingletons[nodeID];
+    if (!res)
+    {
+        res = std::make_shared<CompiledQuorumSet>(
+            *LocalNode::getSingletonQSet(nodeID),
+            [this](NodeID const& n) { return getNodeIndex(n); });
+    }
+    return res;
+}
+
+void
+QuorumEvaluator::collect(
+    std::map<NodeID, SCPEnvelope> const& map,
+    std::function<bool(SCPStatement const&)> const& filter)
+{
+    mNodes.clear();
+    mMembers.clear();
+    for (auto const& it : map)
+    {
+        if (filter(it.second.statement))
+        {
+            auto i = getNodeIndex(it.first);
+            mNodes.set(i);
+            mMembers.push_back(Member{i, &it.second.statement, nullptr});
+        }
+    }
+}
+
+bool
+QuorumEvaluator::isVBlocking(
+    CompiledQuorumSet const& qSet, std::map<NodeID, SCPEnvelope> const& map,
+    std::function<bool(SCPStatement const&)> const& filter)
+{
+    collect(map, filter);
+    return qSet.isVBlocking(mNodes);
+}
+
+bool
+QuorumEvaluator::isQuorum(
+    CompiledQuorumSet const& qSet, std::map<NodeID, SCPEnvelope> const& map,
+    std::function<CompiledQuorumSetPtr(SCPStatement const&)> const& qfun,
+    std::function<bool(SCPStatement const&)> const& filter)
+{
+    collect(map, filter);
+    for (auto& m : mMembers)
+    {
+        m.mQSet = qfun(*m.mStatement);
+    }
+
+    // remove the nodes whose slices are not within the set until nothing
+    // changes: the greatest fixed point doesn't depend on the order nodes
+    // are looked at, so they can be removed as soon as they are found
+    bool changed;
+    do
+    {
+        changed = false;
+        size_t i = 0;
+        while (i < mMembers.size())
+        {
+            auto const& m = mMembers[i];
+            if (!m.mQSet || !m.mQSet->isQuorumSlice(mNodes))
+            {
+                mNodes.reset(m.mIndex);
+                mMembers[i] = std::move(mMembers.back());
+                mMembers.pop_back();
+                changed = true;
+            }
+            else
+            {
+                ++i;
+            }
+        }
+    } while (changed);
+
+    bool res = qSet.isQuorumSlice(mNodes);
+    mMembers.clear();
+    return res;
+}
+
+void
+QuorumEvaluator::trim()
+{
+    if (getCachedQuorumSetCount() > MAX_CACHED_QUORUM_SETS)
+    {
+        mQuorumSets.clear();
+        mSingletons.clear();
+        mNodeIndex.clear();
+        mNodes = NodeBitSet();
+    }
+}
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+// Copyright 2017 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "crypto/SecretKey.h"
+#include "util/HashOfHash.h"
+#include "xdr/Stellar-SCP.h"
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace stellar
+{
+
+/**
+ * Set of nodes, as a bitset over the dense node numbers handed out by a
+ * QuorumEvaluator.
+ */
+class NodeBitSet
+{
+    std::vector<uint64_t> mWords;
+
+  public:
+    void set(size_t i);
+    void reset(size_t i);
+    bool test(size_t i) const;
+    void clear();
+
+    // number of nodes in both this set and `other`
+    size_t countCommon(NodeBitSet const& other) const;
+};
+
+/**
+ * A quorum set with its nodes replaced by their numbers, so that slice and
+ * v-blocking checks are a few masked popcounts per level instead of searches
+ * through lists of node IDs.
+ *
+ * Gives the same answers as LocalNode::isQuorumSlice and
+ * LocalNode::isVBlocking on the quorum set it was built from.
+ */
+class CompiledQuorumSet
+{
+    struct Level
+    {
+        uint32 mThreshold;
+        // validators + inner sets, as listed in the quorum set
+        size_t mEntries;
+        NodeBitSet mValidators;
+        // validators listed more than once at this level, which count once
+        // per listing (sane quorum sets have none)
+        std::vector<size_t> mRepeated;
+        // indices into mLevels
+        std::vector<size_t> mInnerSets;
+    };
+
+    // mLevels[0] is the top level
+    std::vector<Level> mLevels;
+
+    size_t compile(SCPQuorumSet const& qSet,
+                   std::function<size_t(NodeID const&)> const& nodeIndex);
+    size_t countAt(Level const& level, NodeBitSet const& nodes) const;
+    bool isQuorumSliceAt(size_t level, NodeBitSet const& nodes) const;
+    bool isVBlockingAt(size_t level, NodeBitSet const& nodes) const;
+
+  public:
+    CompiledQuorumSet(SCPQuorumSet const& qSet,
+                      std::function<size_t(NodeID const&)> const& nodeIndex);
+
+    bool isQuorumSlice(NodeBitSet const& nodes) const;
+    bool isVBlocking(NodeBitSet const& nodes) const;
+};
+
+typedef std::shared_ptr<CompiledQuorumSet const> CompiledQuorumSetPtr;
+
+/**
+ * Numbers nodes, keeps the compiled form of every quorum set seen (by hash)
+ * and runs the federated voting checks of LocalNode on them.
+ *
+ * One instance is owned by SCP and shared by its slots.
+ */
+class QuorumEvaluator
+{
+    std::unordered_map<NodeID, size_t> mNodeIndex;
+    std::unordered_map<Hash, CompiledQuorumSetPtr> mQuorumSets;
+    std::unordered_map<NodeID, CompiledQuorumSetPtr> mSingletons;
+
+    struct Member
+    {
+        size_t mIndex;
+        SCPStatement const* mStatement;
+        CompiledQuorumSetPtr mQSet;
+    };
+
+    // scratch space of isVBlocking and isQuorum
+    NodeBitSet mNodes;
+    std::vector<Member> mMembers;
+
+    void collect(std::map<NodeID, SCPEnvelope> const& map,
+                 std::function<bool(SCPStatement const&)> const& filter);
+
+  public:
+    // compiled quorum sets are dropped, and node numbers reassigned, once
+    // more than this many quorum sets are cached
+    static size_t const MAX_CACHED_QUORUM_SETS = 1000;
+
+    size_t getNodeIndex(NodeID const& nodeID);
+
+    // compiled form of `qSet`, whose hash is `qSetHash`
+    CompiledQuorumSetPtr getQuorumSet(Hash const& qSetHash,
+                                      SCPQuorumSet const& qSet);
+    // compiled form of the quorum set with hash `qSetHash` if it has been
+    // compiled already, nullptr otherwise
+    CompiledQuorumSetPtr findQuorumSet(Hash const& qSetHash) const;
+    // compiled form of {{nodeID}}
+    CompiledQuorumSetPtr getSingletonQuorumSet(NodeID const& nodeID);
+
+    // Same as LocalNode::isVBlocking and LocalNode::isQuorum; `qfun` is
+    // called once per node passing `filter`.
+    bool isVBlocking(CompiledQuorumSet const& qSet,
+                     std::map<NodeID, SCPEnvelope> const& map,
+                     std::function<bool(SCPStatement const&)> const& filter);
+    bool isQuorum(
+        CompiledQuorumSet const& qSet, std::map<NodeID, SCPEnvelope> const& map,
+        std::function<CompiledQuorumSetPtr(SCPStatement const&)> const& qfun,
+        std::function<bool(SCPStatement const&)> const& filter);
+
+    // Drops everything if the cache grew past MAX_CACHED_QUORUM_SETS. Must
+    // not be called while compiled quorum sets are in use.
+    void trim();
+
+    size_t
+    getCachedQuorumSetCount() const
+    {
+        return mQuorumSets.size() + mSingletons.size();
+    }
+};
+}
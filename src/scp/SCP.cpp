@@ -90,6 +90,7 @@ SCP::purgeSlots(uint64 maxSlotIndex)
             ++it;
         }
     }
+    mQuorumEvaluator.trim();
 }
 
 std::shared_ptr<LocalNode>
@@ -12,6 +12,7 @@
 
 #include "crypto/SecretKey.h"
 #include "lib/json/json-forwards.h"
+#include "scp/QuorumEvaluator.h"
 #include "scp/SCPDriver.h"
 
 namespace stellar
@@ -76,6 +77,13 @@ class SCP
     // returns the local node descriptor
     std::shared_ptr<LocalNode> getLocalNode();
 
+    // compiled quorum sets, shared by all slots
+    QuorumEvaluator&
+    getQuorumEvaluator()
+    {
+        return mQuorumEvaluator;
+    }
+
     void dumpInfo(Json::Value& ret, size_t limit);
 
     // summary: only return object counts
@@ -136,6 +144,7 @@ class SCP
   protected:
     std::shared_ptr<LocalNode> mLocalNode;
     std::map<uint64, std::shared_ptr<Slot>> mKnownSlots;
+    QuorumEvaluator mQuorumEvaluator;
 
     // Slot getter
     std::shared_ptr<Slot> getSlot(uint64 slotIndex, bool create);
@@ -1,6 +1,12 @@
+#include "crypto/SHA.h"
 #include "lib/catch.hpp"
 #include "scp/LocalNode.h"
+#include "scp/QuorumEvaluator.h"
 #include "simulation/Simulation.h"
+#include "util/Logging.h"
+#include "util/Math.h"
+#include "xdrpp/marshal.h"
+#include <chrono>
 
 namespace stellar
 {
@@ -44,4 +50,182 @@ TEST_CASE("nomination weight", "[scp]")
 
     REQUIRE(isNear(result, .6 * .5));
 }
-}
\ No newline at end of file
+
+static std::vector<NodeID>
+makeNodeIDs(size_t n)
+{
+    std::vector<NodeID> res;
+    for (size_t i = 0; i < n; ++i)
+    {
+        auto seed = sha256("NODE_SEED_" + std::to_string(i));
+        res.emplace_back(SecretKey::fromSeed(seed).getPublicKey());
+    }
+    return res;
+}
+
+static SCPQuorumSet
+makeRandomQSet(std::vector<NodeID> const& nodes, int depth)
+{
+    SCPQuorumSet res;
+    auto nValidators = rand_uniform<size_t>(depth == 0 ? 1 : 0, 6);
+    for (size_t i = 0; i < nValidators; ++i)
+    {
+        // repeats are possible, and must count as many times as they are
+        // listed
+        res.validators.emplace_back(rand_element(nodes));
+    }
+    if (depth < 2)
+    {
+        auto nInner = rand_uniform<size_t>(0, 3);
+        for (size_t i = 0; i < nInner; ++i)
+        {
+            res.innerSets.emplace_back(makeRandomQSet(nodes, depth + 1));
+        }
+    }
+    auto entries = res.validators.size() + res.innerSets.size();
+    res.threshold = rand_uniform<uint32>(0, static_cast<uint32>(entries));
+    return res;
+}
+
+static SCPEnvelope
+makePrepare(NodeID const& nodeID, Hash const& qSetHash, uint32 counter)
+{
+    SCPEnvelope env;
+    env.statement.nodeID = nodeID;
+    env.statement.pledges.type(SCP_ST_PREPARE);
+    env.statement.pledges.prepare().quorumSetHash = qSetHash;
+    env.statement.pledges.prepare().ballot.counter = counter;
+    return env;
+}
+
+TEST_CASE("compiled quorum sets", "[scp]")
+{
+    auto nodes = makeNodeIDs(20);
+    QuorumEvaluator qe;
+
+    for (int iter = 0; iter < 200; ++iter)
+    {
+        std::vector<SCPQuorumSetPtr> qSets;
+        std::map<Hash, SCPQuorumSetPtr> byHash;
+        std::vector<Hash> hashes;
+        for (int i = 0; i < 5; ++i)
+        {
+            auto q = std::make_shared<SCPQuorumSet>(makeRandomQSet(nodes, 0));
+            auto h = sha256(xdr::xdr_to_opaque(*q));
+            qSets.emplace_back(q);
+            byHash[h] = q;
+            hashes.emplace_back(h);
+        }
+        // a quorum set nobody knows about
+        hashes.emplace_back(sha256("unknown"));
+
+        std::map<NodeID, SCPEnvelope> envs;
+        std::vector<NodeID> nodeSet;
+        for (auto const& n : nodes)
+        {
+            if (rand_flip())
+            {
+                envs[n] = makePrepare(n, rand_element(hashes),
+                                      rand_uniform<uint32>(0, 3));
+                nodeSet.emplace_back(n);
+            }
+        }
+
+        auto filter = [](SCPStatement const& st) {
+            return st.pledges.prepare().ballot.counter >= 1;
+        };
+        auto qfun = [&](SCPStatement const& st) -> SCPQuorumSetPtr {
+            auto it = byHash.find(st.pledges.prepare().quorumSetHash);
+            return it == byHash.end() ? nullptr : it->second;
+        };
+        auto compiledQfun =
+            [&](SCPStatement const& st) -> CompiledQuorumSetPtr {
+            auto const& h = st.pledges.prepare().quorumSetHash;
+            auto it = byHash.find(h);
+            return it == byHash.end() ? nullptr
+                                      : qe.getQuorumSet(h, *it->second);
+        };
+
+        NodeBitSet bits;
+        for (auto const& n : nodeSet)
+        {
+            bits.set(qe.getNodeIndex(n));
+        }
+
+        for (auto const& q : qSets)
+        {
+            auto c = qe.getQuorumSet(sha256(xdr::xdr_to_opaque(*q)), *q);
+            REQUIRE(c->isQuorumSlice(bits) ==
+                    LocalNode::isQuorumSlice(*q, nodeSet));
+            REQUIRE(c->isVBlocking(bits) ==
+                    LocalNode::isVBlocking(*q, nodeSet));
+            REQUIRE(qe.isVBlocking(*c, envs, filter) ==
+                    LocalNode::isVBlocking(*q, envs, filter));
+            REQUIRE(qe.isQuorum(*c, envs, compiledQfun, filter) ==
+                    LocalNode::isQuorum(*q, envs, qfun, filter));
+        }
+        qe.trim();
+    }
+}
+
+TEST_CASE("quorum evaluation benchmark", "[scp][bench][hide]")
+{
+    // 8 organizations of 5 validators, any 6 organizations with 3 validators
+    // each
+    auto nodes = makeNodeIDs(40);
+    auto qSet = std::make_shared<SCPQuorumSet>();
+    qSet->threshold = 6;
+    for (size_t org = 0; org < 8; ++org)
+    {
+        SCPQuorumSet inner;
+        inner.threshold = 3;
+        for (size_t i = 0; i < 5; ++i)
+        {
+            inner.validators.emplace_back(nodes[org * 5 + i]);
+        }
+        qSet->innerSets.emplace_back(inner);
+    }
+    auto qSetHash = sha256(xdr::xdr_to_opaque(*qSet));
+
+    std::map<NodeID, SCPEnvelope> envs;
+    for (size_t i = 0; i < nodes.size(); ++i)
+    {
+        // a quarter of the nodes is behind
+        envs[nodes[i]] = makePrepare(nodes[i], qSetHash, i % 4 == 0 ? 1 : 2);
+    }
+    auto filter = [](SCPStatement const& st) {
+        return st.pledges.prepare().ballot.counter >= 2;
+    };
+
+    QuorumEvaluator qe;
+    auto compiled = qe.getQuorumSet(qSetHash, *qSet);
+
+    size_t const n = 10000;
+    auto measure = [&](std::string const& name, std::function<bool()> f) {
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < n; ++i)
+        {
+            REQUIRE(f());
+        }
+        auto secs = std::chrono::duration<double>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+        LOG(INFO) << name << ": " << (secs * 1e6 / n) << "us per call";
+    };
+
+    measure("LocalNode::isQuorum", [&]() {
+        return LocalNode::isQuorum(
+            *qSet, envs, [&](SCPStatement const&) { return qSet; }, filter);
+    });
+    measure("QuorumEvaluator::isQuorum", [&]() {
+        return qe.isQuorum(*compiled, envs,
+                           [&](SCPStatement const&) { return compiled; },
+                           filter);
+    });
+    measure("LocalNode::isVBlocking", [&]() {
+        return LocalNode::isVBlocking(*qSet, envs, filter);
+    });
+    measure("QuorumEvaluator::isVBlocking",
+            [&]() { return qe.isVBlocking(*compiled, envs, filter); });
+}
+}
@@ -292,6 +292,28 @@ Slot::getQuorumSetFromStatement(SCPStatement const& st)
     return res;
 }
 
+CompiledQuorumSetPtr
+Slot::getCompiledQuorumSetFromStatement(SCPStatement const& st)
+{
+    auto& qe = mSCP.getQuorumEvaluator();
+    if (st.pledges.type() == SCP_ST_EXTERNALIZE)
+    {
+        return qe.getSingletonQuorumSet(st.nodeID);
+    }
+
+    Hash h = getCompanionQuorumSetHashFromStatement(st);
+    auto res = qe.findQuorumSet(h);
+    if (!res)
+    {
+        auto qSet = getSCPDriver().getQSet(h);
+        if (qSet)
+        {
+            res = qe.getQuorumSet(h, *qSet);
+        }
+    }
+    return res;
+}
+
 void
 Slot::dumpInfo(Json::Value& ret)
 {
@@ -342,7 +364,7 @@ Slot::federatedAccept(StatementPredicate voted, StatementPredicate accepted,
 {
     // Checks if the nodes that claimed to accept the statement form a
     // v-blocking set
-    if (LocalNode::isVBlocking(getLocalNode()->getQuorumSet(), envs, accepted))
+    if (isVBlocking(envs, accepted))
     {
         return true;
     }
@@ -355,10 +377,7 @@ Slot::federatedAccept(StatementPredicate voted, StatementPredicate accepted,
         return res;
     };
 
-    if (LocalNode::isQuorum(
-            getLocalNode()->getQuorumSet(), envs,
-            std::bind(&Slot::getQuorumSetFromStatement, this, _1),
-            ratifyFilter))
+    if (isQuorum(envs, ratifyFilter))
     {
         return true;
     }
@@ -370,9 +389,31 @@ bool
 Slot::federatedRatify(StatementPredicate voted,
                       std::map<NodeID, SCPEnvelope> const& envs)
 {
-    return LocalNode::isQuorum(
-        getLocalNode()->getQuorumSet(), envs,
-        std::bind(&Slot::getQuorumSetFromStatement, this, _1), voted);
+    return isQuorum(envs, voted);
+}
+
+bool
+Slot::isVBlocking(std::map<NodeID, SCPEnvelope> const& envs,
+                  StatementPredicate filter)
+{
+    auto localNode = getLocalNode();
+    auto& qe = mSCP.getQuorumEvaluator();
+    auto qSet = qe.getQuorumSet(localNode->getQuorumSetHash(),
+                                localNode->getQuorumSet());
+    return qe.isVBlocking(*qSet, envs, filter);
+}
+
+bool
+Slot::isQuorum(std::map<NodeID, SCPEnvelope> const& envs,
+               StatementPredicate filter)
+{
+    auto localNode = getLocalNode();
+    auto& qe = mSCP.getQuorumEvaluator();
+    auto qSet = qe.getQuorumSet(localNode->getQuorumSetHash(),
+                                localNode->getQuorumSet());
+    return qe.isQuorum(
+        *qSet, envs,
+        std::bind(&Slot::getCompiledQuorumSetFromStatement, this, _1), filter);
 }
 
 std::shared_ptr<LocalNode>
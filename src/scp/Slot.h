@@ -144,6 +144,9 @@ class Slot : public std::enable_shared_from_this<Slot>
     // returns the QuorumSet that should be used for a node given the
     // statement (singleton for externalize)
     SCPQuorumSetPtr getQuorumSetFromStatement(SCPStatement const& st);
+    // same as getQuorumSetFromStatement, compiled
+    CompiledQuorumSetPtr
+    getCompiledQuorumSetFromStatement(SCPStatement const& st);
 
     // wraps a statement in an envelope (sign it, etc)
     SCPEnvelope createEnvelope(SCPStatement const& statement);
@@ -159,6 +162,13 @@ class Slot : public std::enable_shared_from_this<Slot>
     bool federatedRatify(StatementPredicate voted,
                          std::map<NodeID, SCPEnvelope> const& envs);
 
+    // LocalNode::isVBlocking and LocalNode::isQuorum for the local quorum
+    // set, evaluated on compiled quorum sets
+    bool isVBlocking(std::map<NodeID, SCPEnvelope> const& envs,
+                     StatementPredicate filter);
+    bool isQuorum(std::map<NodeID, SCPEnvelope> const& envs,
+                  StatementPredicate filter);
+
     std::shared_ptr<LocalNode> getLocalNode();
 
     enum timerIDs
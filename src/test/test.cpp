@@ -85,6 +85,9 @@ getTestConfig(int instanceNumber, Config::TestDbMode mode)
 
         thisConfig.ALLOW_LOCALHOST_FOR_TESTING = true;
 
+        // tests trim history explicitly when they want to
+        thisConfig.AUTOMATIC_MAINTENANCE_PERIOD = std::chrono::seconds{0};
+
         // Tests are run in standalone by default, meaning that no external
         // listening interfaces are opened (all sockets must be manually created
         // and connected loopback sockets), no external connections are
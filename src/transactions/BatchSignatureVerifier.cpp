@@ -0,0 +1,210 @@
+// Copyright 2017 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/asio.h"
+#include "transactions/BatchSignatureVerifier.h"
+#include "crypto/ByteSlice.h"
+#include "crypto/KeyUtils.h"
+#include "crypto/SecretKey.h"
+#include "ledger/AccountFrame.h"
+#include "ledger/LedgerManager.h"
+#include "main/Application.h"
+#include "transactions/SignatureUtils.h"
+#include "transactions/TransactionFrame.h"
+#include "util/Logging.h"
+
+#include "medida/meter.h"
+#include "medida/metrics_registry.h"
+#include "medida/timer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace stellar
+{
+
+using xdr::operator==;
+
+// Signatures handed out to a thread at a time; large enough to amortize the
+// synchronization, small enough to spread a single tx set over all threads.
+static size_t const JOBS_PER_CHUNK = 16;
+
+struct BatchSignatureVerifier::Batch
+{
+    std::vector<Job> mJobs;
+    std::atomic<size_t> mNext{0};
+
+    std::mutex mMutex;
+    std::condition_variable mCond;
+    size_t mDone{0};
+};
+
+BatchSignatureVerifier::BatchSignatureVerifier(Application& app)
+    : mApp(app)
+    , mVerifyTimer(app.getMetrics().NewTimer(
+          {"transaction", "signature", "pre-verify"}))
+    , mSignatures(app.getMetrics().NewMeter(
+          {"transaction", "signature", "pre-verified"}, "signature"))
+{
+}
+
+void
+BatchSignatureVerifier::addCandidates(AccountID const& accountID,
+                                      std::vector<PublicKey>& candidates)
+{
+    auto addKey = [&candidates](PublicKey const& key) {
+        if (std::find(candidates.begin(), candidates.end(), key) ==
+            candidates.end())
+        {
+            candidates.push_back(key);
+        }
+    };
+
+    addKey(accountID);
+
+    // goes through the entry cache, and warms it for the validation that
+    // follows
+    auto account = AccountFrame::loadAccount(accountID, mApp.getDatabase());
+    if (!account)
+    {
+        return;
+    }
+    for (auto const& signer : account->getAccount().signers)
+    {
+        if (signer.key.type() == SIGNER_KEY_TYPE_ED25519)
+        {
+            addKey(KeyUtils::convertKey<PublicKey>(signer.key));
+        }
+    }
+}
+
+void
+BatchSignatureVerifier::add(TransactionFramePtr const& tx)
+{
+    auto const& env = tx->getEnvelope();
+    if (env.signatures.empty())
+    {
+        return;
+    }
+
+    std::vector<PublicKey> candidates;
+    addCandidates(env.tx.sourceAccount, candidates);
+    for (auto const& op : env.tx.operations)
+    {
+        if (op.sourceAccount)
+        {
+            addCandidates(*op.sourceAccount, candidates);
+        }
+    }
+
+    auto const& contentsHash = tx->getContentsHash();
+    for (auto const& sig : env.signatures)
+    {
+        for (auto const& key : candidates)
+        {
+            if (SignatureUtils::doesHintMatch(key.ed25519(), sig.hint))
+            {
+                mJobs.push_back(Job{key, sig.signature, contentsHash});
+            }
+        }
+    }
+}
+
+void
+BatchSignatureVerifier::add(std::vector<TransactionFramePtr> const& txs)
+{
+    for (auto const& tx : txs)
+    {
+        add(tx);
+    }
+}
+
+size_t
+BatchSignatureVerifier::size() const
+{
+    return mJobs.size();
+}
+
+void
+BatchSignatureVerifier::runJobs(Batch& batch)
+{
+    auto const total = batch.mJobs.size();
+    for (;;)
+    {
+        size_t begin = batch.mNext.fetch_add(JOBS_PER_CHUNK);
+        if (begin >= total)
+        {
+            return;
+        }
+        size_t end = std::min(begin + JOBS_PER_CHUNK, total);
+        for (size_t i = begin; i < end; ++i)
+        {
+            auto const& job = batch.mJobs[i];
+            PubKeyUtils::verifySig(job.mKey, job.mSignature, job.mContentsHash);
+        }
+
+        std::lock_guard<std::mutex> guard(batch.mMutex);
+        batch.mDone += end - begin;
+        if (batch.mDone == total)
+        {
+            batch.mCond.notify_all();
+        }
+    }
+}
+
+void
+BatchSignatureVerifier::verify()
+{
+    if (mJobs.empty())
+    {
+        return;
+    }
+
+    auto timer = mVerifyTimer.TimeScope();
+    mSignatures.Mark(mJobs.size());
+
+    // owned jointly with the posted tasks: a worker picking one up after the
+    // batch is complete finds nothing left to do, but must still be able to
+    // look at it.
+    auto batch = std::make_shared<Batch>();
+    batch->mJobs.swap(mJobs);
+
+    size_t chunks = (batch->mJobs.size() + JOBS_PER_CHUNK - 1) / JOBS_PER_CHUNK;
+    size_t helpers =
+        std::min<size_t>(chunks - 1, std::thread::hardware_concurrency());
+    for (size_t i = 0; i < helpers; ++i)
+    {
+        mApp.getWorkerIOService().post([batch]() { runJobs(*batch); });
+    }
+
+    // chunks not picked up by a worker yet are verified here
+    runJobs(*batch);
+
+    std::unique_lock<std::mutex> lock(batch->mMutex);
+    batch->mCond.wait(lock, [&batch]() {
+        return batch->mDone == batch->mJobs.size();
+    });
+
+    CLOG(TRACE, "Tx") << "Pre-verified " << batch->mJobs.size()
+                      << " signatures using " << helpers << " workers";
+}
+
+void
+BatchSignatureVerifier::preVerify(Application& app,
+                                  std::vector<TransactionFramePtr> const& txs)
+{
+    // signatures are not checked at all by protocol version 7
+    if (app.getLedgerManager().getCurrentLedgerVersion() == 7)
+    {
+        return;
+    }
+
+    BatchSignatureVerifier verifier(app);
+    verifier.add(txs);
+    verifier.verify();
+}
+}
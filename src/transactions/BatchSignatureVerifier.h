@@ -0,0 +1,82 @@
+#pragma once
+
+// Copyright 2017 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "xdr/Stellar-ledger-entries.h"
+#include "xdr/Stellar-transaction.h"
+#include "xdr/Stellar-types.h"
+
+#include <memory>
+#include <vector>
+
+namespace medida
+{
+class Meter;
+class Timer;
+}
+
+namespace stellar
+{
+
+class Application;
+class TransactionFrame;
+typedef std::shared_ptr<TransactionFrame> TransactionFramePtr;
+
+/**
+ * Verifies, ahead of time and on the worker threads, the ed25519 signatures
+ * that SignatureChecker is going to check for a batch of transactions.
+ *
+ * Nothing is decided here: the results only land in the process-wide
+ * verify-signature cache of PubKeyUtils::verifySig, so that the serial
+ * validation that follows (TransactionFrame::checkValid or apply) finds them
+ * there instead of verifying each signature on the main thread.
+ *
+ * Candidate keys are the source accounts of the transactions and of their
+ * operations, plus the signers of those accounts that exist in the database.
+ * Only signatures whose hint matches a candidate key are queued.
+ *
+ * Must be used from the main thread; the main thread takes part in the
+ * verification so a busy worker pool never leaves it idle.
+ */
+class BatchSignatureVerifier
+{
+  public:
+    explicit BatchSignatureVerifier(Application& app);
+
+    // Queue the signatures of `tx` that may be checked when validating it.
+    void add(TransactionFramePtr const& tx);
+    void add(std::vector<TransactionFramePtr> const& txs);
+
+    // Number of signatures queued so far.
+    size_t size() const;
+
+    // Verify every queued signature and wait until all are done.
+    void verify();
+
+    // Convenience: add `txs` and verify them.
+    static void preVerify(Application& app,
+                          std::vector<TransactionFramePtr> const& txs);
+
+  private:
+    struct Job
+    {
+        PublicKey mKey;
+        Signature mSignature;
+        Hash mContentsHash;
+    };
+    struct Batch;
+
+    Application& mApp;
+    std::vector<Job> mJobs;
+
+    medida::Timer& mVerifyTimer;
+    medida::Meter& mSignatures;
+
+    void addCandidates(AccountID const& accountID,
+                       std::vector<PublicKey>& candidates);
+
+    static void runJobs(Batch& batch);
+};
+}
@@ -30,6 +30,7 @@ class SecretKey;
 class SignatureChecker;
 class XDROutputFileStream;
 class SHA256;
+class TransactionHistoryWriter;
 
 class TransactionFrame;
 using TransactionFramePtr = std::shared_ptr<TransactionFrame>;
@@ -158,12 +159,13 @@ class TransactionFrame
                                       LedgerDelta* delta, Database& app,
                                       AccountID const& accountID);
 
-    // transaction history
-    void storeTransaction(LedgerManager& ledgerManager, TransactionMeta& tm,
-                          int txindex, TransactionResultSet& resultSet) const;
+    // transaction history, buffered in `history` until the ledger closes
+    void storeTransaction(TransactionHistoryWriter& history,
+                          TransactionMeta& tm, int txindex,
+                          TransactionResultSet& resultSet) const;
 
-    // fee history
-    void storeTransactionFee(LedgerManager& ledgerManager,
+    // fee history, buffered in `history` until the ledger closes
+    void storeTransactionFee(TransactionHistoryWriter& history,
                              LedgerEntryChanges const& changes,
                              int txindex) const;
 
@@ -185,6 +187,7 @@ class TransactionFrame
                                            XDROutputFileStream& txResultOut);
     static void dropAll(Database& db);
 
-    static void deleteOldEntries(Database& db, uint32_t ledgerSeq);
+    static size_t deleteOldEntries(Database& db, uint32_t ledgerSeq,
+                                   uint32_t count);
 };
 }
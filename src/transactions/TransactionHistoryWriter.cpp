@@ -0,0 +1,121 @@
+// Copyright 2017 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "transactions/TransactionHistoryWriter.h"
+#include "crypto/Hex.h"
+#include "database/BulkInserter.h"
+#include "database/Database.h"
+#include "util/basen.h"
+#include "xdrpp/marshal.h"
+
+#include <iterator>
+#include <stdexcept>
+
+namespace stellar
+{
+
+template <typename T>
+void
+TransactionHistoryWriter::encode(T const& t, std::string& out)
+{
+    // serialized into mXDR and encoded straight into `out`, both keeping the
+    // storage they got for earlier rows
+    mXDR.resize(xdr::xdr_size(t));
+    xdr::xdr_put p(mXDR.data(), mXDR.data() + mXDR.size());
+    xdr::xdr_argpack_archive(p, t);
+
+    out.clear();
+    out.reserve(bn::encoded_size64(mXDR.size()));
+    bn::encode_b64(mXDR.begin(), mXDR.end(), std::back_inserter(out));
+}
+
+void
+TransactionHistoryWriter::reset(uint32_t ledgerSeq)
+{
+    mLedgerSeq = ledgerSeq;
+    mTxCount = 0;
+    mFeeCount = 0;
+}
+
+void
+TransactionHistoryWriter::addTransaction(Hash const& txID, int txindex,
+                                         TransactionEnvelope const& envelope,
+                                         TransactionResultPair const& result,
+                                         TransactionMeta const& meta)
+{
+    if (mTxCount == mTxRows.size())
+    {
+        mTxRows.emplace_back();
+    }
+    auto& row = mTxRows[mTxCount++];
+    row.mTxID = binToHex(txID);
+    row.mTxIndex = txindex;
+    encode(envelope, row.mBody);
+    encode(result, row.mResult);
+    encode(meta, row.mMeta);
+}
+
+void
+TransactionHistoryWriter::addTransactionFee(Hash const& txID, int txindex,
+                                            LedgerEntryChanges const& changes)
+{
+    if (mFeeCount == mFeeRows.size())
+    {
+        mFeeRows.emplace_back();
+    }
+    auto& row = mFeeRows[mFeeCount++];
+    row.mTxID = binToHex(txID);
+    row.mTxIndex = txindex;
+    encode(changes, row.mChanges);
+}
+
+void
+TransactionHistoryWriter::flush(Database& db)
+{
+    auto ledgerSeq = std::to_string(mLedgerSeq);
+
+    if (mFeeCount != 0)
+    {
+        BulkInserter fees(db, "txfeehistory",
+                          {"txid", "ledgerseq", "txindex", "txchanges"});
+        for (size_t i = 0; i < mFeeCount; ++i)
+        {
+            auto const& row = mFeeRows[i];
+            fees.add(row.mTxID);
+            fees.add(ledgerSeq);
+            fees.add(std::to_string(row.mTxIndex));
+            fees.add(row.mChanges);
+        }
+        fees.flush();
+        if (fees.getRowsInserted() != mFeeCount)
+        {
+            throw std::runtime_error("Could not update data in SQL");
+        }
+    }
+
+    if (mTxCount != 0)
+    {
+        BulkInserter txs(db, "txhistory", {"txid", "ledgerseq", "txindex",
+                                           "txbody", "txresult", "txmeta"});
+        for (size_t i = 0; i < mTxCount; ++i)
+        {
+            auto const& row = mTxRows[i];
+            txs.add(row.mTxID);
+            txs.add(ledgerSeq);
+            txs.add(std::to_string(row.mTxIndex));
+            txs.add(row.mBody);
+            txs.add(row.mResult);
+            txs.add(row.mMeta);
+        }
+        txs.flush();
+        if (txs.getRowsInserted() != mTxCount)
+        {
+            throw std::runtime_error("Could not update data in SQL");
+        }
+    }
+
+    mTxCount = 0;
+    mFeeCount = 0;
+}
+}
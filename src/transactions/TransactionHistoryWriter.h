@@ -0,0 +1,72 @@
+#pragma once
+
+// Copyright 2017 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "overlay/StellarXDR.h"
+#include "util/NonCopyable.h"
+
+#include <string>
+#include <vector>
+
+namespace stellar
+{
+
+class Database;
+
+/**
+ * Buffers the txhistory and txfeehistory rows of the ledger being closed and
+ * writes them with one bulk insert per table, instead of one INSERT per
+ * transaction.
+ *
+ * Rows and their encoding buffers are kept from one ledger to the next, so
+ * once the writer has seen a ledger as large as the current one, buffering a
+ * row doesn't allocate.
+ */
+class TransactionHistoryWriter : NonMovableOrCopyable
+{
+    struct TxRow
+    {
+        std::string mTxID;
+        int mTxIndex;
+        std::string mBody;
+        std::string mResult;
+        std::string mMeta;
+    };
+
+    struct FeeRow
+    {
+        std::string mTxID;
+        int mTxIndex;
+        std::string mChanges;
+    };
+
+    uint32_t mLedgerSeq{0};
+
+    // only the first mTxCount / mFeeCount rows are for the current ledger
+    std::vector<TxRow> mTxRows;
+    size_t mTxCount{0};
+    std::vector<FeeRow> mFeeRows;
+    size_t mFeeCount{0};
+
+    std::vector<uint8_t> mXDR;
+
+    template <typename T> void encode(T const& t, std::string& out);
+
+  public:
+    // Start buffering the rows of ledger `ledgerSeq`, dropping any left over
+    // from a ledger that failed to close.
+    void reset(uint32_t ledgerSeq);
+
+    void addTransaction(Hash const& txID, int txindex,
+                        TransactionEnvelope const& envelope,
+                        TransactionResultPair const& result,
+                        TransactionMeta const& meta);
+    void addTransactionFee(Hash const& txID, int txindex,
+                           LedgerEntryChanges const& changes);
+
+    // Write the rows buffered so far and forget them.
+    void flush(Database& db);
+};
+}
@@ -0,0 +1,193 @@
+// Copyright 2017 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/Gzip.h"
+#include "util/Logging.h"
+
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+#include <zlib.h>
+
+namespace stellar
+{
+
+// large enough that zlib calls are few, small enough to stay in cache
+static size_t const GZIP_BUFFER_SIZE = 128 * 1024;
+
+static std::string
+gzipError(gzFile file, std::string const& what, std::string const& filename)
+{
+    int err = Z_OK;
+    char const* msg = file ? gzerror(file, &err) : "cannot open";
+    return what + " " + filename + ": " + msg;
+}
+
+GzipFileReader::~GzipFileReader()
+{
+    close();
+}
+
+void
+GzipFileReader::open(std::string const& filename)
+{
+    close();
+    mFile = gzopen(filename.c_str(), "rb");
+    if (!mFile)
+    {
+        std::string msg("failed to open gzip file: ");
+        msg += filename;
+        CLOG(ERROR, "Fs") << msg;
+        throw std::runtime_error(msg);
+    }
+    gzbuffer(mFile, GZIP_BUFFER_SIZE);
+    if (gzdirect(mFile))
+    {
+        // zlib would otherwise hand back the raw bytes of a file without a
+        // gzip header, where gzip -d refuses it
+        gzclose_r(mFile);
+        mFile = nullptr;
+        std::string msg("not a gzip file: ");
+        msg += filename;
+        CLOG(ERROR, "Fs") << msg;
+        throw std::runtime_error(msg);
+    }
+    mFilename = filename;
+    mGood = true;
+}
+
+void
+GzipFileReader::close()
+{
+    if (mFile)
+    {
+        gzclose_r(mFile);
+        mFile = nullptr;
+    }
+    mGood = false;
+}
+
+size_t
+GzipFileReader::readSome(char* buf, size_t size)
+{
+    if (!mGood)
+    {
+        return 0;
+    }
+    auto chunk = static_cast<unsigned int>(
+        std::min<size_t>(size, std::numeric_limits<int>::max()));
+    int n = gzread(mFile, buf, chunk);
+    if (n < 0)
+    {
+        mGood = false;
+        throw std::runtime_error(gzipError(mFile, "failed to read", mFilename));
+    }
+    if (n == 0 && chunk != 0)
+    {
+        mGood = false;
+        int err = Z_OK;
+        gzerror(mFile, &err);
+        if (err != Z_OK)
+        {
+            // a truncated stream shows up as Z_BUF_ERROR at its end
+            throw std::runtime_error(
+                gzipError(mFile, "failed to read", mFilename));
+        }
+    }
+    return static_cast<size_t>(n);
+}
+
+bool
+GzipFileReader::read(char* buf, size_t size)
+{
+    while (size > 0)
+    {
+        auto n = readSome(buf, size);
+        if (n == 0)
+        {
+            return false;
+        }
+        buf += n;
+        size -= n;
+    }
+    return true;
+}
+
+void
+gzipFile(std::string const& in, std::string const& out)
+{
+    std::ifstream src(in, std::ifstream::binary);
+    if (!src)
+    {
+        throw std::runtime_error("failed to open " + in);
+    }
+
+    gzFile dst = gzopen(out.c_str(), "wb");
+    if (!dst)
+    {
+        throw std::runtime_error(gzipError(dst, "failed to open", out));
+    }
+    gzbuffer(dst, GZIP_BUFFER_SIZE);
+
+    std::vector<char> buf(GZIP_BUFFER_SIZE);
+    bool ok = true;
+    while (ok && src)
+    {
+        src.read(buf.data(), buf.size());
+        auto n = static_cast<unsigned int>(src.gcount());
+        ok = n == 0 || gzwrite(dst, buf.data(), n) == static_cast<int>(n);
+    }
+    ok = ok && src.eof();
+    std::string err = ok ? "" : gzipError(dst, "failed to compress", in);
+    if (gzclose_w(dst) != Z_OK && ok)
+    {
+        ok = false;
+        err = "failed to write " + out;
+    }
+    if (!ok)
+    {
+        std::remove(out.c_str());
+        throw std::runtime_error(err);
+    }
+}
+
+void
+gunzipFile(std::string const& in, std::string const& out)
+{
+    GzipFileReader src;
+    src.open(in);
+
+    std::ofstream dst(out, std::ofstream::binary | std::ofstream::trunc);
+    if (!dst)
+    {
+        throw std::runtime_error("failed to open " + out);
+    }
+
+    try
+    {
+        std::vector<char> buf(GZIP_BUFFER_SIZE);
+        size_t n;
+        while ((n = src.readSome(buf.data(), buf.size())) > 0)
+        {
+            if (!dst.write(buf.data(), n))
+            {
+                throw std::runtime_error("failed to write " + out);
+            }
+        }
+        dst.close();
+        if (!dst)
+        {
+            throw std::runtime_error("failed to write " + out);
+        }
+    }
+    catch (...)
+    {
+        dst.close();
+        std::remove(out.c_str());
+        throw;
+    }
+}
+}
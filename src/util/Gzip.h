@@ -0,0 +1,56 @@
+#pragma once
+
+// Copyright 2017 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/NonCopyable.h"
+#include <cstddef>
+#include <string>
+
+struct gzFile_s;
+
+namespace stellar
+{
+
+/**
+ * Sequential reader of the decompressed contents of a gzip file, decompressing
+ * in memory as it goes.
+ */
+class GzipFileReader : NonMovableOrCopyable
+{
+    gzFile_s* mFile{nullptr};
+    std::string mFilename;
+    bool mGood{false};
+
+  public:
+    GzipFileReader() = default;
+    ~GzipFileReader();
+
+    // Throws std::runtime_error if `filename` can't be opened.
+    void open(std::string const& filename);
+    void close();
+
+    // False once a read came up short, like std::istream::good().
+    bool
+    good() const
+    {
+        return mGood;
+    }
+
+    // Read up to `size` bytes into `buf`, returning how many were read: 0 at
+    // the end of the data. Throws std::runtime_error if the file is corrupt
+    // or truncated.
+    size_t readSome(char* buf, size_t size);
+
+    // Read exactly `size` bytes into `buf`. Returns false if the data ends
+    // first; throws std::runtime_error if the file is corrupt or truncated.
+    bool read(char* buf, size_t size);
+};
+
+// Compress `in` into the gzip file `out`, or decompress the gzip file `in`
+// into `out`. Both throw std::runtime_error on failure, leaving no `out`
+// behind.
+void gzipFile(std::string const& in, std::string const& out);
+void gunzipFile(std::string const& in, std::string const& out);
+}
@@ -0,0 +1,159 @@
+// Copyright 2017 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/MappedFile.h"
+#include "util/Logging.h"
+
+#include <cerrno>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace stellar
+{
+
+static void
+throwOpenError(std::string const& filename, std::string const& what)
+{
+    std::string msg("failed to map file: ");
+    msg += filename;
+    msg += ", ";
+    msg += what;
+    msg += ", reason: ";
+    msg += std::to_string(errno);
+    CLOG(ERROR, "Fs") << msg;
+    throw std::runtime_error(msg);
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+#ifdef _WIN32
+
+void
+MappedFile::open(std::string const& filename)
+{
+    close();
+
+    HANDLE file =
+        ::CreateFile(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                     OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        throwOpenError(filename, "CreateFile");
+    }
+    LARGE_INTEGER size;
+    if (!::GetFileSizeEx(file, &size))
+    {
+        ::CloseHandle(file);
+        throwOpenError(filename, "GetFileSizeEx");
+    }
+    mFile = file;
+    mSize = static_cast<size_t>(size.QuadPart);
+    mOpen = true;
+    if (mSize == 0)
+    {
+        return;
+    }
+
+    mMapping = ::CreateFileMapping(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mMapping)
+    {
+        close();
+        throwOpenError(filename, "CreateFileMapping");
+    }
+    mData = static_cast<char const*>(
+        ::MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0));
+    if (!mData)
+    {
+        close();
+        throwOpenError(filename, "MapViewOfFile");
+    }
+}
+
+void
+MappedFile::close()
+{
+    if (mData)
+    {
+        ::UnmapViewOfFile(mData);
+    }
+    if (mMapping)
+    {
+        ::CloseHandle(mMapping);
+    }
+    if (mFile)
+    {
+        ::CloseHandle(mFile);
+    }
+    mData = nullptr;
+    mMapping = nullptr;
+    mFile = nullptr;
+    mSize = 0;
+    mOpen = false;
+}
+
+#else
+
+void
+MappedFile::open(std::string const& filename)
+{
+    close();
+
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd == -1)
+    {
+        throwOpenError(filename, "open");
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0)
+    {
+        ::close(fd);
+        throwOpenError(filename, "fstat");
+    }
+
+    size_t size = static_cast<size_t>(st.st_size);
+    void* data = nullptr;
+    if (size != 0)
+    {
+        data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED)
+        {
+            ::close(fd);
+            throwOpenError(filename, "mmap");
+        }
+        // only a hint: failing to give it is harmless
+        ::madvise(data, size, MADV_SEQUENTIAL);
+    }
+    // the mapping keeps the file alive
+    ::close(fd);
+
+    mData = static_cast<char const*>(data);
+    mSize = size;
+    mOpen = true;
+}
+
+void
+MappedFile::close()
+{
+    if (mData)
+    {
+        ::munmap(const_cast<char*>(mData), mSize);
+    }
+    mData = nullptr;
+    mSize = 0;
+    mOpen = false;
+}
+
+#endif
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+// Copyright 2017 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/NonCopyable.h"
+#include <cstddef>
+#include <string>
+
+namespace stellar
+{
+
+/**
+ * Read-only memory mapping of a whole file, released on destruction.
+ *
+ * The kernel is told the mapping will be read sequentially, so it reads
+ * ahead aggressively and can drop pages behind the reader; this is meant for
+ * single forward passes over large files such as buckets.
+ */
+class MappedFile : NonMovableOrCopyable
+{
+    bool mOpen{false};
+    char const* mData{nullptr};
+    size_t mSize{0};
+#ifdef _WIN32
+    void* mFile{nullptr};
+    void* mMapping{nullptr};
+#endif
+
+  public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    // Map `filename`, throwing std::runtime_error if it can't be. An empty
+    // file is "mapped" as an empty range.
+    void open(std::string const& filename);
+    void close();
+
+    bool
+    isOpen() const
+    {
+        return mOpen;
+    }
+
+    char const*
+    data() const
+    {
+        return mData;
+    }
+
+    size_t
+    size() const
+    {
+        return mSize;
+    }
+};
+}
@@ -6,9 +6,12 @@
 
 #include "crypto/ByteSlice.h"
 #include "crypto/SHA.h"
+#include "util/Gzip.h"
 #include "util/Logging.h"
+#include "util/MappedFile.h"
 #include "xdrpp/marshal.h"
 #include <fstream>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -18,13 +21,27 @@ namespace stellar
 /**
  * Helper for loading a sequence of XDR objects from a file one at a time,
  * rather than all at once.
+ *
+ * Files whose name ends in ".gz" are decompressed as they are read, so
+ * history files can be consumed without unzipping them to disk first.
  */
 class XDRInputFileStream
 {
     std::ifstream mIn;
+    std::unique_ptr<GzipFileReader> mGz;
     std::vector<char> mBuf;
     unsigned int mSizeLimit;
 
+    bool
+    read(char* buf, size_t size)
+    {
+        if (mGz)
+        {
+            return mGz->read(buf, size);
+        }
+        return static_cast<bool>(mIn.read(buf, size));
+    }
+
   public:
     XDRInputFileStream(unsigned int sizeLimit = 0) : mSizeLimit{sizeLimit}
     {
@@ -34,11 +51,20 @@ class XDRInputFileStream
     close()
     {
         mIn.close();
+        mGz.reset();
     }
 
     void
     open(std::string const& filename)
     {
+        if (filename.size() > 3 &&
+            filename.compare(filename.size() - 3, 3, ".gz") == 0)
+        {
+            mGz = std::unique_ptr<GzipFileReader>(new GzipFileReader());
+            mGz->open(filename);
+            return;
+        }
+
         mIn.open(filename, std::ifstream::binary);
         if (!mIn)
         {
@@ -53,7 +79,7 @@ class XDRInputFileStream
 
     operator bool() const
     {
-        return mIn.good();
+        return mGz ? mGz->good() : mIn.good();
     }
 
     template <typename T>
@@ -61,7 +87,7 @@ class XDRInputFileStream
     readOne(T& out)
     {
         char szBuf[4];
-        if (!mIn.read(szBuf, 4))
+        if (!read(szBuf, 4))
         {
             return false;
         }
@@ -85,7 +111,7 @@ class XDRInputFileStream
         {
             mBuf.resize(sz);
         }
-        if (!mIn.read(mBuf.data(), sz))
+        if (!read(mBuf.data(), sz))
         {
             throw xdr::xdr_runtime_error("malformed XDR file");
         }
@@ -95,6 +121,129 @@ class XDRInputFileStream
     }
 };
 
+/**
+ * Same as XDRInputFileStream, but reading from a memory mapping of the file:
+ * objects are decoded straight from the mapped pages rather than first being
+ * copied into a buffer.
+ */
+class XDRInputMappedStream
+{
+    MappedFile mFile;
+    size_t mPos{0};
+    unsigned int mSizeLimit;
+
+  public:
+    XDRInputMappedStream(unsigned int sizeLimit = 0) : mSizeLimit{sizeLimit}
+    {
+    }
+
+    void
+    close()
+    {
+        mFile.close();
+        mPos = 0;
+    }
+
+    void
+    open(std::string const& filename)
+    {
+        mFile.open(filename);
+        mPos = 0;
+    }
+
+    operator bool() const
+    {
+        return mFile.isOpen() && mPos < mFile.size();
+    }
+
+    size_t
+    size() const
+    {
+        return mFile.size();
+    }
+
+    // Offset of the next record in the file.
+    size_t
+    getPos() const
+    {
+        return mPos;
+    }
+
+    // Continue reading at `pos`, which must be the offset of a record (or the
+    // end of the file).
+    void
+    seek(size_t pos)
+    {
+        assert(pos <= mFile.size());
+        mPos = pos;
+    }
+
+    // Step over the next record without decoding it.
+    bool
+    skipOne()
+    {
+        uint32_t sz;
+        if (!readSize(sz))
+        {
+            return false;
+        }
+        mPos += 4 + sz;
+        return true;
+    }
+
+    template <typename T>
+    bool
+    readOne(T& out)
+    {
+        uint32_t sz;
+        if (!readSize(sz))
+        {
+            return false;
+        }
+        auto const* p = mFile.data() + mPos + 4;
+        xdr::xdr_get g(p, p + sz);
+        xdr::xdr_argpack_archive(g, out);
+        mPos += 4 + sz;
+        return true;
+    }
+
+  private:
+    // Decode the size of the next record and check the record is all there.
+    bool
+    readSize(uint32_t& sz)
+    {
+        if (!*this || mFile.size() - mPos < 4)
+        {
+            mPos = mFile.size();
+            return false;
+        }
+
+        // Read 4 bytes of size, big-endian, with XDR 'continuation' bit cleared
+        // (high bit of high byte).
+        auto const* p = mFile.data() + mPos;
+        sz = 0;
+        sz |= static_cast<uint8_t>(p[0] & '\x7f');
+        sz <<= 8;
+        sz |= static_cast<uint8_t>(p[1]);
+        sz <<= 8;
+        sz |= static_cast<uint8_t>(p[2]);
+        sz <<= 8;
+        sz |= static_cast<uint8_t>(p[3]);
+
+        if (mSizeLimit != 0 && sz > mSizeLimit)
+        {
+            return false;
+        }
+        // records are a multiple of 4 bytes long, which keeps every one of
+        // them aligned for xdr_get
+        if (sz % 4 != 0 || mFile.size() - mPos - 4 < sz)
+        {
+            throw xdr::xdr_runtime_error("malformed XDR file");
+        }
+        return true;
+    }
+};
+
 class XDROutputFileStream
 {
     std::ofstream mOut;